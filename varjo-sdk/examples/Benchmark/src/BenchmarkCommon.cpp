@@ -0,0 +1,100 @@
+#include "BenchmarkCommon.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "GeometryGenerator.hpp"
+
+namespace
+{
+float randomFloat(float min, float max)
+{
+    float value = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    return min + (max - min) * value;
+}
+}  // namespace
+
+std::unique_ptr<ObjectStore> createObjects(std::shared_ptr<IRenderer> renderer, bool disableAnimation, int maxDonuts)
+{
+    auto donutGeometry = GeometryGenerator::generateDonut(renderer, 0.25f, 0.125f, 256, 64);
+    auto objects = std::make_unique<ObjectStore>(donutGeometry);
+
+    const int32_t donutCount = 14;
+    const int32_t rows = 5;
+    const int32_t layers = 20;
+    const float rowMin = -1.0f;
+    const float rowMax = 2.0f;
+    const float layerMin = 0.75f;
+    const float layerSize = 2.0f;
+    const float angle = 360.0f / static_cast<float>(donutCount);
+    const float layerOffsetangle = angle * (1.0f / static_cast<float>(layers));
+
+    srand(123);  // Keep the animations same on each run.
+
+    objects->reserve((std::min)(maxDonuts, donutCount * rows * layers));
+
+    for (int32_t l = 0; l < layers; ++l) {  // Layers going outward from the center.
+        float offsetAngle = l * layerOffsetangle;
+        float z = layerMin + (layerSize * static_cast<float>(l));
+
+        for (int32_t r = 0; r < rows; ++r) {  // Rows going up from the bottom.
+            float y = rowMin + ((rowMax - rowMin) / static_cast<float>(rows - 1)) * static_cast<float>(r);
+
+            for (int32_t i = 0; i < donutCount; ++i) {  // Number of donuts in a circle.
+                auto rotate = glm::angleAxis(glm::radians((angle * static_cast<float>(i)) + offsetAngle), glm::vec3(0, 1, 0));
+
+                IRenderer::Object object{};
+                object.position = glm::rotate(rotate, glm::vec3{0, y, z});
+                object.scale = glm::vec3{1, 1, 1};
+                object.orientation = rotate * glm::angleAxis(glm::radians(90.0f), glm::vec3(1, 0, 0));
+
+                if (!disableAnimation) {
+                    // Random axis of rotation and rotation speed for each object.
+                    object.velocity = {
+                        glm::vec3{randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f)},
+                        glm::radians(randomFloat(30.0f, 120.0f)),
+                    };
+                }
+
+                objects->add(object);
+
+                if (objects->size() >= static_cast<size_t>(maxDonuts)) {
+                    goto end;
+                }
+            }
+        }
+    }
+
+end:
+    printf("Created %zu donuts\n", objects->size());
+    printf("%zu triangles per frame\n", objects->size() * (donutGeometry->indexCount() / 3));
+    return objects;
+}
+
+void setProfilerFrameStats(Profiler& profiler, const IRenderer& renderer, bool useFrustumCulling, bool useOcclusionCulling)
+{
+    const IRenderer::FrameStats& frameStats = renderer.getFrameStats();
+    profiler.setFrameStat("workerThreads", static_cast<double>(renderer.getWorkerThreadCount()));
+    profiler.setFrameStat("worldMatrixTime", frameStats.worldMatrixTimeMs);
+    if (useFrustumCulling) {
+        profiler.setFrameStat("cullingTime", frameStats.cullingTimeMs);
+        for (size_t i = 0; i < frameStats.visibleInstances.size(); ++i) {
+            profiler.setFrameStat("visibleView" + std::to_string(i), frameStats.visibleInstances[i]);
+            profiler.setFrameStat("culledView" + std::to_string(i), frameStats.culledInstances[i]);
+        }
+    }
+    if (useOcclusionCulling) {
+        // Share of instances in the view frustums that were hidden behind occluders
+        double occludedTotal = 0.0;
+        double visibleTotal = 0.0;
+        profiler.setFrameStat("occlusionCullingTime", frameStats.occlusionCullingTimeMs);
+        for (size_t i = 0; i < frameStats.occludedInstances.size(); ++i) {
+            profiler.setFrameStat("occludedView" + std::to_string(i), frameStats.occludedInstances[i]);
+            occludedTotal += frameStats.occludedInstances[i];
+            visibleTotal += frameStats.visibleInstances[i];
+        }
+        profiler.setFrameStat("occlusionRejectionRate", occludedTotal + visibleTotal > 0.0 ? occludedTotal / (occludedTotal + visibleTotal) : 0.0);
+    }
+}
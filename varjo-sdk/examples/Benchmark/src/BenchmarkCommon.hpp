@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+
+#include "IRenderer.hpp"
+#include "ObjectStore.hpp"
+#include "Profiler.hpp"
+
+/**
+ * Scene setup and profiling shared by the Benchmark and BenchmarkHeadless applications.
+ */
+
+// Create the donut scene. Animation is seeded the same way on each run.
+std::unique_ptr<ObjectStore> createObjects(std::shared_ptr<IRenderer> renderer, bool disableAnimation, int maxDonuts);
+
+// Set renderer statistics of the frame being profiled
+void setProfilerFrameStats(Profiler& profiler, const IRenderer& renderer, bool useFrustumCulling, bool useOcclusionCulling);
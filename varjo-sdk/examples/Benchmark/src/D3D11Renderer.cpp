@@ -137,6 +137,45 @@ void D3D11DepthRenderTexture::createDepthStencilView(D3D11Renderer* renderer, ID
     }
 }
 
+D3D11Geometry::D3D11Geometry(D3D11Renderer* renderer, uint32_t vertexCount, uint32_t indexCount)
+    : Geometry(vertexCount, indexCount)
+    , m_vertexBuffer(nullptr)
+    , m_indexBuffer(nullptr)
+    , m_renderer(renderer)
+{
+    D3D11_BUFFER_DESC desc{};
+    desc.ByteWidth = getVertexDataSize();
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+    HRESULT result = renderer->dxDevice()->CreateBuffer(&desc, nullptr, &m_vertexBuffer);
+    if (result != S_OK) {
+        printf("Failed to create vertex buffer: %d", GetLastError());
+        abort();
+    }
+
+    desc.ByteWidth = getIndexDataSize();
+    desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+    result = renderer->dxDevice()->CreateBuffer(&desc, nullptr, &m_indexBuffer);
+    if (result != S_OK) {
+        printf("Failed to create index buffer: %d", GetLastError());
+        abort();
+    }
+}
+
+D3D11Geometry::~D3D11Geometry()
+{
+    m_vertexBuffer->Release();
+    m_vertexBuffer = nullptr;
+
+    m_indexBuffer->Release();
+    m_indexBuffer = nullptr;
+}
+
+void D3D11Geometry::updateVertexBuffer(void* data) { m_renderer->dxDeviceContext()->UpdateSubresource(m_vertexBuffer, 0, nullptr, data, 0, 0); }
+void D3D11Geometry::updateIndexBuffer(void* data) { m_renderer->dxDeviceContext()->UpdateSubresource(m_indexBuffer, 0, nullptr, data, 0, 0); }
+
 D3D11Renderer::D3D11Renderer(varjo_Session* session, const RendererSettings& renderer_settings)
     : IRenderer(session, renderer_settings)
 {
@@ -842,13 +881,13 @@ void D3D11Renderer::createPerFrameBuffers()
 
 void D3D11Renderer::createInstanceBuffer()
 {
-    const int32_t maxInstances = 5000;
+    const int32_t maxInstances = c_maxInstances;
     m_instanceBuffer.maxInstances = maxInstances;
 
     D3D11_BUFFER_DESC bufferDesc{};
     bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
     bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    bufferDesc.ByteWidth = sizeof(glm::mat4) * maxInstances;
+    bufferDesc.ByteWidth = sizeof(ObjectRenderData) * maxInstances;
     bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
     bufferDesc.StructureByteStride = 0;
 
@@ -20,6 +20,8 @@
 #include "IRenderer.hpp"
 #include "Window.hpp"
 
+class D3D11Renderer;
+
 class D3D11ColorRenderTexture final : public RenderTexture
 {
 public:
@@ -54,12 +56,32 @@ private:
     ID3D11Texture2D* m_depthTexture{nullptr};
 };
 
+class D3D11Geometry : public Geometry
+{
+public:
+    D3D11Geometry(D3D11Renderer* renderer, uint32_t vertexCount, uint32_t indexCount);
+    ~D3D11Geometry();
+
+    void updateVertexBuffer(void* data) override;
+    void updateIndexBuffer(void* data) override;
+
+    ID3D11Buffer* vertexBuffer() const { return m_vertexBuffer; }
+    ID3D11Buffer* indexBuffer() const { return m_indexBuffer; }
+
+private:
+    ID3D11Buffer* m_vertexBuffer;
+    ID3D11Buffer* m_indexBuffer;
+    D3D11Renderer* m_renderer;
+};
+
 class D3D11Renderer final : public IRenderer
 {
 public:
     D3D11Renderer(varjo_Session* session, const RendererSettings& renderer_settings);
     ~D3D11Renderer() override;
 
+    Window* getWindow() const override { return m_window.get(); }
+
     ID3D11Device* dxDevice() const { return m_device; }
     ID3D11DeviceContext* dxDeviceContext() const { return m_deviceContext; }
 
@@ -193,7 +215,7 @@ private:
 
     std::shared_ptr<D3D11ColorRenderTexture> m_currentColorTexture;
 
-
+    std::unique_ptr<Window> m_window;
     Microsoft::WRL::ComPtr<IDXGISwapChain1> m_windowSwapChain;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> m_windowBackBufferTexture;
 };
@@ -20,7 +20,6 @@ using Microsoft::WRL::ComPtr;
 
 namespace
 {
-constexpr int c_MaxInstances = 5000;
 #define HCHECK(value) HCheck(#value, __LINE__, value)
 
 void HCheck(const char* what, int line, HRESULT hr)
@@ -604,7 +603,7 @@ void GpuNode::createResources(varjo_Session* session)
         std::wstringstream allocatorName;
         allocatorName << L"Allocator " << i << "_" << m_nodeMask;
         m_perFrameResources[i].commandAllocator->SetName(allocatorName.str().c_str());
-        m_perFrameResources[i].instanceBuffer = createUploadBuffer(c_MaxInstances * sizeof(IRenderer::ObjectRenderData));
+        m_perFrameResources[i].instanceBuffer = createUploadBuffer(IRenderer::c_maxInstances * sizeof(IRenderer::ObjectRenderData));
         std::wstringstream instanceBufferName;
         instanceBufferName << L"Instance Buffer " << i << "_" << m_nodeMask;
         m_perFrameResources[i].instanceBuffer->SetName(instanceBufferName.str().c_str());
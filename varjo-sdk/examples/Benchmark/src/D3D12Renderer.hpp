@@ -162,6 +162,8 @@ public:
     D3D12Renderer(varjo_Session* session, const RendererSettings& rendererSettings);
     ~D3D12Renderer() override;
 
+    Window* getWindow() const override { return m_window.get(); }
+
     std::shared_ptr<RenderTexture> createColorTexture(int32_t width, int32_t height, varjo_Texture colorTexture) override;
     std::shared_ptr<RenderTexture> createDepthTexture(int32_t width, int32_t height, varjo_Texture depthTexture) override;
     std::shared_ptr<RenderTexture> createVelocityTexture(int32_t width, int32_t height, varjo_Texture velocityTexture) override;
@@ -261,6 +263,6 @@ private:
     std::shared_ptr<D3D12RenderTexture> m_vrsTexture;
 #endif
 
-
+    std::unique_ptr<Window> m_window;
     Microsoft::WRL::ComPtr<IDXGISwapChain1> m_windowSwapChain;
 };
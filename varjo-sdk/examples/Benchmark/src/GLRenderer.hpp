@@ -53,6 +53,26 @@ private:
     bool m_hasStencil;
 };
 
+class GLGeometry : public Geometry
+{
+public:
+    GLGeometry(uint32_t vertexCount, uint32_t indexCount);
+    ~GLGeometry();
+
+    void updateVertexBuffer(void* data) override;
+    void updateIndexBuffer(void* data) override;
+
+    GLuint vao() const { return m_vao; }
+    GLuint indexBuffer() const { return m_indexBuffer; }
+
+private:
+    void copyToBuffer(GLuint buffer, void* data, int32_t size);
+
+    GLuint m_vao;
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+};
+
 
 class GLRenderer final : public IRenderer
 {
@@ -60,6 +80,8 @@ public:
     GLRenderer(varjo_Session* session, const RendererSettings& renderer_settings);
     ~GLRenderer() override;
 
+    Window* getWindow() const override { return m_window.get(); }
+
     std::shared_ptr<Geometry> createGeometry(uint32_t vertexCount, uint32_t indexCount) override;
     std::shared_ptr<RenderTexture> createColorTexture(int32_t width, int32_t height, varjo_Texture colorTexture) override;
     std::shared_ptr<RenderTexture> createDepthTexture(int32_t width, int32_t height, varjo_Texture depthTexture) override;
@@ -163,6 +185,7 @@ private:
     InstanceBuffer m_instanceBuffer = {};
     ShaderUniforms m_shaderUniforms;
 
+    std::unique_ptr<Window> m_window;
     HWND m_hwnd = 0;
     HDC m_hdc = 0;
     HGLRC m_hglrc = 0;
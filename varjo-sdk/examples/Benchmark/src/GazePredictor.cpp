@@ -0,0 +1,139 @@
+#include "GazePredictor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+glm::dvec3 toVec3(const double v[3]) { return {v[0], v[1], v[2]}; }
+
+double getAngle(const glm::dvec3& a, const glm::dvec3& b) { return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)); }
+
+// Rotate direction by rotation vector (axis scaled by angle) with Rodrigues' formula
+void rotate(double v[3], const glm::dvec3& rotation)
+{
+    const double angle = glm::length(rotation);
+    if (angle <= 0.0) {
+        return;
+    }
+
+    const glm::dvec3 axis = rotation / angle;
+    const glm::dvec3 d = toVec3(v);
+    const glm::dvec3 r = d * std::cos(angle) + glm::cross(axis, d) * std::sin(angle) + axis * glm::dot(axis, d) * (1.0 - std::cos(angle));
+    v[0] = r.x;
+    v[1] = r.y;
+    v[2] = r.z;
+}
+}  // namespace
+
+GazePredictor::GazePredictor()
+    : GazePredictor(Settings{})
+{
+}
+
+GazePredictor::GazePredictor(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+void GazePredictor::reset()
+{
+    m_hasGaze = false;
+    m_angularVelocity = {0, 0, 0};
+    m_eyeMovement = EyeMovement::FIXATION;
+}
+
+void GazePredictor::addSample(const varjo_Gaze& gaze)
+{
+    if (gaze.status != varjo_GazeStatus_Valid) {
+        reset();
+        return;
+    }
+
+    // Ignore samples we have already seen
+    if (m_hasGaze && gaze.captureTime <= m_latest.captureTime) {
+        return;
+    }
+
+    const double interval = m_hasGaze ? (gaze.captureTime - m_latest.captureTime) / 1e9 : 0.0;
+    if (!m_hasGaze || interval > m_settings.maxSampleInterval) {
+        // Restart velocity estimation after a gap
+        m_angularVelocity = {0, 0, 0};
+        m_eyeMovement = EyeMovement::FIXATION;
+    } else {
+        // Angular velocity from the rotation between consecutive directions
+        const glm::dvec3 previous = getDirection();
+        const glm::dvec3 current = glm::normalize(toVec3(gaze.gaze.forward));
+        const glm::dvec3 axis = glm::cross(previous, current);
+        const double sinAngle = glm::length(axis);
+        glm::dvec3 velocity{0, 0, 0};
+        if (sinAngle > 0.0) {
+            velocity = axis * (getAngle(previous, current) / (sinAngle * interval));
+        }
+
+        // Low-pass filter velocity. Filter weight depends on the interval, so irregular sampling is handled.
+        const double alpha = 1.0 - std::exp(-interval / m_settings.velocitySmoothingTime);
+        m_angularVelocity += (velocity - m_angularVelocity) * alpha;
+
+        // Classify with hysteresis, so that noise around a single threshold doesn't toggle state
+        const double speed = glm::length(m_angularVelocity);
+        if (m_eyeMovement == EyeMovement::FIXATION && speed > m_settings.saccadeOnsetSpeed) {
+            m_eyeMovement = EyeMovement::SACCADE;
+            m_saccadeStart = previous;
+            m_saccadePeakSpeed = 0.0;
+            m_saccadeDecelerating = false;
+            m_saccadeCount++;
+        } else if (m_eyeMovement == EyeMovement::SACCADE && speed < m_settings.saccadeOffsetSpeed) {
+            m_eyeMovement = EyeMovement::FIXATION;
+        }
+
+        // Track saccade peak speed from unfiltered velocity, which doesn't lag behind
+        if (m_eyeMovement == EyeMovement::SACCADE && !m_saccadeDecelerating) {
+            const double rawSpeed = glm::length(velocity);
+            if (rawSpeed >= m_saccadePeakSpeed) {
+                m_saccadePeakSpeed = rawSpeed;
+                m_saccadePeakAngle = getAngle(m_saccadeStart, current);
+            } else {
+                m_saccadeDecelerating = true;
+            }
+        }
+    }
+
+    m_latest = gaze;
+    m_hasGaze = true;
+}
+
+glm::dvec3 GazePredictor::getPredictedRotation(double time) const
+{
+    if (m_eyeMovement == EyeMovement::SACCADE) {
+        // Integral of exponentially decaying velocity
+        const double tau = m_settings.saccadeDecayTime;
+        glm::dvec3 rotation = m_angularVelocity * (tau * (1.0 - std::exp(-time / tau)));
+
+        // Don't travel past the expected landing point after the peak
+        if (m_saccadeDecelerating) {
+            const double remaining = std::max(0.0, 2.0 * m_saccadePeakAngle - getAngle(m_saccadeStart, getDirection()));
+            const double angle = glm::length(rotation);
+            if (angle > remaining) {
+                rotation *= remaining / angle;
+            }
+        }
+        return rotation;
+    }
+    return m_angularVelocity * (m_settings.fixationVelocityGain * time);
+}
+
+glm::dvec3 GazePredictor::getDirection() const { return glm::normalize(toVec3(m_latest.gaze.forward)); }
+
+varjo_Gaze GazePredictor::predict(varjo_Nanoseconds time) const
+{
+    varjo_Gaze gaze = m_latest;
+    const double predictionTime = std::clamp((time - m_latest.captureTime) / 1e9, 0.0, m_settings.maxPredictionTime);
+    const glm::dvec3 rotation = getPredictedRotation(predictionTime);
+
+    // Eyes rotate together, so the same rotation applies to the combined gaze and both eyes
+    rotate(gaze.gaze.forward, rotation);
+    rotate(gaze.leftEye.forward, rotation);
+    rotate(gaze.rightEye.forward, rotation);
+    return gaze;
+}
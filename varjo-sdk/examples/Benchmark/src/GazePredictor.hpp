@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Varjo.h>
+
+/**
+ * Predicts gaze direction ahead in time from the gaze sample stream.
+ *
+ * Each sample updates a low-pass filtered angular velocity of the gaze direction, which is used to
+ * classify eye movement as fixation or saccade with a velocity threshold with hysteresis. During
+ * fixation, slow drift and smooth pursuit are extrapolated with the filtered velocity. Saccades
+ * decelerate towards their landing point, so during a saccade the velocity is assumed to decay
+ * exponentially, which limits the predicted travel instead of overshooting the target. Saccade
+ * velocity profile is close to symmetric, so once the speed has peaked, the saccade is expected to
+ * land at twice the distance from its start to the peak, and prediction stops there.
+ *
+ * Adding a sample and predicting are constant time and don't allocate.
+ */
+class GazePredictor
+{
+public:
+    enum class EyeMovement {
+        FIXATION,
+        SACCADE,
+    };
+
+    struct Settings {
+        double saccadeOnsetSpeed = glm::radians(120.0);  // Angular speed for entering saccade in rad/s
+        double saccadeOffsetSpeed = glm::radians(60.0);  // Angular speed for leaving saccade in rad/s
+        double velocitySmoothingTime = 0.005;            // Time constant of the velocity filter in seconds
+        double fixationVelocityGain = 0.5;               // Portion of filtered velocity extrapolated during fixation
+        double saccadeDecayTime = 0.015;                 // Time constant of saccade velocity decay in seconds
+        double maxPredictionTime = 0.05;                 // Longest prediction ahead of the latest sample in seconds
+        double maxSampleInterval = 0.05;                 // Longer gaps between samples restart velocity estimation
+    };
+
+    GazePredictor();
+    explicit GazePredictor(const Settings& settings);
+
+    // Forget gaze history
+    void reset();
+
+    // Add gaze sample. Samples must be added in capture order, invalid samples reset the predictor.
+    void addSample(const varjo_Gaze& gaze);
+
+    // Returns true if a valid sample has been added since the last reset
+    bool hasGaze() const { return m_hasGaze; }
+
+    // Returns latest sample with gaze directions predicted for given time. Latest sample must be valid.
+    varjo_Gaze predict(varjo_Nanoseconds time) const;
+
+    // Returns current eye movement classification
+    EyeMovement getEyeMovement() const { return m_eyeMovement; }
+
+    // Returns filtered angular speed in rad/s
+    double getAngularSpeed() const { return glm::length(m_angularVelocity); }
+
+    // Returns number of detected saccades
+    uint64_t getSaccadeCount() const { return m_saccadeCount; }
+
+private:
+    // Returns rotation vector (axis scaled by angle) of predicted gaze movement in given time
+    glm::dvec3 getPredictedRotation(double time) const;
+
+    // Returns latest gaze direction
+    glm::dvec3 getDirection() const;
+
+    Settings m_settings;
+    bool m_hasGaze = false;
+    varjo_Gaze m_latest{};
+    glm::dvec3 m_angularVelocity = {0, 0, 0};
+    EyeMovement m_eyeMovement = EyeMovement::FIXATION;
+    glm::dvec3 m_saccadeStart = {0, 0, 1};
+    double m_saccadePeakSpeed = 0.0;
+    double m_saccadePeakAngle = 0.0;
+    bool m_saccadeDecelerating = false;
+    uint64_t m_saccadeCount = 0;
+};
@@ -0,0 +1,238 @@
+#include "GazeReplay.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+// Recorded samples further apart are not interpolated
+constexpr varjo_Nanoseconds c_maxInterpolationGap = 50'000'000;
+
+// Evaluated prediction latencies in milliseconds
+constexpr std::array<int, 6> c_latencies = {5, 10, 20, 30, 40, 50};
+
+// Longest latency on the grid of latest sample errors in milliseconds
+constexpr int c_maxGridLatency = 60;
+
+struct RecordedSample {
+    varjo_Gaze gaze;
+    glm::dvec3 direction;
+};
+
+std::vector<std::string> splitCsvLine(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+bool loadSamples(const std::string& filename, std::vector<RecordedSample>& samples)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        printf("ERROR: Failed to open gaze recording: %s\n", filename.c_str());
+        return false;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    const std::vector<std::string> header = splitCsvLine(line);
+    const auto findColumn = [&](const char* name) {
+        const auto it = std::find(header.begin(), header.end(), name);
+        return (it != header.end()) ? static_cast<int>(it - header.begin()) : -1;
+    };
+
+    const int timeColumn = findColumn("Capture raw timestamp");
+    const int statusColumn = findColumn("Status");
+    const int forwardColumn = findColumn("Gaze Forward X");
+    if (timeColumn < 0 || statusColumn < 0 || forwardColumn < 0 || findColumn("Gaze Forward Z") != forwardColumn + 2) {
+        printf("ERROR: Not a gaze recording, expected CSV output of GazeTrackingExample: %s\n", filename.c_str());
+        return false;
+    }
+    const int maxColumn = std::max({timeColumn, statusColumn, forwardColumn + 2});
+
+    while (std::getline(file, line)) {
+        const std::vector<std::string> fields = splitCsvLine(line);
+        if (static_cast<int>(fields.size()) <= maxColumn) {
+            continue;
+        }
+
+        RecordedSample sample{};
+        sample.gaze.captureTime = std::stoll(fields[timeColumn]);
+        sample.gaze.status = std::stoll(fields[statusColumn]);
+        for (int i = 0; i < 3; ++i) {
+            sample.gaze.gaze.forward[i] = std::stod(fields[forwardColumn + i]);
+        }
+
+        // Skip repeated samples, predictor expects increasing capture times
+        if (!samples.empty() && sample.gaze.captureTime <= samples.back().gaze.captureTime) {
+            continue;
+        }
+
+        sample.direction = glm::make_vec3(sample.gaze.gaze.forward);
+        if (sample.gaze.status == varjo_GazeStatus_Valid && glm::length(sample.direction) > 0.0) {
+            sample.direction = glm::normalize(sample.direction);
+        } else {
+            sample.gaze.status = varjo_GazeStatus_Invalid;
+        }
+        samples.push_back(sample);
+    }
+    return true;
+}
+
+// Finds recorded gaze direction at given time by interpolating valid neighbor samples. Cursor must not pass the time between calls.
+bool getRecordedDirection(const std::vector<RecordedSample>& samples, size_t& cursor, varjo_Nanoseconds time, glm::dvec3& direction)
+{
+    while (cursor + 1 < samples.size() && samples[cursor + 1].gaze.captureTime <= time) {
+        ++cursor;
+    }
+    if (cursor + 1 >= samples.size() || samples[cursor].gaze.captureTime > time) {
+        return false;
+    }
+
+    const RecordedSample& a = samples[cursor];
+    const RecordedSample& b = samples[cursor + 1];
+    if (a.gaze.status != varjo_GazeStatus_Valid || b.gaze.status != varjo_GazeStatus_Valid ||
+        b.gaze.captureTime - a.gaze.captureTime > c_maxInterpolationGap) {
+        return false;
+    }
+
+    const double t = static_cast<double>(time - a.gaze.captureTime) / static_cast<double>(b.gaze.captureTime - a.gaze.captureTime);
+    direction = glm::normalize(glm::mix(a.direction, b.direction, t));
+    return true;
+}
+
+double getAngleDegrees(const glm::dvec3& a, const glm::dvec3& b)
+{
+    return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+}
+
+// Returns given percentile of errors. Reorders the errors.
+double getPercentile(std::vector<double>& errors, double percentile)
+{
+    if (errors.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(errors.size() - 1, static_cast<size_t>(percentile * errors.size()));
+    std::nth_element(errors.begin(), errors.begin() + index, errors.end());
+    return errors[index];
+}
+
+varjo_Nanoseconds toNanoseconds(int milliseconds) { return static_cast<varjo_Nanoseconds>(milliseconds) * 1'000'000; }
+}  // namespace
+
+bool runGazeReplay(const std::string& filename, const GazePredictor::Settings& settings)
+{
+    std::vector<RecordedSample> samples;
+    if (!loadSamples(filename, samples)) {
+        return false;
+    }
+    if (samples.size() < 2) {
+        printf("ERROR: Gaze recording has too few samples: %s\n", filename.c_str());
+        return false;
+    }
+
+    // Error of the latest sample on a latency grid, for finding latency with the same error as prediction
+    std::vector<std::vector<double>> latestErrors(c_maxGridLatency + 1);
+    std::vector<size_t> gridCursors(latestErrors.size(), 0);
+
+    std::array<std::vector<double>, c_latencies.size()> predictedErrors;
+    std::array<std::vector<double>, c_latencies.size()> saccadeLatestErrors;
+    std::array<std::vector<double>, c_latencies.size()> saccadePredictedErrors;
+    std::array<size_t, c_latencies.size()> cursors{};
+
+    GazePredictor predictor(settings);
+    std::chrono::nanoseconds predictorTime{0};
+    size_t predictorCalls = 0;
+
+    for (const RecordedSample& sample : samples) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        predictor.addSample(sample.gaze);
+        predictorTime += std::chrono::high_resolution_clock::now() - start;
+        ++predictorCalls;
+
+        if (!predictor.hasGaze()) {
+            continue;
+        }
+
+        const varjo_Nanoseconds time = sample.gaze.captureTime;
+        glm::dvec3 recorded;
+        for (size_t i = 0; i < latestErrors.size(); ++i) {
+            if (getRecordedDirection(samples, gridCursors[i], time + toNanoseconds(static_cast<int>(i)), recorded)) {
+                latestErrors[i].push_back(getAngleDegrees(sample.direction, recorded));
+            }
+        }
+
+        const bool saccade = predictor.getEyeMovement() == GazePredictor::EyeMovement::SACCADE;
+        for (size_t i = 0; i < c_latencies.size(); ++i) {
+            const varjo_Nanoseconds targetTime = time + toNanoseconds(c_latencies[i]);
+            if (!getRecordedDirection(samples, cursors[i], targetTime, recorded)) {
+                continue;
+            }
+
+            const auto predictStart = std::chrono::high_resolution_clock::now();
+            const varjo_Gaze predicted = predictor.predict(targetTime);
+            predictorTime += std::chrono::high_resolution_clock::now() - predictStart;
+            ++predictorCalls;
+
+            const double predictedError = getAngleDegrees(glm::normalize(glm::make_vec3(predicted.gaze.forward)), recorded);
+            predictedErrors[i].push_back(predictedError);
+            if (saccade) {
+                saccadeLatestErrors[i].push_back(getAngleDegrees(sample.direction, recorded));
+                saccadePredictedErrors[i].push_back(predictedError);
+            }
+        }
+    }
+
+    std::vector<double> latestP95(latestErrors.size());
+    for (size_t i = 0; i < latestErrors.size(); ++i) {
+        latestP95[i] = getPercentile(latestErrors[i], 0.95);
+    }
+
+    const double duration = (samples.back().gaze.captureTime - samples.front().gaze.captureTime) / 1e9;
+    printf("Gaze replay: %s\n", filename.c_str());
+    printf("  Samples: %zu, duration %.1f s, %.0f Hz, saccades %llu\n", samples.size(), duration, (samples.size() - 1) / duration,
+        static_cast<unsigned long long>(predictor.getSaccadeCount()));
+    printf("  Predictor cost: %.0f ns per call\n", static_cast<double>(predictorTime.count()) / predictorCalls);
+    printf("  Errors in degrees as p50 / p95 / p99, latency reduction from p95 error\n");
+    printf("  %7s | %-22s | %-22s | %-22s | %-22s | %s\n", "Latency", "Latest", "Predicted", "Saccade latest", "Saccade predicted", "Reduction");
+
+    for (size_t i = 0; i < c_latencies.size(); ++i) {
+        const int latency = c_latencies[i];
+        std::vector<double>& latest = latestErrors[latency];
+        const double predictedP95 = getPercentile(predictedErrors[i], 0.95);
+
+        // Find latency where the latest sample has the same error as prediction
+        double equivalentLatency = c_maxGridLatency;
+        for (size_t l = 1; l < latestP95.size(); ++l) {
+            if (latestP95[l] >= predictedP95) {
+                const double range = latestP95[l] - latestP95[l - 1];
+                equivalentLatency = (l - 1) + ((range > 0.0) ? std::clamp((predictedP95 - latestP95[l - 1]) / range, 0.0, 1.0) : 0.0);
+                break;
+            }
+        }
+        if (predictedP95 <= latestP95[0]) {
+            equivalentLatency = 0.0;
+        }
+
+        const auto format = [](std::vector<double>& errors) {
+            char text[64];
+            snprintf(text, sizeof(text), "%.2f / %.2f / %.2f", getPercentile(errors, 0.5), getPercentile(errors, 0.95), getPercentile(errors, 0.99));
+            return std::string(text);
+        };
+        printf("  %4d ms | %-22s | %-22s | %-22s | %-22s | %+.1f ms\n", latency, format(latest).c_str(), format(predictedErrors[i]).c_str(),
+            format(saccadeLatestErrors[i]).c_str(), format(saccadePredictedErrors[i]).c_str(), latency - equivalentLatency);
+    }
+    return true;
+}
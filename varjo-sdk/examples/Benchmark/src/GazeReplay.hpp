@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "GazePredictor.hpp"
+
+/**
+ * Replays recorded gaze through GazePredictor and prints prediction error against latency.
+ *
+ * Gaze is read from a CSV file recorded with GazeTrackingExample (--output). For each sample, gaze is
+ * predicted a range of latencies ahead and compared to the recorded gaze at that time, and the error is
+ * compared to using the latest sample as is. Latency reduction tells how much latency using the latest
+ * sample could have for the same 95th percentile error, which is the margin foveation has to cover.
+ *
+ * Returns false if the file could not be read.
+ */
+bool runGazeReplay(const std::string& filename, const GazePredictor::Settings& settings);
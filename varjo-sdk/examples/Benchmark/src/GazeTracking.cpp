@@ -41,8 +41,9 @@ std::string getCurrentTimestamp()
 }
 }  // namespace
 
-GazeTracking::GazeTracking(varjo_Session* session)
+GazeTracking::GazeTracking(varjo_Session* session, bool usePrediction)
     : m_session(session)
+    , m_usePrediction(usePrediction)
 {
 }
 
@@ -77,8 +78,9 @@ void GazeTracking::requestCalibration()
     varjo_RequestGazeCalibration(m_session);
 }
 
-bool GazeTracking::update()
+bool GazeTracking::update(varjo_Nanoseconds displayTime)
 {
+    m_predictedGaze.reset();
     if (!m_initialized) return false;
 
     varjo_SyncProperties(m_session);
@@ -104,8 +106,22 @@ bool GazeTracking::update()
     }
 
     // Get gaze and check that it is valid
-    varjo_Gaze gaze = varjo_GetGaze(m_session);
-    if (gaze.status == varjo_GazeStatus_Invalid) return false;
+    varjo_Gaze gaze{};
+    if (m_usePrediction) {
+        // Feed all samples since the previous frame to the predictor in capture order
+        const int32_t count = varjo_GetGazeArray(m_session, m_gazeSamples.data(), c_maxGazeSamples);
+        const bool newestFirst = count > 1 && m_gazeSamples[0].captureTime > m_gazeSamples[count - 1].captureTime;
+        for (int32_t i = 0; i < count; ++i) {
+            m_predictor.addSample(m_gazeSamples[newestFirst ? count - 1 - i : i]);
+        }
+        if (!m_predictor.hasGaze()) return false;
+
+        gaze = m_predictor.predict(displayTime);
+        m_predictedGaze = gaze;
+    } else {
+        gaze = varjo_GetGaze(m_session);
+        if (gaze.status == varjo_GazeStatus_Invalid) return false;
+    }
 
     // Calculate relative gaze vector
     glm::vec3 dir = glm::make_vec3(gaze.gaze.forward);
@@ -1,23 +1,39 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include <glm/glm.hpp>
 #include <Varjo.h>
 
+#include "GazePredictor.hpp"
+
 class GazeTracking
 {
 public:
-    GazeTracking(varjo_Session* session);
+    // With prediction enabled, all gaze samples are fed to GazePredictor and gaze is predicted for the display time
+    GazeTracking(varjo_Session* session, bool usePrediction = false);
 
     void init();
     void requestCalibration();
 
-    bool update();
+    bool update(varjo_Nanoseconds displayTime);
     glm::vec3 getPosition() const { return m_position; }
 
+    // Returns gaze predicted for the display time of the latest update, if prediction is enabled and gaze is valid
+    const std::optional<varjo_Gaze>& getPredictedGaze() const { return m_predictedGaze; }
+
 protected:
     varjo_Session* m_session = nullptr;
     bool m_initialized = false;
     glm::dvec3 m_position = {0, 0, 0};
     bool m_calibrating = false;
     bool m_calibrated = false;
+
+    // Runtime keeps gaze samples for 500ms, which is 100 samples at 200Hz
+    static constexpr int32_t c_maxGazeSamples = 256;
+
+    bool m_usePrediction = false;
+    GazePredictor m_predictor;
+    std::array<varjo_Gaze, c_maxGazeSamples> m_gazeSamples{};
+    std::optional<varjo_Gaze> m_predictedGaze;
 };
@@ -1,12 +1,9 @@
 #pragma once
 
 #include <cstdint>
-#include <GL/glew.h>
-#include <d3d11.h>
+#include <vector>
 #include <glm/vec3.hpp>
 
-class D3D11Renderer;
-
 /**
  * Geometry that has positions and normals.
  */
@@ -18,6 +15,12 @@ public:
         glm::vec3 normal;
     };
 
+    // Simplified mesh for software occlusion culling. Must be inside the rendered geometry.
+    struct OccluderMesh {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+
     Geometry(uint32_t vertexCount, uint32_t indexCount);
     virtual ~Geometry();
 
@@ -29,45 +32,20 @@ public:
 
     uint32_t indexCount() const { return m_indexCount; }
 
-protected:
-    uint32_t m_vertexCount;
-    uint32_t m_indexCount;
-};
+    // Radius of a sphere around the origin that contains all vertices. Negative when unknown, such geometry is never culled.
+    float boundingRadius() const { return m_boundingRadius; }
+    void setBoundingRadius(float radius) { m_boundingRadius = radius; }
 
-class D3D11Geometry : public Geometry
-{
-public:
-    D3D11Geometry(D3D11Renderer* renderer, uint32_t vertexCount, uint32_t indexCount);
-    ~D3D11Geometry();
+    // Set bounding radius from vertex positions
+    void setBoundingRadius(const Vertex* vertices, uint32_t vertexCount);
 
-    void updateVertexBuffer(void* data) override;
-    void updateIndexBuffer(void* data) override;
+    // Occluder mesh, empty if the geometry doesn't occlude other objects
+    const OccluderMesh& occluderMesh() const { return m_occluderMesh; }
+    void setOccluderMesh(OccluderMesh mesh) { m_occluderMesh = std::move(mesh); }
 
-    ID3D11Buffer* vertexBuffer() const { return m_vertexBuffer; }
-    ID3D11Buffer* indexBuffer() const { return m_indexBuffer; }
-
-private:
-    ID3D11Buffer* m_vertexBuffer;
-    ID3D11Buffer* m_indexBuffer;
-    D3D11Renderer* m_renderer;
-};
-
-class GLGeometry : public Geometry
-{
-public:
-    GLGeometry(uint32_t vertexCount, uint32_t indexCount);
-    ~GLGeometry();
-
-    void updateVertexBuffer(void* data) override;
-    void updateIndexBuffer(void* data) override;
-
-    GLuint vao() const { return m_vao; }
-    GLuint indexBuffer() const { return m_indexBuffer; }
-
-private:
-    void copyToBuffer(GLuint buffer, void* data, int32_t size);
-
-    GLuint m_vao;
-    GLuint m_vertexBuffer;
-    GLuint m_indexBuffer;
+protected:
+    uint32_t m_vertexCount;
+    uint32_t m_indexCount;
+    float m_boundingRadius{-1.0f};
+    OccluderMesh m_occluderMesh;
 };
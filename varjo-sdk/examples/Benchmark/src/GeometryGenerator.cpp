@@ -66,6 +66,7 @@ std::shared_ptr<Geometry> GeometryGenerator::generateCube(std::shared_ptr<IRende
     std::shared_ptr<Geometry> geometry = renderer->createGeometry(static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()));
     geometry->updateVertexBuffer(vertices.data());
     geometry->updateIndexBuffer(indices.data());
+    geometry->setBoundingRadius(vertices.data(), static_cast<uint32_t>(vertices.size()));
     return geometry;
 }
 
@@ -151,5 +152,45 @@ std::shared_ptr<Geometry> GeometryGenerator::generateDonut(
     std::shared_ptr<Geometry> geometry = renderer->createGeometry(vertexCount, indexCount);
     geometry->updateVertexBuffer(vertices.data());
     geometry->updateIndexBuffer(indices.data());
+    geometry->setBoundingRadius(vertices.data(), vertexCount);
+    geometry->setOccluderMesh(generateDonutOccluder(radius, thickness, 16, 6));
     return geometry;
 }
+
+Geometry::OccluderMesh GeometryGenerator::generateDonutOccluder(float radius, float thickness, int32_t segments, int32_t tessellation)
+{
+    segments = std::max(3, segments);
+    tessellation = std::max(3, tessellation);
+
+    // Flat faces between ring segments cut inwards by at most the sagitta of the outer ring. Shrinking the tube by
+    // that keeps all faces inside the donut. Tube polygon vertices are on the shrunk tube, so its faces are inside too.
+    const float halfThickness = thickness * 0.5f;
+    const float ringRadius = radius - halfThickness;
+    const float sagitta = radius * (1.0f - std::cos(static_cast<float>(M_PI) / static_cast<float>(segments)));
+    const float tubeRadius = std::max(0.0f, halfThickness - sagitta);
+
+    Geometry::OccluderMesh mesh;
+    mesh.positions.reserve(segments * tessellation);
+    mesh.indices.reserve(segments * tessellation * 6);
+
+    for (int i = 0; i < segments; ++i) {
+        const float segmentAngle = static_cast<float>(M_PI * 2.0f) * static_cast<float>(i) / static_cast<float>(segments);
+        for (int ti = 0; ti < tessellation; ++ti) {
+            const float tubeAngle = static_cast<float>(M_PI * 2.0f) * static_cast<float>(ti) / static_cast<float>(tessellation);
+            const glm::vec3 position{0.0f, tubeRadius * std::sin(tubeAngle), ringRadius + tubeRadius * std::cos(tubeAngle)};
+            mesh.positions.push_back(glm::rotateY(position, segmentAngle));
+        }
+    }
+
+    for (int i = 0; i < segments; ++i) {
+        const uint32_t segment0 = i * tessellation;
+        const uint32_t segment1 = ((i + 1) % segments) * tessellation;
+        for (int ti = 0; ti < tessellation; ++ti) {
+            const uint32_t t0 = ti;
+            const uint32_t t1 = (ti + 1) % tessellation;
+            mesh.indices.insert(mesh.indices.end(), {segment0 + t0, segment1 + t0, segment1 + t1, segment0 + t0, segment1 + t1, segment0 + t1});
+        }
+    }
+
+    return mesh;
+}
@@ -7,4 +7,7 @@ class GeometryGenerator
 public:
     static std::shared_ptr<Geometry> generateCube(std::shared_ptr<IRenderer> renderer, float width, float height, float depth);
     static std::shared_ptr<Geometry> generateDonut(std::shared_ptr<IRenderer> renderer, float radius, float thickness, int32_t segments, int32_t tessellation);
+
+    // Low polygon donut that fits inside the donut of the same radius and thickness, used as an occluder
+    static Geometry::OccluderMesh generateDonutOccluder(float radius, float thickness, int32_t segments, int32_t tessellation);
 };
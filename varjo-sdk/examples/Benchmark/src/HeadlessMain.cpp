@@ -0,0 +1,221 @@
+/**
+ * Varjo SDK example.
+ *
+ * HeadlessMain.cpp:
+ *      Contains the frame loop of BenchmarkHeadless, which runs the Benchmark
+ *      scene with the null renderer without a GPU or a Varjo runtime.
+ *
+ *      CPU side of the frame (animation, world matrices, culling and
+ *      submission bookkeeping) is the same as in Benchmark --renderer null,
+ *      so it can be profiled on build and CI machines.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "BenchmarkCommon.hpp"
+#include "GazeReplay.hpp"
+#include "NullRenderer.hpp"
+#include "ObjectStore.hpp"
+#include "Profiler.hpp"
+
+namespace
+{
+std::atomic_bool s_shouldExit = false;
+
+void signalHandler(int /*signal*/) { s_shouldExit = true; }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    // Exit gracefully, when Ctrl-C signal is received
+    std::signal(SIGINT, signalHandler);
+
+    cxxopts::Options options("BenchmarkHeadless",
+        "Varjo Benchmark Test Client without GPU and Varjo runtime\n"  //
+        "(C) 2019-2020 Varjo Technologies");
+
+    options.add_options()                                                                                                                           //
+        ("disable-animation", "Disable all animation")                                                                                              //
+        ("disable-vr-scene", "Disable drawing of the donuts and the background grid")                                                               //
+        ("profile-start-frame", "Start profiling after the given frame number", cxxopts::value<int>()->default_value("0"))                          //
+        ("profile-frame-count", "Number of frames to profile for. Exits after all frames are profiled", cxxopts::value<int>()->default_value("0"))  //
+        ("fps", "Print fps count")                                                                                                                  //
+        ("gaze-replay", "Replay gaze CSV recorded with GazeTrackingExample through gaze predictor and exit", cxxopts::value<std::string>())         //
+        ("use-depth", "Enable layer depth buffer")                                                                                                  //
+        ("stereo", "Uses two big textures instead of four. Focus area is cropped from the texture")                                                 //
+        ("use-velocity", "Enable layer velocity buffer (requires depth)")                                                                           //
+        ("use-foveation", "Use dynamic viewport foveation")                                                                                         //
+        ("max-donuts", "Maximum number of donuts allowed to render", cxxopts::value<int>()->default_value("100000"))                                //
+        ("object-simd", "Instruction set for donut transforms. Defaults to best supported. Allowed options: <scalar|avx2|avx512>",                  //
+            cxxopts::value<std::string>())                                                                                                          //
+        ("worker-threads", "Worker threads for world matrices in addition to the render thread. Defaults to CPU count - 1", cxxopts::value<int>())  //
+        ("frustum-culling", "Cull instances outside of each view on the CPU before uploading and drawing them")                                     //
+        ("occlusion-culling", "Cull instances hidden behind nearer donuts with a software depth buffer. Enables --frustum-culling")                 //
+        ("help", "Display help info");
+
+    try {
+        auto arguments = options.parse(argc, argv);
+
+        if (arguments.count("help")) {
+            std::cout << options.help();
+            return EXIT_SUCCESS;
+        }
+
+        if (arguments.count("gaze-replay")) {
+            return runGazeReplay(arguments["gaze-replay"].as<std::string>(), GazePredictor::Settings{}) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        bool useDepth = arguments.count("use-depth");
+        bool disableAnimation = arguments.count("disable-animation");
+        bool disableVRScene = arguments.count("disable-vr-scene");
+        bool enableProfiling = arguments.count("profile-start-frame") && arguments.count("profile-frame-count");
+        bool printFps = arguments.count("fps");
+        bool useStereo = arguments.count("stereo");
+        bool useVelocity = arguments.count("use-velocity");
+        bool useDynamicViewports = arguments.count("use-foveation");
+        bool useFrustumCulling = arguments.count("frustum-culling");
+        bool useOcclusionCulling = arguments.count("occlusion-culling");
+        int maxDonuts = arguments["max-donuts"].as<int>();
+        int workerThreads = arguments.count("worker-threads") ? arguments["worker-threads"].as<int>()
+                                                              : static_cast<int>(VarjoExamples::WorkerPool::getDefaultThreadCount());
+        std::string objectSimdName =
+            arguments.count("object-simd") ? arguments["object-simd"].as<std::string>() : ObjectStore::getSimdLevelName(ObjectStore::getSupportedSimdLevel());
+
+        if (useVelocity && disableAnimation) {
+            printf("Disabling velocity. --use-velocity requires animation.\n");
+            useVelocity = false;
+        }
+        if (useVelocity && !useDepth) {
+            printf("Force enabling depth. --use-velocity is not expected to work without depth.\n");
+            useDepth = true;
+        }
+        if (useOcclusionCulling && !useFrustumCulling) {
+            printf("Force enabling frustum culling. --occlusion-culling culls the instances left by frustum culling.\n");
+            useFrustumCulling = true;
+        }
+
+        printf("Startup params:\n");
+        printf("  Use depth: %s\n", useDepth ? "enabled" : "disabled");
+        printf("  Animation: %s\n", disableAnimation ? "disabled" : "enabled");
+        printf("  Profiling: %s\n", enableProfiling ? "enabled" : "disabled");
+        printf("  Use velocity: %s\n", useVelocity ? "enabled" : "disabled");
+        printf("  Worker threads: %d\n", workerThreads);
+        printf("  Frustum culling: %s\n", useFrustumCulling ? "enabled" : "disabled");
+        printf("  Occlusion culling: %s\n", useOcclusionCulling ? "enabled" : "disabled");
+
+        int32_t profileStartFrame = arguments["profile-start-frame"].as<int>();
+        int32_t profileFrameCount = arguments["profile-frame-count"].as<int>();
+
+        if (enableProfiling) {
+            printf("Profile:\n");
+            printf("  Start frame: %d\n", profileStartFrame);
+            printf("  Frame count: %d\n", profileFrameCount);
+        }
+
+        ObjectStore::SimdLevel objectSimdLevel = ObjectStore::SimdLevel::SCALAR;
+        if (objectSimdName == "scalar") {
+            objectSimdLevel = ObjectStore::SimdLevel::SCALAR;
+        } else if (objectSimdName == "avx2") {
+            objectSimdLevel = ObjectStore::SimdLevel::AVX2;
+        } else if (objectSimdName == "avx512") {
+            objectSimdLevel = ObjectStore::SimdLevel::AVX512;
+        } else {
+            printf("ERROR: Unknown object SIMD level: %s\n", objectSimdName.c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        Profiler profiler;
+
+        // No VST, gaze, stencil, SLI, VRS or mirror window without a runtime and a GPU
+        RendererSettings rendererSettings{useDepth, false, false, useStereo, false, varjo_DepthTextureFormat_D32_FLOAT, false, false, false,
+            useDynamicViewports, false, false, false, useVelocity, false, false};
+        rendererSettings.setUseFrustumCulling(useFrustumCulling);
+        rendererSettings.setUseOcclusionCulling(useOcclusionCulling);
+
+        std::shared_ptr<IRenderer> renderer = std::make_shared<NullRenderer>(nullptr, rendererSettings);
+        renderer->setWorkerThreadCount(static_cast<size_t>((std::max)(workerThreads, 0)));
+        if (!renderer->init()) {
+            exit(EXIT_FAILURE);
+        }
+
+        std::unique_ptr<ObjectStore> donutObjects = createObjects(renderer, disableAnimation, maxDonuts);
+        donutObjects->setSimdLevel(objectSimdLevel);
+        printf("  Object SIMD: %s\n", ObjectStore::getSimdLevelName(donutObjects->simdLevel()));
+
+        varjo_FrameInfo* frameInfo = renderer->createFrameInfo();
+        varjo_Nanoseconds lastFrameTime = 0;
+        int32_t frameNumber = 0;
+
+        while (!s_shouldExit) {
+            // Null renderer paces frames to the display rate like the runtime does
+            renderer->waitSync(frameInfo);
+
+            if (enableProfiling && frameNumber >= profileStartFrame) {
+                profiler.addSample();
+
+                if (profiler.sampleCount() == 0) {
+                    printf("Start profiling.\n");
+                }
+            }
+
+            float time = lastFrameTime ? (frameInfo->displayTime - lastFrameTime) / 1000000000.0f : 0.0f;
+
+            // Count FPS if enabled
+            if (printFps) {
+                profiler.updateFps();
+            }
+
+            // Rotate objects
+            donutObjects->applyVelocity(time);
+
+            std::vector<IRenderer::Object> gazeObjects;
+            std::vector<std::vector<IRenderer::Object>*> instancedObjects;
+            instancedObjects.push_back(&gazeObjects);
+            std::vector<const ObjectStore*> instancedObjectStores;
+            if (!disableVRScene) {
+                instancedObjectStores.push_back(donutObjects.get());
+            }
+
+            renderer->render(frameInfo, instancedObjects, instancedObjectStores, {}, disableVRScene);
+
+            if (enableProfiling) {
+                setProfilerFrameStats(profiler, *renderer, useFrustumCulling, useOcclusionCulling);
+            }
+
+            lastFrameTime = frameInfo->displayTime;
+            frameNumber++;
+
+            if (enableProfiling && profiler.sampleCount() == profileFrameCount) {
+                printf("Profiling finished.\n");
+                break;
+            }
+        }
+
+        if (enableProfiling) {
+            profiler.exportCSV("frame_times.csv");
+            profiler.exportStatsCSV("frame_stats.csv");
+        }
+
+        renderer->finishRendering();
+        renderer->freeVarjoResources();
+        renderer->freeFrameInfo(frameInfo);
+
+        // Clean up geometry before shutting down the renderer
+        donutObjects.reset();
+        renderer.reset();
+    } catch (const std::exception& e) {
+        std::cerr << e.what();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
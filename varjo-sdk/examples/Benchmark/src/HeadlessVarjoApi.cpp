@@ -0,0 +1,59 @@
+// Varjo API for BenchmarkHeadless, which runs the null renderer without a Varjo runtime.
+//
+// Link this instead of VarjoLib and build with VARJORUNTIME_STATIC. Renderer base class calls these
+// functions only with a session, and the null renderer overrides them for the sessionless case, so
+// reaching any of them is a bug. Only the functions referenced by the renderer sources are provided.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <Varjo.h>
+#include <Varjo_layers.h>
+
+namespace
+{
+[[noreturn]] void unavailable(const char* function)
+{
+    fprintf(stderr, "ERROR: %s called, Varjo runtime is not available in BenchmarkHeadless.\n", function);
+    std::abort();
+}
+}  // namespace
+
+extern "C" {
+
+int32_t varjo_GetViewCount(struct varjo_Session*) { unavailable(__func__); }
+
+struct varjo_ViewDescription varjo_GetViewDescription(struct varjo_Session*, int32_t) { unavailable(__func__); }
+
+void varjo_GetTextureSize(struct varjo_Session*, varjo_TextureSize_Type, int32_t, int32_t*, int32_t*) { unavailable(__func__); }
+
+varjo_Bool varjo_GetRenderingGaze(struct varjo_Session*, struct varjo_Gaze*) { unavailable(__func__); }
+
+struct varjo_FovTangents varjo_GetFoveatedFovTangents(struct varjo_Session*, int32_t, struct varjo_Gaze*, struct varjo_FoveatedFovTangents_Hints*)
+{
+    unavailable(__func__);
+}
+
+struct varjo_FovTangents varjo_GetFovTangents(struct varjo_Session*, int32_t) { unavailable(__func__); }
+
+struct varjo_FrameInfo* varjo_CreateFrameInfo(struct varjo_Session*) { unavailable(__func__); }
+
+void varjo_FreeFrameInfo(struct varjo_FrameInfo*) { unavailable(__func__); }
+
+void varjo_WaitSync(struct varjo_Session*, struct varjo_FrameInfo*) { unavailable(__func__); }
+
+void varjo_BeginFrameWithLayers(struct varjo_Session*) { unavailable(__func__); }
+
+void varjo_EndFrameWithLayers(struct varjo_Session*, struct varjo_SubmitInfoLayers*) { unavailable(__func__); }
+
+struct varjo_Texture varjo_GetSwapChainImage(struct varjo_SwapChain*, int32_t) { unavailable(__func__); }
+
+void varjo_AcquireSwapChainImage(struct varjo_SwapChain*, int32_t*) { unavailable(__func__); }
+
+void varjo_ReleaseSwapChainImage(struct varjo_SwapChain*) { unavailable(__func__); }
+
+void varjo_FreeSwapChain(struct varjo_SwapChain*) { unavailable(__func__); }
+
+void varjo_SetMirrorConfig(struct varjo_Session*, struct varjo_MirrorView*, uint32_t) { unavailable(__func__); }
+
+}  // extern "C"
@@ -2,8 +2,15 @@
 #include <stdio.h>
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <numeric>
 
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <Varjo_layers.h>
@@ -11,6 +18,8 @@
 
 #include "IRenderer.hpp"
 #include "GeometryGenerator.hpp"
+#include "ObjectStore.hpp"
+#include "OcclusionCuller.hpp"
 
 namespace
 {
@@ -24,6 +33,7 @@ glm::mat4 doubleMatrixToGLMMatrix(const double* dMatrix)
     return result;
 }
 
+#ifdef _WIN32
 const char* getErrorMsg(const unsigned long error)
 {
     static char buffer[MAX_PATH];
@@ -51,6 +61,57 @@ const char* getErrorMsg(const unsigned long error)
 
     return buffer;
 }
+#endif
+
+// Returns orientation rotated by angular velocity over given time
+glm::quat getRotatedOrientation(const glm::quat& orientation, const IRenderer::ObjectVelocity& velocity, float timeDeltaSec)
+{
+    if (std::abs(velocity.rotationSpeed) <= std::numeric_limits<float>::epsilon()) {
+        return orientation;
+    }
+
+    glm::quat rot = glm::angleAxis(velocity.rotationSpeed * timeDeltaSec, velocity.rotationAxis);
+    return glm::normalize(orientation * rot);
+}
+
+glm::mat4 getWorldMatrix(const IRenderer::Object& object, const glm::quat& orientation)
+{
+    glm::mat4 matrix = glm::toMat4(orientation);
+    matrix[3][0] = object.position.x;
+    matrix[3][1] = object.position.y;
+    matrix[3][2] = object.position.z;
+    return glm::scale(matrix, object.scale);
+}
+
+// Extract side planes of the frustum from a view projection matrix. Plane normals are normalized and point inside.
+void getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[4])
+{
+    const glm::mat4 m = glm::transpose(viewProjection);
+    planes[0] = m[3] + m[0];  // Left
+    planes[1] = m[3] - m[0];  // Right
+    planes[2] = m[3] + m[1];  // Bottom
+    planes[3] = m[3] - m[1];  // Top
+    for (int i = 0; i < 4; ++i) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+// Returns radius of the bounding sphere of geometry transformed with the world matrix
+float getBoundingSphereRadius(const glm::mat4& world, float geometryRadius)
+{
+    const float scaleSq = (std::max)({glm::dot(world[0], world[0]), glm::dot(world[1], world[1]), glm::dot(world[2], world[2])});
+    return geometryRadius * std::sqrt(scaleSq);
+}
+
+bool isSphereVisible(const glm::vec4 planes[4], const glm::vec3& center, float radius)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
 
 void setToIdentityMatrix(double* m)
 {
@@ -102,18 +163,29 @@ void RenderTargetTextures::reset()
 
 void IRenderer::applyObjectVelocity(Object& object, float timeDeltaSec)
 {
-    if (std::abs(object.velocity.rotationSpeed) <= std::numeric_limits<float>::epsilon()) {
-        return;
-    }
-
-    glm::quat rot = glm::angleAxis(object.velocity.rotationSpeed * timeDeltaSec, object.velocity.rotationAxis);
-    object.orientation = glm::normalize(object.orientation * rot);
+    object.orientation = getRotatedOrientation(object.orientation, object.velocity, timeDeltaSec);
 }
 
 IRenderer::IRenderer(varjo_Session* session, const RendererSettings& renderer_settings)
     : m_session(session)
     , m_settings(renderer_settings)
+    , m_workerPool(std::make_unique<VarjoExamples::WorkerPool>(0))
+{
+    // Task is created once, so that running it every frame doesn't allocate
+    m_worldMatrixTask = [this](std::size_t batchIndex) { calculateWorldMatrices(m_worldMatrixBatches[batchIndex]); };
+    m_cullTask = [this](std::size_t taskIndex) {
+        cullInstanceGroup(taskIndex / m_instanceGroupDrawInfos.size(), taskIndex % m_instanceGroupDrawInfos.size());
+    };
+    m_occlusionTask = [this](std::size_t viewIndex) { cullOccludedInstances(viewIndex); };
+}
+
+IRenderer::~IRenderer() = default;
+
+void IRenderer::setWorkerThreadCount(std::size_t threadCount)
 {
+    if (threadCount != m_workerPool->getThreadCount()) {
+        m_workerPool = std::make_unique<VarjoExamples::WorkerPool>(threadCount);
+    }
 }
 
 bool IRenderer::init()
@@ -176,13 +248,13 @@ bool IRenderer::init()
 
 std::vector<varjo_Viewport> IRenderer::calculateViewports(varjo_TextureSize_Type type) const
 {
-    const int32_t viewCount = type == varjo_TextureSize_Type_Stereo ? 2 : varjo_GetViewCount(m_session);
+    const int32_t viewCount = type == varjo_TextureSize_Type_Stereo ? 2 : getViewCount();
     std::vector<varjo_Viewport> viewports;
     viewports.reserve(viewCount);
     int x = 0, y = 0;
     for (int32_t i = 0; i < viewCount; i++) {
         int32_t width = 0, height = 0;
-        varjo_GetTextureSize(m_session, type, i, &width, &height);
+        getTextureSize(type, i, width, height);
         width = (std::min)((std::max)(256, width), 8096);
         height = (std::min)((std::max)(256, height), 8096);
 #ifndef _WIN64
@@ -205,37 +277,212 @@ std::vector<varjo_Viewport> IRenderer::calculateViewports(varjo_TextureSize_Type
 
 const varjo_Viewport& IRenderer::getActiveViewport(int32_t viewIndex) const { return getActiveViewports()[viewIndex]; }
 
-void IRenderer::calculateWorldMatrices(std::vector<IRenderer::ObjectRenderData>& worldMatrices, const std::vector<IRenderer::Object>& objects)
+void IRenderer::addWorldMatrixBatches(int32_t groupIndex, const ObjectStore* objectStore, const Object* objects, std::size_t objectCount)
 {
-    worldMatrices.resize(objects.size());
+    std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[groupIndex];
+    worldMatrices.resize(objectCount);
 
-    const size_t numObjects = objects.size();
-    for (size_t i = 0; i < numObjects; ++i) {
-        const IRenderer::Object& object = objects[i];
+    for (std::size_t begin = 0; begin < objectCount; begin += c_worldMatrixBatchSize) {
+        const std::size_t end = (std::min)(begin + c_worldMatrixBatchSize, objectCount);
+        m_worldMatrixBatches.push_back({objectStore, objects, worldMatrices.data() + begin, begin, end});
+    }
+}
 
-        glm::mat4 matrix = glm::toMat4(object.orientation);
-        matrix[3][0] = object.position.x;
-        matrix[3][1] = object.position.y;
-        matrix[3][2] = object.position.z;
-        matrix = glm::scale(matrix, object.scale);
+void IRenderer::calculateWorldMatrices(const WorldMatrixBatch& batch) const
+{
+    if (batch.objectStore) {
+        batch.objectStore->calculateWorldMatrices(batch.worldMatrices, batch.begin, batch.end, m_settings.useVelocity(), c_velocityTimeDelta);
+        return;
+    }
 
-        worldMatrices[i].world = matrix;
+    ObjectRenderData* worldMatrices = batch.worldMatrices;
+    for (size_t i = batch.begin; i < batch.end; ++i, ++worldMatrices) {
+        const IRenderer::Object& object = batch.objects[i];
+
+        worldMatrices->world = getWorldMatrix(object, object.orientation);
 
         if (m_settings.useVelocity()) {
-            IRenderer::Object nextFrameObject = object;
-            applyObjectVelocity(nextFrameObject, c_velocityTimeDelta);
+            // Only the orientation changes, so the object itself is not copied
+            worldMatrices->nextFrameWorld = getWorldMatrix(object, getRotatedOrientation(object.orientation, object.velocity, c_velocityTimeDelta));
+        } else {
+            worldMatrices->nextFrameWorld = worldMatrices->world;
+        }
+    }
+}
 
-            glm::mat4 nextFrameMatrix = glm::toMat4(nextFrameObject.orientation);
-            nextFrameMatrix[3][0] = nextFrameObject.position.x;
-            nextFrameMatrix[3][1] = nextFrameObject.position.y;
-            nextFrameMatrix[3][2] = nextFrameObject.position.z;
-            nextFrameMatrix = glm::scale(nextFrameMatrix, nextFrameObject.scale);
+void IRenderer::cullInstances(const varjo_FrameInfo* frameInfo)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
 
-            worldMatrices[i].nextFrameWorld = nextFrameMatrix;
-        } else {
-            worldMatrices[i].nextFrameWorld = matrix;
+    m_viewFrustums.resize(m_viewCount);
+    for (uint32_t i = 0; i < m_viewCount; ++i) {
+        ViewFrustum& frustum = m_viewFrustums[i];
+        frustum.enabled = frameInfo->views[i].enabled;
+        if (frustum.enabled) {
+            const glm::mat4 viewMatrix = doubleMatrixToGLMMatrix(frameInfo->views[i].viewMatrix);
+            const glm::mat4 projectionMatrix = doubleMatrixToGLMMatrix(m_projectionMatrices[i].value);
+            frustum.viewProjection = projectionMatrix * viewMatrix;
+            getFrustumPlanes(frustum.viewProjection, frustum.planes);
+        }
+    }
+
+    // Lists of groups without draw info stay empty. Buffers keep their capacity between frames.
+    const std::size_t listCount = m_viewCount * m_objectWorldMatrices.size();
+    m_visibleIndices.resize(listCount);
+    m_visibleWorldMatrices.resize(listCount);
+    for (auto& matrices : m_visibleWorldMatrices) {
+        matrices.clear();
+    }
+
+    // Every view and instance group pair is a separate task
+    m_workerPool->parallelFor(m_viewCount * m_instanceGroupDrawInfos.size(), m_cullTask);
+
+    const auto occlusionStartTime = std::chrono::high_resolution_clock::now();
+    m_frameStats.cullingTimeMs = std::chrono::duration<double, std::milli>(occlusionStartTime - startTime).count();
+
+    // Each view has its own depth buffer, so views are separate tasks
+    m_frameStats.occludedInstances.assign(m_viewCount, 0);
+    if (m_settings.useOcclusionCulling()) {
+        while (m_viewOcclusions.size() < m_viewCount) {
+            m_viewOcclusions.push_back({std::make_unique<OcclusionCuller>(), {}});
+        }
+        m_workerPool->parallelFor(m_viewCount, m_occlusionTask);
+    }
+
+    m_frameStats.occlusionCullingTimeMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - occlusionStartTime).count();
+
+    m_frameStats.visibleInstances.assign(m_viewCount, 0);
+    m_frameStats.culledInstances.assign(m_viewCount, 0);
+    for (uint32_t i = 0; i < m_viewCount; ++i) {
+        for (const auto& drawInfo : m_instanceGroupDrawInfos) {
+            const std::size_t visibleCount = m_visibleWorldMatrices[getVisibleListIndex(i, drawInfo.groupIndex)].size();
+            m_frameStats.visibleInstances[i] += static_cast<uint32_t>(visibleCount);
+            m_frameStats.culledInstances[i] += static_cast<uint32_t>(m_objectWorldMatrices[drawInfo.groupIndex].size() - visibleCount);
+        }
+        m_frameStats.culledInstances[i] -= m_frameStats.occludedInstances[i];
+    }
+}
+
+void IRenderer::cullInstanceGroup(std::size_t viewIndex, std::size_t drawInfoIndex)
+{
+    const InstanceGroupDrawInfo& drawInfo = m_instanceGroupDrawInfos[drawInfoIndex];
+    const ViewFrustum& frustum = m_viewFrustums[viewIndex];
+    const std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[drawInfo.groupIndex];
+    const std::size_t listIndex = getVisibleListIndex(viewIndex, drawInfo.groupIndex);
+    std::vector<uint32_t>& indices = m_visibleIndices[listIndex];
+    std::vector<ObjectRenderData>& visibleMatrices = m_visibleWorldMatrices[listIndex];
+
+    if (!frustum.enabled) {
+        return;
+    }
+
+    indices.resize(worldMatrices.size());
+    std::size_t visibleCount = 0;
+
+    // Geometry without bounds is always drawn
+    const float geometryRadius = drawInfo.geometry->boundingRadius();
+    if (geometryRadius < 0.0f) {
+        std::iota(indices.begin(), indices.end(), 0);
+        visibleCount = indices.size();
+    } else if (drawInfo.objectStore) {
+        visibleCount = drawInfo.objectStore->cullSpheres(frustum.planes, 4, geometryRadius, indices.data());
+    } else {
+        for (std::size_t i = 0; i < worldMatrices.size(); ++i) {
+            const Object& object = drawInfo.objects[i];
+            const float scale = (std::max)({std::abs(object.scale.x), std::abs(object.scale.y), std::abs(object.scale.z)});
+            if (isSphereVisible(frustum.planes, object.position, geometryRadius * scale)) {
+                indices[visibleCount++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    indices.resize(visibleCount);
+
+    // With occlusion culling the matrices are gathered after the occlusion test of the view
+    if (!m_settings.useOcclusionCulling()) {
+        gatherVisibleMatrices(listIndex, drawInfo.groupIndex);
+    }
+}
+
+void IRenderer::cullOccludedInstances(std::size_t viewIndex)
+{
+    const ViewFrustum& frustum = m_viewFrustums[viewIndex];
+    if (!frustum.enabled) {
+        return;
+    }
+
+    // Nearest and largest visible objects with an occluder mesh hide the most
+    ViewOcclusion& occlusion = m_viewOcclusions[viewIndex];
+    std::size_t objectCount = 0;
+    for (const auto& drawInfo : m_instanceGroupDrawInfos) {
+        objectCount += m_objectWorldMatrices[drawInfo.groupIndex].size();
+    }
+    occlusion.candidates.clear();
+    occlusion.candidates.reserve(objectCount);
+    for (const auto& drawInfo : m_instanceGroupDrawInfos) {
+        const Geometry::OccluderMesh& mesh = drawInfo.geometry->occluderMesh();
+        const float geometryRadius = drawInfo.geometry->boundingRadius();
+        if (mesh.indices.empty() || geometryRadius <= 0.0f) {
+            continue;
+        }
+
+        const std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[drawInfo.groupIndex];
+        for (uint32_t index : m_visibleIndices[getVisibleListIndex(viewIndex, drawInfo.groupIndex)]) {
+            const glm::mat4& world = worldMatrices[index].world;
+            const float distance = (frustum.viewProjection * world[3]).w;
+            occlusion.candidates.push_back({distance / getBoundingSphereRadius(world, geometryRadius), &mesh, &world});
         }
     }
+
+    const std::size_t occluderCount = (std::min)(c_maxOccluders, occlusion.candidates.size());
+    std::nth_element(occlusion.candidates.begin(), occlusion.candidates.begin() + occluderCount, occlusion.candidates.end(),
+        [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.score < b.score; });
+
+    OcclusionCuller& culler = *occlusion.culler;
+    culler.begin(frustum.viewProjection);
+    for (std::size_t i = 0; i < occluderCount; ++i) {
+        culler.addOccluder(*occlusion.candidates[i].mesh, *occlusion.candidates[i].world);
+    }
+    culler.end();
+
+    // Occluders are inside their bounding spheres, so they never hide themselves
+    uint32_t occludedCount = 0;
+    for (const auto& drawInfo : m_instanceGroupDrawInfos) {
+        const std::size_t listIndex = getVisibleListIndex(viewIndex, drawInfo.groupIndex);
+        const float geometryRadius = drawInfo.geometry->boundingRadius();
+        if (geometryRadius >= 0.0f) {
+            const std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[drawInfo.groupIndex];
+            std::vector<uint32_t>& indices = m_visibleIndices[listIndex];
+            std::size_t visibleCount = 0;
+            for (uint32_t index : indices) {
+                const glm::mat4& world = worldMatrices[index].world;
+                if (culler.isSphereVisible(glm::vec3(world[3]), getBoundingSphereRadius(world, geometryRadius))) {
+                    indices[visibleCount++] = index;
+                }
+            }
+            occludedCount += static_cast<uint32_t>(indices.size() - visibleCount);
+            indices.resize(visibleCount);
+        }
+
+        gatherVisibleMatrices(listIndex, drawInfo.groupIndex);
+    }
+
+    m_frameStats.occludedInstances[viewIndex] = occludedCount;
+}
+
+void IRenderer::gatherVisibleMatrices(std::size_t listIndex, int32_t groupIndex)
+{
+    const std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[groupIndex];
+    const std::vector<uint32_t>& indices = m_visibleIndices[listIndex];
+    std::vector<ObjectRenderData>& visibleMatrices = m_visibleWorldMatrices[listIndex];
+
+    // Reserve for the whole group, so that varying visible counts don't reallocate
+    visibleMatrices.reserve(worldMatrices.size());
+    visibleMatrices.resize(indices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        visibleMatrices[i] = worldMatrices[indices[i]];
+    }
 }
 
 const std::vector<varjo_Viewport>& IRenderer::getActiveViewports() const
@@ -253,16 +500,16 @@ void IRenderer::freeSwapchainsAndRenderTargets()
     m_depthTargets.clear();
     m_velocityTargets.clear();
 
-    varjo_FreeSwapChain(m_colorSwapChain);
+    freeSwapChain(m_colorSwapChain);
 
     if (m_settings.useDepthLayers()) {
-        varjo_FreeSwapChain(m_depthSwapChain);
+        freeSwapChain(m_depthSwapChain);
     }
     if (m_settings.useVelocity()) {
-        varjo_FreeSwapChain(m_velocitySwapChain);
+        freeSwapChain(m_velocitySwapChain);
     }
     if (m_settings.showMirrorWindow()) {
-        varjo_FreeSwapChain(m_mirrorSwapchain);
+        freeSwapChain(m_mirrorSwapchain);
     }
 }
 
@@ -280,7 +527,7 @@ void IRenderer::freeRendererResources()
 
 void IRenderer::initViewports()
 {
-    m_viewCount = m_settings.useStereo() ? 2 : varjo_GetViewCount(m_session);
+    m_viewCount = m_settings.useStereo() ? 2 : getViewCount();
     printf("  View count: %d\n", m_viewCount);
 
     const varjo_TextureSize_Type type = m_settings.useStereo() ? varjo_TextureSize_Type_Stereo : varjo_TextureSize_Type_Quad;
@@ -299,14 +546,14 @@ void IRenderer::createRenderTargets()
 {
     // Create a render target for each swap chain texture.
     for (int i = 0; i < m_swapChainConfig.numberOfTextures; ++i) {
-        const varjo_Texture colorTexture = varjo_GetSwapChainImage(m_colorSwapChain, i);
+        const varjo_Texture colorTexture = getSwapChainImage(m_colorSwapChain, i);
         m_colorTargets.push_back(createColorTexture(m_swapChainConfig.textureWidth, m_swapChainConfig.textureHeight, colorTexture));
 
-        const varjo_Texture depthTexture = m_settings.useDepthLayers() ? varjo_GetSwapChainImage(m_depthSwapChain, i) : varjo_Texture{0};
+        const varjo_Texture depthTexture = m_settings.useDepthLayers() ? getSwapChainImage(m_depthSwapChain, i) : varjo_Texture{0};
         m_depthTargets.push_back(createDepthTexture(m_swapChainConfig.textureWidth, m_swapChainConfig.textureHeight, depthTexture));
 
         if (m_settings.useVelocity()) {
-            const varjo_Texture velocityTexture = varjo_GetSwapChainImage(m_velocitySwapChain, i);
+            const varjo_Texture velocityTexture = getSwapChainImage(m_velocitySwapChain, i);
             m_velocityTargets.push_back(createVelocityTexture(m_swapChainConfig.textureWidth, m_swapChainConfig.textureHeight, velocityTexture));
         }
     }
@@ -352,30 +599,29 @@ void IRenderer::drawObjects(const std::shared_ptr<Geometry>& geometry, std::size
     drawObjects(objectsIndex);
 }
 
-void IRenderer::render(
-    varjo_FrameInfo* frameInfo, const std::vector<std::vector<Object>*>& instancedObjects, const std::vector<Object>& nonInstancedObjects, bool disableGrid)
+void IRenderer::render(varjo_FrameInfo* frameInfo, const std::vector<std::vector<Object>*>& instancedObjects,
+    const std::vector<const ObjectStore*>& instancedObjectStores, const std::vector<Object>& nonInstancedObjects, bool disableGrid)
 {
     // Begin rendering of the frame
-    varjo_BeginFrameWithLayers(m_session);
+    beginFrame();
 
     {
         std::shared_ptr<RenderTexture> colorTexture;
         std::shared_ptr<RenderTexture> depthTexture;
         std::shared_ptr<RenderTexture> velocityTexture;
 
-        int32_t swapChainIndex{};
+        int32_t swapChainIndex = acquireSwapChainImage(m_colorSwapChain);
         int32_t depthSwapChainIndex{};
-        varjo_AcquireSwapChainImage(m_colorSwapChain, &swapChainIndex);
         colorTexture = m_colorTargets[swapChainIndex];
         if (m_settings.useDepthLayers()) {
-            varjo_AcquireSwapChainImage(m_depthSwapChain, &depthSwapChainIndex);
+            depthSwapChainIndex = acquireSwapChainImage(m_depthSwapChain);
         } else {
             depthSwapChainIndex = swapChainIndex;
         }
         depthTexture = m_depthTargets[depthSwapChainIndex];
 
         if (m_settings.useVelocity()) {
-            varjo_AcquireSwapChainImage(m_velocitySwapChain, &swapChainIndex);
+            swapChainIndex = acquireSwapChainImage(m_velocitySwapChain);
             velocityTexture = m_velocityTargets[swapChainIndex];
         }
         RenderTargetTextures renderTarget = RenderTargetTextures(colorTexture, depthTexture, velocityTexture);
@@ -388,34 +634,50 @@ void IRenderer::render(
 
     // Calculate object world matrices and generate instance group info vector
     {
-        m_objectWorldMatrices.resize(instancedObjects.size() + nonInstancedObjects.size());
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        // Buffers keep their capacity between frames, so this only allocates when the object counts grow
+        m_objectWorldMatrices.resize(instancedObjects.size() + instancedObjectStores.size() + nonInstancedObjects.size());
         m_instanceGroupDrawInfos.clear();
         m_instanceGroupDrawInfos.reserve(m_objectWorldMatrices.size());
+        m_worldMatrixBatches.clear();
         int32_t instanceGroupIndex = 0;
         for (size_t i = 0; i < instancedObjects.size(); ++i) {
             if (!instancedObjects[i]->empty()) {
-                std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[instanceGroupIndex];
-                calculateWorldMatrices(worldMatrices, *instancedObjects[i]);
+                addWorldMatrixBatches(instanceGroupIndex, nullptr, instancedObjects[i]->data(), instancedObjects[i]->size());
 
                 // Take the geometry reference from the first object of the group
-                m_instanceGroupDrawInfos.push_back({(*instancedObjects[i])[0].geometry, instanceGroupIndex});
+                m_instanceGroupDrawInfos.push_back({(*instancedObjects[i])[0].geometry, instanceGroupIndex, nullptr, instancedObjects[i]->data()});
             }
             ++instanceGroupIndex;
         };
 
+        // Object stores write matrices straight into the instance data with vector kernels
+        for (const ObjectStore* objectStore : instancedObjectStores) {
+            if (!objectStore->empty()) {
+                addWorldMatrixBatches(instanceGroupIndex, objectStore, nullptr, objectStore->size());
+                m_instanceGroupDrawInfos.push_back({objectStore->geometry(), instanceGroupIndex, objectStore, nullptr});
+            }
+            ++instanceGroupIndex;
+        }
+
         // For non-instanced objects create intance groups with size 1
         for (size_t i = 0; i < nonInstancedObjects.size(); ++i) {
-            std::vector<ObjectRenderData>& worldMatrices = m_objectWorldMatrices[instanceGroupIndex];
-            calculateWorldMatrices(worldMatrices, {nonInstancedObjects[i]});
-            m_instanceGroupDrawInfos.push_back({nonInstancedObjects[i].geometry, instanceGroupIndex});
+            addWorldMatrixBatches(instanceGroupIndex, nullptr, &nonInstancedObjects[i], 1);
+            m_instanceGroupDrawInfos.push_back({nonInstancedObjects[i].geometry, instanceGroupIndex, nullptr, &nonInstancedObjects[i]});
             ++instanceGroupIndex;
         }
-    }
 
-    uploadInstanceBuffer(m_objectWorldMatrices);
+        // Batches write to separate parts of the preallocated matrix vectors
+        m_workerPool->parallelFor(m_worldMatrixBatches.size(), m_worldMatrixTask);
+
+        m_frameStats.worldMatrixTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
 
     varjo_Gaze gaze{};
-    if (varjo_GetRenderingGaze(m_session, &gaze)) {
+    if (m_predictedGaze.has_value()) {
+        m_renderingGaze = m_predictedGaze;
+    } else if (getRenderingGaze(gaze)) {
         m_renderingGaze = gaze;
     } else {
         m_renderingGaze = std::nullopt;
@@ -424,6 +686,31 @@ void IRenderer::render(
     const bool useFoveation = m_settings.useDynamicViewports() && m_renderingGaze.has_value();
     useFoveatedViewports(useFoveation);
 
+    // Calculate projection matrices before the upload, culling needs them
+    m_projectionMatrices.resize(m_viewCount);
+    for (uint32_t i = 0; i < m_viewCount; ++i) {
+        if (!frameInfo->views[i].enabled) {
+            continue;
+        }
+
+        varjo_FovTangents tangents = getFovTangents(i, useFoveation ? &m_renderingGaze.value() : nullptr);
+        m_projectionMatrices[i] = varjo_GetProjectionMatrix(&tangents);
+
+        // Change the near and far clip distances
+        const double nearPlane = m_settings.useReverseDepth() ? c_farClipDistance : c_nearClipDistance;
+        const double farPlane = m_settings.useReverseDepth() ? c_nearClipDistance : c_farClipDistance;
+
+        varjo_UpdateNearFarPlanes(m_projectionMatrices[i].value, getClipRange(), nearPlane, farPlane);
+    }
+
+    const bool useFrustumCulling = m_settings.useFrustumCulling();
+    if (useFrustumCulling) {
+        cullInstances(frameInfo);
+        uploadInstanceBuffer(m_visibleWorldMatrices);
+    } else {
+        uploadInstanceBuffer(m_objectWorldMatrices);
+    }
+
     preRenderFrame();
 
     // Render all active views.
@@ -447,21 +734,7 @@ void IRenderer::render(
         // Setup the view and projection matrices.
         glm::mat4 viewMatrix = doubleMatrixToGLMMatrix(view.viewMatrix);
 
-        varjo_FovTangents tangents{};
-        if (useFoveation) {
-            varjo_FoveatedFovTangents_Hints hints{};
-            tangents = varjo_GetFoveatedFovTangents(m_session, i, &m_renderingGaze.value(), &hints);
-        } else {
-            tangents = varjo_GetFovTangents(m_session, i);
-        }
-        varjo_Matrix varjoProjectionMatrix = varjo_GetProjectionMatrix(&tangents);
-
-        // Change the near and far clip distances
-        const double nearPlane = m_settings.useReverseDepth() ? c_farClipDistance : c_nearClipDistance;
-        const double farPlane = m_settings.useReverseDepth() ? c_nearClipDistance : c_farClipDistance;
-
-        varjo_UpdateNearFarPlanes(varjoProjectionMatrix.value, getClipRange(), nearPlane, farPlane);
-
+        const varjo_Matrix& varjoProjectionMatrix = m_projectionMatrices[i];
         const glm::mat4 projectionMatrix = doubleMatrixToGLMMatrix(varjoProjectionMatrix.value);
 
         setupCamera(viewMatrix, projectionMatrix);
@@ -475,7 +748,16 @@ void IRenderer::render(
         }
 
         for (auto& instanceGroupDrawInfo : m_instanceGroupDrawInfos) {
-            drawObjects(instanceGroupDrawInfo.geometry, instanceGroupDrawInfo.groupIndex);
+            if (!useFrustumCulling) {
+                drawObjects(instanceGroupDrawInfo.geometry, instanceGroupDrawInfo.groupIndex);
+                continue;
+            }
+
+            // Skip groups that are completely outside of the view
+            const std::size_t listIndex = getVisibleListIndex(i, instanceGroupDrawInfo.groupIndex);
+            if (!m_visibleWorldMatrices[listIndex].empty()) {
+                drawObjects(instanceGroupDrawInfo.geometry, listIndex);
+            }
         }
 
         advance();
@@ -525,17 +807,59 @@ void IRenderer::render(
 
     unbindRenderTarget();
 
-    varjo_ReleaseSwapChainImage(m_colorSwapChain);
+    releaseSwapChainImage(m_colorSwapChain);
     if (m_settings.useDepthLayers()) {
-        varjo_ReleaseSwapChainImage(m_depthSwapChain);
+        releaseSwapChainImage(m_depthSwapChain);
     }
     if (m_settings.useVelocity()) {
-        varjo_ReleaseSwapChainImage(m_velocitySwapChain);
+        releaseSwapChainImage(m_velocitySwapChain);
     }
 
-    varjo_EndFrameWithLayers(m_session, &submitInfoLayers);
+    endFrame(submitInfoLayers);
+}
+
+void IRenderer::waitSync(varjo_FrameInfo* frameInfo) { varjo_WaitSync(m_session, frameInfo); }
+
+varjo_FrameInfo* IRenderer::createFrameInfo() { return varjo_CreateFrameInfo(m_session); }
+
+void IRenderer::freeFrameInfo(varjo_FrameInfo* frameInfo) { varjo_FreeFrameInfo(frameInfo); }
+
+void IRenderer::beginFrame() { varjo_BeginFrameWithLayers(m_session); }
+
+void IRenderer::endFrame(varjo_SubmitInfoLayers& submitInfo) { varjo_EndFrameWithLayers(m_session, &submitInfo); }
+
+int32_t IRenderer::acquireSwapChainImage(varjo_SwapChain* swapChain)
+{
+    int32_t index{};
+    varjo_AcquireSwapChainImage(swapChain, &index);
+    return index;
+}
+
+void IRenderer::releaseSwapChainImage(varjo_SwapChain* swapChain) { varjo_ReleaseSwapChainImage(swapChain); }
+
+varjo_Texture IRenderer::getSwapChainImage(varjo_SwapChain* swapChain, int32_t index) { return varjo_GetSwapChainImage(swapChain, index); }
+
+void IRenderer::freeSwapChain(varjo_SwapChain* swapChain) { varjo_FreeSwapChain(swapChain); }
+
+int32_t IRenderer::getViewCount() const { return varjo_GetViewCount(m_session); }
+
+void IRenderer::getTextureSize(varjo_TextureSize_Type type, int32_t viewIndex, int32_t& width, int32_t& height) const
+{
+    varjo_GetTextureSize(m_session, type, viewIndex, &width, &height);
 }
 
+varjo_FovTangents IRenderer::getFovTangents(int32_t viewIndex, const varjo_Gaze* foveationGaze) const
+{
+    if (foveationGaze) {
+        varjo_Gaze gaze = *foveationGaze;
+        varjo_FoveatedFovTangents_Hints hints{};
+        return varjo_GetFoveatedFovTangents(m_session, viewIndex, &gaze, &hints);
+    }
+    return varjo_GetFovTangents(m_session, viewIndex);
+}
+
+bool IRenderer::getRenderingGaze(varjo_Gaze& gaze) const { return varjo_GetRenderingGaze(m_session, &gaze) == varjo_True; }
+
 void IRenderer::useFoveatedViewports(bool use) { m_useFoveatedViewports = use; }
 
 void IRenderer::recreateSwapchains()
@@ -549,8 +873,12 @@ void IRenderer::recreateSwapchains()
 
 const char* IRenderer::getLastErrorString()
 {
+#ifdef _WIN32
     const DWORD err = GetLastError();
     return err ? getErrorMsg(err) : "";
+#else
+    return errno ? strerror(errno) : "";
+#endif
 }
 
 glm::ivec2 IRenderer::getMirrorWindowSize()
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 #include <Varjo.h>
 #include <Varjo_types_layers.h>
 
@@ -10,7 +11,11 @@
 #include <optional>
 
 #include "Geometry.hpp"
-#include "Window.hpp"
+#include "WorkerPool.hpp"
+
+class ObjectStore;
+class OcclusionCuller;
+class Window;
 
 class RendererSettings final
 {
@@ -54,9 +59,14 @@ public:
     bool useVelocity() const { return m_useVelocity; }
     bool noSrgb() const { return m_noSrgb; }
     bool showMirrorWindow() const { return m_showMirrorWindow; }
+    bool useFrustumCulling() const { return m_useFrustumCulling; }
+    bool useOcclusionCulling() const { return m_useOcclusionCulling; }
 
     void setUseVrs(bool enabled) { m_useVrs = enabled; }
     void setVisualizeVrs(bool enabled) { m_visualizeVrs = enabled; }
+    void setUseFrustumCulling(bool enabled) { m_useFrustumCulling = enabled; }
+    // Occlusion culling is applied to frustum culled instances, it has no effect without frustum culling
+    void setUseOcclusionCulling(bool enabled) { m_useOcclusionCulling = enabled; }
 
 private:
     bool m_useDepthLayers{false};
@@ -75,6 +85,8 @@ private:
     bool m_useVelocity{false};
     bool m_noSrgb{false};
     bool m_showMirrorWindow{false};
+    bool m_useFrustumCulling{false};
+    bool m_useOcclusionCulling{false};
 };
 
 class RenderTexture
@@ -146,14 +158,36 @@ public:
         glm::mat4 world;
         glm::mat4 nextFrameWorld;  // Estimated world matrix at the next frame. Used to calculate velocity.
     };
+    // CPU statistics of the latest rendered frame
+    struct FrameStats {
+        double worldMatrixTimeMs;                 // Time spent calculating object world matrices
+        double cullingTimeMs;                     // Time spent on frustum culling, zero when culling is disabled
+        double occlusionCullingTimeMs;            // Time spent on occlusion culling, zero when occlusion culling is disabled
+        std::vector<uint32_t> visibleInstances;   // Instances drawn in each view. Empty when culling is disabled.
+        std::vector<uint32_t> culledInstances;    // Instances outside of each view. Empty when culling is disabled.
+        std::vector<uint32_t> occludedInstances;  // Instances in each view hidden behind occluders. Empty when culling is disabled.
+    };
+
+    // Number of objects in a world matrix batch. Multiple of ObjectStore::c_laneCount.
+    static constexpr std::size_t c_worldMatrixBatchSize = 256;
+
+    // Capacity of instance buffers. With frustum culling visible instances are uploaded separately for each view.
+    static constexpr int32_t c_maxInstances = 4 * 5000;
+
+    // Number of objects rasterized as occluders in each view
+    static constexpr std::size_t c_maxOccluders = 32;
 
     static void applyObjectVelocity(Object& object, float timeDeltaSec);
 
     IRenderer(varjo_Session* session, const RendererSettings& renderer_settings);
-    virtual ~IRenderer() = default;
+    virtual ~IRenderer();
 
     bool init();
 
+    // Set number of worker threads used for world matrices in addition to the render thread. Zero calculates them serially.
+    void setWorkerThreadCount(std::size_t threadCount);
+    std::size_t getWorkerThreadCount() const { return m_workerPool->getThreadCount(); }
+
     void updateViewportLayout();
 
     virtual std::shared_ptr<Geometry> createGeometry(uint32_t vertexCount, uint32_t indexCount) = 0;
@@ -162,22 +196,50 @@ public:
     virtual std::shared_ptr<RenderTexture> createDepthTexture(int32_t width, int32_t height, varjo_Texture depthTexture) = 0;
     virtual std::shared_ptr<RenderTexture> createVelocityTexture(int32_t width, int32_t height, varjo_Texture velocityTexture) = 0;
 
-    void render(varjo_FrameInfo* frameInfo, const std::vector<std::vector<Object>*>& instancedObjects, const std::vector<Object>& nonInstancedObjects,
-        bool disableGrid);
+    void render(varjo_FrameInfo* frameInfo, const std::vector<std::vector<Object>*>& instancedObjects, const std::vector<const ObjectStore*>& instancedObjectStores,
+        const std::vector<Object>& nonInstancedObjects, bool disableGrid);
     void useFoveatedViewports(bool use);
+    // Use given gaze for foveation instead of runtime rendering gaze, e.g. gaze predicted for the frame display time
+    void setPredictedGaze(const std::optional<varjo_Gaze>& gaze) { m_predictedGaze = gaze; }
     virtual bool isVrsSupported() const = 0;
     void recreateSwapchains();
     virtual void recreateOcclusionMesh(uint32_t viewIndex) = 0;
     virtual void finishRendering() = 0;
     void freeVarjoResources();
 
-    Window* getWindow() const { return m_window.get(); }
+    // Wait for the time to render the next frame and fill in frame info
+    virtual void waitSync(varjo_FrameInfo* frameInfo);
+
+    // Allocate and free frame info with a view info for each view
+    virtual varjo_FrameInfo* createFrameInfo();
+    virtual void freeFrameInfo(varjo_FrameInfo* frameInfo);
+
+    // Mirror window of GPU renderers, null if not shown
+    virtual Window* getWindow() const { return nullptr; }
+
+    const FrameStats& getFrameStats() const { return m_frameStats; }
 
 protected:
     // Initialize the Varjo graphics API.
     virtual bool initVarjo() = 0;
     virtual void createSwapchains() = 0;
     virtual varjo_SwapChain* createSwapChain(varjo_SwapChainConfig2& swapchainConfig) = 0;
+
+    // Frame and swap chain calls of the layers API. Renderers without a compositor connection replace these with a local stand-in.
+    virtual void beginFrame();
+    virtual void endFrame(varjo_SubmitInfoLayers& submitInfo);
+    virtual int32_t acquireSwapChainImage(varjo_SwapChain* swapChain);
+    virtual void releaseSwapChainImage(varjo_SwapChain* swapChain);
+    virtual varjo_Texture getSwapChainImage(varjo_SwapChain* swapChain, int32_t index);
+    virtual void freeSwapChain(varjo_SwapChain* swapChain);
+
+    // View configuration queries. Renderers without a runtime connection replace these with a fixed configuration.
+    virtual int32_t getViewCount() const;
+    virtual void getTextureSize(varjo_TextureSize_Type type, int32_t viewIndex, int32_t& width, int32_t& height) const;
+    // Returns FOV tangents of the view, foveated around given gaze unless it is null
+    virtual varjo_FovTangents getFovTangents(int32_t viewIndex, const varjo_Gaze* foveationGaze) const;
+    virtual bool getRenderingGaze(varjo_Gaze& gaze) const;
+
     void freeSwapchainsAndRenderTargets();
     void freeRendererResources();
     void initViewports();
@@ -233,13 +295,57 @@ protected:
     glm::ivec2 getMirrorWindowSize();
 
 private:
-    void calculateWorldMatrices(std::vector<IRenderer::ObjectRenderData>& worldMatrices, const std::vector<IRenderer::Object>& objects);
+    // Range of objects in an instance group. Objects come from either an object store or an object array.
+    struct WorldMatrixBatch {
+        const ObjectStore* objectStore;
+        const Object* objects;
+        ObjectRenderData* worldMatrices;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // Resize world matrices of the instance group and split its objects into batches
+    void addWorldMatrixBatches(int32_t groupIndex, const ObjectStore* objectStore, const Object* objects, std::size_t objectCount);
+    void calculateWorldMatrices(const WorldMatrixBatch& batch) const;
+
+    // Calculate view frustums of enabled views, and cull all instance groups against them
+    void cullInstances(const varjo_FrameInfo* frameInfo);
+    void cullInstanceGroup(std::size_t viewIndex, std::size_t drawInfoIndex);
+    // Remove instances hidden behind occluders from the visible instance lists of the view
+    void cullOccludedInstances(std::size_t viewIndex);
+    // Copy world matrices of visible instances to the visible instance list
+    void gatherVisibleMatrices(std::size_t listIndex, int32_t groupIndex);
+
+    // Index of the visible instance list of the instance group in the view
+    std::size_t getVisibleListIndex(std::size_t viewIndex, int32_t groupIndex) const { return viewIndex * m_objectWorldMatrices.size() + groupIndex; }
 
     const std::vector<varjo_Viewport>& getActiveViewports() const;
 
     struct InstanceGroupDrawInfo {
         std::shared_ptr<Geometry> geometry;
         int32_t groupIndex;
+        // Objects of the group, used for culling
+        const ObjectStore* objectStore;
+        const Object* objects;
+    };
+
+    // Side planes of a view frustum. Near and far planes are not tested, the side planes already reject objects behind the eye.
+    struct ViewFrustum {
+        bool enabled;
+        glm::mat4 viewProjection;
+        glm::vec4 planes[4];
+    };
+
+    struct OccluderCandidate {
+        float score;  // Distance divided by radius, smaller hides more
+        const Geometry::OccluderMesh* mesh;
+        const glm::mat4* world;
+    };
+
+    // Occlusion culling state of a view
+    struct ViewOcclusion {
+        std::unique_ptr<OcclusionCuller> culler;
+        std::vector<OccluderCandidate> candidates;
     };
 
 protected:
@@ -261,6 +367,7 @@ protected:
     // Temp vector for object world matrices.
     std::vector<std::vector<ObjectRenderData>> m_objectWorldMatrices;
     std::vector<InstanceGroupDrawInfo> m_instanceGroupDrawInfos;
+    FrameStats m_frameStats{};
 
     // Currently active geometry.
     std::shared_ptr<Geometry> m_currentGeometry;
@@ -273,13 +380,28 @@ protected:
 
     RendererSettings m_settings;
     std::optional<varjo_Gaze> m_renderingGaze;
+    std::optional<varjo_Gaze> m_predictedGaze;
 
     varjo_SwapChain* m_mirrorSwapchain;
     std::vector<varjo_MirrorView> m_mirrorViews{};
 
-    std::unique_ptr<Window> m_window;
-
 private:
+    // World matrix batches of the current frame, calculated in parallel by the worker pool
+    std::vector<WorldMatrixBatch> m_worldMatrixBatches;
+    std::function<void(std::size_t)> m_worldMatrixTask;
+    std::unique_ptr<VarjoExamples::WorkerPool> m_workerPool;
+
+    // Projection matrices of the current frame, calculated before culling and used for rendering and submission
+    std::vector<varjo_Matrix> m_projectionMatrices;
+
+    // Frustum culling state of the current frame. Visible instance lists are indexed with getVisibleListIndex().
+    std::vector<ViewFrustum> m_viewFrustums;
+    std::vector<std::vector<uint32_t>> m_visibleIndices;
+    std::vector<std::vector<ObjectRenderData>> m_visibleWorldMatrices;
+    std::function<void(std::size_t)> m_cullTask;
+    std::vector<ViewOcclusion> m_viewOcclusions;
+    std::function<void(std::size_t)> m_occlusionTask;
+
     bool m_useFoveatedViewports{false};
     std::vector<varjo_Viewport> m_viewports;
     std::vector<varjo_Viewport> m_foveatedViewports;
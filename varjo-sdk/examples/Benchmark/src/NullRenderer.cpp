@@ -0,0 +1,295 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <Varjo_layers.h>
+#include <Varjo_math.h>
+
+#include "NullRenderer.hpp"
+#include "VRSHelper.hpp"
+
+namespace
+{
+// View of the fixed configuration used instead of the runtime
+struct NullView {
+    int32_t width;               // Quad and stereo texture width
+    int32_t height;              // Quad and stereo texture height
+    int32_t foveatedWidth;       // Dynamic foveation texture width
+    int32_t foveatedHeight;      // Dynamic foveation texture height
+    varjo_FovTangents tangents;  // FOV tangents, also used when foveated
+    double eyeOffset;            // Eye position on X axis in meters
+};
+
+// Left and right context views followed by left and right focus views, roughly like a Varjo XR-3
+constexpr std::array<NullView, 4> c_nullViews = {{
+    {1600, 1500, 1000, 940, {1.0, -1.0, -1.3, 1.0}, -0.032},
+    {1600, 1500, 1000, 940, {1.0, -1.0, -1.0, 1.3}, 0.032},
+    {1800, 1800, 1800, 1800, {0.35, -0.35, -0.35, 0.35}, -0.032},
+    {1800, 1800, 1800, 1800, {0.35, -0.35, -0.35, 0.35}, 0.032},
+}};
+
+// Occlusion mesh of a context view: a ring of triangles along the lens edges
+constexpr int32_t c_nullOcclusionMeshVertexCount = 3 * 128;
+}  // namespace
+
+NullGeometry::NullGeometry(uint32_t vertexCount, uint32_t indexCount)
+    : Geometry(vertexCount, indexCount)
+    , m_vertexData(getVertexDataSize())
+    , m_indexData(getIndexDataSize())
+{
+}
+
+void NullGeometry::updateVertexBuffer(void* data) { memcpy(m_vertexData.data(), data, m_vertexData.size()); }
+
+void NullGeometry::updateIndexBuffer(void* data) { memcpy(m_indexData.data(), data, m_indexData.size()); }
+
+NullRenderer::NullRenderer(varjo_Session* session, const RendererSettings& renderer_settings)
+    : IRenderer(session, renderer_settings)
+    , m_startTime(std::chrono::steady_clock::now())
+{
+    if (renderer_settings.useOcclusionMesh()) {
+        for (uint32_t viewIndex = 0; viewIndex < 2; viewIndex++) {
+            recreateOcclusionMesh(viewIndex);
+        }
+    }
+}
+
+NullRenderer::~NullRenderer() { freeRendererResources(); }
+
+std::shared_ptr<Geometry> NullRenderer::createGeometry(uint32_t vertexCount, uint32_t indexCount)
+{
+    return std::make_shared<NullGeometry>(vertexCount, indexCount);
+}
+
+std::shared_ptr<RenderTexture> NullRenderer::createColorTexture(int32_t width, int32_t height, varjo_Texture colorTexture)
+{
+    return std::make_shared<NullRenderTexture>(width, height, colorTexture);
+}
+
+std::shared_ptr<RenderTexture> NullRenderer::createDepthTexture(int32_t width, int32_t height, varjo_Texture depthTexture)
+{
+    return std::make_shared<NullRenderTexture>(width, height, depthTexture);
+}
+
+std::shared_ptr<RenderTexture> NullRenderer::createVelocityTexture(int32_t width, int32_t height, varjo_Texture velocityTexture)
+{
+    return std::make_shared<NullRenderTexture>(width, height, velocityTexture);
+}
+
+void NullRenderer::finishRendering()
+{
+    if (m_stats.frameCount == 0) {
+        return;
+    }
+
+    const double frames = static_cast<double>(m_stats.frameCount);
+    printf("Null renderer: %llu frames, per frame %.1f draw calls, %.1f instances, %.0f triangles\n", static_cast<unsigned long long>(m_stats.frameCount),
+        m_stats.drawCalls / frames, m_stats.instances / frames, m_stats.triangles / frames);
+}
+
+void NullRenderer::recreateOcclusionMesh(uint32_t viewIndex)
+{
+    if (m_settings.useOcclusionMesh() && viewIndex < 2) {
+        m_occlusionMeshVertexCount[viewIndex] = c_nullOcclusionMeshVertexCount;
+    }
+}
+
+void NullRenderer::waitSync(varjo_FrameInfo* frameInfo)
+{
+    // Produce frames without waiting for the compositor. Head stays at the origin looking down -Z.
+    for (std::size_t i = 0; i < c_nullViews.size(); ++i) {
+        const NullView& nullView = c_nullViews[i];
+        varjo_ViewInfo& view = frameInfo->views[i];
+
+        varjo_FovTangents tangents = nullView.tangents;
+        const varjo_Matrix projectionMatrix = varjo_GetProjectionMatrix(&tangents);
+        std::copy(projectionMatrix.value, projectionMatrix.value + 16, view.projectionMatrix);
+
+        std::fill(view.viewMatrix, view.viewMatrix + 16, 0.0);
+        view.viewMatrix[0] = view.viewMatrix[5] = view.viewMatrix[10] = view.viewMatrix[15] = 1.0;
+        view.viewMatrix[12] = -nullView.eyeOffset;
+
+        view.preferredWidth = nullView.width;
+        view.preferredHeight = nullView.height;
+        view.enabled = varjo_True;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime);
+    frameInfo->displayTime = elapsed.count();
+    frameInfo->frameNumber = static_cast<int64_t>(m_stats.frameCount);
+}
+
+varjo_FrameInfo* NullRenderer::createFrameInfo()
+{
+    varjo_FrameInfo* frameInfo = new varjo_FrameInfo{};
+    frameInfo->views = new varjo_ViewInfo[c_nullViews.size()]{};
+    return frameInfo;
+}
+
+void NullRenderer::freeFrameInfo(varjo_FrameInfo* frameInfo)
+{
+    delete[] frameInfo->views;
+    delete frameInfo;
+}
+
+void NullRenderer::renderOcclusionMesh()
+{
+    if (m_settings.useOcclusionMesh() && m_currentViewIndex < 2 && m_occlusionMeshVertexCount[m_currentViewIndex] > 0) {
+        m_stats.drawCalls++;
+        m_stats.triangles += m_occlusionMeshVertexCount[m_currentViewIndex] / 3;
+    }
+}
+
+bool NullRenderer::initVarjo()
+{
+    createSwapchains();
+    return true;
+}
+
+void NullRenderer::createSwapchains()
+{
+    // Same swap chain layout as the GPU renderers
+    m_swapChainConfig.numberOfTextures = 3;
+    m_swapChainConfig.textureArraySize = 1;
+    m_swapChainConfig.textureFormat = m_settings.noSrgb() ? varjo_TextureFormat_R8G8B8A8_UNORM : varjo_TextureFormat_R8G8B8A8_SRGB;
+    m_swapChainConfig.textureWidth = getTotalViewportsWidth();
+    m_swapChainConfig.textureHeight = getTotalViewportsHeight();
+
+    m_colorSwapChain = createSwapChain(m_swapChainConfig);
+
+    if (m_settings.useDepthLayers()) {
+        m_depthSwapChainConfig = m_swapChainConfig;
+        m_depthSwapChainConfig.textureFormat = m_settings.depthFormat();
+        m_depthSwapChain = createSwapChain(m_depthSwapChainConfig);
+    }
+    if (m_settings.useVelocity()) {
+        m_velocitySwapChainConfig = m_swapChainConfig;
+        m_velocitySwapChainConfig.textureFormat = varjo_VelocityTextureFormat_R8G8B8A8_UINT;
+        m_velocitySwapChain = createSwapChain(m_velocitySwapChainConfig);
+    }
+}
+
+varjo_SwapChain* NullRenderer::createSwapChain(varjo_SwapChainConfig2& swapchainConfig)
+{
+    // varjo_SwapChain is opaque, so the stand-in object itself is used as the handle
+    m_swapChains.push_back(std::make_unique<SwapChain>(SwapChain{swapchainConfig, swapchainConfig.numberOfTextures - 1, false}));
+    return reinterpret_cast<varjo_SwapChain*>(m_swapChains.back().get());
+}
+
+NullRenderer::SwapChain& NullRenderer::getSwapChain(varjo_SwapChain* swapChain) { return *reinterpret_cast<SwapChain*>(swapChain); }
+
+void NullRenderer::beginFrame()
+{
+    if (m_frameStarted) {
+        printf("ERROR: Null renderer frame begun twice\n");
+        abort();
+    }
+    m_frameStarted = true;
+}
+
+void NullRenderer::endFrame(varjo_SubmitInfoLayers& submitInfo)
+{
+    if (!m_frameStarted || submitInfo.layerCount != 1) {
+        printf("ERROR: Null renderer frame ended without begin or with %d layers\n", submitInfo.layerCount);
+        abort();
+    }
+    m_frameStarted = false;
+    m_stats.frameCount++;
+}
+
+int32_t NullRenderer::acquireSwapChainImage(varjo_SwapChain* swapChain)
+{
+    SwapChain& nullSwapChain = getSwapChain(swapChain);
+    nullSwapChain.currentImage = (nullSwapChain.currentImage + 1) % nullSwapChain.config.numberOfTextures;
+    nullSwapChain.acquired = true;
+    return nullSwapChain.currentImage;
+}
+
+void NullRenderer::releaseSwapChainImage(varjo_SwapChain* swapChain) { getSwapChain(swapChain).acquired = false; }
+
+varjo_Texture NullRenderer::getSwapChainImage(varjo_SwapChain* swapChain, int32_t index)
+{
+    // Texture handle identifies the swap chain and image, nothing is behind it
+    varjo_Texture texture{};
+    texture.reserved[0] = reinterpret_cast<int64_t>(swapChain);
+    texture.reserved[1] = index;
+    return texture;
+}
+
+void NullRenderer::freeSwapChain(varjo_SwapChain* swapChain)
+{
+    const auto it = std::find_if(m_swapChains.begin(), m_swapChains.end(), [&](const auto& s) { return s.get() == &getSwapChain(swapChain); });
+    if (it != m_swapChains.end()) {
+        m_swapChains.erase(it);
+    }
+}
+
+int32_t NullRenderer::getViewCount() const { return static_cast<int32_t>(c_nullViews.size()); }
+
+void NullRenderer::getTextureSize(varjo_TextureSize_Type type, int32_t viewIndex, int32_t& width, int32_t& height) const
+{
+    const NullView& nullView = c_nullViews[viewIndex];
+    const bool foveated = type == varjo_TextureSize_Type_DynamicFoveation;
+    width = foveated ? nullView.foveatedWidth : nullView.width;
+    height = foveated ? nullView.foveatedHeight : nullView.height;
+}
+
+varjo_FovTangents NullRenderer::getFovTangents(int32_t viewIndex, const varjo_Gaze* /*foveationGaze*/) const { return c_nullViews[viewIndex].tangents; }
+
+void NullRenderer::bindRenderTarget(const RenderTargetTextures& renderTarget) { m_currentRenderTarget = renderTarget; }
+
+void NullRenderer::unbindRenderTarget() { m_currentRenderTarget.reset(); }
+
+void NullRenderer::clearRenderTarget(const RenderTargetTextures& /*renderTarget*/, float /*r*/, float /*g*/, float /*b*/, float /*a*/) {}
+
+void NullRenderer::freeCurrentRenderTarget() { m_currentRenderTarget.reset(); }
+
+void NullRenderer::useGeometry(const std::shared_ptr<Geometry>& geometry) { m_currentGeometry = geometry; }
+
+void NullRenderer::setupCamera(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix)
+{
+    m_viewMatrix = viewMatrix;
+    m_projectionMatrix = projectionMatrix;
+}
+
+void NullRenderer::setViewport(const varjo_Viewport& viewport) { m_currentViewport = viewport; }
+
+void NullRenderer::updateVrsMap(const varjo_Viewport& viewport)
+{
+    // Only the config is built, the shading rate texture is generated by the runtime on the GPU
+    m_vrsConfig = getDefaultVRSConfig(m_currentViewIndex, viewport, c_vrsTileSize, m_settings, m_renderingGaze);
+}
+
+void NullRenderer::uploadInstanceBuffer(const std::vector<std::vector<ObjectRenderData>>& matrices)
+{
+    m_instanceBuffer.drawsOffsetCount.resize(0);
+    m_instanceBuffer.drawsOffsetCount.reserve(matrices.size());
+    std::size_t dataSize = 0;
+    for (const auto& singleDrawMatrices : matrices) {
+        dataSize += singleDrawMatrices.size();
+    }
+
+    // Buffer keeps its capacity between frames like a mapped GPU buffer
+    m_instanceBuffer.data.resize(dataSize);
+    std::size_t dataOffset = 0;
+    for (const auto& singleDrawMatrices : matrices) {
+        m_instanceBuffer.drawsOffsetCount.push_back(std::make_pair(dataOffset, singleDrawMatrices.size()));
+        std::copy(singleDrawMatrices.begin(), singleDrawMatrices.end(), m_instanceBuffer.data.begin() + dataOffset);
+        dataOffset += singleDrawMatrices.size();
+    }
+}
+
+void NullRenderer::drawGrid()
+{
+    m_stats.drawCalls++;
+    m_stats.triangles += m_currentGeometry->indexCount() / 3;
+}
+
+void NullRenderer::drawObjects(std::size_t objectsIndex)
+{
+    const auto& drawOffsetCount = m_instanceBuffer.drawsOffsetCount[objectsIndex];
+
+    m_stats.drawCalls++;
+    m_stats.instances += drawOffsetCount.second;
+    m_stats.triangles += static_cast<uint64_t>(m_currentGeometry->indexCount() / 3) * drawOffsetCount.second;
+}
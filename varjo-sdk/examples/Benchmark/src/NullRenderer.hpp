@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <chrono>
+#include <memory>
+
+#include "IRenderer.hpp"
+
+/**
+ * Geometry that keeps vertex and index data in system memory.
+ */
+class NullGeometry final : public Geometry
+{
+public:
+    NullGeometry(uint32_t vertexCount, uint32_t indexCount);
+
+    void updateVertexBuffer(void* data) override;
+    void updateIndexBuffer(void* data) override;
+
+private:
+    std::vector<uint8_t> m_vertexData;
+    std::vector<uint8_t> m_indexData;
+};
+
+class NullRenderTexture final : public RenderTexture
+{
+public:
+    NullRenderTexture(int32_t width, int32_t height, varjo_Texture texture)
+        : RenderTexture(width, height)
+        , m_texture(texture)
+    {
+    }
+
+    varjo_Texture texture() const override { return m_texture; }
+
+private:
+    varjo_Texture m_texture;
+};
+
+/**
+ * Renderer that doesn't use a GPU, the compositor or the Varjo runtime.
+ *
+ * Runs the whole CPU side of IRenderer::render: world matrices, instance groups, instance buffer upload,
+ * viewport and foveation selection and VRS configs. Draw calls are only counted. Swap chains, frame
+ * submission and frame pacing are replaced with a local stand-in, so frames are produced as fast as the
+ * CPU allows and the profiler frame times measure CPU overhead. View count, texture sizes, FOV tangents,
+ * view poses and occlusion meshes come from a fixed configuration, so the session may be null.
+ */
+class NullRenderer final : public IRenderer
+{
+public:
+    NullRenderer(varjo_Session* session, const RendererSettings& renderer_settings);
+    ~NullRenderer() override;
+
+    std::shared_ptr<Geometry> createGeometry(uint32_t vertexCount, uint32_t indexCount) override;
+    std::shared_ptr<RenderTexture> createColorTexture(int32_t width, int32_t height, varjo_Texture colorTexture) override;
+    std::shared_ptr<RenderTexture> createDepthTexture(int32_t width, int32_t height, varjo_Texture depthTexture) override;
+    std::shared_ptr<RenderTexture> createVelocityTexture(int32_t width, int32_t height, varjo_Texture velocityTexture) override;
+
+    bool isVrsSupported() const override { return true; }
+    void finishRendering() override;
+    void recreateOcclusionMesh(uint32_t viewIndex) override;
+
+    void waitSync(varjo_FrameInfo* frameInfo) override;
+    varjo_FrameInfo* createFrameInfo() override;
+    void freeFrameInfo(varjo_FrameInfo* frameInfo) override;
+
+protected:
+    void renderOcclusionMesh() override;
+
+private:
+    bool initVarjo() override;
+    void createSwapchains() override;
+    varjo_SwapChain* createSwapChain(varjo_SwapChainConfig2& swapchainConfig) override;
+
+    void beginFrame() override;
+    void endFrame(varjo_SubmitInfoLayers& submitInfo) override;
+    int32_t acquireSwapChainImage(varjo_SwapChain* swapChain) override;
+    void releaseSwapChainImage(varjo_SwapChain* swapChain) override;
+    varjo_Texture getSwapChainImage(varjo_SwapChain* swapChain, int32_t index) override;
+    void freeSwapChain(varjo_SwapChain* swapChain) override;
+
+    int32_t getViewCount() const override;
+    void getTextureSize(varjo_TextureSize_Type type, int32_t viewIndex, int32_t& width, int32_t& height) const override;
+    varjo_FovTangents getFovTangents(int32_t viewIndex, const varjo_Gaze* foveationGaze) const override;
+    bool getRenderingGaze(varjo_Gaze& /*gaze*/) const override { return false; }
+
+    void bindRenderTarget(const RenderTargetTextures& renderTarget) override;
+    void unbindRenderTarget() override;
+    void clearRenderTarget(const RenderTargetTextures& renderTarget, float r, float g, float b, float a) override;
+    void freeCurrentRenderTarget() override;
+
+    void useGeometry(const std::shared_ptr<Geometry>& geometry) override;
+
+    void setupCamera(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) override;
+    void setViewport(const varjo_Viewport& viewport) override;
+    void updateVrsMap(const varjo_Viewport& viewport) override;
+    void uploadInstanceBuffer(const std::vector<std::vector<ObjectRenderData>>& matrices) override;
+
+    void drawGrid() override;
+    void drawObjects(std::size_t objectsIndex) override;
+    void drawMirrorWindow() override {}
+    void advance() override {}
+
+    varjo_ClipRange getClipRange() const override { return varjo_ClipRangeZeroToOne; }
+
+    // Stand-in for a compositor swap chain. Images are only handles, no memory is allocated for them.
+    struct SwapChain {
+        varjo_SwapChainConfig2 config;
+        int32_t currentImage;
+        bool acquired;
+    };
+
+    SwapChain& getSwapChain(varjo_SwapChain* swapChain);
+
+    struct InstanceBuffer {
+        std::vector<ObjectRenderData> data;
+        std::vector<std::pair<std::size_t, std::size_t>> drawsOffsetCount;
+    };
+
+    struct FrameStats {
+        uint64_t frameCount;
+        uint64_t drawCalls;
+        uint64_t instances;
+        uint64_t triangles;
+    };
+
+    static constexpr int32_t c_vrsTileSize = 16;
+
+    std::vector<std::unique_ptr<SwapChain>> m_swapChains;
+    bool m_frameStarted = false;
+
+    // Display time of frames advances by wall clock from construction
+    std::chrono::steady_clock::time_point m_startTime;
+
+    InstanceBuffer m_instanceBuffer;
+    RenderTargetTextures m_currentRenderTarget;
+    varjo_Viewport m_currentViewport{};
+    glm::mat4 m_viewMatrix{1.0f};
+    glm::mat4 m_projectionMatrix{1.0f};
+    varjo_VariableRateShadingConfig m_vrsConfig{};
+    std::array<int32_t, 2> m_occlusionMeshVertexCount = {};
+
+    FrameStats m_stats = {};
+};
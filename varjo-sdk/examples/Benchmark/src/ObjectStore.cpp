@@ -0,0 +1,753 @@
+#include "ObjectStore.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OBJECT_STORE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows using any intrinsics without compiler flags, GCC and Clang need per function target attributes.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+namespace
+{
+using Object = IRenderer::Object;
+using ObjectRenderData = IRenderer::ObjectRenderData;
+
+// Pointers to the component arrays of a store, indexed with ObjectStore::Component
+using Components = float* const*;
+using ConstComponents = const float* const*;
+
+// Objects with slower rotation are not rotated, same as IRenderer::applyObjectVelocity
+constexpr float c_minRotationSpeed = std::numeric_limits<float>::epsilon();
+
+// Scalar kernels use glm, so they produce the same results as the AoS code path
+
+glm::quat loadOrientation(ConstComponents c, std::size_t i)
+{
+    return glm::quat(c[ObjectStore::ORIENTATION_W][i], c[ObjectStore::ORIENTATION_X][i], c[ObjectStore::ORIENTATION_Y][i], c[ObjectStore::ORIENTATION_Z][i]);
+}
+
+glm::quat rotateOrientation(ConstComponents c, std::size_t i, float timeDeltaSec)
+{
+    const glm::quat orientation = loadOrientation(c, i);
+    const float speed = c[ObjectStore::ROTATION_SPEED][i];
+    if (std::abs(speed) <= c_minRotationSpeed) {
+        return orientation;
+    }
+
+    const glm::vec3 axis{c[ObjectStore::ROTATION_AXIS_X][i], c[ObjectStore::ROTATION_AXIS_Y][i], c[ObjectStore::ROTATION_AXIS_Z][i]};
+    return glm::normalize(orientation * glm::angleAxis(speed * timeDeltaSec, axis));
+}
+
+glm::mat4 getWorldMatrix(ConstComponents c, std::size_t i, const glm::quat& orientation)
+{
+    glm::mat4 matrix = glm::toMat4(orientation);
+    matrix[3][0] = c[ObjectStore::POSITION_X][i];
+    matrix[3][1] = c[ObjectStore::POSITION_Y][i];
+    matrix[3][2] = c[ObjectStore::POSITION_Z][i];
+    return glm::scale(matrix, glm::vec3{c[ObjectStore::SCALE_X][i], c[ObjectStore::SCALE_Y][i], c[ObjectStore::SCALE_Z][i]});
+}
+
+void applyVelocityScalar(Components c, std::size_t begin, std::size_t end, float timeDeltaSec)
+{
+    for (std::size_t i = begin; i < end; i++) {
+        const glm::quat orientation = rotateOrientation(c, i, timeDeltaSec);
+        c[ObjectStore::ORIENTATION_X][i] = orientation.x;
+        c[ObjectStore::ORIENTATION_Y][i] = orientation.y;
+        c[ObjectStore::ORIENTATION_Z][i] = orientation.z;
+        c[ObjectStore::ORIENTATION_W][i] = orientation.w;
+    }
+}
+
+void calculateWorldMatricesScalar(ConstComponents c, ObjectRenderData* out, std::size_t begin, std::size_t end, bool useVelocity, float velocityTimeDelta)
+{
+    for (std::size_t i = begin; i < end; i++, out++) {
+        out->world = getWorldMatrix(c, i, loadOrientation(c, i));
+        out->nextFrameWorld = useVelocity ? getWorldMatrix(c, i, rotateOrientation(c, i, velocityTimeDelta)) : out->world;
+    }
+}
+
+// Returns bounding sphere radius of object at given index
+float getSphereRadius(ConstComponents c, std::size_t i, float geometryRadius)
+{
+    const float scale = (std::max)({std::abs(c[ObjectStore::SCALE_X][i]), std::abs(c[ObjectStore::SCALE_Y][i]), std::abs(c[ObjectStore::SCALE_Z][i])});
+    return geometryRadius * scale;
+}
+
+std::size_t cullSpheresScalar(ConstComponents c, std::size_t count, const glm::vec4* planes, std::size_t planeCount, float geometryRadius, uint32_t* out)
+{
+    std::size_t visibleCount = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        const glm::vec3 center{c[ObjectStore::POSITION_X][i], c[ObjectStore::POSITION_Y][i], c[ObjectStore::POSITION_Z][i]};
+        const float radius = getSphereRadius(c, i, geometryRadius);
+
+        bool visible = true;
+        for (std::size_t p = 0; p < planeCount && visible; p++) {
+            visible = glm::dot(glm::vec3(planes[p]), center) + planes[p].w >= -radius;
+        }
+
+        // Write unconditionally and advance only for visible objects
+        out[visibleCount] = static_cast<uint32_t>(i);
+        visibleCount += visible ? 1 : 0;
+    }
+    return visibleCount;
+}
+
+// Polynomial sin and cos used by the vector kernels. Angle is reduced to [-pi, pi], and both functions are
+// evaluated as sin(x) on [-pi/2, pi/2] with the Taylor series up to x^11. Truncation error is below 6e-8.
+constexpr float c_halfPi = 1.57079632679490f;
+constexpr float c_invTwoPi = 0.159154943091895f;
+// 2*pi split in two parts, so that k * c_twoPiHigh is exact for the reduction
+constexpr float c_twoPiHigh = 6.28125f;
+constexpr float c_twoPiLow = 1.93530717958647e-3f;
+constexpr float c_sinCoeffs[] = {-1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f, 1.0f / 362880.0f, -1.0f / 39916800.0f};
+
+#ifdef OBJECT_STORE_X86
+
+// Lane count of the AVX2 kernels
+constexpr std::size_t c_avx2Lanes = 8;
+// Lane count of the AVX-512 kernels
+constexpr std::size_t c_avx512Lanes = 16;
+
+// Transpose 8x8 matrix held in rows
+TARGET_AVX2 inline void transpose8x8(__m256 r[8])
+{
+    const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+    const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+    const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+    const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Store matrices of count <= 8 objects. Element e of lane k is element e of the column major matrix of object k.
+TARGET_AVX2 inline void storeMatricesAVX2(const __m256 elements[16], glm::mat4* out, std::size_t count, std::size_t stride)
+{
+    __m256 low[8];
+    __m256 high[8];
+    std::copy(elements, elements + 8, low);
+    std::copy(elements + 8, elements + 16, high);
+    transpose8x8(low);
+    transpose8x8(high);
+
+    for (std::size_t k = 0; k < count; k++) {
+        float* matrix = glm::value_ptr(out[k * stride]);
+        _mm256_storeu_ps(matrix, low[k]);
+        _mm256_storeu_ps(matrix + 8, high[k]);
+    }
+}
+
+// Returns sin(x) for x in [-pi/2, pi/2]
+TARGET_AVX2 inline __m256 sinPolyAVX2(__m256 x)
+{
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_set1_ps(c_sinCoeffs[4]);
+    p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(c_sinCoeffs[3]));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(c_sinCoeffs[2]));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(c_sinCoeffs[1]));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(c_sinCoeffs[0]));
+    return _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(p, x2), x));
+}
+
+TARGET_AVX2 inline void sinCosAVX2(__m256 x, __m256& sin, __m256& cos)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 halfPi = _mm256_set1_ps(c_halfPi);
+
+    // Reduce to [-pi, pi]
+    const __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(c_invTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(c_twoPiHigh)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(c_twoPiLow)));
+
+    // sin(x) = sign(x) * sin(pi/2 - |pi/2 - |x||), cos(x) = sin(pi/2 - |x|)
+    const __m256 sign = _mm256_and_ps(x, signMask);
+    const __m256 absX = _mm256_andnot_ps(signMask, x);
+    const __m256 sinArg = _mm256_sub_ps(halfPi, _mm256_andnot_ps(signMask, _mm256_sub_ps(halfPi, absX)));
+    sin = _mm256_xor_ps(sinPolyAVX2(sinArg), sign);
+    cos = sinPolyAVX2(_mm256_sub_ps(halfPi, absX));
+}
+
+// Quaternion components of 8 objects
+struct QuatAVX2 {
+    __m256 x, y, z, w;
+};
+
+TARGET_AVX2 inline QuatAVX2 loadOrientationAVX2(ConstComponents c, std::size_t i)
+{
+    return {_mm256_loadu_ps(c[ObjectStore::ORIENTATION_X] + i), _mm256_loadu_ps(c[ObjectStore::ORIENTATION_Y] + i),
+        _mm256_loadu_ps(c[ObjectStore::ORIENTATION_Z] + i), _mm256_loadu_ps(c[ObjectStore::ORIENTATION_W] + i)};
+}
+
+// Vector version of rotateOrientation()
+TARGET_AVX2 inline QuatAVX2 rotateOrientationAVX2(ConstComponents c, std::size_t i, const QuatAVX2& q, float timeDeltaSec)
+{
+    const __m256 speed = _mm256_loadu_ps(c[ObjectStore::ROTATION_SPEED] + i);
+    const __m256 absSpeed = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), speed);
+    const __m256 rotating = _mm256_cmp_ps(absSpeed, _mm256_set1_ps(c_minRotationSpeed), _CMP_GT_OQ);
+    if (_mm256_movemask_ps(rotating) == 0) {
+        return q;
+    }
+
+    // Rotation quaternion from angle and axis like glm::angleAxis, axis is not normalized
+    __m256 sin, cos;
+    sinCosAVX2(_mm256_mul_ps(speed, _mm256_set1_ps(timeDeltaSec * 0.5f)), sin, cos);
+    const __m256 rx = _mm256_mul_ps(_mm256_loadu_ps(c[ObjectStore::ROTATION_AXIS_X] + i), sin);
+    const __m256 ry = _mm256_mul_ps(_mm256_loadu_ps(c[ObjectStore::ROTATION_AXIS_Y] + i), sin);
+    const __m256 rz = _mm256_mul_ps(_mm256_loadu_ps(c[ObjectStore::ROTATION_AXIS_Z] + i), sin);
+    const __m256 rw = cos;
+
+    // q * r
+    QuatAVX2 p;
+    p.w = _mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(q.w, rw), _mm256_mul_ps(q.x, rx)), _mm256_add_ps(_mm256_mul_ps(q.y, ry), _mm256_mul_ps(q.z, rz)));
+    p.x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(q.w, rx), _mm256_mul_ps(q.x, rw)), _mm256_sub_ps(_mm256_mul_ps(q.y, rz), _mm256_mul_ps(q.z, ry)));
+    p.y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(q.w, ry), _mm256_mul_ps(q.y, rw)), _mm256_sub_ps(_mm256_mul_ps(q.z, rx), _mm256_mul_ps(q.x, rz)));
+    p.z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(q.w, rz), _mm256_mul_ps(q.z, rw)), _mm256_sub_ps(_mm256_mul_ps(q.x, ry), _mm256_mul_ps(q.y, rx)));
+
+    // Normalize like glm::normalize, zero length becomes identity
+    const __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p.x, p.x), _mm256_mul_ps(p.y, p.y)),  //
+        _mm256_add_ps(_mm256_mul_ps(p.z, p.z), _mm256_mul_ps(p.w, p.w)));
+    const __m256 length = _mm256_sqrt_ps(lengthSq);
+    const __m256 valid = _mm256_and_ps(rotating, _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ));
+    const __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.0f), length);
+    const __m256 identity = _mm256_andnot_ps(valid, rotating);
+
+    QuatAVX2 result;
+    result.x = _mm256_blendv_ps(q.x, _mm256_and_ps(_mm256_mul_ps(p.x, invLength), valid), rotating);
+    result.y = _mm256_blendv_ps(q.y, _mm256_and_ps(_mm256_mul_ps(p.y, invLength), valid), rotating);
+    result.z = _mm256_blendv_ps(q.z, _mm256_and_ps(_mm256_mul_ps(p.z, invLength), valid), rotating);
+    result.w = _mm256_blendv_ps(q.w, _mm256_blendv_ps(_mm256_mul_ps(p.w, invLength), _mm256_set1_ps(1.0f), identity), rotating);
+    return result;
+}
+
+// Vector version of getWorldMatrix(). Returns the 16 column major matrix elements.
+TARGET_AVX2 inline void getWorldMatricesAVX2(ConstComponents c, std::size_t i, const QuatAVX2& q, __m256 e[16])
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 xx = _mm256_mul_ps(q.x, q.x);
+    const __m256 yy = _mm256_mul_ps(q.y, q.y);
+    const __m256 zz = _mm256_mul_ps(q.z, q.z);
+    const __m256 xy = _mm256_mul_ps(q.x, q.y);
+    const __m256 xz = _mm256_mul_ps(q.x, q.z);
+    const __m256 yz = _mm256_mul_ps(q.y, q.z);
+    const __m256 wx = _mm256_mul_ps(q.w, q.x);
+    const __m256 wy = _mm256_mul_ps(q.w, q.y);
+    const __m256 wz = _mm256_mul_ps(q.w, q.z);
+
+    const __m256 sx = _mm256_loadu_ps(c[ObjectStore::SCALE_X] + i);
+    const __m256 sy = _mm256_loadu_ps(c[ObjectStore::SCALE_Y] + i);
+    const __m256 sz = _mm256_loadu_ps(c[ObjectStore::SCALE_Z] + i);
+
+    e[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+    e[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+    e[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+    e[3] = _mm256_setzero_ps();
+    e[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+    e[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+    e[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+    e[7] = _mm256_setzero_ps();
+    e[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+    e[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+    e[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+    e[11] = _mm256_setzero_ps();
+    e[12] = _mm256_loadu_ps(c[ObjectStore::POSITION_X] + i);
+    e[13] = _mm256_loadu_ps(c[ObjectStore::POSITION_Y] + i);
+    e[14] = _mm256_loadu_ps(c[ObjectStore::POSITION_Z] + i);
+    e[15] = one;
+}
+
+TARGET_AVX2 void applyVelocityAVX2(Components c, std::size_t begin, std::size_t end, float timeDeltaSec)
+{
+    // Padding past the end is written too, padded objects don't rotate
+    for (std::size_t i = begin; i < end; i += c_avx2Lanes) {
+        const QuatAVX2 q = rotateOrientationAVX2(c, i, loadOrientationAVX2(c, i), timeDeltaSec);
+        _mm256_storeu_ps(c[ObjectStore::ORIENTATION_X] + i, q.x);
+        _mm256_storeu_ps(c[ObjectStore::ORIENTATION_Y] + i, q.y);
+        _mm256_storeu_ps(c[ObjectStore::ORIENTATION_Z] + i, q.z);
+        _mm256_storeu_ps(c[ObjectStore::ORIENTATION_W] + i, q.w);
+    }
+}
+
+TARGET_AVX2 void calculateWorldMatricesAVX2(ConstComponents c, ObjectRenderData* out, std::size_t begin, std::size_t end, bool useVelocity, float velocityTimeDelta)
+{
+    // Matrices are written in place of ObjectRenderData::world and nextFrameWorld
+    constexpr std::size_t stride = sizeof(ObjectRenderData) / sizeof(glm::mat4);
+
+    for (std::size_t i = begin; i < end; i += c_avx2Lanes, out += c_avx2Lanes) {
+        const std::size_t count = (std::min)(c_avx2Lanes, end - i);
+        const QuatAVX2 q = loadOrientationAVX2(c, i);
+
+        __m256 e[16];
+        getWorldMatricesAVX2(c, i, q, e);
+        storeMatricesAVX2(e, &out->world, count, stride);
+
+        if (useVelocity) {
+            getWorldMatricesAVX2(c, i, rotateOrientationAVX2(c, i, q, velocityTimeDelta), e);
+        }
+        storeMatricesAVX2(e, &out->nextFrameWorld, count, stride);
+    }
+}
+
+TARGET_AVX2 std::size_t cullSpheresAVX2(
+    ConstComponents c, std::size_t count, const glm::vec4* planes, std::size_t planeCount, float geometryRadius, uint32_t* out)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    std::size_t visibleCount = 0;
+
+    // Padding past the end is tested too, but only lanes of real objects are written
+    for (std::size_t i = 0; i < count; i += c_avx2Lanes) {
+        const __m256 x = _mm256_loadu_ps(c[ObjectStore::POSITION_X] + i);
+        const __m256 y = _mm256_loadu_ps(c[ObjectStore::POSITION_Y] + i);
+        const __m256 z = _mm256_loadu_ps(c[ObjectStore::POSITION_Z] + i);
+        const __m256 sx = _mm256_and_ps(_mm256_loadu_ps(c[ObjectStore::SCALE_X] + i), absMask);
+        const __m256 sy = _mm256_and_ps(_mm256_loadu_ps(c[ObjectStore::SCALE_Y] + i), absMask);
+        const __m256 sz = _mm256_and_ps(_mm256_loadu_ps(c[ObjectStore::SCALE_Z] + i), absMask);
+        const __m256 negRadius = _mm256_mul_ps(_mm256_max_ps(_mm256_max_ps(sx, sy), sz), _mm256_set1_ps(-geometryRadius));
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (std::size_t p = 0; p < planeCount; p++) {
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes[p].x)), _mm256_mul_ps(y, _mm256_set1_ps(planes[p].y))),
+                _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(planes[p].z)), _mm256_set1_ps(planes[p].w)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+
+        // Compact visible lanes. Each lane writes its index and advances the output only when visible.
+        const int32_t mask = _mm256_movemask_ps(visible);
+        const std::size_t lanes = (std::min)(c_avx2Lanes, count - i);
+        for (std::size_t k = 0; k < lanes; k++) {
+            out[visibleCount] = static_cast<uint32_t>(i + k);
+            visibleCount += (mask >> k) & 1;
+        }
+    }
+    return visibleCount;
+}
+
+// Returns sin(x) for x in [-pi/2, pi/2]
+TARGET_AVX512 inline __m512 sinPolyAVX512(__m512 x)
+{
+    const __m512 x2 = _mm512_mul_ps(x, x);
+    __m512 p = _mm512_set1_ps(c_sinCoeffs[4]);
+    p = _mm512_add_ps(_mm512_mul_ps(p, x2), _mm512_set1_ps(c_sinCoeffs[3]));
+    p = _mm512_add_ps(_mm512_mul_ps(p, x2), _mm512_set1_ps(c_sinCoeffs[2]));
+    p = _mm512_add_ps(_mm512_mul_ps(p, x2), _mm512_set1_ps(c_sinCoeffs[1]));
+    p = _mm512_add_ps(_mm512_mul_ps(p, x2), _mm512_set1_ps(c_sinCoeffs[0]));
+    return _mm512_add_ps(x, _mm512_mul_ps(_mm512_mul_ps(p, x2), x));
+}
+
+// AVX-512F has no float bitwise operations, they need AVX-512DQ
+TARGET_AVX512 inline __m512 absAVX512(__m512 x) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(0x7fffffff))); }
+
+TARGET_AVX512 inline void sinCosAVX512(__m512 x, __m512& sin, __m512& cos)
+{
+    const __m512 halfPi = _mm512_set1_ps(c_halfPi);
+
+    // Reduce to [-pi, pi]
+    const __m512 k = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(c_invTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm512_sub_ps(x, _mm512_mul_ps(k, _mm512_set1_ps(c_twoPiHigh)));
+    x = _mm512_sub_ps(x, _mm512_mul_ps(k, _mm512_set1_ps(c_twoPiLow)));
+
+    // sin(x) = sign(x) * sin(pi/2 - |pi/2 - |x||), cos(x) = sin(pi/2 - |x|)
+    const __m512i sign = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(static_cast<int32_t>(0x80000000u)));
+    const __m512 absX = absAVX512(x);
+    const __m512 sinArg = _mm512_sub_ps(halfPi, absAVX512(_mm512_sub_ps(halfPi, absX)));
+    sin = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(sinPolyAVX512(sinArg)), sign));
+    cos = sinPolyAVX512(_mm512_sub_ps(halfPi, absX));
+}
+
+// Quaternion components of 16 objects
+struct QuatAVX512 {
+    __m512 x, y, z, w;
+};
+
+TARGET_AVX512 inline QuatAVX512 loadOrientationAVX512(ConstComponents c, std::size_t i)
+{
+    return {_mm512_loadu_ps(c[ObjectStore::ORIENTATION_X] + i), _mm512_loadu_ps(c[ObjectStore::ORIENTATION_Y] + i),
+        _mm512_loadu_ps(c[ObjectStore::ORIENTATION_Z] + i), _mm512_loadu_ps(c[ObjectStore::ORIENTATION_W] + i)};
+}
+
+// Vector version of rotateOrientation()
+TARGET_AVX512 inline QuatAVX512 rotateOrientationAVX512(ConstComponents c, std::size_t i, const QuatAVX512& q, float timeDeltaSec)
+{
+    const __m512 speed = _mm512_loadu_ps(c[ObjectStore::ROTATION_SPEED] + i);
+    const __mmask16 rotating = _mm512_cmp_ps_mask(absAVX512(speed), _mm512_set1_ps(c_minRotationSpeed), _CMP_GT_OQ);
+    if (rotating == 0) {
+        return q;
+    }
+
+    // Rotation quaternion from angle and axis like glm::angleAxis, axis is not normalized
+    __m512 sin, cos;
+    sinCosAVX512(_mm512_mul_ps(speed, _mm512_set1_ps(timeDeltaSec * 0.5f)), sin, cos);
+    const __m512 rx = _mm512_mul_ps(_mm512_loadu_ps(c[ObjectStore::ROTATION_AXIS_X] + i), sin);
+    const __m512 ry = _mm512_mul_ps(_mm512_loadu_ps(c[ObjectStore::ROTATION_AXIS_Y] + i), sin);
+    const __m512 rz = _mm512_mul_ps(_mm512_loadu_ps(c[ObjectStore::ROTATION_AXIS_Z] + i), sin);
+    const __m512 rw = cos;
+
+    // q * r
+    QuatAVX512 p;
+    p.w = _mm512_sub_ps(_mm512_sub_ps(_mm512_mul_ps(q.w, rw), _mm512_mul_ps(q.x, rx)), _mm512_add_ps(_mm512_mul_ps(q.y, ry), _mm512_mul_ps(q.z, rz)));
+    p.x = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(q.w, rx), _mm512_mul_ps(q.x, rw)), _mm512_sub_ps(_mm512_mul_ps(q.y, rz), _mm512_mul_ps(q.z, ry)));
+    p.y = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(q.w, ry), _mm512_mul_ps(q.y, rw)), _mm512_sub_ps(_mm512_mul_ps(q.z, rx), _mm512_mul_ps(q.x, rz)));
+    p.z = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(q.w, rz), _mm512_mul_ps(q.z, rw)), _mm512_sub_ps(_mm512_mul_ps(q.x, ry), _mm512_mul_ps(q.y, rx)));
+
+    // Normalize like glm::normalize, zero length becomes identity
+    const __m512 lengthSq = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(p.x, p.x), _mm512_mul_ps(p.y, p.y)),  //
+        _mm512_add_ps(_mm512_mul_ps(p.z, p.z), _mm512_mul_ps(p.w, p.w)));
+    const __m512 length = _mm512_sqrt_ps(lengthSq);
+    const __mmask16 valid = _mm512_mask_cmp_ps_mask(rotating, length, _mm512_setzero_ps(), _CMP_GT_OQ);
+    const __mmask16 identity = rotating & ~valid;
+    const __m512 invLength = _mm512_div_ps(_mm512_set1_ps(1.0f), length);
+
+    QuatAVX512 result;
+    result.x = _mm512_mask_blend_ps(identity, _mm512_mask_mul_ps(q.x, valid, p.x, invLength), _mm512_setzero_ps());
+    result.y = _mm512_mask_blend_ps(identity, _mm512_mask_mul_ps(q.y, valid, p.y, invLength), _mm512_setzero_ps());
+    result.z = _mm512_mask_blend_ps(identity, _mm512_mask_mul_ps(q.z, valid, p.z, invLength), _mm512_setzero_ps());
+    result.w = _mm512_mask_blend_ps(identity, _mm512_mask_mul_ps(q.w, valid, p.w, invLength), _mm512_set1_ps(1.0f));
+    return result;
+}
+
+// Vector version of getWorldMatrix(). Returns the 16 column major matrix elements.
+TARGET_AVX512 inline void getWorldMatricesAVX512(ConstComponents c, std::size_t i, const QuatAVX512& q, __m512 e[16])
+{
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 two = _mm512_set1_ps(2.0f);
+    const __m512 xx = _mm512_mul_ps(q.x, q.x);
+    const __m512 yy = _mm512_mul_ps(q.y, q.y);
+    const __m512 zz = _mm512_mul_ps(q.z, q.z);
+    const __m512 xy = _mm512_mul_ps(q.x, q.y);
+    const __m512 xz = _mm512_mul_ps(q.x, q.z);
+    const __m512 yz = _mm512_mul_ps(q.y, q.z);
+    const __m512 wx = _mm512_mul_ps(q.w, q.x);
+    const __m512 wy = _mm512_mul_ps(q.w, q.y);
+    const __m512 wz = _mm512_mul_ps(q.w, q.z);
+
+    const __m512 sx = _mm512_loadu_ps(c[ObjectStore::SCALE_X] + i);
+    const __m512 sy = _mm512_loadu_ps(c[ObjectStore::SCALE_Y] + i);
+    const __m512 sz = _mm512_loadu_ps(c[ObjectStore::SCALE_Z] + i);
+
+    e[0] = _mm512_mul_ps(_mm512_sub_ps(one, _mm512_mul_ps(two, _mm512_add_ps(yy, zz))), sx);
+    e[1] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_add_ps(xy, wz)), sx);
+    e[2] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_sub_ps(xz, wy)), sx);
+    e[3] = _mm512_setzero_ps();
+    e[4] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_sub_ps(xy, wz)), sy);
+    e[5] = _mm512_mul_ps(_mm512_sub_ps(one, _mm512_mul_ps(two, _mm512_add_ps(xx, zz))), sy);
+    e[6] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_add_ps(yz, wx)), sy);
+    e[7] = _mm512_setzero_ps();
+    e[8] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_add_ps(xz, wy)), sz);
+    e[9] = _mm512_mul_ps(_mm512_mul_ps(two, _mm512_sub_ps(yz, wx)), sz);
+    e[10] = _mm512_mul_ps(_mm512_sub_ps(one, _mm512_mul_ps(two, _mm512_add_ps(xx, yy))), sz);
+    e[11] = _mm512_setzero_ps();
+    e[12] = _mm512_loadu_ps(c[ObjectStore::POSITION_X] + i);
+    e[13] = _mm512_loadu_ps(c[ObjectStore::POSITION_Y] + i);
+    e[14] = _mm512_loadu_ps(c[ObjectStore::POSITION_Z] + i);
+    e[15] = one;
+}
+
+// Store matrices of count <= 16 objects by transposing both 8 lane halves with the AVX2 transpose
+TARGET_AVX512 inline void storeMatricesAVX512(const __m512 elements[16], glm::mat4* out, std::size_t count, std::size_t stride)
+{
+    __m256 low[16];
+    __m256 high[16];
+    for (int32_t j = 0; j < 16; j++) {
+        low[j] = _mm512_castps512_ps256(elements[j]);
+        high[j] = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(elements[j]), 1));
+    }
+
+    storeMatricesAVX2(low, out, (std::min)(count, c_avx2Lanes), stride);
+    if (count > c_avx2Lanes) {
+        storeMatricesAVX2(high, out + c_avx2Lanes * stride, count - c_avx2Lanes, stride);
+    }
+}
+
+TARGET_AVX512 void applyVelocityAVX512(Components c, std::size_t begin, std::size_t end, float timeDeltaSec)
+{
+    // Padding past the end is written too, padded objects don't rotate
+    for (std::size_t i = begin; i < end; i += c_avx512Lanes) {
+        const QuatAVX512 q = rotateOrientationAVX512(c, i, loadOrientationAVX512(c, i), timeDeltaSec);
+        _mm512_storeu_ps(c[ObjectStore::ORIENTATION_X] + i, q.x);
+        _mm512_storeu_ps(c[ObjectStore::ORIENTATION_Y] + i, q.y);
+        _mm512_storeu_ps(c[ObjectStore::ORIENTATION_Z] + i, q.z);
+        _mm512_storeu_ps(c[ObjectStore::ORIENTATION_W] + i, q.w);
+    }
+}
+
+TARGET_AVX512 void calculateWorldMatricesAVX512(
+    ConstComponents c, ObjectRenderData* out, std::size_t begin, std::size_t end, bool useVelocity, float velocityTimeDelta)
+{
+    // Matrices are written in place of ObjectRenderData::world and nextFrameWorld
+    constexpr std::size_t stride = sizeof(ObjectRenderData) / sizeof(glm::mat4);
+
+    for (std::size_t i = begin; i < end; i += c_avx512Lanes, out += c_avx512Lanes) {
+        const std::size_t count = (std::min)(c_avx512Lanes, end - i);
+        const QuatAVX512 q = loadOrientationAVX512(c, i);
+
+        __m512 e[16];
+        getWorldMatricesAVX512(c, i, q, e);
+        storeMatricesAVX512(e, &out->world, count, stride);
+
+        if (useVelocity) {
+            getWorldMatricesAVX512(c, i, rotateOrientationAVX512(c, i, q, velocityTimeDelta), e);
+        }
+        storeMatricesAVX512(e, &out->nextFrameWorld, count, stride);
+    }
+}
+
+TARGET_AVX512 std::size_t cullSpheresAVX512(
+    ConstComponents c, std::size_t count, const glm::vec4* planes, std::size_t planeCount, float geometryRadius, uint32_t* out)
+{
+    const __m512i laneIndices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    std::size_t visibleCount = 0;
+
+    // Padding past the end is tested too, but only lanes of real objects are written
+    for (std::size_t i = 0; i < count; i += c_avx512Lanes) {
+        const __m512 x = _mm512_loadu_ps(c[ObjectStore::POSITION_X] + i);
+        const __m512 y = _mm512_loadu_ps(c[ObjectStore::POSITION_Y] + i);
+        const __m512 z = _mm512_loadu_ps(c[ObjectStore::POSITION_Z] + i);
+        const __m512 sx = absAVX512(_mm512_loadu_ps(c[ObjectStore::SCALE_X] + i));
+        const __m512 sy = absAVX512(_mm512_loadu_ps(c[ObjectStore::SCALE_Y] + i));
+        const __m512 sz = absAVX512(_mm512_loadu_ps(c[ObjectStore::SCALE_Z] + i));
+        const __m512 negRadius = _mm512_mul_ps(_mm512_max_ps(_mm512_max_ps(sx, sy), sz), _mm512_set1_ps(-geometryRadius));
+
+        const std::size_t lanes = (std::min)(c_avx512Lanes, count - i);
+        __mmask16 visible = static_cast<__mmask16>((1u << lanes) - 1);
+        for (std::size_t p = 0; p < planeCount; p++) {
+            const __m512 distance = _mm512_add_ps(
+                _mm512_add_ps(_mm512_mul_ps(x, _mm512_set1_ps(planes[p].x)), _mm512_mul_ps(y, _mm512_set1_ps(planes[p].y))),
+                _mm512_add_ps(_mm512_mul_ps(z, _mm512_set1_ps(planes[p].z)), _mm512_set1_ps(planes[p].w)));
+            visible = _mm512_mask_cmp_ps_mask(visible, distance, negRadius, _CMP_GE_OQ);
+        }
+
+        // Compact indices of visible lanes with a single compress store
+        const __m512i indices = _mm512_add_epi32(laneIndices, _mm512_set1_epi32(static_cast<int32_t>(i)));
+        _mm512_mask_compressstoreu_epi32(out + visibleCount, visible, indices);
+        visibleCount += std::bitset<c_avx512Lanes>(visible).count();
+    }
+    return visibleCount;
+}
+
+// Detect instruction set support
+ObjectStore::SimdLevel detectSimdLevel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        // Check that OS saves YMM registers, and ZMM registers and mask registers for AVX-512
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+        const bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+        __cpuidex(info, 7, 0);
+        avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+        avx512 = zmmEnabled && (info[1] & (1 << 16)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    const bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+
+    if (avx512) {
+        return ObjectStore::SimdLevel::AVX512;
+    } else if (avx2) {
+        return ObjectStore::SimdLevel::AVX2;
+    }
+    return ObjectStore::SimdLevel::SCALAR;
+}
+
+#else
+
+ObjectStore::SimdLevel detectSimdLevel() { return ObjectStore::SimdLevel::SCALAR; }
+
+#endif  // OBJECT_STORE_X86
+
+}  // namespace
+
+ObjectStore::SimdLevel ObjectStore::getSupportedSimdLevel()
+{
+    static const SimdLevel s_level = detectSimdLevel();
+    return s_level;
+}
+
+const char* ObjectStore::getSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+ObjectStore::ObjectStore(std::shared_ptr<Geometry> geometry)
+    : m_geometry(std::move(geometry))
+    , m_simdLevel(getSupportedSimdLevel())
+{
+}
+
+void ObjectStore::reserve(std::size_t count)
+{
+    const std::size_t paddedCount = (count + c_laneCount - 1) / c_laneCount * c_laneCount;
+    for (auto& values : m_components) {
+        values.reserve(paddedCount);
+    }
+}
+
+void ObjectStore::clear()
+{
+    m_size = 0;
+    for (auto& values : m_components) {
+        values.clear();
+    }
+}
+
+void ObjectStore::add(const IRenderer::Object& object)
+{
+    if (m_size == paddedSize()) {
+        // Append a block of identity objects that don't rotate
+        const std::size_t paddedCount = m_size + c_laneCount;
+        for (int32_t c = 0; c < COMPONENT_COUNT; c++) {
+            const bool one = (c == SCALE_X || c == SCALE_Y || c == SCALE_Z || c == ORIENTATION_W);
+            m_components[c].resize(paddedCount, one ? 1.0f : 0.0f);
+        }
+    }
+
+    const std::size_t i = m_size++;
+    m_components[POSITION_X][i] = object.position.x;
+    m_components[POSITION_Y][i] = object.position.y;
+    m_components[POSITION_Z][i] = object.position.z;
+    m_components[SCALE_X][i] = object.scale.x;
+    m_components[SCALE_Y][i] = object.scale.y;
+    m_components[SCALE_Z][i] = object.scale.z;
+    m_components[ORIENTATION_X][i] = object.orientation.x;
+    m_components[ORIENTATION_Y][i] = object.orientation.y;
+    m_components[ORIENTATION_Z][i] = object.orientation.z;
+    m_components[ORIENTATION_W][i] = object.orientation.w;
+    m_components[ROTATION_AXIS_X][i] = object.velocity.rotationAxis.x;
+    m_components[ROTATION_AXIS_Y][i] = object.velocity.rotationAxis.y;
+    m_components[ROTATION_AXIS_Z][i] = object.velocity.rotationAxis.z;
+    m_components[ROTATION_SPEED][i] = object.velocity.rotationSpeed;
+}
+
+IRenderer::Object ObjectStore::getObject(std::size_t index) const
+{
+    IRenderer::Object object{};
+    object.geometry = m_geometry;
+    object.position = {m_components[POSITION_X][index], m_components[POSITION_Y][index], m_components[POSITION_Z][index]};
+    object.scale = {m_components[SCALE_X][index], m_components[SCALE_Y][index], m_components[SCALE_Z][index]};
+    object.orientation = glm::quat(m_components[ORIENTATION_W][index], m_components[ORIENTATION_X][index], m_components[ORIENTATION_Y][index],
+        m_components[ORIENTATION_Z][index]);
+    object.velocity.rotationAxis = {m_components[ROTATION_AXIS_X][index], m_components[ROTATION_AXIS_Y][index], m_components[ROTATION_AXIS_Z][index]};
+    object.velocity.rotationSpeed = m_components[ROTATION_SPEED][index];
+    return object;
+}
+
+void ObjectStore::setSimdLevel(SimdLevel level)
+{
+    // Never use kernel that the CPU can't run
+    m_simdLevel = (std::min)(level, getSupportedSimdLevel());
+}
+
+void ObjectStore::applyVelocity(float timeDeltaSec)
+{
+    float* components[COMPONENT_COUNT];
+    for (int32_t c = 0; c < COMPONENT_COUNT; c++) {
+        components[c] = m_components[c].data();
+    }
+
+    switch (m_simdLevel) {
+#ifdef OBJECT_STORE_X86
+        case SimdLevel::AVX512: applyVelocityAVX512(components, 0, m_size, timeDeltaSec); break;
+        case SimdLevel::AVX2: applyVelocityAVX2(components, 0, m_size, timeDeltaSec); break;
+#endif
+        default: applyVelocityScalar(components, 0, m_size, timeDeltaSec); break;
+    }
+}
+
+std::size_t ObjectStore::cullSpheres(const glm::vec4* planes, std::size_t planeCount, float geometryRadius, uint32_t* visibleIndices) const
+{
+    const float* components[COMPONENT_COUNT];
+    for (int32_t c = 0; c < COMPONENT_COUNT; c++) {
+        components[c] = m_components[c].data();
+    }
+
+    switch (m_simdLevel) {
+#ifdef OBJECT_STORE_X86
+        case SimdLevel::AVX512: return cullSpheresAVX512(components, m_size, planes, planeCount, geometryRadius, visibleIndices);
+        case SimdLevel::AVX2: return cullSpheresAVX2(components, m_size, planes, planeCount, geometryRadius, visibleIndices);
+#endif
+        default: return cullSpheresScalar(components, m_size, planes, planeCount, geometryRadius, visibleIndices);
+    }
+}
+
+void ObjectStore::calculateWorldMatrices(IRenderer::ObjectRenderData* out, std::size_t begin, std::size_t end, bool useVelocity, float velocityTimeDelta) const
+{
+    const float* components[COMPONENT_COUNT];
+    for (int32_t c = 0; c < COMPONENT_COUNT; c++) {
+        components[c] = m_components[c].data();
+    }
+
+    if (begin >= end) {
+        return;
+    }
+
+    // Vector kernels read whole vectors starting from begin, the last one must stay within the padding
+    const std::size_t lanes = m_simdLevel == SimdLevel::AVX512 ? 16 : 8;
+    const std::size_t lastVector = begin + (end - begin - 1) / lanes * lanes;
+    if (lastVector + lanes > paddedSize()) {
+        calculateWorldMatricesScalar(components, out, begin, end, useVelocity, velocityTimeDelta);
+        return;
+    }
+
+    switch (m_simdLevel) {
+#ifdef OBJECT_STORE_X86
+        case SimdLevel::AVX512: calculateWorldMatricesAVX512(components, out, begin, end, useVelocity, velocityTimeDelta); break;
+        case SimdLevel::AVX2: calculateWorldMatricesAVX2(components, out, begin, end, useVelocity, velocityTimeDelta); break;
+#endif
+        default: calculateWorldMatricesScalar(components, out, begin, end, useVelocity, velocityTimeDelta); break;
+    }
+}
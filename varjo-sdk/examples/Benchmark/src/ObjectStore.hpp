@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "IRenderer.hpp"
+
+/**
+ * Structure-of-arrays storage for a group of objects that share a geometry.
+ *
+ * Position, scale, orientation and angular velocity components are kept in separate arrays, so the
+ * per-frame velocity integration and world matrix generation run as vector kernels over many objects
+ * at once. World matrices are written straight into the instance data handed to the renderer. Arrays
+ * are padded to a multiple of c_laneCount with objects that don't rotate, so kernels never need a
+ * scalar tail loop for the math.
+ *
+ * Vector kernels approximate sin and cos with polynomials. Results differ from the glm based scalar
+ * kernel only by float rounding.
+ */
+class ObjectStore
+{
+public:
+    // Instruction set level used by the kernels
+    enum class SimdLevel {
+        SCALAR,  // Portable glm implementation, same math as IRenderer::applyObjectVelocity
+        AVX2,    // AVX2, 8 objects per iteration
+        AVX512,  // AVX-512F, 16 objects per iteration
+    };
+
+    // Widest vector kernel width, arrays are padded to a multiple of this
+    static constexpr std::size_t c_laneCount = 16;
+
+    // Returns the best instruction set level supported by the running CPU. Detected once and cached.
+    static SimdLevel getSupportedSimdLevel();
+
+    // Returns human readable name for given instruction set level
+    static const char* getSimdLevelName(SimdLevel level);
+
+    explicit ObjectStore(std::shared_ptr<Geometry> geometry);
+
+    // Geometry shared by all objects
+    const std::shared_ptr<Geometry>& geometry() const { return m_geometry; }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    void reserve(std::size_t count);
+    void clear();
+
+    // Append object. Geometry of the object is ignored, all objects use the geometry of the store.
+    void add(const IRenderer::Object& object);
+
+    // Returns object at given index as an AoS object
+    IRenderer::Object getObject(std::size_t index) const;
+
+    // Select kernel used by applyVelocity and calculateWorldMatrices. Falls back to the best supported level.
+    void setSimdLevel(SimdLevel level);
+    SimdLevel simdLevel() const { return m_simdLevel; }
+
+    // Rotate all objects by their angular velocity over given time and renormalize orientations
+    void applyVelocity(float timeDeltaSec);
+
+    // Write world matrices of objects [begin, end) to out[0, end - begin). With velocity, the next frame matrix
+    // is estimated by rotating the orientation over velocityTimeDelta, otherwise it is the same as the world matrix.
+    void calculateWorldMatrices(IRenderer::ObjectRenderData* out, std::size_t begin, std::size_t end, bool useVelocity, float velocityTimeDelta) const;
+
+    // Test object bounding spheres against planes and write indices of the objects that are not fully outside of any plane to
+    // visibleIndices, which must have room for size() values. Planes are (normal, distance) with unit length normals pointing
+    // inside. Sphere radius is geometryRadius scaled by the largest absolute scale component. Returns number of visible objects.
+    std::size_t cullSpheres(const glm::vec4* planes, std::size_t planeCount, float geometryRadius, uint32_t* visibleIndices) const;
+
+    // Component arrays, each holds paddedSize() values
+    enum Component {
+        POSITION_X,
+        POSITION_Y,
+        POSITION_Z,
+        SCALE_X,
+        SCALE_Y,
+        SCALE_Z,
+        ORIENTATION_X,
+        ORIENTATION_Y,
+        ORIENTATION_Z,
+        ORIENTATION_W,
+        ROTATION_AXIS_X,
+        ROTATION_AXIS_Y,
+        ROTATION_AXIS_Z,
+        ROTATION_SPEED,
+        COMPONENT_COUNT,
+    };
+
+    // Returns array of given component. Values past size() are padding.
+    const float* component(Component c) const { return m_components[c].data(); }
+
+    // Number of values in each component array, a multiple of c_laneCount
+    std::size_t paddedSize() const { return m_components[0].size(); }
+
+private:
+    std::shared_ptr<Geometry> m_geometry;
+    std::size_t m_size = 0;
+    std::vector<float> m_components[COMPONENT_COUNT];
+    SimdLevel m_simdLevel;
+};
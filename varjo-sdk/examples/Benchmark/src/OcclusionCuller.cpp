@@ -0,0 +1,310 @@
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OCCLUSION_CULLER_X86 1
+#include <immintrin.h>
+#endif
+
+// MSVC allows using any intrinsics without compiler flags, GCC and Clang need per function target attributes.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+// Occluder triangles with a vertex closer than this are dropped
+constexpr float c_minOccluderW = 0.1f;
+
+// Occluder triangles reaching further outside of the view than this, in normalized device coordinates, are dropped.
+// Keeps edge functions well within float precision.
+constexpr float c_guardBand = 4.0f;
+
+constexpr int32_t c_tilesX = OcclusionCuller::c_width / OcclusionCuller::c_tileSize;
+constexpr int32_t c_tilesY = OcclusionCuller::c_height / OcclusionCuller::c_tileSize;
+
+// Edge functions and depth plane of a triangle as a * x + b * y + c. A pixel is inside when all edge functions are
+// positive at its center.
+struct TriangleSetup {
+    glm::vec3 edge[3];
+    glm::vec3 depth;
+    int32_t minX;
+    int32_t minY;
+    int32_t maxX;
+    int32_t maxY;
+};
+
+void rasterizeScalar(const TriangleSetup& t, float* depth)
+{
+    for (int32_t y = t.minY; y <= t.maxY; y++) {
+        float* row = depth + y * OcclusionCuller::c_width;
+        for (int32_t x = t.minX; x <= t.maxX; x++) {
+            const glm::vec3 p{static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f, 1.0f};
+            if (glm::dot(t.edge[0], p) > 0.0f && glm::dot(t.edge[1], p) > 0.0f && glm::dot(t.edge[2], p) > 0.0f) {
+                row[x] = (std::max)(row[x], glm::dot(t.depth, p));
+            }
+        }
+    }
+}
+
+void buildTilesScalar(const float* depth, float* tileDepth)
+{
+    constexpr int32_t tileSize = OcclusionCuller::c_tileSize;
+    for (int32_t ty = 0; ty < c_tilesY; ty++) {
+        for (int32_t tx = 0; tx < c_tilesX; tx++) {
+            float farthest = std::numeric_limits<float>::max();
+            for (int32_t y = ty * tileSize; y < (ty + 1) * tileSize; y++) {
+                const float* row = depth + y * OcclusionCuller::c_width;
+                for (int32_t x = tx * tileSize; x < (tx + 1) * tileSize; x++) {
+                    farthest = (std::min)(farthest, row[x]);
+                }
+            }
+            tileDepth[ty * c_tilesX + tx] = farthest;
+        }
+    }
+}
+
+#ifdef OCCLUSION_CULLER_X86
+
+// Lane count of the AVX2 kernels
+constexpr int32_t c_avx2Lanes = 8;
+
+// Evaluate a * x + b * y + c for 8 pixels of a row
+TARGET_AVX2 inline __m256 evaluatePlaneAVX2(const glm::vec3& plane, __m256 x, float y)
+{
+    return _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x), _mm256_set1_ps(plane.y * y + plane.z));
+}
+
+TARGET_AVX2 void rasterizeAVX2(const TriangleSetup& t, float* depth)
+{
+    const __m256 zero = _mm256_setzero_ps();
+
+    // Rows are processed in groups of 8 pixels starting from an aligned x, pixels outside of the triangle fail the edge test
+    const int32_t startX = t.minX & ~(c_avx2Lanes - 1);
+    const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(startX)), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+    const float step = static_cast<float>(c_avx2Lanes);
+    const __m256 edgeStep0 = _mm256_set1_ps(t.edge[0].x * step);
+    const __m256 edgeStep1 = _mm256_set1_ps(t.edge[1].x * step);
+    const __m256 edgeStep2 = _mm256_set1_ps(t.edge[2].x * step);
+    const __m256 depthStep = _mm256_set1_ps(t.depth.x * step);
+
+    for (int32_t y = t.minY; y <= t.maxY; y++) {
+        const float py = static_cast<float>(y) + 0.5f;
+        __m256 edge0 = evaluatePlaneAVX2(t.edge[0], px, py);
+        __m256 edge1 = evaluatePlaneAVX2(t.edge[1], px, py);
+        __m256 edge2 = evaluatePlaneAVX2(t.edge[2], px, py);
+        __m256 z = evaluatePlaneAVX2(t.depth, px, py);
+
+        float* row = depth + y * OcclusionCuller::c_width;
+        for (int32_t x = startX; x <= t.maxX; x += c_avx2Lanes) {
+            const __m256 inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(edge0, zero, _CMP_GT_OQ), _mm256_cmp_ps(edge1, zero, _CMP_GT_OQ)), _mm256_cmp_ps(edge2, zero, _CMP_GT_OQ));
+            if (_mm256_movemask_ps(inside) != 0) {
+                const __m256 current = _mm256_loadu_ps(row + x);
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_max_ps(current, z), inside));
+            }
+
+            edge0 = _mm256_add_ps(edge0, edgeStep0);
+            edge1 = _mm256_add_ps(edge1, edgeStep1);
+            edge2 = _mm256_add_ps(edge2, edgeStep2);
+            z = _mm256_add_ps(z, depthStep);
+        }
+    }
+}
+
+TARGET_AVX2 void buildTilesAVX2(const float* depth, float* tileDepth)
+{
+    static_assert(OcclusionCuller::c_tileSize == c_avx2Lanes, "Tile row must be one AVX2 vector");
+
+    for (int32_t ty = 0; ty < c_tilesY; ty++) {
+        for (int32_t tx = 0; tx < c_tilesX; tx++) {
+            const float* tile = depth + ty * c_avx2Lanes * OcclusionCuller::c_width + tx * c_avx2Lanes;
+            __m256 farthest = _mm256_loadu_ps(tile);
+            for (int32_t y = 1; y < c_avx2Lanes; y++) {
+                farthest = _mm256_min_ps(farthest, _mm256_loadu_ps(tile + y * OcclusionCuller::c_width));
+            }
+
+            // Horizontal minimum of the 8 lanes
+            __m128 m = _mm_min_ps(_mm256_castps256_ps128(farthest), _mm256_extractf128_ps(farthest, 1));
+            m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+            m = _mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+            tileDepth[ty * c_tilesX + tx] = _mm_cvtss_f32(m);
+        }
+    }
+}
+
+#endif  // OCCLUSION_CULLER_X86
+
+}  // namespace
+
+OcclusionCuller::OcclusionCuller()
+    : m_depth(c_width * c_height, 0.0f)
+    , m_tileDepth(c_tilesX * c_tilesY, 0.0f)
+    , m_simdLevel(ObjectStore::getSupportedSimdLevel())
+{
+}
+
+void OcclusionCuller::setSimdLevel(ObjectStore::SimdLevel level)
+{
+    // Never use kernel that the CPU can't run
+    m_simdLevel = (std::min)(level, ObjectStore::getSupportedSimdLevel());
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_wScale = glm::length(glm::vec3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3]));
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+}
+
+void OcclusionCuller::addOccluder(const Geometry::OccluderMesh& mesh, const glm::mat4& world)
+{
+    const glm::mat4 worldViewProjection = m_viewProjection * world;
+    // Mirroring world matrix turns front faces clockwise
+    const bool mirrored = glm::determinant(glm::mat3(world)) < 0.0f;
+    m_clipVertices.resize(mesh.positions.size());
+    for (std::size_t i = 0; i < mesh.positions.size(); i++) {
+        m_clipVertices[i] = worldViewProjection * glm::vec4(mesh.positions[i], 1.0f);
+    }
+
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        glm::vec3 screen[3];
+        bool accepted = true;
+        for (int32_t v = 0; v < 3 && accepted; v++) {
+            const glm::vec4& clip = m_clipVertices[mesh.indices[i + v]];
+            if (clip.w < c_minOccluderW) {
+                accepted = false;
+                break;
+            }
+
+            const float invW = 1.0f / clip.w;
+            const float ndcX = clip.x * invW;
+            const float ndcY = clip.y * invW;
+            accepted = std::abs(ndcX) <= c_guardBand && std::abs(ndcY) <= c_guardBand;
+            screen[v] = {(ndcX * 0.5f + 0.5f) * c_width, (ndcY * 0.5f + 0.5f) * c_height, invW};
+        }
+
+        if (accepted) {
+            rasterizeTriangle(screen[0], mirrored ? screen[2] : screen[1], mirrored ? screen[1] : screen[2]);
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    // Back faces and degenerate triangles are skipped. Front faces of closed occluders hide the back faces anyway.
+    const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area < std::numeric_limits<float>::epsilon()) {
+        return;
+    }
+
+    TriangleSetup t;
+    t.minX = (std::max)(0, static_cast<int32_t>(std::floor((std::min)({v0.x, v1.x, v2.x}))));
+    t.minY = (std::max)(0, static_cast<int32_t>(std::floor((std::min)({v0.y, v1.y, v2.y}))));
+    t.maxX = (std::min)(c_width - 1, static_cast<int32_t>(std::floor((std::max)({v0.x, v1.x, v2.x}))));
+    t.maxY = (std::min)(c_height - 1, static_cast<int32_t>(std::floor((std::max)({v0.y, v1.y, v2.y}))));
+    if (t.minX > t.maxX || t.minY > t.maxY) {
+        return;
+    }
+
+    // Edge function of edge a->b is positive on the inner side of a counter-clockwise triangle
+    const glm::vec3* vertices[3] = {&v0, &v1, &v2};
+    for (int32_t e = 0; e < 3; e++) {
+        const glm::vec3& a = *vertices[e];
+        const glm::vec3& b = *vertices[(e + 1) % 3];
+        const float edgeA = -(b.y - a.y);
+        const float edgeB = b.x - a.x;
+        t.edge[e] = {edgeA, edgeB, -(edgeA * a.x + edgeB * a.y)};
+    }
+
+    // Depth is interpolated with barycentric weights, edge function of the opposite edge divided by the area
+    const float invArea = 1.0f / area;
+    t.depth = (t.edge[1] * v0.z + t.edge[2] * v1.z + t.edge[0] * v2.z) * invArea;
+
+    switch (m_simdLevel) {
+#ifdef OCCLUSION_CULLER_X86
+        case ObjectStore::SimdLevel::AVX512:
+        case ObjectStore::SimdLevel::AVX2: rasterizeAVX2(t, m_depth.data()); break;
+#endif
+        default: rasterizeScalar(t, m_depth.data()); break;
+    }
+}
+
+void OcclusionCuller::end()
+{
+    switch (m_simdLevel) {
+#ifdef OCCLUSION_CULLER_X86
+        case ObjectStore::SimdLevel::AVX512:
+        case ObjectStore::SimdLevel::AVX2: buildTilesAVX2(m_depth.data(), m_tileDepth.data()); break;
+#endif
+        default: buildTilesScalar(m_depth.data(), m_tileDepth.data()); break;
+    }
+}
+
+bool OcclusionCuller::isSphereVisible(const glm::vec3& center, float radius) const
+{
+    // Spheres reaching close to the eye are always visible
+    const glm::vec4 clipCenter = m_viewProjection * glm::vec4(center, 1.0f);
+    const float nearestW = clipCenter.w - radius * m_wScale;
+    if (nearestW < c_minOccluderW) {
+        return true;
+    }
+
+    // Screen rectangle of the bounding box corners
+    const glm::vec4 axes[3] = {m_viewProjection[0] * radius, m_viewProjection[1] * radius, m_viewProjection[2] * radius};
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    for (int32_t corner = 0; corner < 8; corner++) {
+        const glm::vec4 clip = clipCenter + ((corner & 1) ? axes[0] : -axes[0]) + ((corner & 2) ? axes[1] : -axes[1]) + ((corner & 4) ? axes[2] : -axes[2]);
+        if (clip.w < c_minOccluderW) {
+            return true;
+        }
+        minX = (std::min)(minX, clip.x / clip.w);
+        minY = (std::min)(minY, clip.y / clip.w);
+        maxX = (std::max)(maxX, clip.x / clip.w);
+        maxY = (std::max)(maxY, clip.y / clip.w);
+    }
+
+    // Objects outside of the buffer are left to frustum culling
+    if (maxX < -1.0f || maxY < -1.0f || minX > 1.0f || minY > 1.0f) {
+        return true;
+    }
+
+    const int32_t pixelMinX = (std::max)(0, static_cast<int32_t>(std::floor((minX * 0.5f + 0.5f) * c_width)));
+    const int32_t pixelMinY = (std::max)(0, static_cast<int32_t>(std::floor((minY * 0.5f + 0.5f) * c_height)));
+    const int32_t pixelMaxX = (std::min)(c_width - 1, static_cast<int32_t>(std::floor((maxX * 0.5f + 0.5f) * c_width)));
+    const int32_t pixelMaxY = (std::min)(c_height - 1, static_cast<int32_t>(std::floor((maxY * 0.5f + 0.5f) * c_height)));
+    return isRectVisible(pixelMinX, pixelMinY, pixelMaxX, pixelMaxY, 1.0f / nearestW);
+}
+
+bool OcclusionCuller::isRectVisible(int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const
+{
+    for (int32_t ty = minY / c_tileSize; ty <= maxY / c_tileSize; ty++) {
+        for (int32_t tx = minX / c_tileSize; tx <= maxX / c_tileSize; tx++) {
+            // Whole tile is nearer than the object
+            if (m_tileDepth[ty * c_tilesX + tx] > depth) {
+                continue;
+            }
+
+            // Test pixels of the rectangle within the tile
+            const int32_t tileMaxY = (std::min)(maxY, (ty + 1) * c_tileSize - 1);
+            const int32_t tileMaxX = (std::min)(maxX, (tx + 1) * c_tileSize - 1);
+            for (int32_t y = (std::max)(minY, ty * c_tileSize); y <= tileMaxY; y++) {
+                const float* row = m_depth.data() + y * c_width;
+                for (int32_t x = (std::max)(minX, tx * c_tileSize); x <= tileMaxX; x++) {
+                    if (row[x] <= depth) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
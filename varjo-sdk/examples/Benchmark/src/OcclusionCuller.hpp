@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Geometry.hpp"
+#include "ObjectStore.hpp"
+
+/**
+ * Software occlusion culler for one view.
+ *
+ * Occluder meshes are rasterized into a small depth buffer. The buffer stores 1/w, which interpolates linearly in screen
+ * space, so a larger value is nearer and cleared pixels are infinitely far. After rasterization a hierarchical level keeps
+ * the farthest depth of each tile. Bounding spheres are tested against the tiles first, and against single pixels only
+ * where the tile alone doesn't hide them.
+ *
+ * Occluder meshes must be inside the objects they stand for. Triangles close to the eye are dropped instead of clipped.
+ * Both only make the occluders smaller, so the test never rejects a visible object.
+ */
+class OcclusionCuller
+{
+public:
+    // Depth buffer size. Width is a multiple of the AVX2 lane count and both are multiples of c_tileSize.
+    static constexpr int32_t c_width = 256;
+    static constexpr int32_t c_height = 256;
+    static constexpr int32_t c_tileSize = 8;
+
+    OcclusionCuller();
+
+    // Select kernels used for rasterization. Falls back to the best supported level.
+    void setSimdLevel(ObjectStore::SimdLevel level);
+    ObjectStore::SimdLevel simdLevel() const { return m_simdLevel; }
+
+    // Clear the depth buffer and set the view projection matrix of the view
+    void begin(const glm::mat4& viewProjection);
+
+    // Rasterize occluder mesh with given world matrix. Front faces of the mesh are counter-clockwise seen from outside.
+    void addOccluder(const Geometry::OccluderMesh& mesh, const glm::mat4& world);
+
+    // Build the tile level. Called after all occluders are added and before testing.
+    void end();
+
+    // Returns false if the sphere is hidden behind the occluders
+    bool isSphereVisible(const glm::vec3& center, float radius) const;
+
+private:
+    // Rasterize counter-clockwise triangle with vertices in screen space. Z of the vertices is 1/w.
+    void rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+    // Returns true if any pixel of the rectangle is farther than depth
+    bool isRectVisible(int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const;
+
+    glm::mat4 m_viewProjection{1.0f};
+    float m_wScale{1.0f};                   // Length of the w row, converts world distance to w distance
+    std::vector<float> m_depth;             // c_width * c_height pixels, 1/w
+    std::vector<float> m_tileDepth;         // Farthest depth of each tile
+    std::vector<glm::vec4> m_clipVertices;  // Occluder vertices in clip space, kept between calls to avoid allocations
+    ObjectStore::SimdLevel m_simdLevel;
+};
@@ -88,6 +88,7 @@ std::shared_ptr<Geometry> OpenVRTracker::getOrLoadRenderModel(vr::TrackedDeviceI
     std::shared_ptr<Geometry> geometry = m_renderer.createGeometry(vertexCount, indexCount);
     geometry->updateVertexBuffer(vertices.data());
     geometry->updateIndexBuffer(indices.data());
+    geometry->setBoundingRadius(vertices.data(), vertexCount);
 
     m_renderModelMap.insert(std::make_pair(renderModelName, geometry));
 
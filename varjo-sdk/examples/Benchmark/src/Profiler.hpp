@@ -1,11 +1,12 @@
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#include <cstdio>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <chrono>
+#include <cmath>
+#include <limits>
 
 class Profiler
 {
@@ -21,7 +22,23 @@ public:
             m_startTime = endTime;
 
             m_frameTimes.push_back(elapsed);
+            m_frameStats.push_back(m_pendingStats);
         }
+        m_pendingStats.assign(m_statNames.size(), std::numeric_limits<double>::quiet_NaN());
+    }
+
+    // Set named statistic of the frame being profiled. Stored together with the frame time on the next addSample().
+    void setFrameStat(const std::string& name, double value)
+    {
+        size_t index = 0;
+        while (index < m_statNames.size() && m_statNames[index] != name) {
+            index++;
+        }
+        if (index == m_statNames.size()) {
+            m_statNames.push_back(name);
+        }
+        m_pendingStats.resize(m_statNames.size(), std::numeric_limits<double>::quiet_NaN());
+        m_pendingStats[index] = value;
     }
 
     int32_t sampleCount() const { return static_cast<int32_t>(m_frameTimes.size()); }
@@ -40,6 +57,46 @@ public:
         }
     }
 
+    // Export frame statistics with a header row and print their averages. Frames without a statistic have an empty value.
+    void exportStatsCSV(const std::string& fileName)
+    {
+        if (m_statNames.empty()) {
+            return;
+        }
+
+        std::ofstream file(fileName);
+        if (!file.is_open()) {
+            printf("Profiler::exportStatsCSV: Failed to open %s\n", fileName.c_str());
+            return;
+        }
+
+        file << "frame,frameTime";
+        for (const auto& name : m_statNames) {
+            file << "," << name;
+        }
+        file << "\n";
+
+        std::vector<double> sums(m_statNames.size(), 0.0);
+        std::vector<size_t> counts(m_statNames.size(), 0);
+        for (size_t i = 0; i < m_frameStats.size(); ++i) {
+            file << i + 1 << "," << m_frameTimes[i];
+            for (size_t j = 0; j < m_statNames.size(); ++j) {
+                file << ",";
+                if (j < m_frameStats[i].size() && !std::isnan(m_frameStats[i][j])) {
+                    file << m_frameStats[i][j];
+                    sums[j] += m_frameStats[i][j];
+                    counts[j]++;
+                }
+            }
+            file << "\n";
+        }
+
+        printf("Frame stat averages:\n");
+        for (size_t j = 0; j < m_statNames.size(); ++j) {
+            printf("  %s: %.4f\n", m_statNames[j].c_str(), counts[j] ? sums[j] / counts[j] : 0.0);
+        }
+    }
+
     using FpsClock = std::chrono::high_resolution_clock;
     void updateFps()
     {
@@ -73,4 +130,9 @@ private:
     bool m_started = false;
     double m_startTime;
     std::vector<double> m_frameTimes;
+
+    // Named per frame statistics, one row for each frame time
+    std::vector<std::string> m_statNames;
+    std::vector<double> m_pendingStats;
+    std::vector<std::vector<double>> m_frameStats;
 };
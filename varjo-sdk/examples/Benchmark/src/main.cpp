@@ -35,7 +35,11 @@
 #include "D3D11Renderer.hpp"
 #include "GeometryGenerator.hpp"
 #include "GazeTracking.hpp"
+#include "GazeReplay.hpp"
 #include "D3D12Renderer.hpp"
+#include "NullRenderer.hpp"
+#include "ObjectStore.hpp"
+#include "BenchmarkCommon.hpp"
 
 #ifdef USE_VULKAN
 #include "VKRenderer.hpp"
@@ -52,6 +56,7 @@ enum class RendererType {
     DIRECT3D12,
     OPENGL,
     VULKAN,
+    NULL_RENDERER,
     UNKNOWN,
 };
 }
@@ -63,8 +68,6 @@ struct ObjectRotation {
     float speed;
 };
 
-void createObjects(std::shared_ptr<IRenderer> renderer, bool disableAnimation, std::vector<IRenderer::Object>& object, int maxDonuts);
-
 void createDefaultTrackableObject(std::shared_ptr<IRenderer> renderer, IRenderer::Object& trackablecObject);
 void createGaze(std::shared_ptr<IRenderer> renderer, IRenderer::Object& gazeObject);
 
@@ -86,9 +89,9 @@ int main(int argc, char** argv)
 
     options.add_options()                                                                                                                           //
 #ifdef USE_VULKAN                                                                                                                                   //
-        ("renderer", "Renderer to be used. Defaults to d3d11. Allowed options: <gl|d3d11|d3d12|vulkan>", cxxopts::value<std::string>())             //
+        ("renderer", "Renderer to be used. Defaults to d3d11. Allowed options: <gl|d3d11|d3d12|vulkan|null>", cxxopts::value<std::string>())        //
 #else                                                                                                                                               //
-        ("renderer", "Renderer to be used. Defaults to d3d11. Allowed options: <gl|d3d11|d3d12>", cxxopts::value<std::string>())  //
+        ("renderer", "Renderer to be used. Defaults to d3d11. Allowed options: <gl|d3d11|d3d12|null>", cxxopts::value<std::string>())  //
 #endif                                                                                                                                              //
         ("use-trackables", "Draw all SteamVR tracked devices. Controllers, trackers, lighthouses. Starts SteamVR runtime if not already running.")  //
         ("disable-animation", "Disable all animation")                                                                                              //
@@ -97,6 +100,8 @@ int main(int argc, char** argv)
         ("profile-frame-count", "Number of frames to profile for. Exits after all frames are profiled", cxxopts::value<int>()->default_value("0"))  //
         ("fps", "Print fps count")                                                                                                                  //
         ("gaze", "Use eye tracking")                                                                                                                //
+        ("gaze-prediction", "Predict gaze at frame display time for gaze marker, foveation and VRS (requires --gaze)")                              //
+        ("gaze-replay", "Replay gaze CSV recorded with GazeTrackingExample through gaze predictor and exit", cxxopts::value<std::string>())         //
         ("use-depth", "Enable layer depth buffer (requires layers API)")                                                                            //
         ("vst-render", "Enable video see through rendering in compositor")                                                                          //
         ("vst-depth", "Enable VST depth sorting in compositor (requires layers API and depth)")                                                     //
@@ -111,6 +116,11 @@ int main(int argc, char** argv)
         ("use-vrs", "Use Variable Rate Shading map")                                                                                                //
         ("visualize-vrs", "Visualize Variable Rate Shading map")                                                                                    //
         ("max-donuts", "Maximum number of donuts allowed to render", cxxopts::value<int>()->default_value("100000"))                                //
+        ("object-simd", "Instruction set for donut transforms. Defaults to best supported. Allowed options: <scalar|avx2|avx512>",                  //
+            cxxopts::value<std::string>())                                                                                                          //
+        ("worker-threads", "Worker threads for world matrices in addition to the render thread. Defaults to CPU count - 1", cxxopts::value<int>())  //
+        ("frustum-culling", "Cull instances outside of each view on the CPU before uploading and drawing them")                                     //
+        ("occlusion-culling", "Cull instances hidden behind nearer donuts with a software depth buffer. Enables --frustum-culling")                 //
         ("no-srgb", "Do not use SRGB texture")                                                                                                      //
         ("show-mirror-window", "Show mirror window")                                                                                                //
         ("draw-always", "Submit frames even when we are not visible")                                                                               //
@@ -124,6 +134,10 @@ int main(int argc, char** argv)
             return EXIT_SUCCESS;
         }
 
+        if (arguments.count("gaze-replay")) {
+            return runGazeReplay(arguments["gaze-replay"].as<std::string>(), GazePredictor::Settings{}) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
         std::string rendererName = arguments.count("renderer") ? arguments["renderer"].as<std::string>() : "d3d11";
         bool useTrackables = arguments.count("use-trackables");
         bool useReverseDepth = arguments.count("reverse-depth") && rendererName != "gl";
@@ -133,6 +147,7 @@ int main(int argc, char** argv)
         bool enableProfiling = arguments.count("profile-start-frame") && arguments.count("profile-frame-count");
         bool printFps = arguments.count("fps");
         bool useGaze = arguments.count("gaze");
+        bool useGazePrediction = useGaze && arguments.count("gaze-prediction");
         bool useVstRender = arguments.count("vst-render");
         bool useVstDepth = arguments.count("vst-depth");
         bool useStereo = arguments.count("stereo");
@@ -145,8 +160,14 @@ int main(int argc, char** argv)
         bool noSrgb = arguments.count("no-srgb");
         bool showMirrorWindow = arguments.count("show-mirror-window");
         bool drawAlways = arguments.count("draw-always");
+        bool useFrustumCulling = arguments.count("frustum-culling");
+        bool useOcclusionCulling = arguments.count("occlusion-culling");
         int maxDonuts = arguments.count("max-donuts") ? arguments["max-donuts"].as<int>() : 100000;
         std::string depthFormatName = arguments.count("depth-format") ? arguments["depth-format"].as<std::string>() : "d32";
+        int workerThreads = arguments.count("worker-threads") ? arguments["worker-threads"].as<int>()
+                                                              : static_cast<int>(VarjoExamples::WorkerPool::getDefaultThreadCount());
+        std::string objectSimdName =
+            arguments.count("object-simd") ? arguments["object-simd"].as<std::string>() : ObjectStore::getSimdLevelName(ObjectStore::getSupportedSimdLevel());
 
         if (useOcclusionMesh && depthFormatName != "d24s8" && depthFormatName != "d32s8") {
             printf("Disabling use of occlusion mesh. --use-occlusion-mesh requires depth format with stencil buffer.");
@@ -160,6 +181,18 @@ int main(int argc, char** argv)
             printf("Disabling use of slave gpu. Rendering on slave gpu requires --use-sli.");
             useSlaveGpu = false;
         }
+        if (showMirrorWindow && rendererName == "null") {
+            printf("Disabling mirror window. --show-mirror-window requires a GPU renderer.");
+            showMirrorWindow = false;
+        }
+        if (rendererName == "null") {
+            // Null renderer runs without a Varjo session, so it never gets visibility events
+            drawAlways = true;
+            if (useGaze || useVstRender || useVstDepth || useTrackables) {
+                printf("Disabling gaze, VST and trackables. --renderer null runs without Varjo runtime.");
+                useGaze = useGazePrediction = useVstRender = useVstDepth = useTrackables = false;
+            }
+        }
         if (useVelocity && disableAnimation) {
             printf("Disabling velocity. --use-velocity requires animation.");
             useVelocity = false;
@@ -168,6 +201,10 @@ int main(int argc, char** argv)
             printf("Force enabling depth. --use-velocity is not expected to work without depth.");
             useDepth = true;
         }
+        if (useOcclusionCulling && !useFrustumCulling) {
+            printf("Force enabling frustum culling. --occlusion-culling culls the instances left by frustum culling.");
+            useFrustumCulling = true;
+        }
 
         printf("Startup params:");
         printf("  Renderer: %s\n", rendererName.c_str());
@@ -175,6 +212,7 @@ int main(int argc, char** argv)
         printf("  Animation: %s\n", disableAnimation ? "disabled" : "enabled");
         printf("  Profiling: %s\n", enableProfiling ? "enabled" : "disabled");
         printf("  Gaze: %s\n", useGaze ? "enabled" : "disabled");
+        printf("  Gaze prediction: %s\n", useGazePrediction ? "enabled" : "disabled");
         printf("  VST rendering: %s\n", useVstRender ? "enabled" : "disabled");
         printf("  VST depth: %s\n", useVstDepth ? "enabled" : "disabled");
         printf("  Occlusion mesh: %s\n", useOcclusionMesh ? "enabled" : "disabled");
@@ -184,6 +222,9 @@ int main(int argc, char** argv)
         printf("  Use velocity: %s\n", useVelocity ? "enabled" : "disabled");
         printf("  Use SRGB texture format: %s\n", !noSrgb ? "enabled" : "disabled");
         printf("  Show mirror window: %s\n", !showMirrorWindow ? "enabled" : "disabled");
+        printf("  Worker threads: %d\n", workerThreads);
+        printf("  Frustum culling: %s\n", useFrustumCulling ? "enabled" : "disabled");
+        printf("  Occlusion culling: %s\n", useOcclusionCulling ? "enabled" : "disabled");
 
         int32_t profileStartFrame = arguments["profile-start-frame"].as<int>();
         int32_t profileFrameCount = arguments["profile-frame-count"].as<int>();
@@ -196,19 +237,23 @@ int main(int argc, char** argv)
 
         Profiler profiler;
 
-        if (!varjo_IsAvailable()) {
-            printf("ERROR: Varjo system not available.\n");
-            exit(EXIT_FAILURE);
-        }
+        // Null renderer uses a fixed view configuration instead of a session
+        varjo_Session* session = nullptr;
+        if (rendererName != "null") {
+            if (!varjo_IsAvailable()) {
+                printf("ERROR: Varjo system not available.\n");
+                exit(EXIT_FAILURE);
+            }
 
-        // Initialize the varjo session
-        varjo_Session* session = varjo_SessionInit();
+            // Initialize the varjo session
+            session = varjo_SessionInit();
 
-        // Check if there was any errors while initializing.
-        varjo_Error error = varjo_GetError(session);
-        if (error != varjo_NoError) {
-            printf("ERROR: Failed to initialize Varjo session: %s\n", varjo_GetErrorDesc(error));
-            exit(EXIT_FAILURE);
+            // Check if there was any errors while initializing.
+            varjo_Error error = varjo_GetError(session);
+            if (error != varjo_NoError) {
+                printf("ERROR: Failed to initialize Varjo session: %s\n", varjo_GetErrorDesc(error));
+                exit(EXIT_FAILURE);
+            }
         }
 
         varjo_TextureFormat depthFormat = 0;
@@ -223,11 +268,25 @@ int main(int argc, char** argv)
             exit(EXIT_FAILURE);
         }
 
+        ObjectStore::SimdLevel objectSimdLevel = ObjectStore::SimdLevel::SCALAR;
+        if (objectSimdName == "scalar") {
+            objectSimdLevel = ObjectStore::SimdLevel::SCALAR;
+        } else if (objectSimdName == "avx2") {
+            objectSimdLevel = ObjectStore::SimdLevel::AVX2;
+        } else if (objectSimdName == "avx512") {
+            objectSimdLevel = ObjectStore::SimdLevel::AVX512;
+        } else {
+            printf("ERROR: Unknown object SIMD level: %s\n", objectSimdName.c_str());
+            exit(EXIT_FAILURE);
+        }
+
         const bool enableVisualizeVrs = enableVrs && arguments.count("visualize-vrs");
 
         RendererType rendererType{RendererType::UNKNOWN};
         RendererSettings rendererSettings{useDepth, useVstRender, useVstDepth, useStereo, useOcclusionMesh, depthFormat, useReverseDepth, useSli, useSlaveGpu,
             useDynamicViewports, enableVrs, useGaze, enableVisualizeVrs, useVelocity, noSrgb, showMirrorWindow};
+        rendererSettings.setUseFrustumCulling(useFrustumCulling);
+        rendererSettings.setUseOcclusionCulling(useOcclusionCulling);
 
         std::shared_ptr<IRenderer> renderer;
         if (rendererName == "gl") {
@@ -247,6 +306,9 @@ int main(int argc, char** argv)
             printf("ERROR: Benchmark compiled without Vulkan support\n");
             exit(EXIT_FAILURE);
 #endif
+        } else if (rendererName == "null") {
+            rendererType = RendererType::NULL_RENDERER;
+            renderer = std::make_shared<NullRenderer>(session, rendererSettings);
         } else {
             printf("ERROR: Unknown renderer: %s\n", rendererName.c_str());
             exit(EXIT_FAILURE);
@@ -260,6 +322,8 @@ int main(int argc, char** argv)
         printf("  Use VRS: %s\n", vrsEnabledAndSupported ? "enabled" : "disabled");
         printf("  Visualize VRS: %s\n", visualizeVrs ? "enabled" : "disabled");
 
+        renderer->setWorkerThreadCount(static_cast<size_t>((std::max)(workerThreads, 0)));
+
         // Initialize.
         // Calls varjo_*Init and fetches all swap chain textures.
         if (!renderer->init()) {
@@ -267,14 +331,15 @@ int main(int argc, char** argv)
         }
 
         // Initialize gaze tracking when needed
-        GazeTracking gaze(session);
+        GazeTracking gaze(session, useGazePrediction);
         if (useGaze) gaze.init();
 
-        std::vector<IRenderer::Object> donutObjects;
         IRenderer::Object defaultTrackableObject;
         IRenderer::Object gazeObject;
 
-        createObjects(renderer, disableAnimation, donutObjects, maxDonuts);
+        std::unique_ptr<ObjectStore> donutObjects = createObjects(renderer, disableAnimation, maxDonuts);
+        donutObjects->setSimdLevel(objectSimdLevel);
+        printf("  Object SIMD: %s\n", ObjectStore::getSimdLevelName(donutObjects->simdLevel()));
         createDefaultTrackableObject(renderer, defaultTrackableObject);
         createGaze(renderer, gazeObject);
 
@@ -322,11 +387,11 @@ int main(int argc, char** argv)
         }
 
         // Frame info is used for per-frame view and projection matrices.
-        varjo_FrameInfo* frameInfo = varjo_CreateFrameInfo(session);
+        varjo_FrameInfo* frameInfo = renderer->createFrameInfo();
 
         // A struct to hold Varjo event data.
         varjo_Event evt{};
-        varjo_Nanoseconds lastFrameTime = varjo_GetCurrentTime(session);
+        varjo_Nanoseconds lastFrameTime = session ? varjo_GetCurrentTime(session) : 0;
 
         int32_t frameNumber = 0;
 
@@ -339,7 +404,7 @@ int main(int argc, char** argv)
                 }
             }
             // Poll Varjo events.
-            while (varjo_PollEvent(session, &evt)) {
+            while (session && varjo_PollEvent(session, &evt)) {
                 switch (evt.header.type) {
                     case varjo_EventType_Visibility: {
                         // Don't render anything when we are hidden.
@@ -370,7 +435,7 @@ int main(int argc, char** argv)
             }
             if (visible || drawAlways) {
                 // Wait for a perfect time to render the frame.
-                varjo_WaitSync(session, frameInfo);
+                renderer->waitSync(frameInfo);
 
                 if (openVRTracker) {
                     // Update the tracking position and rendermodels for openvr trackables.
@@ -394,16 +459,12 @@ int main(int argc, char** argv)
                 }
 
                 // Rotate objects
-                size_t numObjects = donutObjects.size();
-                for (size_t i = 0; i < numObjects; ++i) {
-                    IRenderer::applyObjectVelocity(donutObjects[i], time);
-                }
+                donutObjects->applyVelocity(time);
 
                 std::vector<IRenderer::Object> trackableObjects;
 
-                const glm::mat4 trackingToLocalMat = glm::make_mat4(varjo_GetTrackingToLocalTransform(session).value);
-
                 if (openVRTracker) {
+                    const glm::mat4 trackingToLocalMat = glm::make_mat4(varjo_GetTrackingToLocalTransform(session).value);
                     trackableObjects.reserve(openVRTracker->getTrackableCount());
                     for (int i = 0; i < openVRTracker->getTrackableCount(); ++i) {
                         glm::mat4 trackablePose = glm::mat4_cast(openVRTracker->getTrackableOrientation(i));
@@ -424,7 +485,7 @@ int main(int argc, char** argv)
 
                 // Add object where user is looking when gaze data is valid
                 std::vector<IRenderer::Object> gazeObjects;
-                if (gaze.update()) {
+                if (gaze.update(frameInfo->displayTime)) {
                     IRenderer::Object newObject = gazeObject;
                     newObject.position = gaze.getPosition();
                     gazeObjects.push_back(newObject);
@@ -433,15 +494,23 @@ int main(int argc, char** argv)
 
                 std::vector<std::vector<IRenderer::Object>*> instancedObjects;
                 instancedObjects.push_back(&gazeObjects);
+                std::vector<const ObjectStore*> instancedObjectStores;
                 if (!disableVRScene) {
-                    instancedObjects.push_back(&donutObjects);
+                    instancedObjectStores.push_back(donutObjects.get());
                 }
 
+                // Foveate around gaze predicted for this frame instead of the latest rendering gaze
+                renderer->setPredictedGaze(gaze.getPredictedGaze());
+
                 // Render into the swap chain texture.
-                renderer->render(frameInfo, instancedObjects, trackableObjects, disableVRScene);
+                renderer->render(frameInfo, instancedObjects, instancedObjectStores, trackableObjects, disableVRScene);
+
+                if (enableProfiling) {
+                    setProfilerFrameStats(profiler, *renderer, useFrustumCulling, useOcclusionCulling);
+                }
 
                 // Check if we had any errors during the frame
-                varjo_Error err = varjo_GetError(session);
+                varjo_Error err = session ? varjo_GetError(session) : varjo_NoError;
                 if (err != varjo_NoError) {
                     printf("error: %s\n", varjo_GetErrorDesc(err));
                     break;
@@ -462,6 +531,7 @@ int main(int argc, char** argv)
 
         if (enableProfiling) {
             profiler.exportCSV("frame_times.csv");
+            profiler.exportStatsCSV("frame_stats.csv");
         }
 
         if (openVRTracker) {
@@ -472,15 +542,17 @@ int main(int argc, char** argv)
         renderer->freeVarjoResources();
 
         // Free the frame and submit infos.
-        varjo_FreeFrameInfo(frameInfo);
+        renderer->freeFrameInfo(frameInfo);
 
         // We don't need the session anymore
-        varjo_SessionShutDown(session);
+        if (session) {
+            varjo_SessionShutDown(session);
+        }
 
         // Clean up geometry before shutting down the renderer
         gazeObject.geometry.reset();
         defaultTrackableObject.geometry.reset();
-        donutObjects.clear();
+        donutObjects.reset();
         openVRTracker.reset();
 
         // Shut down the renderer
@@ -509,12 +581,6 @@ bool gotKey()
     return false;
 }
 
-float randomFloat(float min, float max)
-{
-    float value = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-    return min + (max - min) * value;
-}
-
 void createDefaultTrackableObject(std::shared_ptr<IRenderer> renderer, IRenderer::Object& trackableObject)
 {
     auto pentagonGeometry = GeometryGenerator::generateDonut(renderer, 0.08f, 0.05f, 5, 3);
@@ -538,57 +604,3 @@ void createGaze(std::shared_ptr<IRenderer> renderer, IRenderer::Object& gazeObje
 
     printf("Created object for gaze\n");
 }
-
-void createObjects(std::shared_ptr<IRenderer> renderer, bool disableAnimation, std::vector<IRenderer::Object>& objects, int maxDonuts)
-{
-    auto donutGeometry = GeometryGenerator::generateDonut(renderer, 0.25f, 0.125f, 256, 64);
-
-    const int32_t donutCount = 14;
-    const int32_t rows = 5;
-    const int32_t layers = 20;
-    const float rowMin = -1.0f;
-    const float rowMax = 2.0f;
-    const float layerMin = 0.75f;
-    const float layerSize = 2.0f;
-    const float angle = 360.0f / static_cast<float>(donutCount);
-    const float layerOffsetangle = angle * (1.0f / static_cast<float>(layers));
-
-    srand(123);  // Keep the animations same on each run.
-
-    for (int32_t l = 0; l < layers; ++l) {  // Layers going outward from the center.
-        float offsetAngle = l * layerOffsetangle;
-        float z = layerMin + (layerSize * static_cast<float>(l));
-
-        for (int32_t r = 0; r < rows; ++r) {  // Rows going up from the bottom.
-            float y = rowMin + ((rowMax - rowMin) / static_cast<float>(rows - 1)) * static_cast<float>(r);
-
-            for (int32_t i = 0; i < donutCount; ++i) {  // Number of donuts in a circle.
-                auto rotate = glm::angleAxis(glm::radians((angle * static_cast<float>(i)) + offsetAngle), glm::vec3(0, 1, 0));
-
-                IRenderer::Object object{};
-                object.geometry = donutGeometry;
-                object.position = glm::rotate(rotate, glm::vec3{0, y, z});
-                object.scale = glm::vec3{1, 1, 1};
-                object.orientation = rotate * glm::angleAxis(glm::radians(90.0f), glm::vec3(1, 0, 0));
-
-                if (!disableAnimation) {
-                    // Random axis of rotation and rotation speed for each object.
-                    object.velocity = {
-                        glm::vec3{randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f)},
-                        glm::radians(randomFloat(30.0f, 120.0f)),
-                    };
-                }
-
-                objects.push_back(object);
-
-                if (objects.size() >= static_cast<size_t>(maxDonuts)) {
-                    goto end;
-                }
-            }
-        }
-    }
-
-end:
-    printf("Created %zu donuts\n", objects.size());
-    printf("%zu triangles per frame\n", objects.size() * (donutGeometry->indexCount() / 3));
-}
@@ -0,0 +1,775 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "ColorConversion.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLOR_CONVERSION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows using any intrinsics without compiler flags, GCC and Clang need per function target attributes.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX2_F16C __attribute__((target("avx2,f16c")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_AVX2_F16C
+#endif
+
+namespace VarjoExamples
+{
+namespace ColorConversion
+{
+namespace
+{
+// Row conversion function type. Converts given number of pixels starting from the beginning of the row.
+using NV12RowFunc = void (*)(const uint8_t* srcY, const uint8_t* srcUV, uint8_t* dst, int32_t width);
+
+// Convert NV12 pixels [begin, end) of a single row to RGBA
+inline void convertNV12RowScalar(const uint8_t* srcY, const uint8_t* srcUV, uint8_t* dst, int32_t begin, int32_t end)
+{
+    dst += static_cast<size_t>(begin) * 4;
+    for (int32_t x = begin; x < end; x++) {
+        const auto uvX = x - (x & 1);
+        convertYUVtoRGB(srcY[x], srcUV[uvX + 0], srcUV[uvX + 1], dst[0], dst[1], dst[2]);
+        dst[3] = 255;
+        dst += 4;
+    }
+}
+
+void convertNV12RowScalar(const uint8_t* srcY, const uint8_t* srcUV, uint8_t* dst, int32_t width)
+{
+    convertNV12RowScalar(srcY, srcUV, dst, 0, width);
+}
+
+// RGBA16F row conversion function type
+using RGBA16FRowFunc = void (*)(const uint16_t* src, uint8_t* dst, int32_t width, const float background[3]);
+
+// Gamma table covers all non-negative half values up to infinity
+constexpr int32_t c_gammaTableSize = 0x7c01;
+
+// Returns table of gamma corrected values indexed with half float bits. Built once, takes 124 kB.
+const float* getGammaTable()
+{
+    static const std::vector<float> s_table = []() {
+        std::vector<float> table(c_gammaTableSize);
+        for (int32_t i = 0; i < c_gammaTableSize; i++) {
+            table[i] = powf(convertHalfToFloat(static_cast<uint16_t>(i)), c_displayGamma);
+        }
+        return table;
+    }();
+    return s_table.data();
+}
+
+// Returns gamma table index for given half float. Negative values (sign bit set) and NaNs map to zero.
+inline int32_t getGammaIndex(uint16_t value)
+{
+    const int32_t index = static_cast<int16_t>(value);
+    return index < 0 || index >= c_gammaTableSize ? 0 : index;
+}
+
+// Alpha blend gamma corrected value to background and convert to 8 bits. Same operation order as the reference,
+// vector kernels must match this exactly.
+inline uint8_t blendToUnorm8(float value, float alpha, float background)
+{
+    const float blended = value * alpha + background * (1.0f - alpha);
+    return static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 255.0f * blended)));
+}
+
+// Convert RGBA16F pixels [begin, end) of a single row to RGBA8
+inline void convertRGBA16FRowScalar(const uint16_t* src, uint8_t* dst, int32_t begin, int32_t end, const float background[3])
+{
+    const float* gammaTable = getGammaTable();
+    for (int32_t x = begin; x < end; x++) {
+        const uint16_t* pixel = src + static_cast<size_t>(x) * 4;
+        uint8_t* out = dst + static_cast<size_t>(x) * 4;
+        const float alpha = convertHalfToFloat(pixel[3]);
+        for (int32_t c = 0; c < 3; c++) {
+            out[c] = blendToUnorm8(gammaTable[getGammaIndex(pixel[c])], alpha, background[c]);
+        }
+        out[3] = 255;
+    }
+}
+
+void convertRGBA16FRowScalar(const uint16_t* src, uint8_t* dst, int32_t width, const float background[3])
+{
+    convertRGBA16FRowScalar(src, dst, 0, width, background);
+}
+
+// Y8 downsample row function type. Averages boxes of source rows starting at src into dstWidth output pixels.
+using DownsampleRowFunc = void (*)(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth);
+
+// Downsample output pixels [begin, end) of a single row
+template <int32_t Factor>
+inline void downsampleY8RowScalar(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t begin, int32_t end)
+{
+    for (int32_t x = begin; x < end; x++) {
+        uint32_t sum = 0;
+        for (int32_t row = 0; row < Factor; row++) {
+            const uint8_t* box = src + srcRowStride * row + static_cast<size_t>(x) * Factor;
+            for (int32_t col = 0; col < Factor; col++) {
+                sum += box[col];
+            }
+        }
+        dst[x] = static_cast<uint8_t>((sum + Factor * Factor / 2) / (Factor * Factor));
+    }
+}
+
+template <int32_t Factor>
+void downsampleY8RowScalar(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth)
+{
+    downsampleY8RowScalar<Factor>(src, srcRowStride, dst, 0, dstWidth);
+}
+
+// Y8 threshold row function type. Writes mask words for the whole row.
+using ThresholdRowFunc = void (*)(const uint8_t* src, int32_t width, uint8_t threshold, uint32_t* dst);
+
+// Threshold pixels [begin, width) of a single row. Begin must be a multiple of 32.
+template <bool Above>
+inline void thresholdY8RowScalar(const uint8_t* src, uint8_t threshold, uint32_t* dst, int32_t begin, int32_t width)
+{
+    for (int32_t x = begin; x < width; x += 32) {
+        const int32_t count = std::min(width - x, 32);
+        uint32_t bits = 0;
+        for (int32_t i = 0; i < count; i++) {
+            const bool set = Above ? (src[x + i] > threshold) : (src[x + i] < threshold);
+            bits |= static_cast<uint32_t>(set) << i;
+        }
+        dst[x / 32] = bits;
+    }
+}
+
+template <bool Above>
+void thresholdY8RowScalar(const uint8_t* src, int32_t width, uint8_t threshold, uint32_t* dst)
+{
+    thresholdY8RowScalar<Above>(src, threshold, dst, 0, width);
+}
+
+#ifdef COLOR_CONVERSION_X86
+
+// Pack two 16 bit coefficients to 32 bits for multiply-add, low word first
+constexpr int32_t coeffPair(int16_t lo, int16_t hi)
+{
+    return static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16) | static_cast<uint16_t>(lo));
+}
+
+// The vector kernels use the same integer math as convertYUVtoRGB():
+//   R = (298 * C + 128 + 409 * E) >> 8
+//   G = (298 * C + 128 - 100 * D - 208 * E) >> 8
+//   B = (298 * C + 128 + 516 * D) >> 8
+// Luma and chroma terms are computed with 16x16->32 bit multiply-adds (pmaddwd), so no precision is lost.
+// Chroma terms are computed once per UV pair and duplicated for the two pixels sharing it. Clamping
+// to [0, 255] is done with saturating packs, which gives exactly the same result as std::clamp.
+
+// Compute one color channel for 16 pixels from luma terms and (D, E) chroma pairs. Each chroma value is used for two pixels.
+TARGET_SSE41 inline __m128i computeChannelSSE41(const __m128i (&yTerm)[4], const __m128i& deLo, const __m128i& deHi, const __m128i& coeffs)
+{
+    const __m128i chromaLo = _mm_madd_epi16(deLo, coeffs);
+    const __m128i chromaHi = _mm_madd_epi16(deHi, coeffs);
+    const __m128i v0 = _mm_srai_epi32(_mm_add_epi32(yTerm[0], _mm_unpacklo_epi32(chromaLo, chromaLo)), 8);
+    const __m128i v1 = _mm_srai_epi32(_mm_add_epi32(yTerm[1], _mm_unpackhi_epi32(chromaLo, chromaLo)), 8);
+    const __m128i v2 = _mm_srai_epi32(_mm_add_epi32(yTerm[2], _mm_unpacklo_epi32(chromaHi, chromaHi)), 8);
+    const __m128i v3 = _mm_srai_epi32(_mm_add_epi32(yTerm[3], _mm_unpackhi_epi32(chromaHi, chromaHi)), 8);
+    return _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+}
+
+// Convert 16 pixels. Returns R, G, B as 8 bit values.
+TARGET_SSE41 inline void convertNV12x16SSE41(const uint8_t* srcY, const uint8_t* srcUV, __m128i& outR, __m128i& outG, __m128i& outB)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yBias = _mm_set1_epi16(16);
+    const __m128i uvBias = _mm_set1_epi16(128);
+    const __m128i yCoeffs = _mm_set1_epi32(coeffPair(298, 128));    // (C, 1) * (298, 128)
+    const __m128i rCoeffs = _mm_set1_epi32(coeffPair(0, 409));      // (D, E) * (0, 409)
+    const __m128i gCoeffs = _mm_set1_epi32(coeffPair(-100, -208));  // (D, E) * (-100, -208)
+    const __m128i bCoeffs = _mm_set1_epi32(coeffPair(516, 0));      // (D, E) * (516, 0)
+    const __m128i one = _mm_set1_epi16(1);
+
+    const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcY));
+    const __m128i uv8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcUV));
+
+    // Luma terms for pixels 0-3, 4-7, 8-11, 12-15
+    const __m128i cLo = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), yBias);
+    const __m128i cHi = _mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), yBias);
+    const __m128i yTerm[4] = {
+        _mm_madd_epi16(_mm_unpacklo_epi16(cLo, one), yCoeffs),
+        _mm_madd_epi16(_mm_unpackhi_epi16(cLo, one), yCoeffs),
+        _mm_madd_epi16(_mm_unpacklo_epi16(cHi, one), yCoeffs),
+        _mm_madd_epi16(_mm_unpackhi_epi16(cHi, one), yCoeffs),
+    };
+
+    // Chroma (D, E) pairs for UV pairs 0-3 and 4-7
+    const __m128i deLo = _mm_sub_epi16(_mm_unpacklo_epi8(uv8, zero), uvBias);
+    const __m128i deHi = _mm_sub_epi16(_mm_unpackhi_epi8(uv8, zero), uvBias);
+
+    outR = computeChannelSSE41(yTerm, deLo, deHi, rCoeffs);
+    outG = computeChannelSSE41(yTerm, deLo, deHi, gCoeffs);
+    outB = computeChannelSSE41(yTerm, deLo, deHi, bCoeffs);
+}
+
+TARGET_SSE41 void convertNV12RowSSE41(const uint8_t* srcY, const uint8_t* srcUV, uint8_t* dst, int32_t width)
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    int32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i r, g, b;
+        convertNV12x16SSE41(srcY + x, srcUV + x, r, g, b);
+
+        // Interleave to RGBA
+        const __m128i rgLo = _mm_unpacklo_epi8(r, g);
+        const __m128i rgHi = _mm_unpackhi_epi8(r, g);
+        const __m128i baLo = _mm_unpacklo_epi8(b, alpha);
+        const __m128i baHi = _mm_unpackhi_epi8(b, alpha);
+
+        __m128i* out = reinterpret_cast<__m128i*>(dst + static_cast<size_t>(x) * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rgLo, baLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLo, baLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHi, baHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHi, baHi));
+    }
+
+    // Remaining pixels
+    convertNV12RowScalar(srcY, srcUV, dst, x, width);
+}
+
+// Compute one color channel for 16 pixels. Chroma terms for UV pairs 0-3|4-7 are duplicated to pixels 0-3|8-11 and 4-7|12-15.
+TARGET_AVX2 inline __m256i computeChannelAVX2(const __m256i& yTermLo, const __m256i& yTermHi, const __m256i& de, const __m256i& coeffs)
+{
+    const __m256i chroma = _mm256_madd_epi16(de, coeffs);
+    const __m256i lo = _mm256_srai_epi32(_mm256_add_epi32(yTermLo, _mm256_unpacklo_epi32(chroma, chroma)), 8);
+    const __m256i hi = _mm256_srai_epi32(_mm256_add_epi32(yTermHi, _mm256_unpackhi_epi32(chroma, chroma)), 8);
+    return _mm256_packs_epi32(lo, hi);
+}
+
+// Convert 16 pixels. Returns R, G, B as 16 bit values in pixel order 0-15. Values are computed in
+// lane order 0-3|8-11 and 4-7|12-15, which the per lane 32->16 bit pack brings back to pixel order.
+TARGET_AVX2 inline void convertNV12x16AVX2(const uint8_t* srcY, const uint8_t* srcUV, __m256i& outR, __m256i& outG, __m256i& outB)
+{
+    const __m256i yBias = _mm256_set1_epi16(16);
+    const __m256i uvBias = _mm256_set1_epi16(128);
+    const __m256i yCoeffs = _mm256_set1_epi32(coeffPair(298, 128));
+    const __m256i rCoeffs = _mm256_set1_epi32(coeffPair(0, 409));
+    const __m256i gCoeffs = _mm256_set1_epi32(coeffPair(-100, -208));
+    const __m256i bCoeffs = _mm256_set1_epi32(coeffPair(516, 0));
+    const __m256i one = _mm256_set1_epi16(1);
+
+    // Widen 16 luma and 8 UV pairs to 16 bits in natural order
+    const __m256i c = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcY))), yBias);
+    const __m256i de = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcUV))), uvBias);
+
+    // Luma terms for pixels 0-3|8-11 and 4-7|12-15
+    const __m256i yTermLo = _mm256_madd_epi16(_mm256_unpacklo_epi16(c, one), yCoeffs);
+    const __m256i yTermHi = _mm256_madd_epi16(_mm256_unpackhi_epi16(c, one), yCoeffs);
+
+    outR = computeChannelAVX2(yTermLo, yTermHi, de, rCoeffs);
+    outG = computeChannelAVX2(yTermLo, yTermHi, de, gCoeffs);
+    outB = computeChannelAVX2(yTermLo, yTermHi, de, bCoeffs);
+}
+
+TARGET_AVX2 void convertNV12RowAVX2(const uint8_t* srcY, const uint8_t* srcUV, uint8_t* dst, int32_t width)
+{
+    const __m256i alpha = _mm256_set1_epi8(-1);
+
+    int32_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i r0, g0, b0, r1, g1, b1;
+        convertNV12x16AVX2(srcY + x, srcUV + x, r0, g0, b0);
+        convertNV12x16AVX2(srcY + x + 16, srcUV + x + 16, r1, g1, b1);
+
+        // Pack to bytes: lane 0 has pixels 0-7|16-23, lane 1 has pixels 8-15|24-31
+        const __m256i r = _mm256_packus_epi16(r0, r1);
+        const __m256i g = _mm256_packus_epi16(g0, g1);
+        const __m256i b = _mm256_packus_epi16(b0, b1);
+
+        // Interleave: rg/baLo has pixels 0-7|8-15, rg/baHi has pixels 16-23|24-31
+        const __m256i rgLo = _mm256_unpacklo_epi8(r, g);
+        const __m256i rgHi = _mm256_unpackhi_epi8(r, g);
+        const __m256i baLo = _mm256_unpacklo_epi8(b, alpha);
+        const __m256i baHi = _mm256_unpackhi_epi8(b, alpha);
+
+        // RGBA for pixels 0-3|8-11, 4-7|12-15, 16-19|24-27, 20-23|28-31
+        const __m256i p0 = _mm256_unpacklo_epi16(rgLo, baLo);
+        const __m256i p1 = _mm256_unpackhi_epi16(rgLo, baLo);
+        const __m256i p2 = _mm256_unpacklo_epi16(rgHi, baHi);
+        const __m256i p3 = _mm256_unpackhi_epi16(rgHi, baHi);
+
+        __m256i* out = reinterpret_cast<__m256i*>(dst + static_cast<size_t>(x) * 4);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+
+    // Remaining pixels
+    if (x < width) {
+        convertNV12RowSSE41(srcY + x, srcUV + x, dst + static_cast<size_t>(x) * 4, width - x);
+    }
+}
+
+// Convert two RGBA16F pixels to blended 0..255 integer values, one channel per 32 bit lane
+TARGET_AVX2_F16C inline __m256i convertRGBA16FPairAVX2(const uint16_t* src, const float* gammaTable, __m256 background, __m256 oneMinusAlphaMask)
+{
+    const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    // Gamma table lookup with sign extended half bits, negative values and NaNs clamp to index zero
+    __m256i index = _mm256_cvtepi16_epi32(half);
+    const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), index);
+    const __m256i outOfRange = _mm256_or_si256(negative, _mm256_cmpgt_epi32(index, _mm256_set1_epi32(c_gammaTableSize - 1)));
+    index = _mm256_andnot_si256(outOfRange, index);
+    const __m256 value = _mm256_i32gather_ps(gammaTable, index, 4);
+
+    // Broadcast alpha of each pixel to its color channels
+    const __m256 linear = _mm256_cvtph_ps(half);
+    const __m256 alpha = _mm256_shuffle_ps(linear, linear, _MM_SHUFFLE(3, 3, 3, 3));
+
+    // value * alpha + background * (1 - alpha), without FMA to match the scalar kernel
+    const __m256 oneMinusAlpha = _mm256_and_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), alpha), oneMinusAlphaMask);
+    const __m256 blended = _mm256_add_ps(_mm256_mul_ps(value, alpha), _mm256_mul_ps(background, oneMinusAlpha));
+    const __m256 scaled = _mm256_max_ps(_mm256_setzero_ps(), _mm256_min_ps(_mm256_set1_ps(255.0f), _mm256_mul_ps(_mm256_set1_ps(255.0f), blended)));
+    return _mm256_cvttps_epi32(scaled);
+}
+
+// Convert RGBA16F row to RGBA8, 8 pixels per iteration
+TARGET_AVX2_F16C void convertRGBA16FRowAVX2(const uint16_t* src, uint8_t* dst, int32_t width, const float background[3])
+{
+    const float* gammaTable = getGammaTable();
+    const __m256 backgroundPair = _mm256_setr_ps(background[0], background[1], background[2], 0.0f, background[0], background[1], background[2], 0.0f);
+    const __m256 colorMask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int32_t>(0xff000000));
+    const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint16_t* s = src + static_cast<size_t>(x) * 4;
+        const __m256i p01 = convertRGBA16FPairAVX2(s + 0, gammaTable, backgroundPair, colorMask);
+        const __m256i p23 = convertRGBA16FPairAVX2(s + 8, gammaTable, backgroundPair, colorMask);
+        const __m256i p45 = convertRGBA16FPairAVX2(s + 16, gammaTable, backgroundPair, colorMask);
+        const __m256i p67 = convertRGBA16FPairAVX2(s + 24, gammaTable, backgroundPair, colorMask);
+
+        // Pack within 128 bit lanes: pixels end up in order 0 2 4 6 | 1 3 5 7
+        const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(p01, p23), _mm256_packs_epi32(p45, p67));
+        const __m256i pixels = _mm256_or_si256(_mm256_permutevar8x32_epi32(packed, pixelOrder), opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<size_t>(x) * 4), pixels);
+    }
+
+    // Remaining pixels
+    convertRGBA16FRowScalar(src, dst, x, width, background);
+}
+
+// Sum horizontal pixel pairs of given rows to 16 bit values
+TARGET_SSE41 inline __m128i sumPairsSSE41(const uint8_t* src, size_t srcRowStride, int32_t rows)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int32_t row = 0; row < rows; row++) {
+        sum = _mm_add_epi16(sum, _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + srcRowStride * row)), ones));
+    }
+    return sum;
+}
+
+// Downsample Y8 row by 2, 16 output pixels per iteration
+TARGET_SSE41 void downsampleY8x2RowSSE41(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth)
+{
+    const __m128i rounding = _mm_set1_epi16(2);
+
+    int32_t x = 0;
+    for (; x + 16 <= dstWidth; x += 16) {
+        const uint8_t* s = src + static_cast<size_t>(x) * 2;
+        const __m128i lo = _mm_srli_epi16(_mm_add_epi16(sumPairsSSE41(s, srcRowStride, 2), rounding), 2);
+        const __m128i hi = _mm_srli_epi16(_mm_add_epi16(sumPairsSSE41(s + 16, srcRowStride, 2), rounding), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+
+    // Remaining pixels
+    downsampleY8RowScalar<2>(src, srcRowStride, dst, x, dstWidth);
+}
+
+// Downsample Y8 row by 4, 8 output pixels per iteration
+TARGET_SSE41 void downsampleY8x4RowSSE41(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth)
+{
+    const __m128i rounding = _mm_set1_epi16(8);
+
+    int32_t x = 0;
+    for (; x + 8 <= dstWidth; x += 8) {
+        const uint8_t* s = src + static_cast<size_t>(x) * 4;
+
+        // Pair sums of four rows fit in 16 bits, adding adjacent pairs gives the box sums in pixel order
+        const __m128i sum = _mm_hadd_epi16(sumPairsSSE41(s, srcRowStride, 4), sumPairsSSE41(s + 16, srcRowStride, 4));
+        const __m128i avg = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 4);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(avg, avg));
+    }
+
+    // Remaining pixels
+    downsampleY8RowScalar<4>(src, srcRowStride, dst, x, dstWidth);
+}
+
+// Sum horizontal pixel pairs of given rows to 16 bit values
+TARGET_AVX2 inline __m256i sumPairsAVX2(const uint8_t* src, size_t srcRowStride, int32_t rows)
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int32_t row = 0; row < rows; row++) {
+        sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + srcRowStride * row)), ones));
+    }
+    return sum;
+}
+
+// Downsample Y8 row by 2, 32 output pixels per iteration
+TARGET_AVX2 void downsampleY8x2RowAVX2(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth)
+{
+    const __m256i rounding = _mm256_set1_epi16(2);
+
+    int32_t x = 0;
+    for (; x + 32 <= dstWidth; x += 32) {
+        const uint8_t* s = src + static_cast<size_t>(x) * 2;
+        const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(sumPairsAVX2(s, srcRowStride, 2), rounding), 2);
+        const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(sumPairsAVX2(s + 32, srcRowStride, 2), rounding), 2);
+
+        // Pack within 128 bit lanes gives pixels 0-7|16-23|8-15|24-31, reorder 64 bit blocks
+        const __m256i packed = _mm256_packus_epi16(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    // Remaining pixels
+    downsampleY8RowScalar<2>(src, srcRowStride, dst, x, dstWidth);
+}
+
+// Downsample Y8 row by 4, 16 output pixels per iteration
+TARGET_AVX2 void downsampleY8x4RowAVX2(const uint8_t* src, size_t srcRowStride, uint8_t* dst, int32_t dstWidth)
+{
+    const __m256i rounding = _mm256_set1_epi16(8);
+    const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int32_t x = 0;
+    for (; x + 16 <= dstWidth; x += 16) {
+        const uint8_t* s = src + static_cast<size_t>(x) * 4;
+
+        // Adding adjacent pairs within lanes gives box sums for pixels 0-3|8-11 and 4-7|12-15
+        const __m256i sum = _mm256_hadd_epi16(sumPairsAVX2(s, srcRowStride, 4), sumPairsAVX2(s + 32, srcRowStride, 4));
+        const __m256i avg = _mm256_srli_epi16(_mm256_add_epi16(sum, rounding), 4);
+
+        // Pack to bytes and gather the 4 pixel groups of both lanes in order
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(avg, avg), pixelOrder);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_castsi256_si128(packed));
+    }
+
+    // Remaining pixels
+    downsampleY8RowScalar<4>(src, srcRowStride, dst, x, dstWidth);
+}
+
+// Threshold Y8 row to bit mask, 32 pixels per iteration
+template <bool Above>
+TARGET_SSE41 void thresholdY8RowSSE41(const uint8_t* src, int32_t width, uint8_t threshold, uint32_t* dst)
+{
+    // Flipping sign bits makes signed byte compare work for unsigned pixels
+    const __m128i signBit = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold ^ 0x80));
+
+    int32_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m128i lo = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)), signBit);
+        const __m128i hi = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + 16)), signBit);
+        const __m128i maskLo = Above ? _mm_cmpgt_epi8(lo, limit) : _mm_cmpgt_epi8(limit, lo);
+        const __m128i maskHi = Above ? _mm_cmpgt_epi8(hi, limit) : _mm_cmpgt_epi8(limit, hi);
+        dst[x / 32] = static_cast<uint32_t>(_mm_movemask_epi8(maskLo)) | (static_cast<uint32_t>(_mm_movemask_epi8(maskHi)) << 16);
+    }
+
+    // Remaining pixels
+    thresholdY8RowScalar<Above>(src, threshold, dst, x, width);
+}
+
+// Threshold Y8 row to bit mask, 32 pixels per iteration
+template <bool Above>
+TARGET_AVX2 void thresholdY8RowAVX2(const uint8_t* src, int32_t width, uint8_t threshold, uint32_t* dst)
+{
+    // Flipping sign bits makes signed byte compare work for unsigned pixels
+    const __m256i signBit = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold ^ 0x80));
+
+    int32_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i pixels = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x)), signBit);
+        const __m256i mask = Above ? _mm256_cmpgt_epi8(pixels, limit) : _mm256_cmpgt_epi8(limit, pixels);
+        dst[x / 32] = static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+    }
+
+    // Remaining pixels
+    thresholdY8RowScalar<Above>(src, threshold, dst, x, width);
+}
+
+// Detect instruction set support
+SimdLevel detectSimdLevel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        // Check that OS saves YMM registers
+        const bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (avx2) {
+        return SimdLevel::AVX2;
+    } else if (sse41) {
+        return SimdLevel::SSE41;
+    }
+    return SimdLevel::Scalar;
+}
+
+// Detect half float conversion instruction support
+bool detectF16C()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 29)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c") != 0;
+#endif
+}
+
+#else
+
+SimdLevel detectSimdLevel() { return SimdLevel::Scalar; }
+
+bool detectF16C() { return false; }
+
+#endif  // COLOR_CONVERSION_X86
+
+NV12RowFunc getNV12RowFunc(SimdLevel level)
+{
+    // Never use kernel that the CPU can't run
+    level = std::min(level, getSupportedSimdLevel());
+
+    switch (level) {
+#ifdef COLOR_CONVERSION_X86
+        case SimdLevel::AVX2: return convertNV12RowAVX2;
+        case SimdLevel::SSE41: return convertNV12RowSSE41;
+#endif
+        default: return convertNV12RowScalar;
+    }
+}
+
+RGBA16FRowFunc getRGBA16FRowFunc(SimdLevel level)
+{
+    static const bool s_f16c = detectF16C();
+
+    // Never use kernel that the CPU can't run
+    level = std::min(level, getSupportedSimdLevel());
+
+#ifdef COLOR_CONVERSION_X86
+    if (level == SimdLevel::AVX2 && s_f16c) {
+        return convertRGBA16FRowAVX2;
+    }
+#endif
+    return convertRGBA16FRowScalar;
+}
+
+DownsampleRowFunc getDownsampleRowFunc(SimdLevel level, int32_t factor)
+{
+    // Never use kernel that the CPU can't run
+    level = std::min(level, getSupportedSimdLevel());
+
+    switch (level) {
+#ifdef COLOR_CONVERSION_X86
+        case SimdLevel::AVX2: return (factor == 2) ? downsampleY8x2RowAVX2 : downsampleY8x4RowAVX2;
+        case SimdLevel::SSE41: return (factor == 2) ? downsampleY8x2RowSSE41 : downsampleY8x4RowSSE41;
+#endif
+        default: break;
+    }
+
+    if (factor == 2) {
+        return downsampleY8RowScalar<2>;
+    }
+    return downsampleY8RowScalar<4>;
+}
+
+ThresholdRowFunc getThresholdRowFunc(SimdLevel level, ThresholdMode mode)
+{
+    // Never use kernel that the CPU can't run
+    level = std::min(level, getSupportedSimdLevel());
+    const bool above = (mode == ThresholdMode::Above);
+
+    switch (level) {
+#ifdef COLOR_CONVERSION_X86
+        case SimdLevel::AVX2: return above ? thresholdY8RowAVX2<true> : thresholdY8RowAVX2<false>;
+        case SimdLevel::SSE41: return above ? thresholdY8RowSSE41<true> : thresholdY8RowSSE41<false>;
+#endif
+        default: break;
+    }
+
+    if (above) {
+        return thresholdY8RowScalar<true>;
+    }
+    return thresholdY8RowScalar<false>;
+}
+
+}  // namespace
+
+SimdLevel getSupportedSimdLevel()
+{
+    static const SimdLevel s_level = detectSimdLevel();
+    return s_level;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Scalar: return "Scalar";
+        case SimdLevel::SSE41: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        default: return "Unknown";
+    }
+}
+
+void convertNV12ToRGBA(const uint8_t* srcY, const uint8_t* srcUV, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride)
+{
+    convertNV12ToRGBA(srcY, srcUV, srcRowStride, width, height, dst, dstRowStride, getSupportedSimdLevel());
+}
+
+void convertNV12ToRGBA(const uint8_t* srcY, const uint8_t* srcUV, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride,
+    SimdLevel level)
+{
+    const NV12RowFunc rowFunc = getNV12RowFunc(level);
+
+    for (int32_t y = 0; y < height; y++) {
+        // Two luma rows share the same chroma row
+        rowFunc(srcY + srcRowStride * y, srcUV + srcRowStride * (y / 2), dst + dstRowStride * y, width);
+    }
+}
+
+float convertHalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    uint32_t bits = 0;
+    if (exponent == 0x1f) {
+        // Infinity or NaN
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        // Normalized, rebias exponent from 15 to 127
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // Subnormal half is a normalized float
+        uint32_t floatExponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            floatExponent--;
+        }
+        bits = sign | (floatExponent << 23) | ((mantissa & 0x3ff) << 13);
+    } else {
+        // Zero
+        bits = sign;
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void convertRGBA16FToRGBA(
+    const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride, const float background[3])
+{
+    convertRGBA16FToRGBA(src, srcRowStride, width, height, dst, dstRowStride, background, getSupportedSimdLevel());
+}
+
+void convertRGBA16FToRGBA(const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride,
+    const float background[3], SimdLevel level)
+{
+    const RGBA16FRowFunc rowFunc = getRGBA16FRowFunc(level);
+
+    const uint8_t* srcBytes = reinterpret_cast<const uint8_t*>(src);
+    for (int32_t y = 0; y < height; y++) {
+        rowFunc(reinterpret_cast<const uint16_t*>(srcBytes + srcRowStride * y), dst + dstRowStride * y, width, background);
+    }
+}
+
+void convertRGBA16FToRGBAReference(
+    const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride, const float background[3])
+{
+    const uint8_t* srcBytes = reinterpret_cast<const uint8_t*>(src);
+    for (int32_t y = 0; y < height; y++) {
+        const uint16_t* halfSrc = reinterpret_cast<const uint16_t*>(srcBytes + srcRowStride * y);
+        uint8_t* line = dst + dstRowStride * y;
+        for (int32_t x = 0; x < width * 4; x += 4) {
+            const float alpha = convertHalfToFloat(halfSrc[x + 3]);
+            for (int32_t c = 0; c < 3; c++) {
+                const float value = powf(convertHalfToFloat(halfSrc[x + c]), c_displayGamma);
+                line[x + c] = blendToUnorm8(value, alpha, background[c]);
+            }
+            line[x + 3] = 255;
+        }
+    }
+}
+
+bool downsampleY8(const uint8_t* src, size_t srcRowStride, int32_t dstWidth, int32_t dstHeight, int32_t factor, uint8_t* dst, size_t dstRowStride)
+{
+    return downsampleY8(src, srcRowStride, dstWidth, dstHeight, factor, dst, dstRowStride, getSupportedSimdLevel());
+}
+
+bool downsampleY8(
+    const uint8_t* src, size_t srcRowStride, int32_t dstWidth, int32_t dstHeight, int32_t factor, uint8_t* dst, size_t dstRowStride, SimdLevel level)
+{
+    if (factor == 1) {
+        for (int32_t y = 0; y < dstHeight; y++) {
+            std::memcpy(dst + dstRowStride * y, src + srcRowStride * y, static_cast<size_t>(dstWidth));
+        }
+        return true;
+    }
+
+    if (factor != 2 && factor != 4) {
+        return false;
+    }
+
+    const DownsampleRowFunc rowFunc = getDownsampleRowFunc(level, factor);
+    for (int32_t y = 0; y < dstHeight; y++) {
+        rowFunc(src + srcRowStride * factor * y, srcRowStride, dst + dstRowStride * y, dstWidth);
+    }
+    return true;
+}
+
+void thresholdY8(const uint8_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t threshold, ThresholdMode mode, uint32_t* dst,
+    size_t dstRowWords)
+{
+    thresholdY8(src, srcRowStride, width, height, threshold, mode, dst, dstRowWords, getSupportedSimdLevel());
+}
+
+void thresholdY8(const uint8_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t threshold, ThresholdMode mode, uint32_t* dst,
+    size_t dstRowWords, SimdLevel level)
+{
+    const ThresholdRowFunc rowFunc = getThresholdRowFunc(level, mode);
+    for (int32_t y = 0; y < height; y++) {
+        rowFunc(src + srcRowStride * y, width, threshold, dst + dstRowWords * y);
+    }
+}
+
+}  // namespace ColorConversion
+}  // namespace VarjoExamples
@@ -0,0 +1,95 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace VarjoExamples
+{
+// Vectorized CPU color conversion kernels used for data stream buffers.
+namespace ColorConversion
+{
+//! Instruction set level used by the conversion kernels
+enum class SimdLevel {
+    Scalar = 0,  //!< Portable C++ implementation
+    SSE41,       //!< SSE4.1, 16 pixels per iteration
+    AVX2,        //!< AVX2, 32 pixels per iteration
+};
+
+//! Returns the best instruction set level supported by the running CPU. Detected once and cached.
+SimdLevel getSupportedSimdLevel();
+
+//! Returns human readable name for given instruction set level
+const char* getSimdLevelName(SimdLevel level);
+
+//! Converts YUV color to RGB using fixed point BT.601 (limited range) coefficients.
+//! This is the reference implementation that all vectorized kernels must match bit exactly.
+inline void convertYUVtoRGB(uint8_t Y, uint8_t U, uint8_t V, uint8_t& R, uint8_t& G, uint8_t& B)
+{
+    const int C = static_cast<int>(Y) - 16;
+    const int D = static_cast<int>(U) - 128;
+    const int E = static_cast<int>(V) - 128;
+    R = static_cast<uint8_t>(std::clamp((298 * C + 409 * E + 128) >> 8, 0, 255));
+    G = static_cast<uint8_t>(std::clamp((298 * C - 100 * D - 208 * E + 128) >> 8, 0, 255));
+    B = static_cast<uint8_t>(std::clamp((298 * C + 516 * D + 128) >> 8, 0, 255));
+}
+
+//! Convert YUV420 NV12 image to RGBA8. Y and interleaved UV planes share the same row stride.
+//! Uses the best kernel supported by the CPU unless explicitly given.
+void convertNV12ToRGBA(const uint8_t* srcY, const uint8_t* srcUV, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride);
+
+//! Convert YUV420 NV12 image to RGBA8 using given kernel. Falls back to scalar if the level is not supported by the CPU.
+void convertNV12ToRGBA(const uint8_t* srcY, const uint8_t* srcUV, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride,
+    SimdLevel level);
+
+//! Converts IEEE 754 half precision value to float. Portable, does not need F16C or DirectXMath.
+float convertHalfToFloat(uint16_t value);
+
+//! Gamma used for converting linear RGBA16F images for display
+constexpr float c_displayGamma = 1.0f / 2.2f;
+
+//! Convert linear RGBA16F image to gamma corrected RGBA8. Color is alpha blended over given background color
+//! and output alpha is opaque. Negative and NaN color values are converted to black. Gamma correction uses a
+//! table indexed with the half float bits, so results match convertRGBA16FToRGBAReference() exactly for other values.
+//! Uses the best kernel supported by the CPU.
+void convertRGBA16FToRGBA(
+    const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride, const float background[3]);
+
+//! Convert linear RGBA16F image to gamma corrected RGBA8 using given kernel. The AVX2 kernel also requires F16C
+//! support. Falls back to scalar if the level is not supported by the CPU, SSE4.1 level uses the scalar kernel.
+void convertRGBA16FToRGBA(const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride,
+    const float background[3], SimdLevel level);
+
+//! Reference implementation of convertRGBA16FToRGBA() that evaluates powf for every color channel
+void convertRGBA16FToRGBAReference(
+    const uint16_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride, const float background[3]);
+
+//! Downsample Y8 image by averaging boxes of factor x factor pixels, rounding to nearest. Factor 1 copies the image.
+//! Source must have at least factor times the given output width and height. Returns false if factor is not 1, 2 or 4.
+//! Uses the best kernel supported by the CPU.
+bool downsampleY8(const uint8_t* src, size_t srcRowStride, int32_t dstWidth, int32_t dstHeight, int32_t factor, uint8_t* dst, size_t dstRowStride);
+
+//! Downsample Y8 image using given kernel. Falls back to scalar if the level is not supported by the CPU.
+bool downsampleY8(
+    const uint8_t* src, size_t srcRowStride, int32_t dstWidth, int32_t dstHeight, int32_t factor, uint8_t* dst, size_t dstRowStride, SimdLevel level);
+
+//! Pixel test used when thresholding Y8 images to bit masks
+enum class ThresholdMode {
+    Below,  //!< Set bits of pixels darker than the threshold
+    Above,  //!< Set bits of pixels brighter than the threshold
+};
+
+//! Threshold Y8 image to a bit mask. Bit (x % 32) of word (x / 32) in a mask row is set if pixel x passes the test,
+//! and unused bits at the end of rows are cleared. Mask rows need (width + 31) / 32 words.
+//! Uses the best kernel supported by the CPU.
+void thresholdY8(const uint8_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t threshold, ThresholdMode mode, uint32_t* dst,
+    size_t dstRowWords);
+
+//! Threshold Y8 image to a bit mask using given kernel. Falls back to scalar if the level is not supported by the CPU.
+void thresholdY8(const uint8_t* src, size_t srcRowStride, int32_t width, int32_t height, uint8_t threshold, ThresholdMode mode, uint32_t* dst,
+    size_t dstRowWords, SimdLevel level);
+
+}  // namespace ColorConversion
+}  // namespace VarjoExamples
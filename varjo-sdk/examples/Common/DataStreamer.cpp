@@ -6,12 +6,15 @@
 
 #include "DataStreamer.hpp"
 
-#include <fstream>
 #include <string>
+#include <thread>
 #include <algorithm>
+#include <cinttypes>
+#include <fstream>
 
-#include <DirectXPackedVector.h>
 #include <glm/gtc/type_ptr.hpp>
+#include "ColorConversion.hpp"
+#include "FrameRecording.hpp"
 #include "Undistorter.hpp"
 
 namespace VarjoExamples
@@ -24,17 +27,47 @@ const auto c_reportInterval = std::chrono::seconds{1};
 // Channel flags for channel indices
 const varjo_ChannelFlag c_channelFlags[] = {varjo_ChannelFlag_First, varjo_ChannelFlag_Second};
 
-// Converts YUV color to RGB
-inline void convertYUVtoRGB(uint8_t Y, uint8_t U, uint8_t V, uint8_t& R, uint8_t& G, uint8_t& B)
+// Returns snapshot filename for given buffer
+std::string getSnapshotFilename(
+    const char* baseName, const DataStreamer::Frame::Metadata& frameMetadata, varjo_BufferId bufferId, SnapshotWriter::ImageFormat format)
 {
-    const int C = static_cast<int>(Y) - 16;
-    const int D = static_cast<int>(U) - 128;
-    const int E = static_cast<int>(V) - 128;
-    R = static_cast<uint8_t>(std::clamp((298 * C + 409 * E + 128) >> 8, 0, 255));
-    G = static_cast<uint8_t>(std::clamp((298 * C - 100 * D - 208 * E + 128) >> 8, 0, 255));
-    B = static_cast<uint8_t>(std::clamp((298 * C + 516 * D + 128) >> 8, 0, 255));
+    return std::string(baseName) + "_sid" + std::to_string(frameMetadata.streamFrame.id) + "_frm" + std::to_string(frameMetadata.streamFrame.frameNumber) +
+           "_bid" + std::to_string(bufferId) + SnapshotWriter::getFileExtension(format);
+}
+
+// Returns nanoseconds elapsed since given time
+int64_t getElapsedNanoseconds(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
 }
 
+// Appends latency summary as JSON object member
+void appendJson(std::string& line, const char* name, const LatencyHistogram::Summary& summary)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        ",\"%s\":{\"count\":%" PRIu64 ",\"min\":%" PRId64 ",\"mean\":%" PRId64 ",\"p50\":%" PRId64 ",\"p90\":%" PRId64 ",\"p99\":%" PRId64
+        ",\"p999\":%" PRId64 ",\"max\":%" PRId64 "}",
+        name, summary.count, summary.min, summary.mean, summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+    line += buffer;
+}
+
+// Scoped counter for tracking stream callbacks in progress
+class ScopedCounter
+{
+public:
+    explicit ScopedCounter(std::atomic<int32_t>& counter)
+        : m_counter(counter)
+    {
+        m_counter++;
+    }
+
+    ~ScopedCounter() { m_counter--; }
+
+private:
+    std::atomic<int32_t>& m_counter;
+};
+
 // Converts color from Y8 format to RGBA
 constexpr uint32_t convertY8toRGBA(uint8_t Y)
 {
@@ -44,7 +77,7 @@ constexpr uint32_t convertY8toRGBA(uint8_t Y)
 }
 
 // Helper template to construct Y8 to RGBA map
-template <uint32_t... I>
+template <size_t... I>
 static constexpr std::array<uint32_t, sizeof...(I)> buildY8toRGBAMap(std::index_sequence<I...>) noexcept
 {
     return std::array<uint32_t, sizeof...(I)>{convertY8toRGBA(I)...};
@@ -53,84 +86,43 @@ static constexpr std::array<uint32_t, sizeof...(I)> buildY8toRGBAMap(std::index_
 // Map for doing optimized color conversion from Y8 to RGBA
 constexpr std::array<uint32_t, 256> c_convertY8ToRGBAMap = buildY8toRGBAMap(std::make_index_sequence<256>{});
 
-void writeBMP(const std::string& filename, int32_t width, int32_t height, int32_t components, const uint8_t* data)
+// Convert distorted YUV buffer to RGBA by gathering samples using given remap table
+void remapYUVToRGBA(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output, const uint32_t* samples)
 {
-    assert(components == 4);
-
-    std::ofstream outFile(filename, std::ofstream::binary);
-    if (!outFile.good()) {
-        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
-        return;
-    }
-
-    const uint32_t imageDataSize = components * width * height;
-
-    // Write BMP headers
-    BITMAPFILEHEADER bmFileHdr;
-    bmFileHdr.bfType = *(reinterpret_cast<const WORD*>("BM"));
-    bmFileHdr.bfSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + imageDataSize;
-    bmFileHdr.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
-    outFile.write(reinterpret_cast<const char*>(&bmFileHdr), sizeof(bmFileHdr));
-    if (!outFile.good()) {
-        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-        return;
-    }
-
-    // Write bitmap header for RGB data
-    BITMAPINFOHEADER bmInfoHdr;
-    ZeroMemory(&bmInfoHdr, sizeof(bmInfoHdr));
-    bmInfoHdr.biSize = sizeof(bmInfoHdr);
-    bmInfoHdr.biWidth = width;
-    bmInfoHdr.biHeight = -height;  // Negative height to avoid flipping image vertically
-    bmInfoHdr.biPlanes = 1;
-    bmInfoHdr.biBitCount = 32;
-    bmInfoHdr.biCompression = BI_RGB;
-    bmInfoHdr.biSizeImage = 0;
-    bmInfoHdr.biXPelsPerMeter = bmInfoHdr.biYPelsPerMeter = 2835;
-    bmInfoHdr.biClrImportant = bmInfoHdr.biClrUsed = 0;
-    outFile.write(reinterpret_cast<const char*>(&bmInfoHdr), sizeof(bmInfoHdr));
-    if (!outFile.good()) {
-        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-        return;
-    }
+    const size_t bufferRowStride = buffer.rowStride;
 
-    // Write data row by row
-    std::vector<uint8_t> row(components * width);
-    for (int32_t y = 0; y < height; ++y) {
-        const uint8_t* src = data + y * width * components;
-        uint8_t* dst = row.data();
-        for (int32_t x = 0; x < width; ++x) {
-            // Swap RGBA to BGRA used in bitmaps
-            dst[0] = src[2];
-            dst[1] = src[1];
-            dst[2] = src[0];
-            dst[3] = src[3];
-            dst += 4;
-            src += 4;
-        }
-
-        outFile.write(reinterpret_cast<const char*>(row.data()), row.size());
-        if (!outFile.good()) {
-            LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-            return;
+    // Calculate start address of Y- and UV-planes. UV plane has half vertical resolution.
+    const uint8_t* yStart = input;
+    const uint8_t* uvStart = input + bufferRowStride * buffer.height;
+
+    const size_t sampleCount = static_cast<size_t>(outputSize.x) * outputSize.y;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        // Init to black which will be written in case the sample coordinate is invalid.
+        uint8_t R = 0;
+        uint8_t G = 0;
+        uint8_t B = 0;
+
+        // Sample from Y and UV planes and convert to RGB.
+        const uint32_t sample = samples[i];
+        if (sample != Undistorter::c_invalidSample) {
+            const uint32_t x = sample & 0xffff;
+            const uint32_t y = sample >> 16;
+            const uint32_t uvX = x & ~1u;
+
+            const uint8_t Y = yStart[y * bufferRowStride + x];
+            const uint8_t U = uvStart[(y / 2) * bufferRowStride + uvX + 0];
+            const uint8_t V = uvStart[(y / 2) * bufferRowStride + uvX + 1];
+
+            ColorConversion::convertYUVtoRGB(Y, U, V, R, G, B);
         }
-    }
-
-    outFile.close();
-    LOG_INFO("File saved succesfully: %s", filename.c_str());
-}
-
-// Save varjo buffer data as BMP image file
-void saveBMP(const std::string& filename, const varjo_BufferMetadata& buffer, const void* bufferData)
-{
-    LOG_DEBUG("Saving buffer to file: %s", filename.c_str());
 
-    constexpr int32_t components = 4;
-    std::vector<uint8_t> output(buffer.width * buffer.height * components);
-
-    DataStreamer::convertToR8G8B8A(buffer, bufferData, output.data());
-
-    writeBMP(filename.c_str(), buffer.width, buffer.height, components, output.data());
+        // Write out RGBA.
+        output[0] = R;
+        output[1] = G;
+        output[2] = B;
+        output[3] = 255;
+        output += 4;
+    }
 }
 
 }  // namespace
@@ -139,21 +131,34 @@ DataStreamer::DataStreamer(varjo_Session* session, const std::function<void(cons
     : m_session(session)
     , m_onFrameCallback(onFrameCallback)
 {
+    m_streamManagement.streams = std::make_shared<const StreamTable>();
     m_streamManagement.running = true;
 }
 
 DataStreamer::~DataStreamer()
 {
-    // To initiate shutdown, set running flag to false to ensure all callbacks will not process data anymore.
-    // We need to lock the mutex only for the time when the flag is being changed.
-    {
-        std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
-        m_streamManagement.running = false;
+    // Stop latency log first, it reads the stream table
+    setLatencyLogFile("");
+
+    // To initiate shutdown, set running flag to false to ensure all callbacks will not process data anymore,
+    // and wait for the callbacks that are already in progress.
+    m_streamManagement.running = false;
+    while (m_streamManagement.activeCallbacks > 0) {
+        std::this_thread::yield();
     }
 
+    // Channel workers might still be handling buffers of running streams
+    stopChannelWorkers();
+
+    // Queued snapshots might reference leased buffers, write them before the buffers are freed
+    m_snapshotWriter.flush();
+
     // If we have streams running, stop them
-    for (const auto& [streamId, stream] : m_streamManagement.streams) {
+    for (const auto& [streamId, stream] : *getStreams()) {
         LOG_WARNING("Stopping running data stream: %d", static_cast<int>(streamId));
+
+        // Outstanding leases must not unlock buffers of a stopped stream
+        stream->leases->detach();
         varjo_StopDataStream(m_session, streamId);
     }
 
@@ -161,40 +166,44 @@ DataStreamer::~DataStreamer()
     m_session = nullptr;
 }
 
-std::pair<varjo_StreamId, varjo_ChannelFlag> DataStreamer::getStreamingIdAndChannel(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const
-{
-    // Frame callback comes from different thread, lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
+std::shared_ptr<const DataStreamer::StreamTable> DataStreamer::getStreams() const { return std::atomic_load(&m_streamManagement.streams); }
 
-    // Find out if we have running stream ( without throwing std::bad_alloc from copying StreamData,
-    // getStreamingIdAndChannel is called from destructor and should not throw )
-    for (const auto& [id, data] : m_streamManagement.streams) {
-        if (data.streamType == streamType && data.streamFormat == streamFormat) {
-            return std::make_pair(id, data.channels);
+std::shared_ptr<DataStreamer::StreamData> DataStreamer::findStream(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const
+{
+    const auto streams = getStreams();
+    for (const auto& [id, stream] : *streams) {
+        if (stream->streamType == streamType && stream->streamFormat == streamFormat) {
+            return stream;
         }
     }
 
+    return nullptr;
+}
+
+std::pair<varjo_StreamId, varjo_ChannelFlag> DataStreamer::getStreamingIdAndChannel(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const
+{
+    // Find out if we have running stream from the current stream table snapshot
+    const auto stream = findStream(streamType, streamFormat);
+    if (stream) {
+        return std::make_pair(stream->streamId, stream->channels);
+    }
+
     return std::make_pair(varjo_InvalidId, varjo_ChannelFlag_None);
 }
 
 bool DataStreamer::isStreaming() const
 {
-    // Frame callback comes from different thread, lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
-
     // Find out if we have running streams
-    return !m_streamManagement.streams.empty();
+    return !getStreams()->empty();
 }
 
 bool DataStreamer::isStreaming(varjo_StreamType streamType) const
 {
-    // Lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
-
-    const auto it = std::find_if(m_streamManagement.streams.begin(), m_streamManagement.streams.end(),
-        [streamType](const std::pair<varjo_StreamId, StreamData>& item) { return item.second.streamType == streamType; });
+    const auto streams = getStreams();
+    const auto it = std::find_if(streams->begin(), streams->end(),
+        [streamType](const std::pair<const varjo_StreamId, std::shared_ptr<StreamData>>& item) { return item.second->streamType == streamType; });
 
-    return it != m_streamManagement.streams.end();
+    return it != streams->end();
 }
 
 bool DataStreamer::isStreaming(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const
@@ -239,31 +248,66 @@ void DataStreamer::startDataStream(varjo_StreamType streamType, varjo_TextureFor
         LOG_INFO("Start streaming: type=%lld, format=%lld", streamType, streamFormat);
 
         if (!isStreaming()) {
-            m_statusLine = "Starting stream.";
+            std::lock_guard<std::mutex> statsLock(m_statsMutex);
+            m_stats.statusLine = "Starting stream.";
         }
 
-        // Start stream
-        streamId = startStreaming(streamType, streamFormat, channels);
-
-        // Check if successfully started
-        if (streamId != varjo_InvalidId) {
-            // Frame callback comes from different thread, lock streaming data
-            std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
+        // Only one channel in environment cubemap
+        if (streamType == varjo_StreamType_EnvironmentCubemap) {
+            channels &= varjo_ChannelFlag_First;
+        }
 
-            StreamData stream;
-            stream.streamId = streamId;
-            stream.streamType = streamType;
-            stream.streamFormat = streamFormat;
-            stream.channels = channels;
-            stream.frameData[varjo_ChannelIndex_First] = {};
-            stream.frameData[varjo_ChannelIndex_Second] = {};
-            m_streamManagement.streams[streamId] = stream;
+        // Find suitable stream
+        const auto config = findStreamConfig(streamType, streamFormat, channels);
+        if (config.has_value()) {
+            streamId = config->streamId;
+
+            auto stream = std::make_shared<StreamData>();
+            stream->streamId = streamId;
+            stream->streamType = streamType;
+            stream->streamFormat = streamFormat;
+            stream->channels = channels;
+            stream->frameInterval = (config->frameRate > 0) ? 1000000000LL / config->frameRate : 0;
+            stream->parallelChannels = m_parallelChannelHandling && (channels != varjo_ChannelFlag_None);
+            stream->leases = std::make_shared<BufferLeases>();
+            stream->leases->activate(m_session);
+
+            // Publish new stream table before starting the stream, so that frames arriving right after
+            // start are not ignored. Frame callbacks keep using the table they already loaded.
+            size_t streamCount = 0;
+            {
+                std::lock_guard<std::mutex> streamLock(m_streamManagement.mutex);
+                if (stream->parallelChannels) {
+                    startChannelWorkers();
+                }
+                auto streams = std::make_shared<StreamTable>(*getStreams());
+                (*streams)[streamId] = stream;
+                streamCount = streams->size();
+                std::atomic_store(&m_streamManagement.streams, std::shared_ptr<const StreamTable>(std::move(streams)));
+            }
 
             // Reset stats if first stream
-            if (m_streamManagement.streams.size() == 1) {
-                m_stats = {};
+            if (streamCount == 1) {
+                std::lock_guard<std::mutex> statsLock(m_statsMutex);
+                m_stats.frameCount = 0;
                 m_stats.reportTime = std::chrono::high_resolution_clock::now();
             }
+
+            // Start the frame stream, and provide callback for handling frames
+            varjo_StartDataStream(m_session, streamId, channels, dataStreamFrameCallback, this);
+            if (CHECK_VARJO_ERR(m_session) != varjo_NoError) {
+                LOG_WARNING("Start stream failed: type=%lld, format=%lld", streamType, streamFormat);
+
+                // Remove stream again
+                stream->stopping = true;
+                waitStreamCallbacks(*stream);
+                waitChannelWorkers(*stream);
+                stream->leases->detach();
+                std::lock_guard<std::mutex> streamLock(m_streamManagement.mutex);
+                auto streams = std::make_shared<StreamTable>(*getStreams());
+                streams->erase(streamId);
+                std::atomic_store(&m_streamManagement.streams, std::shared_ptr<const StreamTable>(std::move(streams)));
+            }
         } else {
             LOG_WARNING("Start stream failed. Could not find stream with type=%lld, format=%lld", streamType, streamFormat);
         }
@@ -274,32 +318,42 @@ void DataStreamer::startDataStream(varjo_StreamType streamType, varjo_TextureFor
 
 void DataStreamer::stopDataStream(varjo_StreamType streamType, varjo_TextureFormat streamFormat)
 {
-    varjo_StreamId streamId = getStreamingIdAndChannel(streamType, streamFormat).first;
+    const auto stream = findStream(streamType, streamFormat);
 
-    if (streamId != varjo_InvalidId) {
+    if (stream) {
         LOG_INFO("Stop streaming: type=%lld", streamType);
 
+        // Keep delayed buffers from being handled while the stream is stopped and removed
+        std::lock_guard<std::mutex> delayedLock(m_streamManagement.delayedMutex);
+
+        // Stream callbacks and channel workers skip buffers of a stopping stream, wait for the ones already handling
+        // its buffers. Callbacks go first, as they can still queue buffers for the workers.
+        stream->stopping = true;
+        waitStreamCallbacks(*stream);
+        waitChannelWorkers(*stream);
+
+        // Detach outstanding buffer leases from the stream. Nothing can acquire new leases or queue snapshots for the
+        // stream anymore. Buffers get freed when the stream is stopped, so queued snapshots referencing them must be
+        // written first.
+        stream->leases->detach();
+        m_snapshotWriter.flush();
+
         // Stop stream
-        varjo_StopDataStream(m_session, streamId);
+        varjo_StopDataStream(m_session, stream->streamId);
         CHECK_VARJO_ERR(m_session);
 
-        // Scope lock for cleanup
+        // Remove stream. Any delayed or channel worker buffers still queued for it are released with the stream data,
+        // buffers were already freed by varjo_StopDataStream call.
         {
-            // Frame callback comes from different thread, lock streaming data
-            std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
-
-            // Remove stream
-            m_streamManagement.streams.erase(streamId);
-
-            // Remove any delayed buffer that we might have stored. Buffers were already
-            // freed by varjo_StopDataStream call.
-            const auto isBufferFromThisStream = [streamId](const DelayedBuffer& delayedBuffer) { return delayedBuffer.frame.streamFrame.id == streamId; };
-            auto& delayedBuffers = m_streamManagement.delayedBuffers;
-            delayedBuffers.erase(std::remove_if(delayedBuffers.begin(), delayedBuffers.end(), isBufferFromThisStream), delayedBuffers.end());
+            std::lock_guard<std::mutex> streamLock(m_streamManagement.mutex);
+            auto streams = std::make_shared<StreamTable>(*getStreams());
+            streams->erase(stream->streamId);
+            std::atomic_store(&m_streamManagement.streams, std::shared_ptr<const StreamTable>(std::move(streams)));
         }
 
         if (!isStreaming()) {
-            m_statusLine = "";
+            std::lock_guard<std::mutex> statsLock(m_statsMutex);
+            m_stats.statusLine = "";
         }
 
     } else {
@@ -309,35 +363,35 @@ void DataStreamer::stopDataStream(varjo_StreamType streamType, varjo_TextureForm
 
 void DataStreamer::handleDelayedBuffers(bool ignore)
 {
-    // Callback comes from different thread, lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
-
-    auto& delayedBuffers = m_streamManagement.delayedBuffers;
-    if (delayedBuffers.empty()) {
-        return;
-    }
-
-    // Handle buffers if not ignored
-    if (!ignore) {
-        LOG_DEBUG("Handling delayed stream buffers: count=%d", delayedBuffers.size());
-        for (auto& db : delayedBuffers) {
-            storeBuffer(db.frame, db.bufferId, db.cpuBuffer, db.baseName, db.takeSnapshot);
-        }
-    } else {
-        LOG_DEBUG("Ignoring delayed stream buffers: count=%d", delayedBuffers.size());
+    // Delayed buffer queues have a single consumer, serialize handling
+    std::lock_guard<std::mutex> delayedLock(m_streamManagement.delayedMutex);
+    drainDelayedBuffers(ignore);
+}
 
-        for (auto& db : delayedBuffers) {
-            if (db.bufferId != varjo_InvalidId) {
+void DataStreamer::drainDelayedBuffers(bool ignore)
+{
+    const auto streams = getStreams();
+    for (const auto& [streamId, stream] : *streams) {
+        size_t count = 0;
+        DelayedBuffer db;
+        while (stream->delayedBuffers.pop(db)) {
+            count++;
+
+            // Handle buffers if not ignored
+            if (!ignore) {
+                auto& frame = stream->frameData[static_cast<size_t>(db.frame.channelIndex)].delayedFrame;
+                storeBuffer(*stream, frame, db.frame, db.bufferId, db.cpuBuffer, db.baseName, db.takeSnapshot, db.timing);
+            } else if (db.bufferId != varjo_InvalidId) {
                 // Just unlock buffer to allow reuse
-                LOG_DEBUG("Unlocking buffer (id=%lld)", db.bufferId);
-                varjo_UnlockDataStreamBuffer(m_session, db.bufferId);
-                CHECK_VARJO_ERR(m_session);
+                unlockBuffer(*stream, db.frame.channelIndex, db.bufferId, db.timing);
             }
         }
-    }
 
-    // Clear buffers
-    delayedBuffers.clear();
+        if (count > 0) {
+            LOG_DEBUG("%s delayed stream buffers: id=%lld, count=%zu, dropped=%llu", ignore ? "Ignored" : "Handled", streamId, count,
+                static_cast<unsigned long long>(stream->droppedDelayedBuffers.load()));
+        }
+    }
 }
 
 void DataStreamer::printStreamConfigs() const
@@ -355,22 +409,12 @@ void DataStreamer::printStreamConfigs() const
     LOG_INFO("");
 }
 
-void DataStreamer::storeBuffer(const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, void* cpuData, const std::string& baseName, bool takeSnapshot)
+void DataStreamer::storeBuffer(StreamData& stream, Frame& frame, const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, void* cpuData,
+    const char* baseName, bool takeSnapshot, const FrameTiming& timing)
 {
-    auto streamIt = m_streamManagement.streams.find(frameMetadata.streamFrame.id);
-    if (streamIt == m_streamManagement.streams.end()) {
-        // Stream has been stopped and removed already
-        return;
-    }
-
-    auto channelIt = streamIt->second.frameData.find(frameMetadata.channelIndex);
-    if (channelIt == streamIt->second.frameData.end()) {
-        // Removed or unsupported channel
-        return;
-    }
+    auto& frameData = stream.frameData[static_cast<size_t>(frameMetadata.channelIndex)];
 
     // Handle buffer
-    auto& frameData = channelIt->second;
     bool validFrameData = false;
     if (bufferId == varjo_InvalidId) {
         // Metadata only
@@ -383,13 +427,6 @@ void DataStreamer::storeBuffer(const Frame::Metadata& frameMetadata, varjo_Buffe
                frameMetadata.bufferMetadata.format == varjo_TextureFormat_NV12 ||          //
                frameMetadata.bufferMetadata.format == varjo_TextureFormat_Y8_UNORM);
 
-        if (takeSnapshot && cpuData != nullptr) {
-            // Save buffer data to file.
-            std::string fileName = baseName + "_sid" + std::to_string(frameMetadata.streamFrame.id) + "_frm" +
-                                   std::to_string(frameMetadata.streamFrame.frameNumber) + "_bid" + std::to_string(bufferId) + ".bmp";
-            saveBMP(fileName, frameMetadata.bufferMetadata, cpuData);
-        }
-
         validFrameData = true;
     } else if (frameMetadata.bufferMetadata.type == varjo_BufferType_GPU) {
         assert(cpuData == nullptr);
@@ -398,45 +435,120 @@ void DataStreamer::storeBuffer(const Frame::Metadata& frameMetadata, varjo_Buffe
         CRITICAL("Unsupported output type!");
     }
 
-    if (validFrameData && m_onFrameCallback) {
-        // Store the frame
-        auto& frame = frameData.frame;
+    // Capture buffer if burst is in progress
+    if (validFrameData && cpuData != nullptr) {
+        if (const auto burst = std::atomic_load(&stream.burst)) {
+            captureBurstBuffer(stream, burst, frameMetadata, bufferId, cpuData, baseName);
+        }
+    }
+
+    // Record frame before the callback, so slow consumers do not delay recording
+    if (validFrameData) {
+        if (const auto recorder = std::atomic_load(&m_recorder)) {
+            recorder->record(frameMetadata, cpuData, cpuData ? static_cast<size_t>(frameMetadata.bufferMetadata.byteSize) : 0);
+        }
+    }
 
+    // Lease the locked buffer instead of copying it, unless the stream has too many leases outstanding
+    bool leased = false;
+    if (validFrameData && m_onFrameCallback && m_bufferLeasing && cpuData != nullptr) {
+        leased = stream.leases->tryAcquire(m_maxBufferLeases);
+        if (!leased) {
+            LOG_DEBUG("Buffer lease limit reached, copying buffer (id=%lld)", bufferId);
+        }
+    }
+
+    if (validFrameData && m_onFrameCallback) {
         // Store metadata
         frame.metadata = frameMetadata;
 
-        // Resize buffer if needed.
-        if (frame.data.size() != frameMetadata.bufferMetadata.byteSize) {
-            frame.data.resize(frameMetadata.bufferMetadata.byteSize);
-        }
+        if (leased) {
+            // Buffer gets unlocked when the last copy of the lease is released
+            auto leases = stream.leases;
+            auto metrics = frameData.metrics;
+            const auto lockTime = timing.lockTime;
+            frame.data.clear();
+            frame.lease = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(cpuData), [leases, metrics, lockTime, bufferId](const uint8_t*) {
+                leases->release(bufferId);
+                metrics->bufferLockTime.record(getElapsedNanoseconds(lockTime));
+            });
+        } else {
+            // Resize buffer if needed.
+            if (frame.data.size() != frameMetadata.bufferMetadata.byteSize) {
+                frame.data.resize(frameMetadata.bufferMetadata.byteSize);
+            }
 
-        // Store buffer data
-        if (cpuData != nullptr && frameMetadata.bufferMetadata.byteSize > 0) {
-            memcpy(frame.data.data(), cpuData, frameMetadata.bufferMetadata.byteSize);
+            // Store buffer data
+            if (cpuData != nullptr && frameMetadata.bufferMetadata.byteSize > 0) {
+                memcpy(frame.data.data(), cpuData, frameMetadata.bufferMetadata.byteSize);
+            }
         }
+    }
+
+    // Queue snapshot for writing in background. Leased buffer is referenced as is, otherwise the buffer is copied
+    // because it gets unlocked when we return.
+    if (validFrameData && takeSnapshot && cpuData != nullptr) {
+        SnapshotWriter::Request request;
+        request.filename = getSnapshotFilename(baseName, frameMetadata, bufferId, m_snapshotFormat);
+        request.bufferMetadata = frameMetadata.bufferMetadata;
+        request.data = leased ? frame.lease : SnapshotWriter::copyBuffer(cpuData, frameMetadata.bufferMetadata.byteSize);
+        m_snapshotWriter.write(std::move(request));
+    }
+
+    if (validFrameData && m_onFrameCallback) {
+        frameData.metrics->callbackToDelivery.record(getElapsedNanoseconds(timing.arrival));
 
         // Do callback
         m_onFrameCallback(frame);
+
+        // Drop our reference, the lease is now owned by the consumer if it kept a copy
+        frame.lease.reset();
     }
     frameData.frameCount++;
 
-    // Unlock buffer
-    if (bufferId != varjo_InvalidId) {
-        LOG_DEBUG("Unlocking buffer (id=%lld)", bufferId);
-        varjo_UnlockDataStreamBuffer(m_session, bufferId);
-        CHECK_VARJO_ERR(m_session);
+    // Unlock buffer unless leased
+    if (bufferId != varjo_InvalidId && !leased) {
+        unlockBuffer(stream, frameMetadata.channelIndex, bufferId, timing);
     }
 }
 
-void DataStreamer::handleBuffer(const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, const std::string& baseName, bool takeSnapshot)
+void DataStreamer::unlockBuffer(StreamData& stream, varjo_ChannelIndex channelIndex, varjo_BufferId bufferId, const FrameTiming& timing)
 {
+    LOG_DEBUG("Unlocking buffer (id=%lld)", bufferId);
+    varjo_UnlockDataStreamBuffer(m_session, bufferId);
+    CHECK_VARJO_ERR(m_session);
+
+    stream.frameData[static_cast<size_t>(channelIndex)].metrics->bufferLockTime.record(getElapsedNanoseconds(timing.lockTime));
+}
+
+void DataStreamer::handleBuffer(const std::shared_ptr<StreamData>& streamData, const Frame::Metadata& frameMetadata, varjo_BufferId bufferId,
+    const char* baseName, bool takeSnapshot, const FrameTiming& timing)
+{
+    auto& stream = *streamData;
     varjo_BufferMetadata bufferMetadata{};
     void* cpuData = nullptr;
 
+    // Measure latency and frame sequence. Interval jitter is the deviation of the stream callback interval from
+    // the frame period, taking frames missing from the sequence into account.
+    auto& metrics = *stream.frameData[static_cast<size_t>(frameMetadata.channelIndex)].metrics;
+    const int64_t frameNumber = frameMetadata.streamFrame.frameNumber;
+    metrics.exposureToCallback.record(timing.arrivalTime - frameMetadata.timestamp);
+    if (metrics.lastFrameNumber >= 0 && frameNumber > metrics.lastFrameNumber) {
+        const int64_t frameCount = frameNumber - metrics.lastFrameNumber;
+        metrics.droppedFrames += static_cast<uint64_t>(frameCount - 1);
+        if (stream.frameInterval > 0) {
+            metrics.intervalJitter.record(std::abs(timing.arrivalTime - metrics.lastArrivalTime - frameCount * stream.frameInterval));
+        }
+    }
+    metrics.lastFrameNumber = frameNumber;
+    metrics.lastArrivalTime = timing.arrivalTime;
+
+    FrameTiming bufferTiming = timing;
     if (bufferId != varjo_InvalidId) {
         // Lock buffer if we have one (metadata only streams don't have it)
         varjo_LockDataStreamBuffer(m_session, bufferId);
         CHECK_VARJO_ERR(m_session);
+        bufferTiming.lockTime = std::chrono::steady_clock::now();
 
         bufferMetadata = varjo_GetBufferMetadata(m_session, bufferId);
         cpuData = varjo_GetBufferCPUData(m_session, bufferId);
@@ -457,13 +569,52 @@ void DataStreamer::handleBuffer(const Frame::Metadata& frameMetadata, varjo_Buff
         delayedBuffer.cpuBuffer = cpuData;
         delayedBuffer.baseName = baseName;
         delayedBuffer.takeSnapshot = takeSnapshot;
+        delayedBuffer.timing = bufferTiming;
+
+        // Add to delayed buffers. Will be handled in main loop. If the main loop has fallen behind,
+        // drop the buffer instead of waiting for it.
+        if (!stream.delayedBuffers.push(delayedBuffer)) {
+            stream.droppedDelayedBuffers++;
+            LOG_DEBUG("Delayed buffer queue full, dropping buffer (id=%lld)", bufferId);
+            if (bufferId != varjo_InvalidId) {
+                unlockBuffer(stream, frame.channelIndex, bufferId, bufferTiming);
+            }
+        }
 
-        // Add to delayed buffers. Will be handled in main loop.
-        m_streamManagement.delayedBuffers.emplace_back(delayedBuffer);
+    } else if (stream.parallelChannels && bufferId != varjo_InvalidId) {
+        ChannelJob job;
+        job.stream = streamData;
+        job.buffer.frame = frame;
+        job.buffer.bufferId = bufferId;
+        job.buffer.cpuBuffer = cpuData;
+        job.buffer.baseName = baseName;
+        job.buffer.takeSnapshot = takeSnapshot;
+        job.buffer.timing = bufferTiming;
+
+        // Queue buffer for the worker of this channel, so that the stream thread can return and the other channel gets
+        // handled concurrently. If the worker has fallen behind, drop the buffer instead of waiting for it.
+        auto& worker = *m_channelWorkers[static_cast<size_t>(frame.channelIndex)];
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> workerLock(worker.mutex);
+            if (worker.size < c_maxChannelJobs) {
+                std::swap(worker.jobs[(worker.head + worker.size) % c_maxChannelJobs], job);
+                worker.size++;
+                queued = true;
+            }
+        }
+
+        if (queued) {
+            worker.condition.notify_all();
+        } else {
+            m_droppedChannelBuffers++;
+            LOG_DEBUG("Channel worker queue full, dropping buffer (id=%lld)", bufferId);
+            unlockBuffer(stream, frame.channelIndex, bufferId, bufferTiming);
+        }
 
     } else {
         // Handle buffer immediately
-        storeBuffer(frame, bufferId, cpuData, baseName, takeSnapshot);
+        storeBuffer(stream, stream.frameData[static_cast<size_t>(frame.channelIndex)].frame, frame, bufferId, cpuData, baseName, takeSnapshot, bufferTiming);
     }
 }
 
@@ -479,8 +630,9 @@ void DataStreamer::dataStreamFrameCallback(const varjo_StreamFrame* frame, varjo
 
 void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Session* session)
 {
-    // Callback comes from different thread, lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
+    // Callback comes from different thread. Instead of locking, register the callback as in progress
+    // so that destructor can wait for it, and only read the published stream table.
+    const ScopedCounter callbackCounter(m_streamManagement.activeCallbacks);
 
     // Check if the data streaming is shutting down
     if (!m_streamManagement.running) {
@@ -488,14 +640,6 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
     }
 
     m_stats.frameCount++;
-    const auto now = std::chrono::high_resolution_clock::now();
-    const auto delta = now - m_stats.reportTime;
-    if (delta >= c_reportInterval) {
-        m_statusLine = "Got " + std::to_string(m_stats.frameCount) + " frames from " + std::to_string(m_streamManagement.streams.size()) + " streams in last " +
-                       std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(delta).count()) + " ms";
-        m_stats = {};
-        m_stats.reportTime = now;
-    }
 
     // Check that client session hasn't already be reset in destructor. Should never happen!
     if (session != m_session) {
@@ -503,21 +647,39 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
         return;
     }
 
-    // Check that the stream is still running
-    const auto it = m_streamManagement.streams.find(frame->id);
-    if (it == m_streamManagement.streams.end()) {
+    // Check that the stream is still running. Stream table snapshot keeps stream data alive until we return.
+    const auto streams = getStreams();
+    const auto it = streams->find(frame->id);
+    if (it == streams->end()) {
         LOG_WARNING("Frame callback ignored. Stream already deleted: type=%lld, id=%lld", frame->type, frame->id);
         return;
     }
 
-    auto& stream = it->second;
+    const auto& streamData = it->second;
+    auto& stream = *streamData;
+
+    // Register the callback with the stream before checking that it is not stopping. Stopping sets the flag before
+    // waiting for the counter, so either we see the flag here or it waits until we return. Delivery mode changes
+    // pause delivery the same way, and the frame is dropped.
+    const ScopedCounter streamCallbackCounter(stream.activeCallbacks);
+    if (stream.stopping) {
+        return;
+    }
+    if (m_streamManagement.deliveryPaused) {
+        LOG_DEBUG("Frame dropped while changing delivery mode: type=%lld, id=%lld", frame->type, frame->id);
+        return;
+    }
+
+    // Capture arrival time for latency measurements
+    FrameTiming timing;
+    timing.arrival = std::chrono::steady_clock::now();
+    timing.arrivalTime = varjo_GetCurrentTime(m_session);
 
     // Check wether we need to take snapshot of the frame
-    const auto snaphotRequested = stream.snapshotRequested;
-    it->second.snapshotRequested = false;
+    const bool snaphotRequested = stream.snapshotRequested.exchange(false);
 
     // Buffer filename prefixes
-    std::vector<std::string> bufferFilenames;
+    std::array<const char*, 2> bufferFilenames{};
     varjo_Nanoseconds timestamp = 0;
     switch (frame->type) {
         case varjo_StreamType_DistortedColor:
@@ -546,9 +708,9 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
 
             // Use a distinct name for the file in case auto adaptation was enabled.
             if (frame->metadata.environmentCubemap.mode == varjo_EnvironmentCubemapMode_AutoAdapt) {
-                bufferFilenames = {"cube_adapted"};
+                bufferFilenames = {"cube_adapted", nullptr};
             } else {
-                bufferFilenames = {"cube"};
+                bufferFilenames = {"cube", nullptr};
             }
             break;
 
@@ -573,7 +735,7 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
         frameMetadata.timestamp = timestamp;
         frameMetadata.extrinsics = {};
         frameMetadata.intrinsics = {};
-        handleBuffer(frameMetadata, varjo_InvalidId, "", false);
+        handleBuffer(streamData, frameMetadata, varjo_InvalidId, "", false, timing);
         return;
     }
 
@@ -616,64 +778,499 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
             frameMetadata.timestamp = timestamp;
             frameMetadata.extrinsics = extrinsics;
             frameMetadata.intrinsics = intrinsics;
-            handleBuffer(frameMetadata, bufferId, bufferFilenames[static_cast<size_t>(channelIndex)], snaphotRequested);
+            handleBuffer(streamData, frameMetadata, bufferId, bufferFilenames[static_cast<size_t>(channelIndex)], snaphotRequested, timing);
         }
     }
 }
 
-varjo_StreamId DataStreamer::startStreaming(varjo_StreamType type, varjo_TextureFormat format, varjo_ChannelFlag channels)
+std::optional<varjo_StreamConfig> DataStreamer::findStreamConfig(varjo_StreamType type, varjo_TextureFormat format, varjo_ChannelFlag channels) const
 {
-    varjo_StreamId streamId = varjo_InvalidId;
-
     // Fetch stream configs
     std::vector<varjo_StreamConfig> configs;
     configs.resize(varjo_GetDataStreamConfigCount(m_session));
     varjo_GetDataStreamConfigs(m_session, configs.data(), static_cast<int32_t>(configs.size()));
     CHECK_VARJO_ERR(m_session);
 
-    // Only one channel in environment cubemap
-    if (type == varjo_StreamType_EnvironmentCubemap) {
-        channels &= varjo_ChannelFlag_First;
-    }
-
-    // Find suitable stream, start the frame stream, and provide callback for handling frames.
+    // Find suitable stream
     for (const auto& conf : configs) {
         if (conf.streamType == type) {
             if ((conf.bufferType == varjo_BufferType_CPU) && ((conf.channelFlags & channels) == channels) && (conf.format == format)) {
-                varjo_StartDataStream(m_session, conf.streamId, channels, dataStreamFrameCallback, this);
-                if (CHECK_VARJO_ERR(m_session) == varjo_NoError) {
-                    streamId = conf.streamId;
-                }
-                break;
+                return conf;
             }
         }
     }
 
-    return streamId;
+    return std::nullopt;
 }
 
 bool DataStreamer::isDelayedBufferHandlingEnabled() const { return m_delayedBufferHandling; }
 
-void DataStreamer::setDelayedBufferHandlingEnabled(bool enabled) { m_delayedBufferHandling = enabled; }
+void DataStreamer::setDelayedBufferHandlingEnabled(bool enabled)
+{
+    // Serialize with delayed buffer handling and stopping streams
+    std::lock_guard<std::mutex> delayedLock(m_streamManagement.delayedMutex);
+    if (enabled == m_delayedBufferHandling) {
+        return;
+    }
 
-void DataStreamer::requestSnapshot(varjo_StreamType streamType, varjo_TextureFormat streamFormat)
+    // Frames of a channel must not be delivered from two threads at once. Pause stream callbacks and let them and
+    // the channel workers finish the buffers they already have, so that this thread is the only one delivering.
+    // Streams started after the table is loaded see the pause flag in their first callback.
+    m_streamManagement.deliveryPaused = true;
+    const auto streams = getStreams();
+    for (const auto& [streamId, stream] : *streams) {
+        waitStreamCallbacks(*stream);
+    }
+    waitChannelWorkersIdle();
+
+    // Deliver buffers queued for delayed handling before stream threads start delivering
+    if (!enabled) {
+        drainDelayedBuffers(false);
+    }
+
+    m_delayedBufferHandling = enabled;
+    m_streamManagement.deliveryPaused = false;
+}
+
+bool DataStreamer::isBufferLeasingEnabled() const { return m_bufferLeasing; }
+
+void DataStreamer::setBufferLeasingEnabled(bool enabled, int32_t maxLeasesPerStream)
+{
+    m_maxBufferLeases = maxLeasesPerStream;
+    m_bufferLeasing = enabled;
+}
+
+bool DataStreamer::isParallelChannelHandlingEnabled() const { return m_parallelChannelHandling; }
+
+void DataStreamer::setParallelChannelHandlingEnabled(bool enabled) { m_parallelChannelHandling = enabled; }
+
+void DataStreamer::startChannelWorkers()
+{
+    for (size_t i = 0; i < m_channelWorkers.size(); i++) {
+        if (!m_channelWorkers[i]) {
+            m_channelWorkers[i] = std::make_unique<ChannelWorker>();
+            m_channelWorkers[i]->thread = std::thread(&DataStreamer::channelWorkerMain, this, i);
+        }
+    }
+}
+
+void DataStreamer::stopChannelWorkers()
+{
+    for (auto& worker : m_channelWorkers) {
+        if (worker) {
+            {
+                std::lock_guard<std::mutex> workerLock(worker->mutex);
+                worker->stop = true;
+            }
+            worker->condition.notify_all();
+            worker->thread.join();
+            worker.reset();
+        }
+    }
+}
+
+void DataStreamer::waitChannelWorkers(const StreamData& stream)
+{
+    for (auto& worker : m_channelWorkers) {
+        if (worker) {
+            std::unique_lock<std::mutex> workerLock(worker->mutex);
+            worker->condition.wait(workerLock, [&]() { return worker->active != &stream; });
+        }
+    }
+}
+
+void DataStreamer::waitChannelWorkersIdle()
+{
+    for (auto& worker : m_channelWorkers) {
+        if (worker) {
+            std::unique_lock<std::mutex> workerLock(worker->mutex);
+            worker->condition.wait(workerLock, [&]() { return worker->size == 0 && worker->active == nullptr; });
+        }
+    }
+}
+
+void DataStreamer::waitStreamCallbacks(const StreamData& stream)
+{
+    while (stream.activeCallbacks > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void DataStreamer::channelWorkerMain(size_t channelIndex)
+{
+    auto& worker = *m_channelWorkers[channelIndex];
+
+    std::unique_lock<std::mutex> workerLock(worker.mutex);
+    for (;;) {
+        worker.condition.wait(workerLock, [&worker]() { return worker.stop || worker.size > 0; });
+        if (worker.stop) {
+            break;
+        }
+
+        // Take oldest job. Buffers of stopping streams get released when the stream is stopped.
+        ChannelJob job;
+        std::swap(job, worker.jobs[worker.head]);
+        worker.head = (worker.head + 1) % c_maxChannelJobs;
+        worker.size--;
+        if (job.stream->stopping) {
+            // Wake up waiters for an idle worker, as nothing else notifies if this was the last job
+            worker.condition.notify_all();
+            continue;
+        }
+
+        // Handle buffer without holding the lock, so that the stream thread can queue more
+        worker.active = job.stream.get();
+        workerLock.unlock();
+
+        auto& stream = *job.stream;
+        const auto& buffer = job.buffer;
+        storeBuffer(stream, stream.frameData[channelIndex].workerFrame, buffer.frame, buffer.bufferId, buffer.cpuBuffer, buffer.baseName, buffer.takeSnapshot,
+            buffer.timing);
+
+        workerLock.lock();
+        worker.active = nullptr;
+        worker.condition.notify_all();
+    }
+}
+
+void DataStreamer::BufferLeases::activate(varjo_Session* streamSession)
 {
-    // Frame callback comes from different thread, lock streaming data
-    std::lock_guard<std::recursive_mutex> streamLock(m_streamManagement.mutex);
+    std::lock_guard<std::mutex> leaseLock(mutex);
+    session = streamSession;
+    state |= c_activeFlag;
+}
 
-    // Find out if we have running stream
-    const auto it = std::find_if(
-        m_streamManagement.streams.begin(), m_streamManagement.streams.end(), [streamType, streamFormat](const std::pair<varjo_StreamId, StreamData>& item) {
-            return item.second.streamType == streamType && item.second.streamFormat == streamFormat;
-        });
+bool DataStreamer::BufferLeases::tryAcquire(int32_t maxLeases)
+{
+    // Flag and count are checked and updated in one compare and swap, so this fails if detach() cleared the flag
+    // after we loaded the state
+    uint32_t current = state.load();
+    while ((current & c_activeFlag) && static_cast<int32_t>(current & ~c_activeFlag) < maxLeases) {
+        if (state.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DataStreamer::BufferLeases::release(varjo_BufferId bufferId)
+{
+    std::lock_guard<std::mutex> leaseLock(mutex);
+    state--;
+
+    // Buffers of stopped streams have already been freed
+    if (session) {
+        LOG_DEBUG("Unlocking leased buffer (id=%lld)", bufferId);
+        varjo_UnlockDataStreamBuffer(session, bufferId);
+        CHECK_VARJO_ERR(session);
+    }
+}
 
-    if (it != m_streamManagement.streams.end()) {
-        it->second.snapshotRequested = true;
+void DataStreamer::BufferLeases::detach()
+{
+    std::lock_guard<std::mutex> leaseLock(mutex);
+    const uint32_t outstanding = state.fetch_and(~c_activeFlag) & ~c_activeFlag;
+    session = nullptr;
+
+    if (outstanding > 0) {
+        LOG_DEBUG("Stopping stream with outstanding buffer leases: count=%u", outstanding);
+    }
+}
+
+std::string DataStreamer::getStatusLine() const
+{
+    if (!isStreaming()) {
+        return "Not streaming.";
+    }
+
+    // Report frames counted by stream callbacks since the last report
+    std::lock_guard<std::mutex> statsLock(m_statsMutex);
+    const auto now = std::chrono::high_resolution_clock::now();
+    const auto delta = now - m_stats.reportTime;
+    if (delta >= c_reportInterval) {
+        m_stats.statusLine = "Got " + std::to_string(m_stats.frameCount.exchange(0)) + " frames from " + std::to_string(getStreams()->size()) +
+                             " streams in last " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(delta).count()) + " ms";
+        m_stats.reportTime = now;
+
+        // Report snapshot writer only if it has been used
+        const auto writerStats = m_snapshotWriter.getStats();
+        if (writerStats.written > 0 || writerStats.dropped > 0 || writerStats.queueDepth > 0) {
+            m_stats.statusLine += ", snapshots: " + std::to_string(writerStats.written) + " written, " + std::to_string(writerStats.queueDepth) + " queued, " +
+                                  std::to_string(writerStats.dropped) + " dropped";
+        }
+
+        // Report channel worker drops if any
+        if (const uint64_t droppedChannelBuffers = m_droppedChannelBuffers; droppedChannelBuffers > 0) {
+            m_stats.statusLine += ", channel workers: " + std::to_string(droppedChannelBuffers) + " dropped";
+        }
+
+        // Report recording if active
+        if (const auto recorder = std::atomic_load(&m_recorder)) {
+            const auto recorderStats = recorder->getStats();
+            m_stats.statusLine += ", recorded: " + std::to_string(recorderStats.recordedFrames) + " frames, " +
+                                  std::to_string(recorderStats.bytesWritten >> 20) + " MB, " + std::to_string(recorderStats.droppedFrames) + " dropped";
+        }
+    }
+
+    return m_stats.statusLine.empty() ? "Not streaming." : m_stats.statusLine;
+}
+
+void DataStreamer::requestSnapshot(varjo_StreamType streamType, varjo_TextureFormat streamFormat)
+{
+    // Find out if we have running stream. Flag is picked up by the next frame callback.
+    const auto stream = findStream(streamType, streamFormat);
+
+    if (stream) {
+        stream->snapshotRequested = true;
     } else {
         LOG_WARNING("Failed to request snap shot. Not running stream: type=%lld, format=%lld", streamType, streamFormat);
     }
 }
 
+void DataStreamer::requestBurstCapture(varjo_StreamType streamType, varjo_TextureFormat streamFormat, int32_t frameCount)
+{
+    const auto stream = findStream(streamType, streamFormat);
+    if (!stream) {
+        LOG_WARNING("Failed to request burst capture. Not running stream: type=%lld, format=%lld", streamType, streamFormat);
+        return;
+    }
+
+    if (frameCount <= 0) {
+        LOG_ERROR("Invalid burst frame count: %d", frameCount);
+        return;
+    }
+
+    if (std::atomic_load(&stream->burst)) {
+        LOG_WARNING("Burst capture already in progress: type=%lld, format=%lld", streamType, streamFormat);
+        return;
+    }
+
+    // Buffer size comes from the config of the running stream, as other formats of the same stream type differ in size
+    const auto config = findStreamConfig(stream->streamType, stream->streamFormat, stream->channels);
+    if (!config.has_value()) {
+        LOG_ERROR("Failed to request burst capture. Stream config not found: type=%lld, format=%lld", streamType, streamFormat);
+        return;
+    }
+
+    size_t bufferSize = static_cast<size_t>(config->rowStride) * config->height;
+    switch (config->format) {
+        case varjo_TextureFormat_NV12: {
+            // Full resolution Y plane and half resolution interleaved UV plane
+            bufferSize = bufferSize * 3 / 2;
+        } break;
+        case varjo_TextureFormat_Y8_UNORM:
+        case varjo_TextureFormat_RGBA16_FLOAT: {
+            // Single plane, row stride includes pixel size
+        } break;
+        default: {
+            LOG_ERROR("Failed to request burst capture. Unsupported format: %lld", config->format);
+            return;
+        }
+    }
+
+    const size_t channelCount = ((stream->channels & varjo_ChannelFlag_First) ? 1 : 0) + ((stream->channels & varjo_ChannelFlag_Second) ? 1 : 0);
+    const size_t slotCount = static_cast<size_t>(frameCount) * std::max<size_t>(channelCount, 1);
+
+    // Preallocate memory for all frames of all channels here, so stream callbacks only need to copy
+    auto burst = std::make_shared<BurstCapture>();
+    burst->slots.resize(slotCount);
+    burst->requests.resize(slotCount);
+    for (auto& slot : burst->slots) {
+        slot = std::make_shared<std::vector<uint8_t>>(bufferSize);
+    }
+
+    LOG_INFO("Starting burst capture: type=%lld, frames=%d, buffers=%zu, memory=%zu MB", streamType, frameCount, slotCount, (slotCount * bufferSize) >> 20);
+    std::atomic_store(&stream->burst, burst);
+}
+
+void DataStreamer::captureBurstBuffer(StreamData& stream, const std::shared_ptr<BurstCapture>& burst, const Frame::Metadata& frameMetadata,
+    varjo_BufferId bufferId, const void* cpuData, const char* baseName)
+{
+    const size_t slotIndex = burst->nextSlot.fetch_add(1);
+    if (slotIndex >= burst->slots.size()) {
+        // Burst already full, waiting for the last copies to finish
+        return;
+    }
+
+    // Slots are never reallocated on the stream thread. If the buffer does not fit, the stream config has changed
+    // after the request, so the burst is cancelled and its buffers are released when the last reference goes away.
+    auto& slot = burst->slots[slotIndex];
+    const size_t byteSize = static_cast<size_t>(frameMetadata.bufferMetadata.byteSize);
+    if (slot->size() < byteSize) {
+        std::shared_ptr<BurstCapture> expected = burst;
+        if (std::atomic_compare_exchange_strong(&stream.burst, &expected, std::shared_ptr<BurstCapture>())) {
+            LOG_ERROR("Burst buffer too small, cancelling burst capture: size=%zu, required=%zu", slot->size(), byteSize);
+        }
+        return;
+    }
+    memcpy(slot->data(), cpuData, byteSize);
+
+    auto& request = burst->requests[slotIndex];
+    request.filename = getSnapshotFilename(baseName, frameMetadata, bufferId, m_snapshotFormat);
+    request.bufferMetadata = frameMetadata.bufferMetadata;
+    request.data = std::shared_ptr<const uint8_t>(slot, slot->data());
+
+    // Last captured buffer ends the burst and hands all buffers to the writer
+    if (burst->capturedCount.fetch_add(1) + 1 == burst->slots.size()) {
+        std::shared_ptr<BurstCapture> expected = burst;
+        std::atomic_compare_exchange_strong(&stream.burst, &expected, std::shared_ptr<BurstCapture>());
+
+        LOG_INFO("Burst capture done, writing %zu buffers", burst->requests.size());
+        m_snapshotWriter.writeAll(std::move(burst->requests));
+    }
+}
+
+SnapshotWriter::Stats DataStreamer::getSnapshotWriterStats() const { return m_snapshotWriter.getStats(); }
+
+SnapshotWriter::ImageFormat DataStreamer::getSnapshotFormat() const { return m_snapshotFormat; }
+
+void DataStreamer::setSnapshotFormat(SnapshotWriter::ImageFormat format) { m_snapshotFormat = format; }
+
+void DataStreamer::setRecorder(std::shared_ptr<FrameRecorder> recorder) { std::atomic_store(&m_recorder, std::move(recorder)); }
+
+std::shared_ptr<FrameRecorder> DataStreamer::getRecorder() const { return std::atomic_load(&m_recorder); }
+
+std::vector<DataStreamer::ChannelLatencyStats> DataStreamer::getLatencyStats() const
+{
+    std::vector<ChannelLatencyStats> result;
+
+    const auto streams = getStreams();
+    for (const auto& [streamId, stream] : *streams) {
+        for (varjo_ChannelIndex channelIndex : {varjo_ChannelIndex_Left, varjo_ChannelIndex_Right}) {
+            // Metadata only streams report frames on first channel
+            const bool hasChannel = (stream->channels == varjo_ChannelFlag_None) ? (channelIndex == varjo_ChannelIndex_Left)
+                                                                                  : ((stream->channels & c_channelFlags[channelIndex]) != 0);
+            if (!hasChannel) {
+                continue;
+            }
+
+            const auto& frameData = stream->frameData[static_cast<size_t>(channelIndex)];
+            const auto& metrics = *frameData.metrics;
+
+            ChannelLatencyStats stats;
+            stats.streamId = streamId;
+            stats.streamType = stream->streamType;
+            stats.streamFormat = stream->streamFormat;
+            stats.channelIndex = channelIndex;
+            stats.frameCount = static_cast<uint64_t>(frameData.frameCount.load());
+            stats.droppedFrames = metrics.droppedFrames;
+            stats.exposureToCallback = metrics.exposureToCallback.getSnapshot().getSummary();
+            stats.callbackToDelivery = metrics.callbackToDelivery.getSnapshot().getSummary();
+            stats.bufferLockTime = metrics.bufferLockTime.getSnapshot().getSummary();
+            stats.intervalJitter = metrics.intervalJitter.getSnapshot().getSummary();
+            result.emplace_back(stats);
+        }
+    }
+
+    return result;
+}
+
+bool DataStreamer::setLatencyLogFile(const std::string& filename, std::chrono::milliseconds interval)
+{
+    // Stop current log
+    if (m_latencyLog.thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_latencyLog.mutex);
+            m_latencyLog.stop = true;
+        }
+        m_latencyLog.condition.notify_all();
+        m_latencyLog.thread.join();
+        LOG_INFO("Latency log stopped.");
+    }
+
+    if (filename.empty()) {
+        return true;
+    }
+
+    // Check that file can be written before starting the log thread
+    if (!std::ofstream(filename, std::ios::out | std::ios::trunc).is_open()) {
+        LOG_ERROR("Could not open latency log file: %s", filename.c_str());
+        return false;
+    }
+
+    LOG_INFO("Latency log started: %s, interval=%lld ms", filename.c_str(), static_cast<long long>(interval.count()));
+    m_latencyLog.stop = false;
+    m_latencyLog.thread = std::thread(&DataStreamer::latencyLogMain, this, filename, interval);
+    return true;
+}
+
+bool DataStreamer::isLatencyLogEnabled() const { return m_latencyLog.thread.joinable(); }
+
+void DataStreamer::latencyLogMain(std::string filename, std::chrono::milliseconds interval)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::app);
+
+    // Histogram snapshots at the previous log line of each channel, so that each line covers one interval
+    struct Logged {
+        std::array<LatencyHistogram::Snapshot, 4> snapshots;  //!< Histogram snapshots
+        uint64_t frameCount{0};                               //!< Handled frames
+        uint64_t droppedFrames{0};                            //!< Dropped frames
+    };
+    std::map<std::shared_ptr<ChannelMetrics>, Logged> logged;
+
+    auto reportTime = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_latencyLog.mutex);
+    while (!m_latencyLog.condition.wait_for(lock, interval, [this]() { return m_latencyLog.stop; })) {
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - reportTime).count();
+        const auto time = varjo_GetCurrentTime(m_session);
+        reportTime = now;
+
+        // Write line for each running stream channel
+        std::map<std::shared_ptr<ChannelMetrics>, Logged> current;
+        const auto streams = getStreams();
+        for (const auto& [streamId, stream] : *streams) {
+            for (size_t ch = 0; ch < stream->frameData.size(); ch++) {
+                const auto& frameData = stream->frameData[ch];
+                const auto& metrics = frameData.metrics;
+
+                Logged entry;
+                entry.snapshots = {metrics->exposureToCallback.getSnapshot(), metrics->callbackToDelivery.getSnapshot(),
+                    metrics->bufferLockTime.getSnapshot(), metrics->intervalJitter.getSnapshot()};
+                entry.frameCount = static_cast<uint64_t>(frameData.frameCount.load());
+                entry.droppedFrames = metrics->droppedFrames;
+
+                // Skip channels that have never had frames
+                if (entry.frameCount == 0 && entry.snapshots[0].count == 0) {
+                    continue;
+                }
+
+                // Subtract previous line of this channel
+                Logged delta = entry;
+                const auto it = logged.find(metrics);
+                if (it != logged.end()) {
+                    for (size_t i = 0; i < delta.snapshots.size(); i++) {
+                        delta.snapshots[i].subtract(it->second.snapshots[i]);
+                    }
+                    delta.frameCount -= it->second.frameCount;
+                    delta.droppedFrames -= it->second.droppedFrames;
+                }
+
+                char buffer[256];
+                snprintf(buffer, sizeof(buffer),
+                    "{\"time\":%" PRId64 ",\"intervalMs\":%lld,\"streamId\":%" PRId64 ",\"streamType\":%" PRId64 ",\"streamFormat\":%" PRId64
+                    ",\"channel\":%zu,\"frames\":%" PRIu64 ",\"dropped\":%" PRIu64,
+                    static_cast<int64_t>(time), static_cast<long long>(elapsed), static_cast<int64_t>(streamId), static_cast<int64_t>(stream->streamType),
+                    static_cast<int64_t>(stream->streamFormat), ch, delta.frameCount, delta.droppedFrames);
+
+                std::string line = buffer;
+                appendJson(line, "exposureToCallback", delta.snapshots[0].getSummary());
+                appendJson(line, "callbackToDelivery", delta.snapshots[1].getSummary());
+                appendJson(line, "bufferLockTime", delta.snapshots[2].getSummary());
+                appendJson(line, "intervalJitter", delta.snapshots[3].getSummary());
+                line += "}\n";
+                file << line;
+
+                current.emplace(metrics, std::move(entry));
+            }
+        }
+        file.flush();
+
+        // Forget stopped streams
+        logged = std::move(current);
+    }
+}
+
 bool DataStreamer::convertToR8G8B8A(const varjo_BufferMetadata& buffer, const void* input, void* output, size_t outputRowStride)
 {
     constexpr int32_t components = 4;
@@ -686,63 +1283,16 @@ bool DataStreamer::convertToR8G8B8A(const varjo_BufferMetadata& buffer, const vo
             // Background color for alpha blending
             const float rgbBackground[3] = {0.25f, 0.45f, 0.40f};
 
-            // Convert half float to uint8
-            const DirectX::PackedVector::HALF* halfSrc = reinterpret_cast<const DirectX::PackedVector::HALF*>(input);
-            for (int32_t y = 0; y < buffer.height; y++) {
-                uint8_t* line = static_cast<uint8_t*>(output) + outputRowStride * y;
-                for (int32_t x = 0; x < buffer.width * components; x += components) {
-                    // Streamed RGB values are in linear colorspace so we gamma correct them for screen here
-                    constexpr float gamma = 1.0f / 2.2f;
-
-                    // Read alpha
-                    const float alpha = DirectX::PackedVector::XMConvertHalfToFloat(halfSrc[x + 3]);
-
-                    // Read value, gamma correct, alpha blend to background color
-                    for (int32_t c = 0; c < 3; c++) {
-                        float value = powf(DirectX::PackedVector::XMConvertHalfToFloat(halfSrc[x + c]), gamma);
-                        value = value * alpha + rgbBackground[c] * (1.0f - alpha);
-                        line[x + c] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 255.0f * value)));
-                    }
-
-                    // Write alpha
-                    line[x + 3] = 255;
-                    // line[x + 3] = static_cast<uint8_t>(max(0, min(255, 255.0 * alpha)));
-                }
-
-                halfSrc += buffer.rowStride / sizeof(DirectX::PackedVector::HALF);
-            }
+            // Streamed RGB values are in linear colorspace so we gamma correct them for screen and alpha blend to background color
+            ColorConversion::convertRGBA16FToRGBA(reinterpret_cast<const uint16_t*>(input), buffer.rowStride, buffer.width, buffer.height,
+                static_cast<uint8_t*>(output), outputRowStride, rgbBackground);
         } break;
 
         case varjo_TextureFormat_NV12: {
-            // Convert YUV420 NV12 to RGBA8
+            // Convert YUV420 NV12 to RGBA8 using the best SIMD kernel available on this CPU
             const uint8_t* bY = reinterpret_cast<const uint8_t*>(input);
             const uint8_t* bUV = bY + buffer.rowStride * buffer.height;
-
-            for (int32_t y = 0; y < buffer.height; y++) {
-                uint8_t* line = static_cast<uint8_t*>(output) + outputRowStride * y;
-                size_t lineOffs = 0;
-                for (int32_t x = 0; x < buffer.width; x++) {
-                    const uint8_t Y = bY[x];
-
-                    const auto uvX = x - (x & 1);
-                    const uint8_t U = bUV[uvX + 0];
-                    const uint8_t V = bUV[uvX + 1];
-
-                    uint8_t R, G, B;
-                    convertYUVtoRGB(Y, U, V, R, G, B);
-
-                    // Write RGBA
-                    line[lineOffs + 0] = R;
-                    line[lineOffs + 1] = G;
-                    line[lineOffs + 2] = B;
-                    line[lineOffs + 3] = 255;
-                    lineOffs += components;
-                }
-                bY += buffer.rowStride;
-                if ((y & 1) == 1) {
-                    bUV += buffer.rowStride;
-                }
-            }
+            ColorConversion::convertNV12ToRGBA(bY, bUV, buffer.rowStride, buffer.width, buffer.height, static_cast<uint8_t*>(output), outputRowStride);
         } break;
 
         case varjo_TextureFormat_Y8_UNORM: {
@@ -779,20 +1329,15 @@ bool DataStreamer::convertDistortedYUVToRectifiedRGBA(const varjo_BufferMetadata
         return false;
     }
 
-    const int bufferRowStride = buffer.rowStride;
-    const int chromaResDivider = (buffer.format == varjo_TextureFormat_NV12) ? 2 : 1;
-
+    // One-off conversion evaluates the camera model per pixel instead of building a remap table that would be used only once
+    const size_t bufferRowStride = buffer.rowStride;
     const glm::ivec2 inputSize(buffer.width, buffer.height);
     const Undistorter undistorter(inputSize, outputSize, intrinsics, extrinsics, projection);
 
-    // Calculate start address of Y- and UV-planes.
-    const uint32_t uvOffs = (bufferRowStride * inputSize.y);
+    // Calculate start address of Y- and UV-planes. UV plane has half vertical resolution.
     const uint8_t* yStart = input;
-    const uint8_t* uvStart = input + uvOffs;
+    const uint8_t* uvStart = input + bufferRowStride * buffer.height;
 
-    // Output pointer
-    uint8_t* outPtr = output;
-    size_t outOffs = 0;
     for (int y = 0; y < outputSize.y; ++y) {
         for (int x = 0; x < outputSize.x; ++x) {
             // Init to black which will be written in case the sample coordinate is invalid.
@@ -803,24 +1348,42 @@ bool DataStreamer::convertDistortedYUVToRectifiedRGBA(const varjo_BufferMetadata
             // If the sample coord falls in within the buffer, sample from Y and UV planes and convert to RGB.
             const glm::ivec2 sampleCoord = undistorter.getSampleCoord(x, y);
             if (sampleCoord.x >= 0 && sampleCoord.x < inputSize.x && sampleCoord.y >= 0 && sampleCoord.y < inputSize.y) {
-                const int uvX = sampleCoord.x - (sampleCoord.x & 1);
+                const size_t uvX = sampleCoord.x & ~1;
 
-                int Y = yStart[sampleCoord.y * bufferRowStride + sampleCoord.x];
-                int U = uvStart[sampleCoord.y / chromaResDivider * bufferRowStride + uvX + 0];
-                int V = uvStart[sampleCoord.y / chromaResDivider * bufferRowStride + uvX + 1];
+                const uint8_t Y = yStart[sampleCoord.y * bufferRowStride + sampleCoord.x];
+                const uint8_t U = uvStart[(sampleCoord.y / 2) * bufferRowStride + uvX + 0];
+                const uint8_t V = uvStart[(sampleCoord.y / 2) * bufferRowStride + uvX + 1];
 
-                convertYUVtoRGB(Y, U, V, R, G, B);
+                ColorConversion::convertYUVtoRGB(Y, U, V, R, G, B);
             }
 
             // Write out RGBA.
-            outPtr[outOffs++] = R;
-            outPtr[outOffs++] = G;
-            outPtr[outOffs++] = B;
-            outPtr[outOffs++] = 255;
+            output[0] = R;
+            output[1] = G;
+            output[2] = B;
+            output[3] = 255;
+            output += 4;
         }
     }
 
     return true;
 }
 
+bool DataStreamer::convertDistortedYUVToRectifiedRGBA(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output,
+    const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, std::optional<const varjo_Matrix> projection, RemapCache& remapCache)
+{
+    if (!(buffer.format == varjo_TextureFormat_NV12)) {
+        CRITICAL("Unsupported pixel format: %d", static_cast<int>(buffer.format));
+        return false;
+    }
+
+    // Get cached remap table, built only when parameters change
+    const glm::ivec2 inputSize(buffer.width, buffer.height);
+    const auto table = remapCache.getTable(RemapCache::Key::create(inputSize, outputSize, intrinsics, extrinsics, projection));
+
+    remapYUVToRGBA(buffer, input, outputSize, output, table->samples.data());
+
+    return true;
+}
+
 }  // namespace VarjoExamples
@@ -5,18 +5,28 @@
 #include <atomic>
 #include <array>
 #include <chrono>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include <Varjo_datastream.h>
 
 #include "Globals.hpp"
+#include "LatencyHistogram.hpp"
+#include "RemapCache.hpp"
+#include "SnapshotWriter.hpp"
+#include "SpscQueue.hpp"
 
 namespace VarjoExamples
 {
+class FrameRecorder;
+
 //! Simple example class for testing Varjo data streaming
 class DataStreamer
 {
@@ -31,11 +41,42 @@ public:
             varjo_CameraIntrinsics intrinsics{};    //!< Camera frame intrinsics (if available)
             varjo_BufferMetadata bufferMetadata{};  //!< Buffer metadata
         };
-        Metadata metadata{};        //!< Frame metadata
-        std::vector<uint8_t> data;  //!< Buffer data
+        Metadata metadata{};                   //!< Frame metadata
+        std::vector<uint8_t> data;             //!< Buffer data, empty if the frame holds a buffer lease
+        std::shared_ptr<const uint8_t> lease;  //!< Leased runtime buffer data, see setBufferLeasingEnabled()
+
+        //! Returns buffer data, either leased or copied
+        const uint8_t* getData() const { return lease ? lease.get() : data.data(); }
+    };
+
+    //! Default maximum number of outstanding buffer leases per stream
+    static constexpr int32_t c_defaultMaxBufferLeases = 4;
+
+    //! Default interval for writing latency statistics to log file
+    static constexpr std::chrono::milliseconds c_defaultLatencyLogInterval{1000};
+
+    //! Latency statistics of a stream channel. Durations are in nanoseconds.
+    struct ChannelLatencyStats {
+        varjo_StreamId streamId{varjo_InvalidId};                       //!< Stream ID
+        varjo_StreamType streamType{0};                                 //!< Stream type
+        varjo_TextureFormat streamFormat{varjo_TextureFormat_INVALID};  //!< Stream format
+        varjo_ChannelIndex channelIndex{0};                             //!< Channel index
+        uint64_t frameCount{0};                                         //!< Number of handled frames
+        uint64_t droppedFrames{0};                                      //!< Number of frames missing from frame number sequence
+        LatencyHistogram::Summary exposureToCallback;                   //!< Frame timestamp to stream callback
+        LatencyHistogram::Summary callbackToDelivery;                   //!< Stream callback to frame callback
+        LatencyHistogram::Summary bufferLockTime;                       //!< Time buffer was kept locked
+        LatencyHistogram::Summary intervalJitter;                       //!< Deviation of stream callback interval from frame period
     };
 
     //! Construct data streamer
+    //!
+    //! Frame callback is called without holding any streamer lock, so it must be thread safe:
+    //! - Frames of different streams can be delivered concurrently from their stream threads.
+    //! - With parallel channel handling, the two channels of a stream are delivered concurrently from channel workers.
+    //! - With delayed buffer handling, frames are delivered on the thread calling handleDelayedBuffers().
+    //! Frames of a single stream channel are never delivered concurrently, also when the delivery mode is changed,
+    //! and they are delivered in arrival order.
     DataStreamer(varjo_Session* session, const std::function<void(const Frame&)>& onFrameCallback);
 
     //! Destruct data streamer. Cleans up running data streams.
@@ -80,23 +121,92 @@ public:
     //! Is delayed bufferhandling currently enabled
     bool isDelayedBufferHandlingEnabled() const;
 
-    //! Set delayed bufferhandling enabled
+    //! Set delayed bufferhandling enabled. Stream callbacks drop frames while the mode changes. Buffers queued
+    //! for delayed handling are delivered on the calling thread before frames are delivered from stream threads.
     void setDelayedBufferHandlingEnabled(bool enabled);
 
+    //! Is zero-copy buffer leasing currently enabled
+    bool isBufferLeasingEnabled() const;
+
+    //! Set zero-copy buffer leasing enabled. When enabled, frames passed to the callback reference the locked
+    //! runtime buffer through Frame::lease instead of a copy, and copying the frame only copies the reference.
+    //! The buffer is unlocked when the last copy of the lease is released. If a stream already has the maximum
+    //! number of leases outstanding, its frames are copied as usual so the runtime does not run out of buffers.
+    //! Leased data is valid only while the stream is running, so leases should be released before stopping it.
+    void setBufferLeasingEnabled(bool enabled, int32_t maxLeasesPerStream = c_defaultMaxBufferLeases);
+
+    //! Is parallel channel handling currently enabled
+    bool isParallelChannelHandlingEnabled() const;
+
+    //! Set parallel channel handling enabled for streams started after the call. When enabled, the stream callback only locks
+    //! channel buffers and hands them to a worker thread dedicated to the channel index, so the runtime stream thread returns
+    //! right away and left and right channels are copied and passed to the frame callback concurrently. Frames of a channel
+    //! are passed to the frame callback in order, but the callback is called from both workers and must be thread safe.
+    //! Delayed buffer handling takes precedence when enabled.
+    void setParallelChannelHandlingEnabled(bool enabled);
+
     //! Return status line
-    std::string getStatusLine() const { return isStreaming() ? (m_statusLine.empty() ? "Not streaming." : m_statusLine) : "Not streaming."; }
+    std::string getStatusLine() const;
 
     //! Requests making snapshot for next frame
     void requestSnapshot(varjo_StreamType streamType, varjo_TextureFormat streamFormat);
 
+    //! Requests capturing given number of consecutive frames from all stream channels. Memory for the frames
+    //! is allocated up front on the calling thread, sized from the config of the running stream, and the frames
+    //! are written to files only after the whole burst has been captured. Stream must have been started.
+    void requestBurstCapture(varjo_StreamType streamType, varjo_TextureFormat streamFormat, int32_t frameCount);
+
+    //! Returns snapshot writer statistics
+    SnapshotWriter::Stats getSnapshotWriterStats() const;
+
+    //! Returns snapshot image file format
+    SnapshotWriter::ImageFormat getSnapshotFormat() const;
+
+    //! Set snapshot image file format. PNG by default, BMP is faster to write but larger.
+    void setSnapshotFormat(SnapshotWriter::ImageFormat format);
+
+    //! Set recorder for recording frames of all running streams, or null to stop recording. Frames are passed to
+    //! FrameRecorder::record() from stream callbacks before the frame callback. Closing the recorder is up to the caller.
+    void setRecorder(std::shared_ptr<FrameRecorder> recorder);
+
+    //! Returns current recorder, null if not recording
+    std::shared_ptr<FrameRecorder> getRecorder() const;
+
+    //! Returns latency statistics of running stream channels since the streams were started
+    std::vector<ChannelLatencyStats> getLatencyStats() const;
+
+    //! Start writing latency statistics of running stream channels to given file at given interval, or stop
+    //! writing if filename is empty. Each line is a JSON object with statistics of one channel for the interval.
+    //! Returns false if the file could not be opened.
+    bool setLatencyLogFile(const std::string& filename, std::chrono::milliseconds interval = c_defaultLatencyLogInterval);
+
+    //! Returns true if latency statistics are being written to a file
+    bool isLatencyLogEnabled() const;
+
     //! Helper function for converting input buffer to R8G8B8A8 color format
     static bool convertToR8G8B8A(const varjo_BufferMetadata& buffer, const void* input, void* output, size_t outputRowStride = 0);
 
-    //! Helper function for converting distorted YUV input buffer to rectified RGBA output buffer
+    //! Helper function for converting distorted YUV input buffer to rectified RGBA output buffer. Evaluates the camera model
+    //! for every output pixel, so use the overload taking a RemapCache when converting frames repeatedly.
     static bool convertDistortedYUVToRectifiedRGBA(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output,
         const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, std::optional<const varjo_Matrix> projection);
 
+    //! Helper function for converting distorted YUV input buffer to rectified RGBA output buffer. Uses remap table from given cache,
+    //! so the camera model needs to be evaluated only when calibration or buffer sizes change.
+    static bool convertDistortedYUVToRectifiedRGBA(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output,
+        const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, std::optional<const varjo_Matrix> projection, RemapCache& remapCache);
+
 private:
+    struct StreamData;
+    struct BurstCapture;
+
+    //! Frame timing captured in the stream callback
+    struct FrameTiming {
+        varjo_Nanoseconds arrivalTime{0};                  //!< Stream callback time on Varjo clock
+        std::chrono::steady_clock::time_point arrival{};   //!< Stream callback time
+        std::chrono::steady_clock::time_point lockTime{};  //!< Buffer lock time
+    };
+
     //! Static data stream frame callback function
     static void dataStreamFrameCallback(const varjo_StreamFrame* frame, varjo_Session* session, void* userData);
 
@@ -104,63 +214,216 @@ private:
     void onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Session* session);
 
     //! Handle frame buffer
-    void handleBuffer(const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, const std::string& baseName, bool takeSnapshot);
+    void handleBuffer(const std::shared_ptr<StreamData>& streamData, const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, const char* baseName,
+        bool takeSnapshot, const FrameTiming& timing);
+
+    //! Store buffer contents to file and pass it to frame callback using given frame storage
+    void storeBuffer(StreamData& stream, Frame& frame, const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, void* cpuData, const char* baseName,
+        bool takeSnapshot, const FrameTiming& timing);
+
+    //! Unlock buffer that is not leased and record lock hold time
+    void unlockBuffer(StreamData& stream, varjo_ChannelIndex channelIndex, varjo_BufferId bufferId, const FrameTiming& timing);
+
+    //! Start channel worker threads if not yet running. Stream management mutex must be held.
+    void startChannelWorkers();
+
+    //! Stop channel worker threads. Queued buffers are left locked for stopping the streams to release.
+    void stopChannelWorkers();
+
+    //! Wait until channel workers are not handling buffers of given stream, which must be marked as stopping
+    void waitChannelWorkers(const StreamData& stream);
 
-    //! Store buffer contents to file
-    void storeBuffer(const Frame::Metadata& frameMetadata, varjo_BufferId bufferId, void* cpuData, const std::string& baseName, bool takeSnapshot);
+    //! Wait until channel workers have handled all queued buffers
+    void waitChannelWorkersIdle();
 
-    //! Find data stream of given type and texture format and start it
-    varjo_StreamId startStreaming(varjo_StreamType streamType, varjo_TextureFormat streamFormat, varjo_ChannelFlag channels);
+    //! Wait until stream callbacks are not handling frames of given stream, which must be marked as stopping
+    //! or have its delivery paused
+    void waitStreamCallbacks(const StreamData& stream);
+
+    //! Handle or ignore queued delayed buffers of all streams. Delayed mutex must be held.
+    void drainDelayedBuffers(bool ignore);
+
+    //! Channel worker thread main loop
+    void channelWorkerMain(size_t channelIndex);
+
+    //! Latency log thread main loop
+    void latencyLogMain(std::string filename, std::chrono::milliseconds interval);
+
+    //! Capture buffer to burst slot. Queues the burst for writing when all slots have been filled.
+    void captureBurstBuffer(StreamData& stream, const std::shared_ptr<BurstCapture>& burst, const Frame::Metadata& frameMetadata, varjo_BufferId bufferId,
+        const void* cpuData, const char* baseName);
+
+    //! Find CPU data stream config of given type and texture format providing given channels
+    std::optional<varjo_StreamConfig> findStreamConfig(varjo_StreamType streamType, varjo_TextureFormat streamFormat, varjo_ChannelFlag channels) const;
 
     //! Get streaming ID
     std::pair<varjo_StreamId, varjo_ChannelFlag> getStreamingIdAndChannel(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const;
 
 private:
+    //! Buffer lease bookkeeping for a stream. Shared with outstanding leases, so that they can be
+    //! released safely from any thread, also after the stream has been stopped.
+    struct BufferLeases {
+        //! Lease state bit set while new leases can be acquired. The other bits count outstanding leases.
+        static constexpr uint32_t c_activeFlag = 0x80000000u;
+
+        std::mutex mutex;                 //!< Mutex for unlocking and detaching
+        varjo_Session* session{nullptr};  //!< Varjo session, reset when stream is stopped
+        std::atomic<uint32_t> state{0};   //!< Active flag and outstanding lease count, updated together so that
+                                          //!< no lease can be acquired once detach() has cleared the flag
+
+        //! Allow acquiring leases. Called once before the stream is started.
+        void activate(varjo_Session* streamSession);
+
+        //! Try to acquire a lease without blocking. Returns false if detached or at given limit.
+        bool tryAcquire(int32_t maxLeases);
+
+        //! Release lease of given buffer, unlocks the buffer if stream is still running
+        void release(varjo_BufferId bufferId);
+
+        //! Detach leases from a stream that is being stopped. Leases acquired before this keep their buffers.
+        void detach();
+    };
+
     //! Delayed buffer info structure
     struct DelayedBuffer {
         Frame::Metadata frame{};                   //!< Frame metadata
-        std::string baseName;                      //!< Base filename
+        const char* baseName{nullptr};             //!< Base filename
         varjo_BufferId bufferId{varjo_InvalidId};  //!< Varjo buffer identifier
         void* cpuBuffer{nullptr};                  //!< Pointer to CPU buffer data
         bool takeSnapshot{false};                  //!< Flag indicating whether stream snapshot should be created
+        FrameTiming timing{};                      //!< Frame timing
+    };
+
+    //! Latency measurements of a stream channel. Histograms are shared with buffer leases, which record
+    //! the lock hold time when released. Frame sequence state is only accessed by the stream callback thread.
+    struct ChannelMetrics {
+        LatencyHistogram exposureToCallback;     //!< Frame timestamp to stream callback
+        LatencyHistogram callbackToDelivery;     //!< Stream callback to frame callback
+        LatencyHistogram bufferLockTime;         //!< Time buffer was kept locked
+        LatencyHistogram intervalJitter;         //!< Deviation of stream callback interval from frame period
+        std::atomic<uint64_t> droppedFrames{0};  //!< Number of frames missing from frame number sequence
+        int64_t lastFrameNumber{-1};             //!< Frame number of previous frame
+        varjo_Nanoseconds lastArrivalTime{0};    //!< Stream callback time of previous frame
+    };
+
+    //! Burst capture of consecutive frames into preallocated memory
+    struct BurstCapture {
+        std::vector<std::shared_ptr<std::vector<uint8_t>>> slots;  //!< Preallocated frame buffers
+        std::vector<SnapshotWriter::Request> requests;             //!< Write requests for captured frames
+        std::atomic<size_t> nextSlot{0};                           //!< Next free slot
+        std::atomic<size_t> capturedCount{0};                      //!< Number of slots filled
     };
 
+    //! Maximum number of delayed buffers per stream. Buffers beyond this are unlocked without handling.
+    static constexpr size_t c_maxDelayedBuffers = 16;
+
     //! Internal frame data
     struct FrameData {
-        Frame frame;
-        int64_t frameCount{0};
+        Frame frame;                                                                  //!< Frame storage reused by the stream callback thread
+        Frame delayedFrame;                                                           //!< Frame storage reused when handling delayed buffers
+        Frame workerFrame;                                                            //!< Frame storage reused by the channel worker
+        std::atomic<int64_t> frameCount{0};                                           //!< Number of handled frames
+        std::shared_ptr<ChannelMetrics> metrics{std::make_shared<ChannelMetrics>()};  //!< Latency measurements
     };
 
-    //! Internal stream data
+    //! Internal stream data. Stream configuration is immutable after the stream has been published,
+    //! the rest is either atomic or owned by a single thread.
     struct StreamData {
         varjo_StreamId streamId{varjo_InvalidId};                       //!< Stream ID
         varjo_StreamType streamType{0};                                 //!< Stream type
         varjo_TextureFormat streamFormat{varjo_TextureFormat_INVALID};  //!< Stream format
         varjo_ChannelFlag channels{varjo_ChannelFlag_None};             //!< Channels
-        bool snapshotRequested{true};                                   //!< Flag indicating whether stream snapshot should be created
-        std::map<varjo_ChannelIndex, FrameData> frameData;              //!< Frame data for each channel
+        varjo_Nanoseconds frameInterval{0};                             //!< Nominal frame interval, zero if unknown
+        bool parallelChannels{false};                                   //!< Channel buffers are handled by channel workers
+        std::atomic_bool stopping{false};                               //!< Set when stopping, callbacks and channel workers skip the stream
+        std::atomic<int32_t> activeCallbacks{0};                        //!< Number of stream callbacks handling frames of the stream
+        std::atomic_bool snapshotRequested{true};                       //!< Flag indicating whether stream snapshot should be created
+        std::array<FrameData, 2> frameData;                             //!< Frame data for each channel
+        std::shared_ptr<BufferLeases> leases;                           //!< Buffer leases of this stream
+        SpscQueue<DelayedBuffer, c_maxDelayedBuffers> delayedBuffers;   //!< Delayed buffers, pushed by callback thread
+        std::atomic<uint64_t> droppedDelayedBuffers{0};                 //!< Number of delayed buffers dropped due to full queue
+        std::shared_ptr<BurstCapture> burst;                            //!< Burst capture in progress, accessed atomically
+    };
+
+    //! Maximum number of buffers queued per channel worker. Buffers beyond this are unlocked without handling.
+    static constexpr size_t c_maxChannelJobs = 16;
+
+    //! Locked buffer queued for a channel worker
+    struct ChannelJob {
+        std::shared_ptr<StreamData> stream;  //!< Stream of the buffer, kept alive until handled
+        DelayedBuffer buffer;                //!< Buffer info
     };
 
-    //! Struct for thread safe stream management
+    //! Worker thread handling buffers of one channel index of all parallel streams in arrival order
+    struct ChannelWorker {
+        std::mutex mutex;                               //!< Mutex for job queue and worker state
+        std::condition_variable condition;              //!< Signaled when jobs are queued or handled, or worker should stop
+        std::array<ChannelJob, c_maxChannelJobs> jobs;  //!< Job ring buffer, slots are reused
+        size_t head{0};                                 //!< Index of oldest queued job
+        size_t size{0};                                 //!< Number of queued jobs
+        const StreamData* active{nullptr};              //!< Stream of the job being handled, null if idle
+        bool stop{false};                               //!< Stop flag for worker thread
+        std::thread thread;                             //!< Worker thread
+    };
+
+    //! Immutable table of running streams. Replaced as a whole when streams are started or stopped.
+    using StreamTable = std::unordered_map<varjo_StreamId, std::shared_ptr<StreamData>>;
+
+    //! Struct for thread safe stream management. Stream callbacks only read the published stream table,
+    //! so they never wait for the render thread.
     struct StreamManagement {
-        mutable std::recursive_mutex mutex;                      //!< Mutex for locking streamer data
-        std::atomic_bool running{false};                         //!< If true streaming is running
-        std::unordered_map<varjo_StreamId, StreamData> streams;  //!< Set of running streams
-        std::vector<DelayedBuffer> delayedBuffers;               //!< List of delayed buffers
+        std::mutex mutex;                            //!< Mutex for serializing stream table updates
+        std::mutex delayedMutex;                     //!< Mutex for serializing delayed buffer handling
+        std::atomic_bool running{false};             //!< If true streaming is running
+        std::atomic_bool deliveryPaused{false};      //!< Set while delivery mode changes, callbacks drop frames
+        std::atomic<int32_t> activeCallbacks{0};     //!< Number of stream callbacks in progress
+        std::shared_ptr<const StreamTable> streams;  //!< Running streams, accessed atomically
     };
 
-    varjo_Session* m_session{nullptr};                          //!< Varjo session
-    const std::function<void(const Frame&)> m_onFrameCallback;  //!< Frame callback function
-    std::atomic_bool m_delayedBufferHandling{false};            //!< Flag for delayed buffer handling
-    StreamManagement m_streamManagement;                        //!< Stream management data
-    std::string m_statusLine;                                   //!< Streaming status line
+    //! Returns current stream table snapshot
+    std::shared_ptr<const StreamTable> getStreams() const;
+
+    //! Find running stream with given type and format from the current snapshot
+    std::shared_ptr<StreamData> findStream(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const;
 
-    //! Stream statistics
-    struct {
-        uint64_t streamCount{0};                                      //!< Stream count
-        uint64_t frameCount{0};                                       //!< Frame count
+    varjo_Session* m_session{nullptr};                                 //!< Varjo session
+    const std::function<void(const Frame&)> m_onFrameCallback;         //!< Frame callback function
+    std::atomic_bool m_delayedBufferHandling{false};                   //!< Flag for delayed buffer handling
+    std::atomic_bool m_bufferLeasing{false};                           //!< Flag for zero-copy buffer leasing
+    std::atomic<int32_t> m_maxBufferLeases{c_defaultMaxBufferLeases};  //!< Maximum number of outstanding leases per stream
+    std::atomic_bool m_parallelChannelHandling{false};                 //!< Flag for parallel channel handling of new streams
+    StreamManagement m_streamManagement;                               //!< Stream management data
+    SnapshotWriter m_snapshotWriter;                                   //!< Background writer for snapshot files
+
+    //! Channel workers per channel index, created when the first parallel stream is started
+    std::array<std::unique_ptr<ChannelWorker>, 2> m_channelWorkers;
+
+    //! Number of buffers dropped due to full channel worker queues
+    std::atomic<uint64_t> m_droppedChannelBuffers{0};
+
+    //! Snapshot image file format
+    std::atomic<SnapshotWriter::ImageFormat> m_snapshotFormat{SnapshotWriter::ImageFormat::PNG};
+
+    //! Frame recorder, accessed atomically
+    std::shared_ptr<FrameRecorder> m_recorder;
+
+    //! Stream statistics. Frame count is updated by stream callbacks, the rest only when reporting.
+    struct Stats {
+        std::atomic<uint64_t> frameCount{0};                          //!< Frame count
         std::chrono::high_resolution_clock::time_point reportTime{};  //!< Last report time
-    } m_stats;
+        std::string statusLine;                                       //!< Streaming status line
+    };
+    mutable std::mutex m_statsMutex;  //!< Mutex for reporting stats
+    mutable Stats m_stats;            //!< Stream statistics
+
+    //! Latency log writing
+    struct LatencyLog {
+        std::mutex mutex;                   //!< Mutex for stop flag
+        std::condition_variable condition;  //!< Signaled when log thread should stop
+        std::thread thread;                 //!< Log thread
+        bool stop{false};                   //!< Stop flag for log thread
+    };
+    LatencyLog m_latencyLog;  //!< Latency log writing
 };
 
 }  // namespace VarjoExamples
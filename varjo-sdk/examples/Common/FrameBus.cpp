@@ -0,0 +1,348 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "FrameBus.hpp"
+
+#include <algorithm>
+
+#include "ColorConversion.hpp"
+
+namespace VarjoExamples
+{
+FrameBus::Subscription::Subscription(const SubscriberOptions& options)
+    : m_options(options)
+{
+    if ((options.transform.downsample != 1 && options.transform.downsample != 2 && options.transform.downsample != 4) || options.transform.decimation < 1) {
+        CRITICAL("Invalid frame bus ingest transform: downsample=%d, decimation=%d", options.transform.downsample, options.transform.decimation);
+    }
+
+    // Keep latest only needs room for one frame
+    const size_t capacity = (options.policy == Policy::KeepLatest) ? 1 : std::max<size_t>(options.queueDepth, 1);
+    m_entries.resize(capacity);
+}
+
+bool FrameBus::Subscription::matches(const Frame& frame) const
+{
+    if (m_options.streamType.has_value() && (*m_options.streamType != frame.metadata.streamFrame.type)) {
+        return false;
+    }
+    return (m_options.channels & (varjo_ChannelFlag(1) << frame.metadata.channelIndex)) != 0;
+}
+
+bool FrameBus::Subscription::accept(const Frame& frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_closed) {
+        return false;
+    }
+
+    m_receivedFrames++;
+
+    // Decimate per channel, so that both channels of a stream keep the same frames
+    auto& channelFrames = m_channelFrames[static_cast<size_t>(frame.metadata.channelIndex) % m_channelFrames.size()];
+    if (channelFrames++ % static_cast<uint64_t>(m_options.transform.decimation) != 0) {
+        m_decimatedFrames++;
+        return false;
+    }
+    return true;
+}
+
+bool FrameBus::Subscription::push(const FramePtr& frame, std::chrono::steady_clock::time_point publishTime, bool transformed)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_closed) {
+        return false;
+    }
+
+    if (m_size == m_entries.size()) {
+        if (m_options.policy == Policy::Block) {
+            // Wait for consumer to make room. Subscription may get closed while waiting.
+            m_blockedFrames++;
+            const bool ready = m_notFull.wait_for(lock, m_options.blockTimeout, [this]() { return m_closed || m_size < m_entries.size(); });
+            if (!ready || m_closed) {
+                m_droppedFrames++;
+                return false;
+            }
+        } else {
+            // Release oldest payload to make room
+            m_entries[m_head].frame.reset();
+            m_head = (m_head + 1) % m_entries.size();
+            m_size--;
+            m_droppedFrames++;
+        }
+    }
+
+    if (transformed) {
+        m_transformedFrames++;
+    }
+
+    auto& entry = m_entries[(m_head + m_size) % m_entries.size()];
+    entry.frame = frame;
+    entry.publishTime = publishTime;
+    m_size++;
+    m_maxSize = std::max(m_maxSize, m_size);
+
+    lock.unlock();
+    m_notEmpty.notify_one();
+    return true;
+}
+
+void FrameBus::Subscription::popFront(FramePtr& frame)
+{
+    auto& entry = m_entries[m_head];
+    frame = std::move(entry.frame);
+    m_lag.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - entry.publishTime).count());
+    m_head = (m_head + 1) % m_entries.size();
+    m_size--;
+    m_consumedFrames++;
+}
+
+bool FrameBus::Subscription::tryPop(FramePtr& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_size == 0) {
+            return false;
+        }
+        popFront(frame);
+    }
+
+    m_notFull.notify_one();
+    return true;
+}
+
+bool FrameBus::Subscription::waitPop(FramePtr& frame, std::chrono::milliseconds timeout)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_notEmpty.wait_for(lock, timeout, [this]() { return m_closed || m_size > 0; }) || m_size == 0) {
+            return false;
+        }
+        popFront(frame);
+    }
+
+    m_notFull.notify_one();
+    return true;
+}
+
+bool FrameBus::Subscription::popLatest(FramePtr& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_size == 0) {
+            return false;
+        }
+
+        // Older frames were never consumed, count them as dropped
+        while (m_size > 1) {
+            m_entries[m_head].frame.reset();
+            m_head = (m_head + 1) % m_entries.size();
+            m_size--;
+            m_droppedFrames++;
+        }
+        popFront(frame);
+    }
+
+    m_notFull.notify_one();
+    return true;
+}
+
+void FrameBus::Subscription::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_size > 0) {
+            m_entries[m_head].frame.reset();
+            m_head = (m_head + 1) % m_entries.size();
+            m_size--;
+        }
+    }
+
+    m_notFull.notify_all();
+}
+
+bool FrameBus::Subscription::isClosed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_closed;
+}
+
+void FrameBus::Subscription::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+}
+
+FrameBus::SubscriberStats FrameBus::Subscription::getStats() const
+{
+    SubscriberStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.receivedFrames = m_receivedFrames;
+        stats.consumedFrames = m_consumedFrames;
+        stats.droppedFrames = m_droppedFrames;
+        stats.blockedFrames = m_blockedFrames;
+        stats.decimatedFrames = m_decimatedFrames;
+        stats.transformedFrames = m_transformedFrames;
+        stats.queueDepth = m_size;
+        stats.maxQueueDepth = m_maxSize;
+    }
+
+    stats.lag = m_lag.getSnapshot().getSummary();
+    return stats;
+}
+
+FrameBus::FrameBus() { m_subscribers = std::make_shared<const SubscriberList>(); }
+
+FrameBus::~FrameBus()
+{
+    // Subscriptions may outlive the bus, wake up their waiting consumers
+    for (const auto& subscription : *getSubscribers()) {
+        subscription->close();
+    }
+}
+
+std::shared_ptr<const FrameBus::SubscriberList> FrameBus::getSubscribers() const { return std::atomic_load(&m_subscribers); }
+
+std::shared_ptr<FrameBus::Subscription> FrameBus::subscribe(const SubscriberOptions& options)
+{
+    auto subscription = std::make_shared<Subscription>(options);
+
+    std::lock_guard<std::mutex> lock(m_subscribeMutex);
+    auto subscribers = std::make_shared<SubscriberList>(*getSubscribers());
+    subscribers->push_back(subscription);
+    std::atomic_store(&m_subscribers, std::shared_ptr<const SubscriberList>(std::move(subscribers)));
+
+    LOG_DEBUG("Frame bus subscriber added: %s", options.name.c_str());
+    return subscription;
+}
+
+void FrameBus::unsubscribe(const std::shared_ptr<Subscription>& subscription)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_subscribeMutex);
+        auto subscribers = std::make_shared<SubscriberList>(*getSubscribers());
+        const auto it = std::find(subscribers->begin(), subscribers->end(), subscription);
+        if (it == subscribers->end()) {
+            LOG_WARNING("Frame bus subscriber not found: %s", subscription ? subscription->getOptions().name.c_str() : "(null)");
+            return;
+        }
+        subscribers->erase(it);
+        std::atomic_store(&m_subscribers, std::shared_ptr<const SubscriberList>(std::move(subscribers)));
+    }
+
+    // Publishers may still hold the old list, closing makes them skip the subscription
+    subscription->close();
+    LOG_DEBUG("Frame bus subscriber removed: %s", subscription->getOptions().name.c_str());
+}
+
+void FrameBus::publish(const Frame& frame) { publishFrame(frame, nullptr); }
+
+void FrameBus::publish(const FramePtr& frame) { publishFrame(*frame, frame); }
+
+void FrameBus::publishFrame(const Frame& frame, FramePtr payload)
+{
+    m_publishedFrames++;
+    const auto publishTime = std::chrono::steady_clock::now();
+    const auto subscribers = getSubscribers();
+
+    // Queue to non-blocking subscribers first, so that they do not wait for blocking ones
+    bool matched = false;
+    FramePtr copiedPayload;
+    for (const bool blocking : {false, true}) {
+        for (const auto& subscription : *subscribers) {
+            const auto& options = subscription->getOptions();
+            if (((options.policy == Policy::Block) != blocking) || !subscription->matches(frame)) {
+                continue;
+            }
+
+            matched = true;
+            if (!subscription->accept(frame)) {
+                continue;
+            }
+
+            // Transformed frames are produced straight from the published buffer
+            if (options.transform.hasImageTransform()) {
+                auto transformed = std::make_shared<Frame>();
+                if (transformFrame(frame, options.transform, *transformed)) {
+                    subscription->push(std::move(transformed), publishTime, true);
+                    continue;
+                }
+            }
+
+            // Leased frame data is copied once for subscribers that must not hold the runtime buffer locked
+            if (frame.lease && options.copyLeasedFrames) {
+                if (!copiedPayload) {
+                    auto copied = std::make_shared<Frame>();
+                    copied->metadata = frame.metadata;
+                    copied->data.assign(frame.lease.get(), frame.lease.get() + frame.metadata.bufferMetadata.byteSize);
+                    copiedPayload = std::move(copied);
+                    m_copiedFrames++;
+                }
+                subscription->push(copiedPayload, publishTime, false);
+                continue;
+            }
+
+            // Copy frame once for all other subscribers. Copying a leased frame only copies the lease reference.
+            if (!payload) {
+                if (!frame.lease) {
+                    m_copiedFrames++;
+                }
+                payload = std::make_shared<const Frame>(frame);
+            }
+            subscription->push(payload, publishTime, false);
+        }
+    }
+
+    if (!matched) {
+        m_unsubscribedFrames++;
+    }
+}
+
+FrameBus::Stats FrameBus::getStats() const
+{
+    Stats stats;
+    stats.publishedFrames = m_publishedFrames;
+    stats.unsubscribedFrames = m_unsubscribedFrames;
+    stats.copiedFrames = m_copiedFrames;
+    return stats;
+}
+
+bool FrameBus::transformFrame(const Frame& frame, const IngestTransform& transform, Frame& output)
+{
+    const auto& buffer = frame.metadata.bufferMetadata;
+    const uint8_t* data = frame.getData();
+    if (buffer.format != varjo_TextureFormat_Y8_UNORM || buffer.byteSize <= 0 || data == nullptr) {
+        return false;
+    }
+
+    // Clip region of interest to the frame
+    const int32_t width = (transform.roiWidth > 0) ? std::min(transform.roiWidth, buffer.width) : buffer.width;
+    const int32_t height = (transform.roiHeight > 0) ? std::min(transform.roiHeight, buffer.height) : buffer.height;
+    const int32_t x = transform.centerRoi ? (buffer.width - width) / 2 : std::clamp(transform.roiX, 0, buffer.width - width);
+    const int32_t y = transform.centerRoi ? (buffer.height - height) / 2 : std::clamp(transform.roiY, 0, buffer.height - height);
+
+    // Partial boxes at the right and bottom edges are left out
+    const int32_t outputWidth = width / transform.downsample;
+    const int32_t outputHeight = height / transform.downsample;
+    if (outputWidth <= 0 || outputHeight <= 0) {
+        return false;
+    }
+
+    output.metadata = frame.metadata;
+    output.metadata.bufferMetadata.width = outputWidth;
+    output.metadata.bufferMetadata.height = outputHeight;
+    output.metadata.bufferMetadata.rowStride = outputWidth;
+    output.metadata.bufferMetadata.byteSize = outputWidth * outputHeight;
+    output.lease.reset();
+    output.data.resize(static_cast<size_t>(outputWidth) * outputHeight);
+
+    const uint8_t* src = data + static_cast<size_t>(buffer.rowStride) * y + x;
+    return ColorConversion::downsampleY8(src, buffer.rowStride, outputWidth, outputHeight, transform.downsample, output.data.data(), outputWidth);
+}
+
+}  // namespace VarjoExamples
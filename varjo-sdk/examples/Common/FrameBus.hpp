@@ -0,0 +1,231 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DataStreamer.hpp"
+#include "LatencyHistogram.hpp"
+
+namespace VarjoExamples
+{
+//! Publish/subscribe fan-out of data stream frames to multiple consumers.
+//!
+//! Frames published to the bus are wrapped once into an immutable reference counted payload that
+//! is shared by all subscribers, so each frame is copied at most once regardless of the number of
+//! consumers. Leased frames are not copied at all, but their runtime buffer stays locked until the
+//! last subscriber releases the payload. Each subscriber has its own bounded queue with a stream
+//! and channel filter and a policy for a full queue. Subscriber list is replaced as a whole when
+//! subscribing or unsubscribing, so publishing never waits for subscription changes.
+//!
+//! Queued leased frames count against the DataStreamer lease limit, so subscribers that queue more
+//! frames than there are leases per stream should set copyLeasedFrames to get their own copy instead.
+//!
+//! Subscribers can also request an ingest transform that crops, downsamples or decimates frames.
+//! Transformed frames are produced directly from the published buffer into a payload of their own,
+//! so with DataStreamer buffer leasing enabled the full resolution frame is never copied.
+//!
+//! publish() can be passed as DataStreamer frame callback, and can be called from multiple threads.
+class FrameBus
+{
+public:
+    using Frame = DataStreamer::Frame;
+
+    //! Immutable frame payload shared by subscribers
+    using FramePtr = std::shared_ptr<const Frame>;
+
+    //! Default number of frames queued per subscriber
+    static constexpr size_t c_defaultQueueDepth = 4;
+
+    //! Default time the publisher waits for a blocking subscriber
+    static constexpr std::chrono::milliseconds c_defaultBlockTimeout{5};
+
+    //! Policy for publishing to a full subscriber queue
+    enum class Policy {
+        DropOldest,  //!< Discard the oldest queued frame to make room
+        KeepLatest,  //!< Keep only the latest frame, queue depth is always one
+        Block,       //!< Wait for the subscriber to make room, drop the new frame on timeout
+    };
+
+    //! Transform applied to frames queued to a subscriber. Crop and downsample apply to Y8 frames, other formats are
+    //! queued as is. Buffer metadata of transformed frames describes the output buffer, other metadata is unchanged.
+    struct IngestTransform {
+        int32_t roiX{0};        //!< Region of interest left edge in source pixels
+        int32_t roiY{0};        //!< Region of interest top edge in source pixels
+        int32_t roiWidth{0};    //!< Region of interest width in source pixels, zero for full width
+        int32_t roiHeight{0};   //!< Region of interest height in source pixels, zero for full height
+        bool centerRoi{false};  //!< Center region of interest in the frame instead of using roiX and roiY
+        int32_t downsample{1};  //!< Box downsample factor, 1, 2 or 4
+        int32_t decimation{1};  //!< Queue only every Nth frame of each channel
+
+        //! Returns true if frame data is cropped or downsampled
+        bool hasImageTransform() const { return roiWidth > 0 || roiHeight > 0 || downsample > 1; }
+    };
+
+    //! Subscriber options
+    struct SubscriberOptions {
+        std::string name;                                               //!< Subscriber name for logging
+        std::optional<varjo_StreamType> streamType;                     //!< Stream type to receive, all types if not set
+        varjo_ChannelFlag channels{varjo_ChannelFlag_All};              //!< Channels to receive
+        size_t queueDepth{c_defaultQueueDepth};                         //!< Maximum number of queued frames
+        Policy policy{Policy::DropOldest};                              //!< Policy for full queue
+        std::chrono::milliseconds blockTimeout{c_defaultBlockTimeout};  //!< Maximum publisher wait with Block policy
+        IngestTransform transform{};                                    //!< Transform for queued frames
+        bool copyLeasedFrames{false};                                   //!< Copy untransformed leased frames instead of sharing the lease
+    };
+
+    //! Subscriber statistics
+    struct SubscriberStats {
+        uint64_t receivedFrames{0};     //!< Number of frames matching the filter
+        uint64_t consumedFrames{0};     //!< Number of frames taken by the subscriber
+        uint64_t droppedFrames{0};      //!< Number of frames dropped due to full queue
+        uint64_t blockedFrames{0};      //!< Number of frames the publisher had to wait for
+        uint64_t decimatedFrames{0};    //!< Number of frames skipped by decimation
+        uint64_t transformedFrames{0};  //!< Number of frames cropped or downsampled
+        size_t queueDepth{0};           //!< Number of currently queued frames
+        size_t maxQueueDepth{0};        //!< Largest number of queued frames
+        LatencyHistogram::Summary lag;  //!< Time from publishing to consuming in nanoseconds
+    };
+
+    //! Subscriber queue. Consumer functions can be called from any thread.
+    class Subscription
+    {
+    public:
+        //! Construct subscription with given options
+        explicit Subscription(const SubscriberOptions& options);
+
+        // Disable copy, move and assign
+        Subscription(const Subscription& other) = delete;
+        Subscription(const Subscription&& other) = delete;
+        Subscription& operator=(const Subscription& other) = delete;
+        Subscription& operator=(const Subscription&& other) = delete;
+
+        //! Returns subscriber options
+        const SubscriberOptions& getOptions() const { return m_options; }
+
+        //! Take oldest queued frame without waiting. Returns false if the queue is empty.
+        bool tryPop(FramePtr& frame);
+
+        //! Take oldest queued frame, waiting for one until timeout. Returns false on timeout or if unsubscribed.
+        bool waitPop(FramePtr& frame, std::chrono::milliseconds timeout);
+
+        //! Take latest queued frame, discarding older ones. Returns false if the queue is empty.
+        bool popLatest(FramePtr& frame);
+
+        //! Discard all queued frames
+        void clear();
+
+        //! Returns true if the subscription has been removed from the bus
+        bool isClosed() const;
+
+        //! Returns subscriber statistics
+        SubscriberStats getStats() const;
+
+    private:
+        friend class FrameBus;
+
+        //! Queued frame
+        struct Entry {
+            FramePtr frame;                                     //!< Shared payload
+            std::chrono::steady_clock::time_point publishTime;  //!< Publish time for lag measurement
+        };
+
+        //! Returns true if the subscriber wants given frame
+        bool matches(const Frame& frame) const;
+
+        //! Count matching frame and apply decimation. Returns false if the frame should be skipped.
+        bool accept(const Frame& frame);
+
+        //! Queue accepted frame according to policy. Returns false if the frame was dropped.
+        bool push(const FramePtr& frame, std::chrono::steady_clock::time_point publishTime, bool transformed);
+
+        //! Take oldest entry and record lag. Queue must not be empty and mutex must be held.
+        void popFront(FramePtr& frame);
+
+        //! Stop receiving frames and wake up waiting threads
+        void close();
+
+        const SubscriberOptions m_options;          //!< Subscriber options
+        std::vector<Entry> m_entries;               //!< Entry ring buffer
+        size_t m_head{0};                           //!< Index of oldest entry
+        size_t m_size{0};                           //!< Number of queued entries
+        size_t m_maxSize{0};                        //!< Largest number of queued entries
+        bool m_closed{false};                       //!< Removed from bus
+        mutable std::mutex m_mutex;                 //!< Mutex for queue and counters
+        std::condition_variable m_notEmpty;         //!< Signaled when frames are queued or subscription is closed
+        std::condition_variable m_notFull;          //!< Signaled when frames are taken or subscription is closed
+        uint64_t m_receivedFrames{0};               //!< Number of frames matching the filter
+        uint64_t m_consumedFrames{0};               //!< Number of frames taken
+        uint64_t m_droppedFrames{0};                //!< Number of frames dropped
+        uint64_t m_blockedFrames{0};                //!< Number of frames the publisher waited for
+        uint64_t m_decimatedFrames{0};              //!< Number of frames skipped by decimation
+        uint64_t m_transformedFrames{0};            //!< Number of transformed frames queued
+        std::array<uint64_t, 2> m_channelFrames{};  //!< Matching frames per channel for decimation
+        LatencyHistogram m_lag;                     //!< Publish to consume time
+    };
+
+    //! Bus statistics
+    struct Stats {
+        uint64_t publishedFrames{0};     //!< Number of published frames
+        uint64_t unsubscribedFrames{0};  //!< Number of published frames no subscriber wanted
+        uint64_t copiedFrames{0};        //!< Number of frames whose data was copied into a payload
+    };
+
+    //! Construct empty bus
+    FrameBus();
+
+    //! Destruct bus. Closes remaining subscriptions.
+    ~FrameBus();
+
+    // Disable copy, move and assign
+    FrameBus(const FrameBus& other) = delete;
+    FrameBus(const FrameBus&& other) = delete;
+    FrameBus& operator=(const FrameBus& other) = delete;
+    FrameBus& operator=(const FrameBus&& other) = delete;
+
+    //! Add subscriber. Subscription only receives frames published after this call.
+    std::shared_ptr<Subscription> subscribe(const SubscriberOptions& options);
+
+    //! Remove subscriber. Queued frames can still be taken, but no new frames are received.
+    void unsubscribe(const std::shared_ptr<Subscription>& subscription);
+
+    //! Publish frame to matching subscribers. Frame data is copied once if any subscriber wants it, leased
+    //! frames only share the lease. With Block policy subscribers, the call may wait up to their timeout.
+    void publish(const Frame& frame);
+
+    //! Publish existing payload to matching subscribers without copying
+    void publish(const FramePtr& frame);
+
+    //! Returns bus statistics
+    Stats getStats() const;
+
+    //! Crop and downsample Y8 frame according to given transform. Output buffer is reused if it is large enough.
+    //! Returns false if the frame has no Y8 data or the transformed frame would be empty.
+    static bool transformFrame(const Frame& frame, const IngestTransform& transform, Frame& output);
+
+private:
+    //! Queue frame to matching subscribers. Untransformed subscribers share given payload, which is created
+    //! from the frame if null.
+    void publishFrame(const Frame& frame, FramePtr payload);
+
+    using SubscriberList = std::vector<std::shared_ptr<Subscription>>;
+
+    //! Returns current subscriber list snapshot
+    std::shared_ptr<const SubscriberList> getSubscribers() const;
+
+    std::mutex m_subscribeMutex;                          //!< Mutex for serializing subscriber list updates
+    std::shared_ptr<const SubscriberList> m_subscribers;  //!< Subscribers, accessed atomically
+    std::atomic<uint64_t> m_publishedFrames{0};           //!< Number of published frames
+    std::atomic<uint64_t> m_unsubscribedFrames{0};        //!< Number of frames without subscribers
+    std::atomic<uint64_t> m_copiedFrames{0};              //!< Number of copied payloads
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,670 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "FrameRecording.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VarjoExamples
+{
+using namespace RecordingFormat;
+
+namespace
+{
+// Round value up to given power of two alignment
+constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+// Offset of payload from the start of its record
+constexpr size_t c_payloadOffset = alignUp(sizeof(RecordHeader), c_recordAlignment);
+
+// Offset of the first record from the start of its chunk
+constexpr size_t c_firstRecordOffset = alignUp(sizeof(ChunkHeader), c_recordAlignment);
+
+static_assert(sizeof(FileHeader) <= c_blockSize, "File header must fit in a block");
+
+// Deleter for block aligned buffers
+struct AlignedDeleter {
+    void operator()(uint8_t* ptr) const { ::operator delete(ptr, std::align_val_t{c_blockSize}); }
+};
+
+// Block aligned buffer usable with unbuffered writes
+using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedDeleter>;
+
+// Allocate zero initialized block aligned buffer
+AlignedBuffer allocateAligned(size_t size)
+{
+    AlignedBuffer buffer(static_cast<uint8_t*>(::operator new(size, std::align_val_t{c_blockSize})));
+    memset(buffer.get(), 0, size);
+    return buffer;
+}
+
+}  // namespace
+
+//! Sequentially written output file
+struct FrameRecorder::OutputFile {
+#if defined(_WIN32)
+    HANDLE handle{INVALID_HANDLE_VALUE};  //!< File handle
+#else
+    int fd{-1};  //!< File descriptor
+#endif
+
+    //! Close file on destruction
+    ~OutputFile() { close(); }
+
+    //! Create file. Unbuffered writes require block aligned buffers, sizes and offsets.
+    bool open(const std::string& filename, bool unbuffered)
+    {
+#if defined(_WIN32)
+        const DWORD flags = unbuffered ? (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH) : FILE_FLAG_SEQUENTIAL_SCAN;
+        handle = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+        if (handle == INVALID_HANDLE_VALUE && unbuffered) {
+            LOG_WARNING("Unbuffered writes not supported, using buffered writes: %s", filename.c_str());
+            return open(filename, false);
+        }
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(O_DIRECT)
+        if (unbuffered) {
+            flags |= O_DIRECT;
+        }
+#endif
+        fd = ::open(filename.c_str(), flags, 0644);
+        if (fd < 0 && unbuffered) {
+            LOG_WARNING("Unbuffered writes not supported, using buffered writes: %s", filename.c_str());
+            return open(filename, false);
+        }
+        return fd >= 0;
+#endif
+    }
+
+    //! Write all given data at the current file position
+    bool write(const uint8_t* data, size_t size)
+    {
+        // Limit single writes, Win32 write size is 32-bit
+        constexpr size_t c_maxWriteSize = 1024 * 1024 * 1024;
+
+        while (size > 0) {
+            const size_t writeSize = std::min(size, c_maxWriteSize);
+#if defined(_WIN32)
+            DWORD written = 0;
+            if (!WriteFile(handle, data, static_cast<DWORD>(writeSize), &written, nullptr) || written == 0) {
+                return false;
+            }
+#else
+            const ssize_t written = ::write(fd, data, writeSize);
+            if (written <= 0) {
+                return false;
+            }
+#endif
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    //! Close file
+    void close()
+    {
+#if defined(_WIN32)
+        if (handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+};
+
+//! Chunk buffer
+struct FrameRecorder::Chunk {
+    AlignedBuffer buffer;     //!< Block aligned chunk data
+    size_t capacity{0};       //!< Buffer capacity, multiple of block size
+    size_t dataSize{0};       //!< Bytes used by header and records
+    uint32_t recordCount{0};  //!< Number of records in chunk
+    uint64_t fileOffset{0};   //!< File offset of chunk
+    uint64_t chunkSize{0};    //!< Chunk size in file including padding, set when submitted
+};
+
+FrameRecorder::FrameRecorder() = default;
+
+FrameRecorder::~FrameRecorder() { close(); }
+
+bool FrameRecorder::open(const std::string& filename) { return open(filename, Options()); }
+
+bool FrameRecorder::open(const std::string& filename, const Options& options)
+{
+    if (isOpen()) {
+        LOG_ERROR("Recorder already open: %s", m_filename.c_str());
+        return false;
+    }
+
+    auto file = std::make_unique<OutputFile>();
+    if (!file->open(filename, options.unbufferedWrites)) {
+        LOG_ERROR("Failed to create recording file: %s", filename.c_str());
+        return false;
+    }
+
+    // Write file header block
+    auto headerBlock = allocateAligned(c_blockSize);
+    const FileHeader header;
+    memcpy(headerBlock.get(), &header, sizeof(header));
+    if (!file->write(headerBlock.get(), c_blockSize)) {
+        LOG_ERROR("Failed to write recording file: %s", filename.c_str());
+        file->close();
+        return false;
+    }
+
+    // Allocate all chunk buffers up front, so recording does not allocate memory
+    const size_t chunkSize = static_cast<size_t>(alignUp(std::max<size_t>(options.chunkSize, c_blockSize), c_blockSize));
+    const size_t chunkCount = std::max<size_t>(options.chunkCount, 2);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_chunks.clear();
+    m_freeChunks.clear();
+    m_queuedChunks.clear();
+    for (size_t i = 0; i < chunkCount; i++) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->buffer = allocateAligned(chunkSize);
+        chunk->capacity = chunkSize;
+        m_freeChunks.push_back(chunk.get());
+        m_chunks.push_back(std::move(chunk));
+    }
+
+    m_filename = filename;
+    m_file = std::move(file);
+    m_currentChunk = nullptr;
+    m_nextChunkOffset = c_blockSize;
+    m_chunkCount = 0;
+    m_index.clear();
+    m_stats = {};
+    m_open = true;
+    m_stop = false;
+    m_writerThread = std::thread(&FrameRecorder::writerMain, this);
+
+    LOG_INFO("Recording started: %s, chunks=%zu, chunkSize=%zu KB, unbuffered=%s", filename.c_str(), chunkCount, chunkSize >> 10,
+        options.unbufferedWrites ? "true" : "false");
+    return true;
+}
+
+bool FrameRecorder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_open) {
+            return false;
+        }
+
+        // Stop accepting frames and queue the last chunk
+        m_open = false;
+        if (m_currentChunk) {
+            submitChunk();
+        }
+        m_stop = true;
+    }
+
+    // Writer thread writes all queued chunks before exiting
+    m_writeCondition.notify_all();
+    m_writerThread.join();
+
+    // Write index and trailer. Padding goes in front of the index, so the block aligned write
+    // leaves the trailer in the last bytes of the file.
+    const size_t indexSize = m_index.size() * sizeof(IndexEntry);
+    const size_t blockSize = static_cast<size_t>(alignUp(indexSize + sizeof(FileTrailer), c_blockSize));
+    const size_t padding = blockSize - indexSize - sizeof(FileTrailer);
+
+    FileTrailer trailer;
+    trailer.indexOffset = m_nextChunkOffset + padding;
+    trailer.entryCount = m_index.size();
+    trailer.chunkCount = m_chunkCount;
+
+    auto indexBlock = allocateAligned(blockSize);
+    if (indexSize > 0) {
+        memcpy(indexBlock.get() + padding, m_index.data(), indexSize);
+    }
+    memcpy(indexBlock.get() + padding + indexSize, &trailer, sizeof(trailer));
+
+    const bool indexWritten = m_file->write(indexBlock.get(), blockSize);
+    m_file->close();
+    m_file.reset();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.writeFailed = m_stats.writeFailed || !indexWritten;
+
+    // Release chunk memory
+    m_freeChunks.clear();
+    m_chunks.clear();
+
+    if (m_stats.writeFailed) {
+        LOG_ERROR("Recording failed: %s", m_filename.c_str());
+    } else {
+        LOG_INFO("Recording finished: %s, frames=%llu, dropped=%llu, size=%llu MB", m_filename.c_str(),
+            static_cast<unsigned long long>(m_stats.recordedFrames), static_cast<unsigned long long>(m_stats.droppedFrames),
+            static_cast<unsigned long long>((m_nextChunkOffset + blockSize) >> 20));
+    }
+    return !m_stats.writeFailed;
+}
+
+bool FrameRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+bool FrameRecorder::record(const DataStreamer::Frame::Metadata& metadata, const void* data, size_t size)
+{
+    const size_t recordSize = static_cast<size_t>(alignUp(c_payloadOffset + (data ? size : 0), c_recordAlignment));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open) {
+        return false;
+    }
+
+    // Start new chunk if the record does not fit in the current one
+    if (m_currentChunk && m_currentChunk->dataSize + recordSize > m_currentChunk->capacity) {
+        submitChunk();
+    }
+    if (!m_currentChunk && !beginChunk()) {
+        m_stats.droppedFrames++;
+        return false;
+    }
+
+    // Frames larger than a chunk get a chunk of their own
+    Chunk& chunk = *m_currentChunk;
+    if (c_firstRecordOffset + recordSize > chunk.capacity) {
+        const size_t capacity = static_cast<size_t>(alignUp(c_firstRecordOffset + recordSize, c_blockSize));
+        LOG_WARNING("Frame larger than recording chunk, reallocating: size=%zu, chunkSize=%zu", size, chunk.capacity);
+        chunk.buffer = allocateAligned(capacity);
+        chunk.capacity = capacity;
+    }
+
+    // Copy record to chunk
+    uint8_t* recordStart = chunk.buffer.get() + chunk.dataSize;
+    RecordHeader header;
+    header.payloadSize = data ? size : 0;
+    header.metadata = metadata;
+    memcpy(recordStart, &header, sizeof(header));
+    if (header.payloadSize > 0) {
+        memcpy(recordStart + c_payloadOffset, data, size);
+    }
+
+    IndexEntry entry;
+    entry.streamType = metadata.streamFrame.type;
+    entry.channelIndex = metadata.channelIndex;
+    entry.frameNumber = metadata.streamFrame.frameNumber;
+    entry.timestamp = metadata.timestamp;
+    entry.recordOffset = chunk.fileOffset + chunk.dataSize;
+    entry.payloadOffset = entry.recordOffset + c_payloadOffset;
+    entry.payloadSize = header.payloadSize;
+    m_index.push_back(entry);
+
+    chunk.dataSize += recordSize;
+    chunk.recordCount++;
+    m_stats.recordedFrames++;
+    return true;
+}
+
+FrameRecorder::Stats FrameRecorder::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+bool FrameRecorder::beginChunk()
+{
+    if (m_freeChunks.empty()) {
+        return false;
+    }
+
+    m_currentChunk = m_freeChunks.back();
+    m_freeChunks.pop_back();
+
+    // Chunks are written in submission order, so file offset is known already
+    m_currentChunk->fileOffset = m_nextChunkOffset;
+    m_currentChunk->dataSize = c_firstRecordOffset;
+    m_currentChunk->recordCount = 0;
+    return true;
+}
+
+void FrameRecorder::submitChunk()
+{
+    Chunk& chunk = *m_currentChunk;
+    chunk.chunkSize = alignUp(chunk.dataSize, c_blockSize);
+
+    ChunkHeader header;
+    header.recordCount = chunk.recordCount;
+    header.dataSize = chunk.dataSize;
+    header.chunkSize = chunk.chunkSize;
+    memcpy(chunk.buffer.get(), &header, sizeof(header));
+
+    // Clear padding so stale data from earlier chunks is not written out
+    memset(chunk.buffer.get() + chunk.dataSize, 0, static_cast<size_t>(chunk.chunkSize - chunk.dataSize));
+
+    m_nextChunkOffset += chunk.chunkSize;
+    m_chunkCount++;
+    m_queuedChunks.push_back(m_currentChunk);
+    m_currentChunk = nullptr;
+
+    m_stats.queuedChunks = m_queuedChunks.size();
+    m_stats.maxQueuedChunks = std::max(m_stats.maxQueuedChunks, m_stats.queuedChunks);
+    m_writeCondition.notify_one();
+}
+
+void FrameRecorder::writerMain()
+{
+    while (true) {
+        Chunk* chunk = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_writeCondition.wait(lock, [this]() { return m_stop || !m_queuedChunks.empty(); });
+            if (m_queuedChunks.empty()) {
+                // Stopped and all chunks written
+                return;
+            }
+            chunk = m_queuedChunks.front();
+        }
+
+        // Write without holding the lock, recording continues to other chunks
+        const bool ok = m_file->write(chunk->buffer.get(), static_cast<size_t>(chunk->chunkSize));
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queuedChunks.pop_front();
+            m_freeChunks.push_back(chunk);
+            m_stats.queuedChunks = m_queuedChunks.size();
+            if (ok) {
+                m_stats.bytesWritten += chunk->chunkSize;
+            } else if (!m_stats.writeFailed) {
+                LOG_ERROR("Failed to write recording chunk: %s", m_filename.c_str());
+                m_stats.writeFailed = true;
+            }
+        }
+    }
+}
+
+//! Read only memory mapped file
+struct FrameRecording::MappedFile {
+#if defined(_WIN32)
+    HANDLE handle{INVALID_HANDLE_VALUE};  //!< File handle
+    HANDLE mapping{nullptr};              //!< File mapping handle
+#endif
+    const uint8_t* data{nullptr};  //!< Mapped file data
+    size_t size{0};                //!< File size in bytes
+
+    //! Unmap file on destruction
+    ~MappedFile() { close(); }
+
+    //! Map whole file
+    bool open(const std::string& filename)
+    {
+#if defined(_WIN32)
+        handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat fileStat {};
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            size = static_cast<size_t>(fileStat.st_size);
+            void* ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            data = (ptr != MAP_FAILED) ? static_cast<const uint8_t*>(ptr) : nullptr;
+        }
+        // Mapping stays valid after closing the descriptor
+        ::close(fd);
+#endif
+        if (!data) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    //! Unmap file
+    void close()
+    {
+#if defined(_WIN32)
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+        }
+        if (handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+    }
+};
+
+FrameRecording::FrameRecording() = default;
+
+FrameRecording::~FrameRecording() { close(); }
+
+bool FrameRecording::open(const std::string& filename)
+{
+    close();
+
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(filename)) {
+        LOG_ERROR("Failed to open recording: %s", filename.c_str());
+        return false;
+    }
+
+    // Validate header
+    FileHeader header;
+    if (file->size < c_blockSize) {
+        LOG_ERROR("Invalid recording, file too small: %s", filename.c_str());
+        return false;
+    }
+    memcpy(&header, file->data, sizeof(header));
+    if (header.magic != c_fileMagic || header.version != c_version || header.blockSize != c_blockSize ||
+        header.metadataSize != sizeof(DataStreamer::Frame::Metadata)) {
+        LOG_ERROR("Invalid or incompatible recording: %s, version=%u", filename.c_str(), header.version);
+        return false;
+    }
+    m_file = std::move(file);
+
+    // Load index from trailer if the recording was finalized
+    bool indexValid = false;
+    if (m_file->size >= c_blockSize + sizeof(FileTrailer)) {
+        FileTrailer trailer;
+        memcpy(&trailer, m_file->data + m_file->size - sizeof(FileTrailer), sizeof(trailer));
+        const uint64_t indexSize = trailer.entryCount * sizeof(IndexEntry);
+        if (trailer.magic == c_trailerMagic && trailer.indexOffset >= c_blockSize && trailer.entryCount <= m_file->size / sizeof(IndexEntry) &&
+            trailer.indexOffset + indexSize + sizeof(FileTrailer) == m_file->size) {
+            m_index.resize(static_cast<size_t>(trailer.entryCount));
+            if (indexSize > 0) {
+                memcpy(m_index.data(), m_file->data + trailer.indexOffset, static_cast<size_t>(indexSize));
+            }
+            indexValid = true;
+        }
+    }
+
+    if (!indexValid) {
+        LOG_WARNING("Recording index missing, rebuilding: %s", filename.c_str());
+        if (!rebuildIndex()) {
+            LOG_ERROR("Failed to rebuild recording index: %s", filename.c_str());
+            close();
+            return false;
+        }
+    }
+
+    // Reject entries pointing outside the file or to a misplaced record header. getFrame() reads the header at
+    // record offset, so it must be aligned, follow the file header and be directly followed by the payload.
+    for (const auto& entry : m_index) {
+        const bool recordValid = entry.recordOffset >= c_blockSize && entry.recordOffset % c_recordAlignment == 0 &&
+                                 entry.recordOffset <= m_file->size - c_payloadOffset && entry.payloadOffset == entry.recordOffset + c_payloadOffset;
+        if (!recordValid || entry.payloadSize > m_file->size - entry.payloadOffset) {
+            LOG_ERROR("Invalid recording index entry: record=%llu, offset=%llu, size=%llu", static_cast<unsigned long long>(entry.recordOffset),
+                static_cast<unsigned long long>(entry.payloadOffset), static_cast<unsigned long long>(entry.payloadSize));
+            close();
+            return false;
+        }
+    }
+
+    buildLookups();
+
+    LOG_INFO("Opened recording: %s, frames=%zu, channels=%zu", filename.c_str(), m_index.size(), m_lookups.size());
+    return true;
+}
+
+void FrameRecording::close()
+{
+    if (m_file) {
+        m_file->close();
+        m_file.reset();
+    }
+    m_index.clear();
+    m_lookups.clear();
+}
+
+bool FrameRecording::isOpen() const { return m_file != nullptr; }
+
+std::optional<FrameRecording::FrameView> FrameRecording::getFrame(size_t index) const
+{
+    if (!m_file || index >= m_index.size()) {
+        return std::nullopt;
+    }
+
+    const IndexEntry& entry = m_index[index];
+    const auto* header = reinterpret_cast<const RecordHeader*>(m_file->data + entry.recordOffset);
+
+    FrameView view;
+    view.metadata = &header->metadata;
+    view.data = entry.payloadSize > 0 ? m_file->data + entry.payloadOffset : nullptr;
+    view.size = static_cast<size_t>(entry.payloadSize);
+    return view;
+}
+
+std::optional<FrameRecording::FrameView> FrameRecording::findFrame(varjo_StreamType streamType, varjo_ChannelIndex channelIndex, int64_t frameNumber) const
+{
+    const auto it = m_lookups.find(ChannelKey(streamType, channelIndex));
+    if (it == m_lookups.end()) {
+        return std::nullopt;
+    }
+
+    const auto& entries = it->second.byFrameNumber;
+    const auto pos = std::lower_bound(
+        entries.begin(), entries.end(), frameNumber, [this](size_t entry, int64_t value) { return m_index[entry].frameNumber < value; });
+    if (pos == entries.end() || m_index[*pos].frameNumber != frameNumber) {
+        return std::nullopt;
+    }
+    return getFrame(*pos);
+}
+
+std::optional<FrameRecording::FrameView> FrameRecording::findFrameAt(
+    varjo_StreamType streamType, varjo_ChannelIndex channelIndex, varjo_Nanoseconds timestamp) const
+{
+    const auto it = m_lookups.find(ChannelKey(streamType, channelIndex));
+    if (it == m_lookups.end()) {
+        return std::nullopt;
+    }
+
+    // First entry after timestamp, the one before it is the latest at or before timestamp
+    const auto& entries = it->second.byTimestamp;
+    const auto pos = std::upper_bound(
+        entries.begin(), entries.end(), timestamp, [this](varjo_Nanoseconds value, size_t entry) { return value < m_index[entry].timestamp; });
+    if (pos == entries.begin()) {
+        return std::nullopt;
+    }
+    return getFrame(*(pos - 1));
+}
+
+bool FrameRecording::rebuildIndex()
+{
+    m_index.clear();
+
+    uint64_t offset = c_blockSize;
+    while (offset + sizeof(ChunkHeader) <= m_file->size) {
+        ChunkHeader chunk;
+        memcpy(&chunk, m_file->data + offset, sizeof(chunk));
+        if (chunk.magic != c_chunkMagic || chunk.chunkSize < chunk.dataSize || chunk.chunkSize > m_file->size - offset) {
+            // End of chunks, either the index or a chunk that was not completely written
+            break;
+        }
+
+        uint64_t recordOffset = offset + c_firstRecordOffset;
+        for (uint32_t i = 0; i < chunk.recordCount; i++) {
+            RecordHeader record;
+            if (recordOffset + sizeof(record) > offset + chunk.dataSize) {
+                return false;
+            }
+            memcpy(&record, m_file->data + recordOffset, sizeof(record));
+            const uint64_t recordSize = alignUp(c_payloadOffset + record.payloadSize, c_recordAlignment);
+            if (record.magic != c_recordMagic || recordOffset + recordSize > offset + chunk.dataSize) {
+                return false;
+            }
+
+            IndexEntry entry;
+            entry.streamType = record.metadata.streamFrame.type;
+            entry.channelIndex = record.metadata.channelIndex;
+            entry.frameNumber = record.metadata.streamFrame.frameNumber;
+            entry.timestamp = record.metadata.timestamp;
+            entry.recordOffset = recordOffset;
+            entry.payloadOffset = recordOffset + c_payloadOffset;
+            entry.payloadSize = record.payloadSize;
+            m_index.push_back(entry);
+
+            recordOffset += recordSize;
+        }
+
+        offset += chunk.chunkSize;
+    }
+    return true;
+}
+
+void FrameRecording::buildLookups()
+{
+    m_lookups.clear();
+    for (size_t i = 0; i < m_index.size(); i++) {
+        auto& lookup = m_lookups[ChannelKey(m_index[i].streamType, m_index[i].channelIndex)];
+        lookup.byFrameNumber.push_back(i);
+        lookup.byTimestamp.push_back(i);
+    }
+
+    // Frames are mostly recorded in order already, stable sort keeps recording order for duplicates
+    for (auto& [key, lookup] : m_lookups) {
+        std::stable_sort(lookup.byFrameNumber.begin(), lookup.byFrameNumber.end(),
+            [this](size_t a, size_t b) { return m_index[a].frameNumber < m_index[b].frameNumber; });
+        std::stable_sort(
+            lookup.byTimestamp.begin(), lookup.byTimestamp.end(), [this](size_t a, size_t b) { return m_index[a].timestamp < m_index[b].timestamp; });
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,264 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "DataStreamer.hpp"
+
+namespace VarjoExamples
+{
+//! Layout of data stream recording files.
+//!
+//! A recording starts with a file header block followed by chunks of frame records. Each chunk
+//! is written with a single sequential write and padded to the block size, so chunks can be
+//! written without OS buffering. Records hold the frame metadata as is, followed by the buffer
+//! payload. The file ends with an index of all records and a trailer pointing to the index.
+//! If a recording was not finalized, the index can be rebuilt by walking the chunks.
+namespace RecordingFormat
+{
+//! Block size for file layout. Chunks and the index are aligned to this for unbuffered writes.
+constexpr size_t c_blockSize = 4096;
+
+//! Alignment of records and payloads within a chunk
+constexpr size_t c_recordAlignment = 64;
+
+//! Current format version
+constexpr uint32_t c_version = 1;
+
+//! Magic values for file structures
+constexpr uint32_t c_fileMagic = 0x43455256;     //!< "VREC"
+constexpr uint32_t c_chunkMagic = 0x4b4e4843;    //!< "CHNK"
+constexpr uint32_t c_recordMagic = 0x4d415246;   //!< "FRAM"
+constexpr uint32_t c_trailerMagic = 0x58444e49;  //!< "INDX"
+
+//! File header, stored at the start of the first block
+struct FileHeader {
+    uint32_t magic{c_fileMagic};                                   //!< File magic
+    uint32_t version{c_version};                                   //!< Format version
+    uint32_t blockSize{c_blockSize};                               //!< Block size of the file layout
+    uint32_t metadataSize{sizeof(DataStreamer::Frame::Metadata)};  //!< Size of frame metadata in records
+    uint64_t reserved[6]{};                                        //!< Reserved
+};
+
+//! Chunk header, stored at the start of each chunk
+struct ChunkHeader {
+    uint32_t magic{c_chunkMagic};  //!< Chunk magic
+    uint32_t recordCount{0};       //!< Number of records in chunk
+    uint64_t dataSize{0};          //!< Bytes used by header and records
+    uint64_t chunkSize{0};         //!< Chunk size in file including padding
+    uint64_t reserved{0};          //!< Reserved
+};
+
+//! Record header, followed by payload at next record alignment
+struct RecordHeader {
+    uint32_t magic{c_recordMagic};             //!< Record magic
+    uint32_t reserved{0};                      //!< Reserved
+    uint64_t payloadSize{0};                   //!< Payload size in bytes
+    DataStreamer::Frame::Metadata metadata{};  //!< Frame metadata
+};
+
+//! Index entry for a single record
+struct IndexEntry {
+    varjo_StreamType streamType{0};      //!< Stream type
+    varjo_ChannelIndex channelIndex{0};  //!< Channel index
+    int64_t frameNumber{0};              //!< Stream frame number
+    varjo_Nanoseconds timestamp{0};      //!< Frame timestamp
+    uint64_t recordOffset{0};            //!< File offset of record header
+    uint64_t payloadOffset{0};           //!< File offset of payload
+    uint64_t payloadSize{0};             //!< Payload size in bytes
+};
+
+//! File trailer, stored in the last bytes of the file after the index
+struct FileTrailer {
+    uint64_t indexOffset{0};         //!< File offset of the first index entry
+    uint64_t entryCount{0};          //!< Number of index entries
+    uint64_t chunkCount{0};          //!< Number of chunks
+    uint32_t reserved{0};            //!< Reserved
+    uint32_t magic{c_trailerMagic};  //!< Trailer magic
+};
+
+}  // namespace RecordingFormat
+
+//! Streaming recorder for data stream frames.
+//!
+//! Stream callbacks copy frames into preallocated chunk buffers, and a writer thread writes full
+//! chunks to the file with large sequential writes. Recording never blocks the caller on disk:
+//! if all chunk buffers are waiting to be written, the frame is dropped and counted instead.
+//! Optionally the file is written unbuffered (FILE_FLAG_NO_BUFFERING or O_DIRECT), which avoids
+//! polluting the OS file cache with data that is not read back.
+class FrameRecorder
+{
+public:
+    //! Default chunk buffer size
+    static constexpr size_t c_defaultChunkSize = 16 * 1024 * 1024;
+
+    //! Default number of chunk buffers
+    static constexpr size_t c_defaultChunkCount = 8;
+
+    //! Recorder options
+    struct Options {
+        size_t chunkSize{c_defaultChunkSize};    //!< Chunk buffer size, rounded up to block size
+        size_t chunkCount{c_defaultChunkCount};  //!< Number of chunk buffers, limits memory used for buffering
+        bool unbufferedWrites{false};            //!< Bypass OS file cache when writing
+    };
+
+    //! Recorder statistics
+    struct Stats {
+        uint64_t recordedFrames{0};  //!< Number of frames recorded
+        uint64_t droppedFrames{0};   //!< Number of frames dropped due to no free chunk buffers
+        uint64_t bytesWritten{0};    //!< Number of bytes written to file
+        size_t queuedChunks{0};      //!< Number of chunks waiting to be written
+        size_t maxQueuedChunks{0};   //!< Highest number of chunks waiting to be written
+        bool writeFailed{false};     //!< Flag indicating a failed file write
+    };
+
+    //! Construct recorder
+    FrameRecorder();
+
+    //! Destruct recorder. Closes the recording if open.
+    ~FrameRecorder();
+
+    // Disable copy, move and assign
+    FrameRecorder(const FrameRecorder& other) = delete;
+    FrameRecorder(const FrameRecorder&& other) = delete;
+    FrameRecorder& operator=(const FrameRecorder& other) = delete;
+    FrameRecorder& operator=(const FrameRecorder&& other) = delete;
+
+    //! Create recording file with default options. Returns false on failure.
+    bool open(const std::string& filename);
+
+    //! Create recording file and allocate chunk buffers. Returns false on failure.
+    bool open(const std::string& filename, const Options& options);
+
+    //! Write remaining frames and index, and close the file. Returns false if any write failed.
+    bool close();
+
+    //! Is recording file open
+    bool isOpen() const;
+
+    //! Record frame with given metadata and buffer data. Can be called from multiple threads.
+    //! Returns false if the frame was dropped or the recorder is not open.
+    bool record(const DataStreamer::Frame::Metadata& metadata, const void* data, size_t size);
+
+    //! Returns recorder statistics
+    Stats getStats() const;
+
+    //! Returns recording filename
+    const std::string& getFilename() const { return m_filename; }
+
+private:
+    struct OutputFile;
+    struct Chunk;
+
+    //! Take free chunk buffer for recording. Mutex must be held. Returns false if none available.
+    bool beginChunk();
+
+    //! Finalize current chunk and queue it for writing. Mutex must be held.
+    void submitChunk();
+
+    //! Writer thread main loop
+    void writerMain();
+
+    std::string m_filename;                            //!< Recording filename
+    std::unique_ptr<OutputFile> m_file;                //!< Output file
+    std::vector<std::unique_ptr<Chunk>> m_chunks;      //!< All chunk buffers
+    std::thread m_writerThread;                        //!< Writer thread
+    mutable std::mutex m_mutex;                        //!< Mutex for chunks, index and stats
+    std::condition_variable m_writeCondition;          //!< Signaled when chunks are queued or writer stopped
+    std::vector<Chunk*> m_freeChunks;                  //!< Chunk buffers available for recording
+    std::deque<Chunk*> m_queuedChunks;                 //!< Full chunks waiting to be written
+    Chunk* m_currentChunk{nullptr};                    //!< Chunk currently being filled
+    uint64_t m_nextChunkOffset{0};                     //!< File offset of next chunk
+    uint64_t m_chunkCount{0};                          //!< Number of chunks submitted
+    std::vector<RecordingFormat::IndexEntry> m_index;  //!< Index of recorded frames
+    Stats m_stats{};                                   //!< Recorder statistics
+    bool m_open{false};                                //!< Flag indicating whether frames are accepted
+    bool m_stop{false};                                //!< Stop flag for writer thread
+};
+
+//! Read access to a data stream recording.
+//!
+//! The file is memory mapped, so frames are accessed in place without copying and only the pages
+//! actually touched are read from disk. Frames can be looked up by index in recording order, or
+//! per stream channel by frame number or timestamp.
+class FrameRecording
+{
+public:
+    //! Frame in a recording. Pointers reference the mapped file and are valid until it is closed.
+    struct FrameView {
+        const DataStreamer::Frame::Metadata* metadata{nullptr};  //!< Frame metadata
+        const uint8_t* data{nullptr};                            //!< Buffer data, null for metadata only frames
+        size_t size{0};                                          //!< Buffer data size in bytes
+    };
+
+    //! Construct empty recording
+    FrameRecording();
+
+    //! Destruct recording. Unmaps the file.
+    ~FrameRecording();
+
+    // Disable copy, move and assign
+    FrameRecording(const FrameRecording& other) = delete;
+    FrameRecording(const FrameRecording&& other) = delete;
+    FrameRecording& operator=(const FrameRecording& other) = delete;
+    FrameRecording& operator=(const FrameRecording&& other) = delete;
+
+    //! Map recording file and load its index. Rebuilds the index if the recording was not finalized.
+    //! Returns false if the file could not be opened or is not a valid recording.
+    bool open(const std::string& filename);
+
+    //! Unmap recording file
+    void close();
+
+    //! Is recording open
+    bool isOpen() const;
+
+    //! Returns index of all frames in recording order
+    const std::vector<RecordingFormat::IndexEntry>& getIndex() const { return m_index; }
+
+    //! Returns number of frames in recording
+    size_t getFrameCount() const { return m_index.size(); }
+
+    //! Returns frame at given index in recording order
+    std::optional<FrameView> getFrame(size_t index) const;
+
+    //! Find frame with given frame number from given stream channel
+    std::optional<FrameView> findFrame(varjo_StreamType streamType, varjo_ChannelIndex channelIndex, int64_t frameNumber) const;
+
+    //! Find latest frame at or before given timestamp from given stream channel
+    std::optional<FrameView> findFrameAt(varjo_StreamType streamType, varjo_ChannelIndex channelIndex, varjo_Nanoseconds timestamp) const;
+
+private:
+    struct MappedFile;
+
+    //! Rebuild index by walking the chunks of a recording that was not finalized
+    bool rebuildIndex();
+
+    //! Build per channel lookup tables from the index
+    void buildLookups();
+
+    //! Stream channel lookup key
+    using ChannelKey = std::pair<varjo_StreamType, varjo_ChannelIndex>;
+
+    //! Per channel lookup tables of index entry positions
+    struct ChannelLookup {
+        std::vector<size_t> byFrameNumber;  //!< Entries sorted by frame number
+        std::vector<size_t> byTimestamp;    //!< Entries sorted by timestamp
+    };
+
+    std::unique_ptr<MappedFile> m_file;                //!< Mapped recording file
+    std::vector<RecordingFormat::IndexEntry> m_index;  //!< Index of all frames
+    std::map<ChannelKey, ChannelLookup> m_lookups;     //!< Lookup tables per stream channel
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,146 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "FrameSynchronizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+namespace VarjoExamples
+{
+FrameSynchronizer::FrameSynchronizer(const std::vector<Input>& inputs, MatchMode mode, varjo_Nanoseconds tolerance, size_t queueCapacity)
+    : m_mode(mode)
+    , m_tolerance((mode == MatchMode::Timestamp) ? std::max<varjo_Nanoseconds>(tolerance, 0) : 0)
+{
+    if (inputs.empty()) {
+        CRITICAL("Frame synchronizer needs at least one input.");
+    }
+
+    for (const auto& input : inputs) {
+        m_inputs.emplace_back(std::make_unique<InputQueue>(input, queueCapacity));
+    }
+}
+
+bool FrameSynchronizer::push(const Frame& frame)
+{
+    // Inputs are few, so linear search is the fastest lookup
+    for (auto& queue : m_inputs) {
+        if ((queue->input.streamType == frame.metadata.streamFrame.type) && (queue->input.channelIndex == frame.metadata.channelIndex)) {
+#ifndef NDEBUG
+            // Queue has a single producer, pushes of an input must not overlap
+            const bool overlapping = queue->pushing.exchange(true);
+            assert(!overlapping && "Concurrent push to the same frame synchronizer input");
+#endif
+
+            // Copy frame into queue slot. Slot buffer is reused if it is large enough.
+            const bool pushed = queue->frames.push(frame);
+
+#ifndef NDEBUG
+            queue->pushing = false;
+#endif
+
+            if (!pushed) {
+                queue->droppedFrames++;
+                return false;
+            }
+            return true;
+        }
+    }
+
+    m_ignoredFrames++;
+    return false;
+}
+
+bool FrameSynchronizer::getNextSet(FrameSet& set)
+{
+    for (;;) {
+        // Every input needs a frame for a complete set. Newest of the oldest frames is the reference
+        // that other inputs need to match, as older frames can't be matched with any frames of that input.
+        int64_t reference = std::numeric_limits<int64_t>::min();
+        for (auto& queue : m_inputs) {
+            const Frame* frame = queue->frames.peek(0);
+            if (!frame) {
+                return false;
+            }
+            reference = std::max(reference, getKey(*frame));
+        }
+
+        // Discard frames that are too old to match the reference. If the next frame of an input is not
+        // newer than the reference either, it is a better match, so the older frame is discarded too.
+        bool discarded = false;
+        for (auto& queue : m_inputs) {
+            const Frame* frame = queue->frames.peek(0);
+            while (frame) {
+                const Frame* next = queue->frames.peek(1);
+                if ((getKey(*frame) >= reference - m_tolerance) && (!next || (getKey(*next) > reference))) {
+                    break;
+                }
+
+                popFrame(*queue);
+                m_unmatchedFrames++;
+                discarded = true;
+                frame = queue->frames.peek(0);
+            }
+        }
+
+        // Frames at the front have changed, so find new reference
+        if (discarded) {
+            continue;
+        }
+
+        // All inputs have a matching frame. Swap them into the set so that the previous set buffers get reused.
+        set.frames.resize(m_inputs.size());
+        for (size_t i = 0; i < m_inputs.size(); i++) {
+            std::swap(set.frames[i], *m_inputs[i]->frames.peek(0));
+            popFrame(*m_inputs[i]);
+        }
+
+        m_matchedSets++;
+        return true;
+    }
+}
+
+bool FrameSynchronizer::getLatestSet(FrameSet& set)
+{
+    bool found = false;
+    while (getNextSet(set)) {
+        found = true;
+    }
+    return found;
+}
+
+void FrameSynchronizer::clear()
+{
+    for (auto& queue : m_inputs) {
+        while (queue->frames.peek(0)) {
+            popFrame(*queue);
+        }
+    }
+}
+
+FrameSynchronizer::Stats FrameSynchronizer::getStats() const
+{
+    Stats stats;
+    stats.matchedSets = m_matchedSets;
+    stats.unmatchedFrames = m_unmatchedFrames;
+    stats.ignoredFrames = m_ignoredFrames;
+    for (const auto& queue : m_inputs) {
+        stats.droppedFrames += queue->droppedFrames;
+    }
+    return stats;
+}
+
+int64_t FrameSynchronizer::getKey(const Frame& frame) const
+{
+    return (m_mode == MatchMode::FrameNumber) ? frame.metadata.streamFrame.frameNumber : frame.metadata.timestamp;
+}
+
+void FrameSynchronizer::popFrame(InputQueue& queue)
+{
+    // Leased runtime buffers must not be held by queued frames that are no longer used
+    queue.frames.peek(0)->lease.reset();
+    queue.frames.discard();
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,123 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "DataStreamer.hpp"
+#include "SpscQueue.hpp"
+
+namespace VarjoExamples
+{
+//! Groups frames from multiple stream channels into matched sets.
+//!
+//! Each input is a single stream channel, e.g. left or right color camera, eye camera or cubemap.
+//! Frames are pushed to a bounded queue per input without locking, so push() can be called
+//! directly from DataStreamer frame callbacks. The consumer pulls sets with one frame per input,
+//! matched either by frame number (channels of the same stream) or by timestamp within a
+//! tolerance (channels of different streams). Frames that can no longer be part of a complete set
+//! are discarded and counted, and frames are dropped if the queue of their input is full.
+//! Queue slots keep their frame buffers for reuse, so the queue capacity also bounds the memory
+//! held per input: with copied buffers, up to capacity full frames.
+//!
+//! Each input must only be pushed from one thread at a time, debug builds assert this. The
+//! pushing thread may change between pushes. DataStreamer delivers a stream channel from its
+//! stream thread, its channel worker or the thread handling delayed buffers, and never from two
+//! of them at once, also when the delivery mode changes. So pushing from the DataStreamer frame
+//! callback is safe.
+//! Consumer functions must be called from a single thread.
+class FrameSynchronizer
+{
+public:
+    using Frame = DataStreamer::Frame;
+
+    //! Default number of frames buffered per input
+    static constexpr size_t c_defaultQueueCapacity = 16;
+
+    //! Frame matching mode
+    enum class MatchMode {
+        FrameNumber,  //!< Match frames with equal stream frame numbers
+        Timestamp,    //!< Match frames with timestamps within tolerance
+    };
+
+    //! Synchronized stream channel
+    struct Input {
+        varjo_StreamType streamType{0};      //!< Stream type
+        varjo_ChannelIndex channelIndex{0};  //!< Channel index
+    };
+
+    //! Matched frames, one per input in input order. Frame storage is reused between sets.
+    struct FrameSet {
+        std::vector<Frame> frames;  //!< Frames in input order
+    };
+
+    //! Synchronizer statistics
+    struct Stats {
+        uint64_t matchedSets{0};      //!< Number of complete sets returned
+        uint64_t unmatchedFrames{0};  //!< Number of frames discarded because no set could be completed with them
+        uint64_t droppedFrames{0};    //!< Number of frames dropped due to full input queue
+        uint64_t ignoredFrames{0};    //!< Number of pushed frames not matching any input
+    };
+
+    //! Construct synchronizer for given inputs. For timestamp matching, frames match if their
+    //! timestamps differ at most by given tolerance. Queue capacity is the number of frames
+    //! buffered per input, rounded up to a power of two.
+    FrameSynchronizer(
+        const std::vector<Input>& inputs, MatchMode mode, varjo_Nanoseconds tolerance = 0, size_t queueCapacity = c_defaultQueueCapacity);
+
+    // Disable copy, move and assign
+    FrameSynchronizer(const FrameSynchronizer& other) = delete;
+    FrameSynchronizer(const FrameSynchronizer&& other) = delete;
+    FrameSynchronizer& operator=(const FrameSynchronizer& other) = delete;
+    FrameSynchronizer& operator=(const FrameSynchronizer&& other) = delete;
+
+    //! Push frame to the queue of its input. Returns false if the frame was dropped or ignored. Producer side.
+    bool push(const Frame& frame);
+
+    //! Get oldest matched set. Frames of the given set are handed to the input queues for reuse.
+    //! Returns false and leaves the set untouched if no complete set is available. Consumer side.
+    bool getNextSet(FrameSet& set);
+
+    //! Get latest matched set, discarding older sets. Returns false if no complete set is available. Consumer side.
+    bool getLatestSet(FrameSet& set);
+
+    //! Discard all queued frames. Consumer side.
+    void clear();
+
+    //! Returns synchronizer statistics
+    Stats getStats() const;
+
+private:
+    //! Input queue
+    struct InputQueue {
+        InputQueue(const Input& queueInput, size_t capacity)
+            : input(queueInput)
+            , frames(capacity)
+        {
+        }
+
+        Input input{};                           //!< Stream channel
+        SpscQueue<Frame> frames;                 //!< Queued frames, oldest first
+        std::atomic<uint64_t> droppedFrames{0};  //!< Frames dropped due to full queue
+#ifndef NDEBUG
+        std::atomic_bool pushing{false};  //!< Set while a frame is pushed, for detecting concurrent producers
+#endif
+    };
+
+    //! Returns matching key of frame
+    int64_t getKey(const Frame& frame) const;
+
+    //! Remove oldest frame of input. Releases its buffer lease, but keeps the buffer for reuse.
+    static void popFrame(InputQueue& queue);
+
+    const MatchMode m_mode;                             //!< Matching mode
+    const varjo_Nanoseconds m_tolerance;                //!< Matching tolerance in timestamp mode
+    std::vector<std::unique_ptr<InputQueue>> m_inputs;  //!< Input queues
+    std::atomic<uint64_t> m_matchedSets{0};             //!< Number of complete sets returned
+    std::atomic<uint64_t> m_unmatchedFrames{0};         //!< Number of frames discarded without match
+    std::atomic<uint64_t> m_ignoredFrames{0};           //!< Number of frames not matching any input
+};
+
+}  // namespace VarjoExamples
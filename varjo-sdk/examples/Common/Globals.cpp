@@ -1,6 +1,8 @@
 
 #include "Globals.hpp"
 
+#include <cstdarg>
+
 namespace
 {
 constexpr VarjoExamples::LogLevel c_defaultLogLevel = VarjoExamples::LogLevel::Info;
@@ -61,7 +63,7 @@ void VarjoExamples::writeLog(LogLevel level, const char* funcName, int lineNum,
     // formatStr  += std::string(funcName) + "():" + std::to_string(lineNum) + ": ";
     formatStr += std::string(prefix) + format;
     va_start(args, format);
-    vsprintf_s(lineBuf, lineLimit, formatStr.data(), args);
+    vsnprintf(lineBuf, lineLimit, formatStr.data(), args);
     va_end(args);
 
     writeLog(level, std::string(lineBuf));
@@ -74,7 +76,7 @@ void VarjoExamples::writeLog(LogLevel level, const char* funcName, int lineNum,
     va_list args;
     const std::string formatStr = std::string(prefix) + format;
     va_start(args, format);
-    vsprintf_s(lineBuf, lineLimit, formatStr.data(), args);
+    vsnprintf(lineBuf, lineLimit, formatStr.data(), args);
     va_end(args);
 
     // calls std::terminate()
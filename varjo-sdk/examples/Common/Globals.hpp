@@ -9,7 +9,9 @@
 #include <stdexcept>
 #include <functional>
 
+#ifdef _WIN32
 #include <wrl.h>
+#endif
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -18,8 +20,10 @@
 
 #include <Varjo.h>
 
+#ifdef _WIN32
 // Use MS COM smart pointers for DX objects
 using Microsoft::WRL::ComPtr;
+#endif
 
 namespace VarjoExamples
 {
@@ -54,35 +58,36 @@ extern void writeLog(LogLevel level, const char* funcName, int lineNum, const ch
     }
 
 //! Macro for debug log
-#define LOG_DEBUG(FORMAT, ...)                                                                                    \
-    {                                                                                                             \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Debug, __FUNCTION__, __LINE__, "", FORMAT, __VA_ARGS__); \
+#define LOG_DEBUG(FORMAT, ...)                                                                                      \
+    {                                                                                                               \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Debug, __FUNCTION__, __LINE__, "", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for info log
-#define LOG_INFO(FORMAT, ...)                                                                                    \
-    {                                                                                                            \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Info, __FUNCTION__, __LINE__, "", FORMAT, __VA_ARGS__); \
+#define LOG_INFO(FORMAT, ...)                                                                                      \
+    {                                                                                                              \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Info, __FUNCTION__, __LINE__, "", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for warn log
-#define LOG_WARNING(FORMAT, ...)                                                                                          \
-    {                                                                                                                     \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Warning, __FUNCTION__, __LINE__, "WARN: ", FORMAT, __VA_ARGS__); \
+#define LOG_WARNING(FORMAT, ...)                                                                                            \
+    {                                                                                                                       \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Warning, __FUNCTION__, __LINE__, "WARN: ", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for error log
-#define LOG_ERROR(FORMAT, ...)                                                                                           \
-    {                                                                                                                    \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Error, __FUNCTION__, __LINE__, "ERROR: ", FORMAT, __VA_ARGS__); \
+#define LOG_ERROR(FORMAT, ...)                                                                                             \
+    {                                                                                                                      \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Error, __FUNCTION__, __LINE__, "ERROR: ", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for critical error. This calls std::terminate().
-#define CRITICAL(FORMAT, ...)                                                                                                  \
-    {                                                                                                                          \
-        VarjoExamples::writeCritical(__FUNCTION__, __LINE__, "CRITICAL: ", FORMAT, __VA_ARGS__); \
+#define CRITICAL(FORMAT, ...)                                                                      \
+    {                                                                                              \
+        VarjoExamples::writeCritical(__FUNCTION__, __LINE__, "CRITICAL: ", FORMAT, ##__VA_ARGS__); \
     }
 
+#ifdef _WIN32
 //! Check Windows error code
 inline void checkHResult(const char* func, int line, const char* what, HRESULT hr)
 {
@@ -93,6 +98,7 @@ inline void checkHResult(const char* func, int line, const char* what, HRESULT h
 
 //! Macro for checking microsoft HRESULT
 #define CHECK_HRESULT(VALUE) VarjoExamples::checkHResult(__FUNCTION__, __LINE__, #VALUE, VALUE)
+#endif
 
 //! Check Varjo error code
 inline varjo_Error checkVError(const char* func, int line, varjo_Session* session)
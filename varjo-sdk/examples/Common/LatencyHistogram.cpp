@@ -0,0 +1,131 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace VarjoExamples
+{
+namespace
+{
+// Returns index of highest set bit of a non-zero value
+int getHighestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long bit = 0;
+    _BitScanReverse64(&bit, value);
+    return static_cast<int>(bit);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+}  // namespace
+
+void LatencyHistogram::record(int64_t value)
+{
+    value = std::clamp<int64_t>(value, 0, c_maxValue);
+    m_counts[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.counts.resize(c_bucketCount);
+    for (size_t i = 0; i < c_bucketCount; i++) {
+        snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+size_t LatencyHistogram::getBucketIndex(int64_t value)
+{
+    value = std::clamp<int64_t>(value, 0, c_maxValue);
+    if (value < c_subBucketCount) {
+        return static_cast<size_t>(value);
+    }
+
+    // Keep the highest c_subBucketBits bits of the value, value >> shift is in upper half of sub-buckets
+    const int shift = getHighestBit(static_cast<uint64_t>(value)) - c_subBucketBits + 1;
+    return static_cast<size_t>(shift * (c_subBucketCount / 2) + (value >> shift));
+}
+
+int64_t LatencyHistogram::getBucketStart(size_t index)
+{
+    const int64_t i = static_cast<int64_t>(index);
+    if (i < c_subBucketCount) {
+        return i;
+    }
+
+    const int64_t shift = i / (c_subBucketCount / 2) - 1;
+    return (i - shift * (c_subBucketCount / 2)) << shift;
+}
+
+int64_t LatencyHistogram::getBucketWidth(size_t index)
+{
+    const int64_t i = static_cast<int64_t>(index);
+    return (i < c_subBucketCount) ? 1 : (int64_t(1) << (i / (c_subBucketCount / 2) - 1));
+}
+
+void LatencyHistogram::Snapshot::subtract(const Snapshot& earlier)
+{
+    if (earlier.counts.size() != counts.size()) {
+        return;
+    }
+
+    count = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        // Counts only grow, but snapshots are not atomic as a whole
+        counts[i] = (counts[i] > earlier.counts[i]) ? counts[i] - earlier.counts[i] : 0;
+        count += counts[i];
+    }
+    sum -= earlier.sum;
+}
+
+int64_t LatencyHistogram::Snapshot::getPercentile(double percentile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the value at given percentile, at least the first value
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * count)));
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return getBucketStart(i) + (getBucketWidth(i) - 1) / 2;
+        }
+    }
+
+    return c_maxValue;
+}
+
+LatencyHistogram::Summary LatencyHistogram::Snapshot::getSummary() const
+{
+    Summary summary;
+    summary.count = count;
+    if (count == 0) {
+        return summary;
+    }
+
+    summary.min = getPercentile(0.0);
+    summary.mean = sum / static_cast<int64_t>(count);
+    summary.p50 = getPercentile(50.0);
+    summary.p90 = getPercentile(90.0);
+    summary.p99 = getPercentile(99.0);
+    summary.p999 = getPercentile(99.9);
+    summary.max = getPercentile(100.0);
+    return summary;
+}
+
+}  // namespace VarjoExamples
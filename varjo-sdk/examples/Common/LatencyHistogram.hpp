@@ -0,0 +1,91 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VarjoExamples
+{
+//! Lock-free histogram of durations in nanoseconds with bounded relative error.
+//!
+//! Values are counted in log-linear buckets like in HDR histograms: values below c_subBucketCount
+//! are counted exactly, and each higher power of two range is split into c_subBucketCount / 2
+//! linear buckets, so values are resolved within about 3%. Recording is a couple of relaxed
+//! atomic increments, so it can be done from any thread including stream callbacks. Statistics
+//! are computed from snapshots, which can be subtracted to get statistics for an interval.
+class LatencyHistogram
+{
+public:
+    //! Number of exactly counted values, and twice the number of buckets per power of two
+    static constexpr int c_subBucketBits = 6;
+    static constexpr int64_t c_subBucketCount = int64_t(1) << c_subBucketBits;
+
+    //! Largest value that can be recorded, larger values are counted as this. About 18 minutes.
+    static constexpr int c_valueBits = 40;
+    static constexpr int64_t c_maxValue = (int64_t(1) << c_valueBits) - 1;
+
+    //! Number of buckets needed to cover values up to c_maxValue
+    static constexpr size_t c_bucketCount = (c_valueBits - c_subBucketBits + 2) * (c_subBucketCount / 2);
+
+    //! Summary statistics of a histogram, values in nanoseconds
+    struct Summary {
+        uint64_t count{0};  //!< Number of values
+        int64_t min{0};     //!< Smallest value
+        int64_t mean{0};    //!< Mean value
+        int64_t p50{0};     //!< Median
+        int64_t p90{0};     //!< 90th percentile
+        int64_t p99{0};     //!< 99th percentile
+        int64_t p999{0};    //!< 99.9th percentile
+        int64_t max{0};     //!< Largest value
+    };
+
+    //! Point in time copy of histogram counts
+    struct Snapshot {
+        std::vector<uint64_t> counts;  //!< Bucket counts
+        uint64_t count{0};             //!< Total count of all buckets
+        int64_t sum{0};                //!< Sum of recorded values
+
+        //! Subtract earlier snapshot of the same histogram, leaving values recorded in between
+        void subtract(const Snapshot& earlier);
+
+        //! Returns value at given percentile (0-100). Values are bucket midpoints.
+        int64_t getPercentile(double percentile) const;
+
+        //! Returns summary statistics
+        Summary getSummary() const;
+    };
+
+    //! Construct empty histogram
+    LatencyHistogram() = default;
+
+    // Disable copy, move and assign
+    LatencyHistogram(const LatencyHistogram& other) = delete;
+    LatencyHistogram(const LatencyHistogram&& other) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram& other) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&& other) = delete;
+
+    //! Record value. Negative values are counted as zero.
+    void record(int64_t value);
+
+    //! Returns snapshot of current counts
+    Snapshot getSnapshot() const;
+
+    //! Returns bucket of given value
+    static size_t getBucketIndex(int64_t value);
+
+    //! Returns smallest value counted in given bucket
+    static int64_t getBucketStart(size_t index);
+
+    //! Returns number of values counted in given bucket
+    static int64_t getBucketWidth(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, c_bucketCount> m_counts{};  //!< Bucket counts
+    std::atomic<int64_t> m_sum{0};                                //!< Sum of recorded values
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,671 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "PngEncoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include "Globals.hpp"
+#include "WorkerPool.hpp"
+
+namespace VarjoExamples
+{
+namespace PngEncoder
+{
+namespace
+{
+// Target size of uncompressed image data per band
+constexpr size_t c_bandSize = 256 * 1024;
+
+// Maximum number of LZ77 tokens per deflate block. Smaller blocks adapt Huffman codes better to local statistics.
+constexpr size_t c_maxBlockTokens = 32 * 1024;
+
+// LZ77 parameters
+constexpr int c_hashBits = 15;
+constexpr size_t c_windowSize = 32768;
+constexpr size_t c_minMatch = 4;
+constexpr size_t c_maxMatch = 258;
+
+// Deflate alphabets
+constexpr int c_litLenSymbols = 286;
+constexpr int c_distSymbols = 30;
+constexpr int c_codeLengthSymbols = 19;
+constexpr int c_endOfBlock = 256;
+constexpr int c_maxCodeLength = 15;
+constexpr int c_maxCodeLengthCodeLength = 7;
+
+// Deflate length and distance code tables
+constexpr uint16_t c_lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t c_lengthExtraBits[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t c_distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t c_distExtraBits[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t c_codeLengthOrder[c_codeLengthSymbols] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Lookup tables from match length and distance to deflate codes
+struct CodeTables {
+    std::array<uint8_t, c_maxMatch + 1> lengthCodes{};  //!< Length code for match lengths 3..258
+    std::array<uint8_t, 512> distCodes{};               //!< Distance code, see getDistCode()
+    std::array<uint32_t, 256> crc{};                    //!< CRC-32 table
+
+    CodeTables()
+    {
+        for (int code = 0; code < 29; ++code) {
+            const int count = code == 28 ? 1 : (1 << c_lengthExtraBits[code]);
+            for (int i = 0; i < count; ++i) {
+                lengthCodes[c_lengthBase[code] + i] = static_cast<uint8_t>(code);
+            }
+        }
+
+        // Distances up to 256 are looked up directly, longer ones in steps of 128
+        for (int code = 0; code < c_distSymbols; ++code) {
+            const int count = 1 << c_distExtraBits[code];
+            for (int i = 0; i < count; ++i) {
+                const int dist = c_distBase[code] + i - 1;
+                if (dist < 256) {
+                    distCodes[dist] = static_cast<uint8_t>(code);
+                } else {
+                    distCodes[256 + (dist >> 7)] = static_cast<uint8_t>(code);
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+            }
+            crc[i] = c;
+        }
+    }
+
+    uint8_t getDistCode(size_t dist) const { return dist <= 256 ? distCodes[dist - 1] : distCodes[256 + ((dist - 1) >> 7)]; }
+};
+
+const CodeTables c_codeTables;
+
+// LZ77 token, either a literal byte or a match
+struct Token {
+    uint16_t litLen;  //!< Literal byte if dist is zero, otherwise match length
+    uint16_t dist;    //!< Match distance, zero for literals
+};
+
+// Deflate bit stream writer, bits are written least significant first. Appends to given buffer.
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& output)
+        : m_output(output)
+        , m_size(output.size())
+    {
+    }
+
+    // Write given number of bits (max 32)
+    void write(uint32_t bits, int count)
+    {
+        m_bits |= static_cast<uint64_t>(bits) << m_count;
+        m_count += count;
+        if (m_count >= 32) {
+            // Grow geometrically, resizing per write would dominate encoding time
+            if (m_size + 4 > m_output.size()) {
+                m_output.resize(std::max<size_t>(m_output.size() * 2, 4096));
+            }
+            std::memcpy(m_output.data() + m_size, &m_bits, 4);
+            m_size += 4;
+            m_bits >>= 32;
+            m_count -= 32;
+        }
+    }
+
+    // Pad to byte boundary and flush pending bits. Output buffer is trimmed to the written size.
+    void alignToByte()
+    {
+        m_output.resize(m_size);
+        while (m_count > 0) {
+            m_output.push_back(static_cast<uint8_t>(m_bits));
+            m_bits >>= 8;
+            m_count = std::max(m_count - 8, 0);
+        }
+        m_bits = 0;
+        m_size = m_output.size();
+    }
+
+private:
+    std::vector<uint8_t>& m_output;  //!< Output buffer
+    size_t m_size{0};                //!< Number of bytes written to output buffer
+    uint64_t m_bits{0};              //!< Pending bits
+    int m_count{0};                  //!< Number of pending bits
+};
+
+// Huffman code for an alphabet
+struct HuffmanCode {
+    std::array<uint8_t, c_litLenSymbols> lengths{};  //!< Code length per symbol
+    std::array<uint16_t, c_litLenSymbols> codes{};   //!< Bit reversed code per symbol
+
+    void write(BitWriter& writer, int symbol) const { writer.write(codes[symbol], lengths[symbol]); }
+};
+
+// Build length limited Huffman code for given symbol frequencies. Always produces a complete code,
+// because inflate implementations reject incomplete code length codes.
+void buildHuffmanCode(const uint32_t* freqs, int symbolCount, int maxLength, HuffmanCode& code)
+{
+    std::fill(code.lengths.begin(), code.lengths.end(), static_cast<uint8_t>(0));
+
+    // Used symbols sorted by increasing frequency
+    std::array<std::pair<uint32_t, int>, c_litLenSymbols> symbols;
+    size_t n = 0;
+    for (int i = 0; i < symbolCount; ++i) {
+        if (freqs[i] > 0) {
+            symbols[n++] = {freqs[i], i};
+        }
+    }
+
+    // One or no symbols, add dummy symbols to keep the code complete
+    for (int i = 0; n < 2; ++i) {
+        if (freqs[i] == 0) {
+            symbols[n++] = {0, i};
+        }
+    }
+    std::sort(symbols.begin(), symbols.begin() + n);
+
+    // Build Huffman tree with two queues: sorted leaves and internal nodes that are created in increasing weight order
+    std::array<uint32_t, 2 * c_litLenSymbols> weights{};
+    std::array<uint16_t, 2 * c_litLenSymbols> parents{};
+    for (size_t i = 0; i < n; ++i) {
+        weights[i] = symbols[i].first;
+    }
+    size_t leaf = 0;
+    size_t internal = n;
+    for (size_t node = n; node < 2 * n - 1; ++node) {
+        for (int k = 0; k < 2; ++k) {
+            const size_t child = (leaf < n && (internal >= node || weights[leaf] <= weights[internal])) ? leaf++ : internal++;
+            parents[child] = static_cast<uint16_t>(node);
+            weights[node] += weights[child];
+        }
+    }
+
+    // Node depths, parents always come after their children
+    std::array<uint16_t, 2 * c_litLenSymbols> depths{};
+    std::array<int, c_litLenSymbols + 1> lengthCounts{};
+    int maxDepth = 0;
+    for (size_t i = 2 * n - 2; i-- > 0;) {
+        depths[i] = depths[parents[i]] + 1;
+        if (i < n) {
+            lengthCounts[depths[i]]++;
+            maxDepth = std::max<int>(maxDepth, depths[i]);
+        }
+    }
+
+    // Limit code lengths by moving leaves up the tree (JPEG Annex K.3)
+    for (int i = maxDepth; i > maxLength; --i) {
+        while (lengthCounts[i] > 0) {
+            int j = i - 2;
+            while (lengthCounts[j] == 0) {
+                --j;
+            }
+            lengthCounts[i] -= 2;
+            lengthCounts[i - 1] += 1;
+            lengthCounts[j + 1] += 2;
+            lengthCounts[j] -= 1;
+        }
+    }
+
+    // Assign longest codes to least frequent symbols
+    size_t s = 0;
+    for (int length = std::min(maxDepth, maxLength); length > 0; --length) {
+        for (int i = 0; i < lengthCounts[length]; ++i) {
+            code.lengths[symbols[s++].second] = static_cast<uint8_t>(length);
+        }
+    }
+
+    // Canonical codes, bit reversed for writing least significant bit first
+    std::array<int, c_maxCodeLength + 2> nextCode{};
+    std::array<int, c_maxCodeLength + 1> counts{};
+    for (int i = 0; i < symbolCount; ++i) {
+        counts[code.lengths[i]]++;
+    }
+    counts[0] = 0;
+    for (int length = 1; length <= c_maxCodeLength; ++length) {
+        nextCode[length + 1] = (nextCode[length] + counts[length]) << 1;
+    }
+    for (int i = 0; i < symbolCount; ++i) {
+        const int length = code.lengths[i];
+        if (length > 0) {
+            uint32_t value = nextCode[length]++;
+            uint32_t reversed = 0;
+            for (int b = 0; b < length; ++b) {
+                reversed = (reversed << 1) | (value & 1);
+                value >>= 1;
+            }
+            code.codes[i] = static_cast<uint16_t>(reversed);
+        }
+    }
+}
+
+// Write tokens as a deflate block with dynamic Huffman codes
+void writeBlock(BitWriter& writer, const Token* tokens, size_t tokenCount, bool final)
+{
+    const auto& tables = c_codeTables;
+
+    std::array<uint32_t, c_litLenSymbols> litLenFreqs{};
+    std::array<uint32_t, c_distSymbols> distFreqs{};
+    for (size_t i = 0; i < tokenCount; ++i) {
+        const Token& token = tokens[i];
+        if (token.dist == 0) {
+            litLenFreqs[token.litLen]++;
+        } else {
+            litLenFreqs[257 + tables.lengthCodes[token.litLen]]++;
+            distFreqs[tables.getDistCode(token.dist)]++;
+        }
+    }
+    litLenFreqs[c_endOfBlock] = 1;
+
+    HuffmanCode litLenCode;
+    HuffmanCode distCode;
+    buildHuffmanCode(litLenFreqs.data(), c_litLenSymbols, c_maxCodeLength, litLenCode);
+    buildHuffmanCode(distFreqs.data(), c_distSymbols, c_maxCodeLength, distCode);
+
+    int litLenCount = c_litLenSymbols;
+    while (litLenCount > 257 && litLenCode.lengths[litLenCount - 1] == 0) {
+        --litLenCount;
+    }
+    int distCount = c_distSymbols;
+    while (distCount > 1 && distCode.lengths[distCount - 1] == 0) {
+        --distCount;
+    }
+
+    // Run length encode code lengths of both alphabets as one sequence
+    std::array<uint8_t, c_litLenSymbols + c_distSymbols> lengths;
+    std::copy_n(litLenCode.lengths.begin(), litLenCount, lengths.begin());
+    std::copy_n(distCode.lengths.begin(), distCount, lengths.begin() + litLenCount);
+    const size_t lengthCount = static_cast<size_t>(litLenCount) + distCount;
+
+    struct RunLength {
+        uint8_t symbol;  //!< Code length symbol
+        uint8_t extra;   //!< Extra bits value for repeat symbols
+    };
+    std::array<RunLength, c_litLenSymbols + c_distSymbols> runs;
+    size_t runCount = 0;
+    std::array<uint32_t, c_codeLengthSymbols> codeLengthFreqs{};
+    auto addRun = [&](int symbol, int extra) {
+        runs[runCount++] = {static_cast<uint8_t>(symbol), static_cast<uint8_t>(extra)};
+        codeLengthFreqs[symbol]++;
+    };
+
+    for (size_t i = 0; i < lengthCount;) {
+        const uint8_t length = lengths[i];
+        size_t run = 1;
+        while (i + run < lengthCount && lengths[i + run] == length) {
+            ++run;
+        }
+        i += run;
+
+        if (length == 0) {
+            while (run >= 11) {
+                const size_t count = std::min<size_t>(run, 138);
+                addRun(18, static_cast<int>(count - 11));
+                run -= count;
+            }
+            if (run >= 3) {
+                addRun(17, static_cast<int>(run - 3));
+                run = 0;
+            }
+        } else {
+            addRun(length, 0);
+            --run;
+            while (run >= 3) {
+                const size_t count = std::min<size_t>(run, 6);
+                addRun(16, static_cast<int>(count - 3));
+                run -= count;
+            }
+        }
+        for (; run > 0; --run) {
+            addRun(length, 0);
+        }
+    }
+
+    HuffmanCode codeLengthCode;
+    buildHuffmanCode(codeLengthFreqs.data(), c_codeLengthSymbols, c_maxCodeLengthCodeLength, codeLengthCode);
+    int codeLengthCount = c_codeLengthSymbols;
+    while (codeLengthCount > 4 && codeLengthCode.lengths[c_codeLengthOrder[codeLengthCount - 1]] == 0) {
+        --codeLengthCount;
+    }
+
+    // Block header
+    writer.write(final ? 1 : 0, 1);
+    writer.write(2, 2);  // Dynamic Huffman codes
+    writer.write(litLenCount - 257, 5);
+    writer.write(distCount - 1, 5);
+    writer.write(codeLengthCount - 4, 4);
+    for (int i = 0; i < codeLengthCount; ++i) {
+        writer.write(codeLengthCode.lengths[c_codeLengthOrder[i]], 3);
+    }
+    for (size_t i = 0; i < runCount; ++i) {
+        codeLengthCode.write(writer, runs[i].symbol);
+        switch (runs[i].symbol) {
+            case 16: writer.write(runs[i].extra, 2); break;
+            case 17: writer.write(runs[i].extra, 3); break;
+            case 18: writer.write(runs[i].extra, 7); break;
+        }
+    }
+
+    // Block data
+    for (size_t i = 0; i < tokenCount; ++i) {
+        const Token& token = tokens[i];
+        if (token.dist == 0) {
+            litLenCode.write(writer, token.litLen);
+        } else {
+            const int lengthCode = tables.lengthCodes[token.litLen];
+            litLenCode.write(writer, 257 + lengthCode);
+            writer.write(token.litLen - c_lengthBase[lengthCode], c_lengthExtraBits[lengthCode]);
+
+            const int dCode = tables.getDistCode(token.dist);
+            distCode.write(writer, dCode);
+            writer.write(token.dist - c_distBase[dCode], c_distExtraBits[dCode]);
+        }
+    }
+    litLenCode.write(writer, c_endOfBlock);
+}
+
+// Read 32-bit value from unaligned address
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Read 64-bit value from unaligned address
+uint64_t read64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Find LZ77 matches with a single probe hash table, like fast zlib levels
+void findMatches(const uint8_t* data, size_t size, std::vector<int32_t>& hashTable, std::vector<Token>& tokens)
+{
+    hashTable.assign(size_t(1) << c_hashBits, -1);
+    tokens.clear();
+
+    size_t pos = 0;
+    while (pos + 8 <= size) {
+        const uint32_t sequence = read32(data + pos);
+        const uint32_t hash = (sequence * 2654435761u) >> (32 - c_hashBits);
+        const int32_t candidate = hashTable[hash];
+        hashTable[hash] = static_cast<int32_t>(pos);
+
+        if (candidate >= 0 && pos - static_cast<size_t>(candidate) <= c_windowSize && read32(data + candidate) == sequence) {
+            // Extend match 8 bytes at a time
+            const size_t maxLength = std::min(c_maxMatch, size - pos);
+            size_t length = c_minMatch;
+            while (length + 8 <= maxLength) {
+                uint64_t diff = read64(data + pos + length) ^ read64(data + candidate + length);
+                if (diff != 0) {
+                    while ((diff & 0xff) == 0) {
+                        diff >>= 8;
+                        ++length;
+                    }
+                    break;
+                }
+                length += 8;
+            }
+            if (length + 8 > maxLength) {
+                while (length < maxLength && data[pos + length] == data[candidate + length]) {
+                    ++length;
+                }
+            }
+
+            tokens.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(pos - candidate)});
+
+            // Index the end of the match so that the following data can refer to it
+            const size_t last = pos + length - 1;
+            if (last + 4 <= size) {
+                hashTable[(read32(data + last) * 2654435761u) >> (32 - c_hashBits)] = static_cast<int32_t>(last);
+            }
+            pos += length;
+        } else {
+            tokens.push_back({data[pos], 0});
+            ++pos;
+        }
+    }
+
+    for (; pos < size; ++pos) {
+        tokens.push_back({data[pos], 0});
+    }
+}
+
+// Apply PNG Paeth filter to a row. Previous row is null for the first image row.
+template <int32_t Channels>
+void filterRow(const uint8_t* row, const uint8_t* prevRow, size_t rowBytes, uint8_t* output)
+{
+    if (prevRow == nullptr) {
+        // Paeth predictor degenerates to Sub on the first row
+        for (size_t i = 0; i < rowBytes; ++i) {
+            output[i] = static_cast<uint8_t>(row[i] - (i >= Channels ? row[i - Channels] : 0));
+        }
+        return;
+    }
+
+    for (int32_t i = 0; i < Channels; ++i) {
+        output[i] = static_cast<uint8_t>(row[i] - prevRow[i]);
+    }
+
+    // Branchless predictor selection, so that the compiler can vectorize the loop
+    for (size_t i = Channels; i < rowBytes; ++i) {
+        const int16_t a = row[i - Channels];
+        const int16_t b = prevRow[i];
+        const int16_t c = prevRow[i - Channels];
+        const int16_t pa = static_cast<int16_t>(std::abs(b - c));
+        const int16_t pb = static_cast<int16_t>(std::abs(a - c));
+        const int16_t pc = static_cast<int16_t>(std::abs(a + b - 2 * c));
+        const int16_t bc = pb <= pc ? b : c;
+        const int16_t predictor = (pa <= pb && pa <= pc) ? a : bc;
+        output[i] = static_cast<uint8_t>(row[i] - predictor);
+    }
+}
+
+// Update Adler-32 checksum
+uint32_t updateAdler32(uint32_t adler, const uint8_t* data, size_t size)
+{
+    constexpr uint32_t c_base = 65521;
+    constexpr size_t c_maxRun = 5552;  // Largest run that cannot overflow 32-bit sums
+
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        const size_t run = std::min(size, c_maxRun);
+        for (size_t i = 0; i < run; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= c_base;
+        b %= c_base;
+        data += run;
+        size -= run;
+    }
+    return a | (b << 16);
+}
+
+// Combine Adler-32 checksums of two consecutive data blocks
+uint32_t combineAdler32(uint32_t adler1, uint32_t adler2, size_t size2)
+{
+    constexpr uint32_t c_base = 65521;
+
+    const uint32_t rem = static_cast<uint32_t>(size2 % c_base);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % c_base);
+    sum1 += (adler2 & 0xffff) + c_base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + c_base - rem;
+    if (sum1 >= c_base) sum1 -= c_base;
+    if (sum1 >= c_base) sum1 -= c_base;
+    if (sum2 >= (c_base << 1)) sum2 -= (c_base << 1);
+    if (sum2 >= c_base) sum2 -= c_base;
+    return sum1 | (sum2 << 16);
+}
+
+// Update CRC-32 checksum, without pre or post conditioning
+uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    const auto& table = c_codeTables.crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+// Append big endian 32-bit value
+void append32(std::vector<uint8_t>& output, uint32_t value)
+{
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    output.insert(output.end(), bytes, bytes + 4);
+}
+
+// Returns CRC of PNG chunk with given type and data
+uint32_t getChunkCrc(const char* type, const uint8_t* data, size_t size)
+{
+    return updateCrc32(updateCrc32(0xffffffff, reinterpret_cast<const uint8_t*>(type), 4), data, size) ^ 0xffffffff;
+}
+
+// Append PNG chunk with given type, data and precomputed CRC
+void appendChunk(std::vector<uint8_t>& output, const char* type, const uint8_t* data, size_t size, uint32_t crc)
+{
+    append32(output, static_cast<uint32_t>(size));
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data, data + size);
+    append32(output, crc);
+}
+
+// Append PNG chunk with given type and data
+void appendChunk(std::vector<uint8_t>& output, const char* type, const uint8_t* data, size_t size)
+{
+    appendChunk(output, type, data, size, getChunkCrc(type, data, size));
+}
+
+// Independently compressed band of image rows
+struct Band {
+    std::vector<uint8_t> deflated;  //!< Deflate stream of filtered rows, ends at a byte boundary
+    uint32_t adler{1};              //!< Adler-32 checksum of filtered rows
+    uint32_t crc{0};                //!< CRC of the image data chunk holding the band
+    size_t filteredSize{0};         //!< Size of filtered rows in bytes
+};
+
+}  // namespace
+
+bool encode(const uint8_t* data, int32_t width, int32_t height, int32_t channels, size_t rowStride, std::vector<uint8_t>& output, WorkerPool* workerPool)
+{
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    if (data == nullptr || width <= 0 || height <= 0 || (channels != 1 && channels != 3 && channels != 4) || rowStride < rowBytes) {
+        LOG_ERROR("Invalid PNG image: width=%d, height=%d, channels=%d, rowStride=%zu", width, height, channels, rowStride);
+        return false;
+    }
+
+    // Split image to bands of whole rows
+    const size_t rowsPerBand = std::max<size_t>(1, c_bandSize / (rowBytes + 1));
+    const size_t bandCount = (static_cast<size_t>(height) + rowsPerBand - 1) / rowsPerBand;
+    std::vector<Band> bands(bandCount);
+
+    const std::function<void(size_t)> encodeBand = [&](size_t bandIndex) {
+        const size_t firstRow = bandIndex * rowsPerBand;
+        const size_t rowCount = std::min(rowsPerBand, static_cast<size_t>(height) - firstRow);
+        Band& band = bands[bandIndex];
+
+        // Filter rows, each prefixed with filter type. Rows can refer to the last row of previous band, the
+        // filtered data does not depend on other bands.
+        std::vector<uint8_t> filtered(rowCount * (rowBytes + 1));
+        for (size_t i = 0; i < rowCount; ++i) {
+            const size_t y = firstRow + i;
+            uint8_t* dst = filtered.data() + i * (rowBytes + 1);
+            dst[0] = 4;  // Paeth
+            const uint8_t* prevRow = y > 0 ? data + (y - 1) * rowStride : nullptr;
+            switch (channels) {
+                case 1: filterRow<1>(data + y * rowStride, prevRow, rowBytes, dst + 1); break;
+                case 3: filterRow<3>(data + y * rowStride, prevRow, rowBytes, dst + 1); break;
+                case 4: filterRow<4>(data + y * rowStride, prevRow, rowBytes, dst + 1); break;
+            }
+        }
+        band.filteredSize = filtered.size();
+        band.adler = updateAdler32(1, filtered.data(), filtered.size());
+
+        std::vector<int32_t> hashTable;
+        std::vector<Token> tokens;
+        tokens.reserve(filtered.size());
+        findMatches(filtered.data(), filtered.size(), hashTable, tokens);
+
+        const bool lastBand = bandIndex + 1 == bandCount;
+        band.deflated.reserve(filtered.size() / 2);
+        if (bandIndex == 0) {
+            // Zlib header: deflate with 32K window, fastest compression level
+            band.deflated.push_back(0x78);
+            band.deflated.push_back(0x01);
+        }
+
+        BitWriter writer(band.deflated);
+        for (size_t i = 0; i < tokens.size(); i += c_maxBlockTokens) {
+            const size_t count = std::min(c_maxBlockTokens, tokens.size() - i);
+            writeBlock(writer, tokens.data() + i, count, lastBand && i + count == tokens.size());
+        }
+
+        if (!lastBand) {
+            // Sync flush: empty stored block ends the band at a byte boundary, so the next band can continue the stream
+            writer.write(0, 3);
+            writer.alignToByte();
+            const uint8_t emptyStored[4] = {0x00, 0x00, 0xff, 0xff};
+            band.deflated.insert(band.deflated.end(), emptyStored, emptyStored + 4);
+        } else {
+            writer.alignToByte();
+        }
+
+        band.crc = getChunkCrc("IDAT", band.deflated.data(), band.deflated.size());
+    };
+
+    if (workerPool) {
+        workerPool->parallelFor(bandCount, encodeBand);
+    } else {
+        for (size_t i = 0; i < bandCount; ++i) {
+            encodeBand(i);
+        }
+    }
+
+    // Signature and header
+    size_t outputSize = 8 + 25 + 12 + 4 + 12;
+    for (const auto& band : bands) {
+        outputSize += band.deflated.size() + 12;
+    }
+    output.clear();
+    output.reserve(outputSize);
+
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    output.insert(output.end(), signature, signature + 8);
+
+    const uint8_t colorTypes[5] = {0, 0, 0, 2, 6};  // Gray, RGB or RGBA
+    std::vector<uint8_t> header;
+    append32(header, static_cast<uint32_t>(width));
+    append32(header, static_cast<uint32_t>(height));
+    header.push_back(8);                     // Bit depth
+    header.push_back(colorTypes[channels]);  // Color type
+    header.push_back(0);                     // Deflate compression
+    header.push_back(0);                     // Adaptive filtering
+    header.push_back(0);                     // No interlace
+    appendChunk(output, "IHDR", header.data(), header.size());
+
+    // Image data: each band in its own chunk, followed by zlib checksum of all bands
+    uint32_t adler = 1;
+    for (const auto& band : bands) {
+        appendChunk(output, "IDAT", band.deflated.data(), band.deflated.size(), band.crc);
+        adler = combineAdler32(adler, band.adler, band.filteredSize);
+    }
+    std::vector<uint8_t> checksum;
+    append32(checksum, adler);
+    appendChunk(output, "IDAT", checksum.data(), checksum.size());
+
+    appendChunk(output, "IEND", nullptr, 0);
+    return true;
+}
+
+}  // namespace PngEncoder
+}  // namespace VarjoExamples
@@ -0,0 +1,28 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VarjoExamples
+{
+class WorkerPool;
+
+// Fast lossless PNG encoder for snapshot images.
+//
+// The image is split into horizontal bands that are filtered and deflated independently, so
+// bands can be encoded in parallel. Each band is terminated with a sync flush and stored in its
+// own IDAT chunk, so the bands form a single valid zlib stream without recompression. Compression
+// uses single probe LZ77 matching with dynamic Huffman codes, which trades some compression
+// ratio for speed, similar to zlib level 1.
+namespace PngEncoder
+{
+//! Encode 8-bit image with 1 (gray), 3 (RGB) or 4 (RGBA) channels. Rows are read with given stride.
+//! Bands are encoded using given worker pool if available. Returns false on invalid parameters.
+bool encode(const uint8_t* data, int32_t width, int32_t height, int32_t channels, size_t rowStride, std::vector<uint8_t>& output,
+    WorkerPool* workerPool = nullptr);
+
+}  // namespace PngEncoder
+}  // namespace VarjoExamples
@@ -0,0 +1,192 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "Rectifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ColorConversion.hpp"
+#include "Undistorter.hpp"
+
+namespace VarjoExamples
+{
+namespace
+{
+// Output tile size in pixels. A tile of table entries and RGBA output is 24kB and maps to a
+// compact source region, so each tile stays in L1/L2 cache while processed.
+constexpr int c_tileWidth = 64;
+constexpr int c_tileHeight = 32;
+
+// Distorted NV12 source planes
+struct Source {
+    const uint8_t* y;   // Start of Y plane
+    const uint8_t* uv;  // Start of interleaved UV plane
+    size_t rowStride;   // Row stride of both planes
+    int32_t width;      // Y plane width
+    int32_t height;     // Y plane height
+    int32_t uvWidth;    // UV plane width in UV pairs
+    int32_t uvHeight;   // UV plane height
+};
+
+// Output tile rectangle
+struct Tile {
+    int32_t x0, y0;  // Top left corner, inclusive
+    int32_t x1, y1;  // Bottom right corner, exclusive
+};
+
+// Bilinear interpolation of four texels with 8-bit weights
+inline uint8_t bilerp(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11, uint32_t wx, uint32_t wy)
+{
+    const uint32_t top = t00 * (256 - wx) + t10 * wx;
+    const uint32_t bottom = t01 * (256 - wx) + t11 * wx;
+    return static_cast<uint8_t>((top * (256 - wy) + bottom * wy + 32768) >> 16);
+}
+
+// Sample Y plane at given 16.16 fixed point position
+inline uint8_t sampleY(const Source& src, int32_t fx, int32_t fy)
+{
+    const int32_t x0 = fx >> 16;
+    const int32_t y0 = fy >> 16;
+    const int32_t x1 = std::min(x0 + 1, src.width - 1);
+    const int32_t y1 = std::min(y0 + 1, src.height - 1);
+    const uint8_t* row0 = src.y + y0 * src.rowStride;
+    const uint8_t* row1 = src.y + y1 * src.rowStride;
+    return bilerp(row0[x0], row0[x1], row1[x0], row1[x1], (fx >> 8) & 0xff, (fy >> 8) & 0xff);
+}
+
+// Sample UV plane at given 16.16 fixed point Y plane position
+inline void sampleUV(const Source& src, int32_t fx, int32_t fy, uint8_t& U, uint8_t& V)
+{
+    // Chroma samples are centered between 2x2 luma samples: uv = (y + 0.5) / 2 - 0.5
+    const int32_t cx = std::max((fx >> 1) - 0x4000, 0);
+    const int32_t cy = std::max((fy >> 1) - 0x4000, 0);
+    const int32_t x0 = cx >> 16;
+    const int32_t y0 = cy >> 16;
+    const int32_t x1 = std::min(x0 + 1, src.uvWidth - 1);
+    const int32_t y1 = std::min(y0 + 1, src.uvHeight - 1);
+    const uint32_t wx = (cx >> 8) & 0xff;
+    const uint32_t wy = (cy >> 8) & 0xff;
+    const uint8_t* row0 = src.uv + y0 * src.rowStride;
+    const uint8_t* row1 = src.uv + y1 * src.rowStride;
+    U = bilerp(row0[x0 * 2], row0[x1 * 2], row1[x0 * 2], row1[x1 * 2], wx, wy);
+    V = bilerp(row0[x0 * 2 + 1], row0[x1 * 2 + 1], row1[x0 * 2 + 1], row1[x1 * 2 + 1], wx, wy);
+}
+
+// Rectify one output tile. Templated on format to keep the per pixel loop free of branches.
+template <Rectifier::OutputFormat Format>
+void rectifyTile(const Source& src, const Undistorter::FixedPointSample* samples, int32_t outputWidth, const Tile& tile, uint8_t* output,
+    size_t outputRowStride)
+{
+    constexpr size_t c_bytesPerPixel = Format == Rectifier::OutputFormat::RGBA8 ? 4 : (Format == Rectifier::OutputFormat::RGB8 ? 3 : 1);
+
+    for (int32_t y = tile.y0; y < tile.y1; ++y) {
+        const Undistorter::FixedPointSample* rowSamples = samples + static_cast<size_t>(y) * outputWidth;
+        uint8_t* dst = output + y * outputRowStride + tile.x0 * c_bytesPerPixel;
+
+        for (int32_t x = tile.x0; x < tile.x1; ++x, dst += c_bytesPerPixel) {
+            const Undistorter::FixedPointSample& sample = rowSamples[x];
+
+            // Write black for samples outside the source buffer
+            if (sample.x == Undistorter::c_invalidFixedPointSample) {
+                dst[0] = 0;
+                if constexpr (Format != Rectifier::OutputFormat::Y8) {
+                    dst[1] = 0;
+                    dst[2] = 0;
+                }
+                if constexpr (Format == Rectifier::OutputFormat::RGBA8) {
+                    dst[3] = 255;
+                }
+                continue;
+            }
+
+            const uint8_t Y = sampleY(src, sample.x, sample.y);
+
+            if constexpr (Format == Rectifier::OutputFormat::Y8) {
+                dst[0] = Y;
+            } else {
+                uint8_t U, V;
+                sampleUV(src, sample.x, sample.y, U, V);
+                ColorConversion::convertYUVtoRGB(Y, U, V, dst[0], dst[1], dst[2]);
+                if constexpr (Format == Rectifier::OutputFormat::RGBA8) {
+                    dst[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+size_t Rectifier::getBytesPerPixel(OutputFormat format)
+{
+    switch (format) {
+        case OutputFormat::RGBA8: return 4;
+        case OutputFormat::RGB8: return 3;
+        case OutputFormat::Y8: return 1;
+        default: assert(false); return 0;
+    }
+}
+
+Rectifier::Rectifier(size_t threadCount)
+    : m_workerPool(threadCount)
+{
+}
+
+bool Rectifier::rectify(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output, size_t outputRowStride,
+    OutputFormat format, const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, std::optional<const varjo_Matrix> projection)
+{
+    if (!(buffer.format == varjo_TextureFormat_NV12)) {
+        CRITICAL("Unsupported pixel format: %d", static_cast<int>(buffer.format));
+        return false;
+    }
+
+    // Get cached remap table, built only when parameters change
+    const glm::ivec2 inputSize(buffer.width, buffer.height);
+    const auto table = m_remapCache.getTable(
+        RemapCache::Key::create(inputSize, outputSize, intrinsics, extrinsics, projection, RemapCache::SampleFormat::FixedPoint));
+
+    return rectify(buffer, input, *table, output, outputRowStride, format);
+}
+
+bool Rectifier::rectify(
+    const varjo_BufferMetadata& buffer, const uint8_t* input, const RemapCache::Table& table, uint8_t* output, size_t outputRowStride, OutputFormat format)
+{
+    if (!(buffer.format == varjo_TextureFormat_NV12)) {
+        CRITICAL("Unsupported pixel format: %d", static_cast<int>(buffer.format));
+        return false;
+    }
+
+    if (table.key.sampleFormat != RemapCache::SampleFormat::FixedPoint || table.key.inputSize != glm::ivec2(buffer.width, buffer.height)) {
+        LOG_ERROR("Remap table does not match input buffer.");
+        return false;
+    }
+
+    const glm::ivec2 outputSize = table.key.outputSize;
+    if (outputRowStride == 0) {
+        outputRowStride = outputSize.x * getBytesPerPixel(format);
+    }
+
+    // UV plane follows Y plane and has half vertical resolution
+    const size_t inputRowStride = buffer.rowStride;
+    const Source src{input, input + inputRowStride * buffer.height, inputRowStride, buffer.width, buffer.height, buffer.width / 2, buffer.height / 2};
+
+    const int32_t tilesX = (outputSize.x + c_tileWidth - 1) / c_tileWidth;
+    const int32_t tilesY = (outputSize.y + c_tileHeight - 1) / c_tileHeight;
+    const Undistorter::FixedPointSample* samples = table.fixedPointSamples.data();
+
+    m_workerPool.parallelFor(static_cast<size_t>(tilesX) * tilesY, [&](size_t index) {
+        const int32_t tx = static_cast<int32_t>(index % tilesX);
+        const int32_t ty = static_cast<int32_t>(index / tilesX);
+        const Tile tile{tx * c_tileWidth, ty * c_tileHeight, std::min((tx + 1) * c_tileWidth, outputSize.x), std::min((ty + 1) * c_tileHeight, outputSize.y)};
+
+        switch (format) {
+            case OutputFormat::RGBA8: rectifyTile<OutputFormat::RGBA8>(src, samples, outputSize.x, tile, output, outputRowStride); break;
+            case OutputFormat::RGB8: rectifyTile<OutputFormat::RGB8>(src, samples, outputSize.x, tile, output, outputRowStride); break;
+            case OutputFormat::Y8: rectifyTile<OutputFormat::Y8>(src, samples, outputSize.x, tile, output, outputRowStride); break;
+        }
+    });
+
+    return true;
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,63 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <optional>
+
+#include <Varjo_types_datastream.h>
+
+#include "Globals.hpp"
+#include "RemapCache.hpp"
+#include "WorkerPool.hpp"
+
+namespace VarjoExamples
+{
+//! Bilinear rectification engine for distorted NV12 camera buffers.
+//!
+//! Sample positions come from cached 16.16 fixed point remap tables, so per frame work is only
+//! the filtered gather and color conversion. Output is split into tiles small enough to keep
+//! their source region and table rows in cache, and tiles are processed in parallel on a
+//! worker pool.
+class Rectifier
+{
+public:
+    //! Rectified output format
+    enum class OutputFormat {
+        RGBA8 = 0,  //!< 8-bit RGBA, alpha set to 255
+        RGB8,       //!< 8-bit RGB
+        Y8,         //!< 8-bit luminance, Y plane values as is
+    };
+
+    //! Returns bytes per pixel for given output format
+    static size_t getBytesPerPixel(OutputFormat format);
+
+    //! Construct rectifier with given number of worker threads
+    explicit Rectifier(size_t threadCount = WorkerPool::getDefaultThreadCount());
+
+    // Disable copy, move and assign
+    Rectifier(const Rectifier& other) = delete;
+    Rectifier(const Rectifier&& other) = delete;
+    Rectifier& operator=(const Rectifier& other) = delete;
+    Rectifier& operator=(const Rectifier&& other) = delete;
+
+    //! Rectify distorted NV12 input buffer to given output format using bilinear filtering.
+    //! Output row stride of zero means tightly packed rows.
+    bool rectify(const varjo_BufferMetadata& buffer, const uint8_t* input, const glm::ivec2& outputSize, uint8_t* output, size_t outputRowStride,
+        OutputFormat format, const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, std::optional<const varjo_Matrix> projection);
+
+    //! Rectify distorted NV12 input buffer using given fixed point remap table. Output size is taken from the table key.
+    bool rectify(const varjo_BufferMetadata& buffer, const uint8_t* input, const RemapCache::Table& table, uint8_t* output, size_t outputRowStride,
+        OutputFormat format);
+
+    //! Returns remap table cache used by the rectifier
+    RemapCache& getRemapCache() { return m_remapCache; }
+
+    //! Returns number of worker threads
+    size_t getThreadCount() const { return m_workerPool.getThreadCount(); }
+
+private:
+    WorkerPool m_workerPool;  //!< Worker pool for processing output tiles
+    RemapCache m_remapCache;  //!< Cached fixed point remap tables
+};
+
+}  // namespace VarjoExamples
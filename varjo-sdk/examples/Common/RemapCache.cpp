@@ -0,0 +1,149 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "RemapCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace VarjoExamples
+{
+namespace
+{
+// Compare intrinsics values. Struct is compared per field to avoid comparing padding.
+bool equals(const varjo_CameraIntrinsics& a, const varjo_CameraIntrinsics& b)
+{
+    return a.model == b.model && a.principalPointX == b.principalPointX && a.principalPointY == b.principalPointY && a.focalLengthX == b.focalLengthX &&
+           a.focalLengthY == b.focalLengthY && std::memcmp(a.distortionCoefficients, b.distortionCoefficients, sizeof(a.distortionCoefficients)) == 0;
+}
+
+// Compare matrix values
+bool equals(const varjo_Matrix& a, const varjo_Matrix& b) { return std::memcmp(a.value, b.value, sizeof(a.value)) == 0; }
+
+}  // namespace
+
+RemapCache::Key RemapCache::Key::create(const glm::ivec2& inputSize, const glm::ivec2& outputSize, const varjo_CameraIntrinsics& intrinsics,
+    const varjo_Matrix& extrinsics, std::optional<const varjo_Matrix> projection, SampleFormat sampleFormat)
+{
+    Key key;
+    key.sampleFormat = sampleFormat;
+    key.inputSize = inputSize;
+    key.outputSize = outputSize;
+    key.intrinsics = intrinsics;
+    // Camera position is not needed for rectification, so changes in it don't invalidate the table
+    key.extrinsicsRotation = glm::mat3x3(fromVarjoMatrix(extrinsics));
+    if (projection.has_value()) {
+        key.projection = projection.value();
+    }
+    return key;
+}
+
+bool RemapCache::Key::operator==(const Key& other) const
+{
+    if (sampleFormat != other.sampleFormat || inputSize != other.inputSize || outputSize != other.outputSize || extrinsicsRotation != other.extrinsicsRotation ||
+        projection.has_value() != other.projection.has_value()) {
+        return false;
+    }
+
+    if (projection.has_value() && !equals(projection.value(), other.projection.value())) {
+        return false;
+    }
+
+    return equals(intrinsics, other.intrinsics);
+}
+
+RemapCache::RemapCache(size_t memoryLimit)
+    : m_memoryLimit(memoryLimit)
+{
+}
+
+std::shared_ptr<const RemapCache::Table> RemapCache::getTable(const Key& key)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = std::find_if(m_tables.begin(), m_tables.end(), [&key](const std::shared_ptr<const Table>& table) { return table->key == key; });
+        if (it != m_tables.end()) {
+            // Move to front as most recently used
+            m_tables.splice(m_tables.begin(), m_tables, it);
+            m_stats.hits++;
+            return m_tables.front();
+        }
+
+        m_stats.misses++;
+    }
+
+    // Build the table without holding the lock, this runs the camera model for every output pixel
+    LOG_DEBUG("Building remap table: input=%dx%d, output=%dx%d", key.inputSize.x, key.inputSize.y, key.outputSize.x, key.outputSize.y);
+    auto table = std::make_shared<Table>();
+    table->key = key;
+    {
+        const std::optional<const varjo_Matrix> projection = key.projection;
+        const Undistorter undistorter(key.inputSize, key.outputSize, key.intrinsics, toVarjoMatrix(glm::mat4x4(key.extrinsicsRotation)), projection);
+        switch (key.sampleFormat) {
+            case SampleFormat::Packed: table->samples = undistorter.buildRemapTable(); break;
+            case SampleFormat::FixedPoint: table->fixedPointSamples = undistorter.buildFixedPointRemapTable(); break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Don't cache tables that would not fit in the cache at all
+    if (table->byteSize() > m_memoryLimit) {
+        LOG_WARNING("Remap table exceeds cache memory limit: size=%zu, limit=%zu", table->byteSize(), m_memoryLimit);
+        return table;
+    }
+
+    // Another thread might have built the same table meanwhile, replace it with ours
+    m_tables.remove_if([&key](const std::shared_ptr<const Table>& cached) { return cached->key == key; });
+    m_tables.emplace_front(table);
+    evict();
+
+    return table;
+}
+
+void RemapCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tables.clear();
+}
+
+void RemapCache::setMemoryLimit(size_t memoryLimit)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memoryLimit = memoryLimit;
+    evict();
+}
+
+size_t RemapCache::getMemoryLimit() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memoryLimit;
+}
+
+RemapCache::Stats RemapCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats = m_stats;
+    stats.tableCount = m_tables.size();
+    for (const auto& table : m_tables) {
+        stats.memoryUsage += table->byteSize();
+    }
+    return stats;
+}
+
+void RemapCache::evict()
+{
+    size_t memoryUsage = 0;
+    for (const auto& table : m_tables) {
+        memoryUsage += table->byteSize();
+    }
+
+    while (memoryUsage > m_memoryLimit && !m_tables.empty()) {
+        memoryUsage -= m_tables.back()->byteSize();
+        m_tables.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,108 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <Varjo_types_datastream.h>
+
+#include "Globals.hpp"
+#include "Undistorter.hpp"
+
+namespace VarjoExamples
+{
+//! Thread safe cache for precomputed undistortion remap tables.
+//!
+//! Building a remap table runs the full camera model for every output pixel, but the inputs
+//! (intrinsics, extrinsics rotation, projection and buffer sizes) rarely change. Tables are
+//! cached by these parameters, so per frame rectification becomes a plain gather. A change in
+//! calibration produces a new key, and least recently used tables are evicted when the memory
+//! limit is exceeded.
+class RemapCache
+{
+public:
+    //! Remap table sample format
+    enum class SampleFormat {
+        Packed = 0,  //!< Nearest neighbor samples, see Undistorter::buildRemapTable()
+        FixedPoint,  //!< Bilinear samples, see Undistorter::buildFixedPointRemapTable()
+    };
+
+    //! Remap table parameters
+    struct Key {
+        SampleFormat sampleFormat{SampleFormat::Packed};  //!< Sample format of the table
+        glm::ivec2 inputSize{0, 0};                       //!< Input buffer size
+        glm::ivec2 outputSize{0, 0};                      //!< Output buffer size
+        varjo_CameraIntrinsics intrinsics{};              //!< Camera intrinsics
+        glm::mat3x3 extrinsicsRotation{1.0f};             //!< Rotation part of camera extrinsics
+        std::optional<varjo_Matrix> projection{};         //!< Optional projection for rectified image
+
+        //! Construct key from undistortion parameters
+        static Key create(const glm::ivec2& inputSize, const glm::ivec2& outputSize, const varjo_CameraIntrinsics& intrinsics,
+            const varjo_Matrix& extrinsics, std::optional<const varjo_Matrix> projection, SampleFormat sampleFormat = SampleFormat::Packed);
+
+        //! Compare keys
+        bool operator==(const Key& other) const;
+    };
+
+    //! Remap table in output row order. Only the samples matching key sample format are filled.
+    struct Table {
+        Key key;                                                       //!< Parameters the table was built with
+        std::vector<uint32_t> samples;                                 //!< Packed sample coordinates
+        std::vector<Undistorter::FixedPointSample> fixedPointSamples;  //!< Fixed point sample coordinates
+
+        //! Memory used by table samples
+        size_t byteSize() const { return samples.size() * sizeof(uint32_t) + fixedPointSamples.size() * sizeof(Undistorter::FixedPointSample); }
+    };
+
+    //! Cache statistics
+    struct Stats {
+        uint64_t hits{0};       //!< Number of lookups served from the cache
+        uint64_t misses{0};     //!< Number of tables built
+        uint64_t evictions{0};  //!< Number of tables evicted due to memory limit
+        size_t tableCount{0};   //!< Number of cached tables
+        size_t memoryUsage{0};  //!< Memory used by cached tables in bytes
+    };
+
+    //! Default memory limit for cached tables
+    static constexpr size_t c_defaultMemoryLimit = 64 * 1024 * 1024;
+
+    //! Construct cache with given memory limit in bytes
+    explicit RemapCache(size_t memoryLimit = c_defaultMemoryLimit);
+
+    // Disable copy, move and assign
+    RemapCache(const RemapCache& other) = delete;
+    RemapCache(const RemapCache&& other) = delete;
+    RemapCache& operator=(const RemapCache& other) = delete;
+    RemapCache& operator=(const RemapCache&& other) = delete;
+
+    //! Get remap table for given parameters. Builds and caches the table if not found.
+    //! Returned table stays valid even if it gets evicted from the cache.
+    std::shared_ptr<const Table> getTable(const Key& key);
+
+    //! Invalidate all cached tables, e.g. when camera calibration has changed
+    void clear();
+
+    //! Set memory limit in bytes. Evicts tables if needed.
+    void setMemoryLimit(size_t memoryLimit);
+
+    //! Returns memory limit in bytes
+    size_t getMemoryLimit() const;
+
+    //! Returns cache statistics
+    Stats getStats() const;
+
+private:
+    //! Evict least recently used tables until memory usage is within limit. Mutex must be held.
+    void evict();
+
+    mutable std::mutex m_mutex;                        //!< Mutex for cache data
+    std::list<std::shared_ptr<const Table>> m_tables;  //!< Cached tables, most recently used first
+    size_t m_memoryLimit{0};                           //!< Memory limit in bytes
+    Stats m_stats{};                                   //!< Cache statistics
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,490 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "ReplayDataStream.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VarjoExamples
+{
+namespace
+{
+// Channel flags for channel indices
+const varjo_ChannelFlag c_channelFlags[] = {varjo_ChannelFlag_First, varjo_ChannelFlag_Second};
+
+// Value copied buffers are overwritten with when their stream stops
+constexpr uint8_t c_freedBufferValue = 0xdd;
+
+// Bits reserved for buffer index in buffer IDs
+constexpr int64_t c_bufferIndexBits = 16;
+
+// Returns buffer ID for given stream channel buffer
+varjo_BufferId makeBufferId(varjo_StreamId streamId, varjo_ChannelIndex channelIndex, size_t bufferIndex)
+{
+    return ((streamId * 2 + channelIndex) << c_bufferIndexBits) | static_cast<int64_t>(bufferIndex);
+}
+
+// Set timestamp in type specific frame metadata
+void setFrameTimestamp(varjo_StreamFrame& frame, varjo_Nanoseconds timestamp)
+{
+    switch (frame.type) {
+        case varjo_StreamType_DistortedColor: frame.metadata.distortedColor.timestamp = timestamp; break;
+        case varjo_StreamType_EnvironmentCubemap: frame.metadata.environmentCubemap.timestamp = timestamp; break;
+        case varjo_StreamType_EyeCamera: frame.metadata.eyeCamera.timestamp = timestamp; break;
+        default: break;
+    }
+}
+
+}  // namespace
+
+ReplayDataStream::ReplayDataStream() = default;
+
+ReplayDataStream::~ReplayDataStream()
+{
+    for (const auto& stream : m_streams) {
+        stopDataStream(stream->config.streamId);
+    }
+}
+
+bool ReplayDataStream::open(const std::string& filename) { return open(filename, Options()); }
+
+bool ReplayDataStream::open(const std::string& filename, const Options& options)
+{
+    if (!m_streams.empty()) {
+        LOG_ERROR("Replay already open.");
+        return false;
+    }
+
+    if (!m_recording.open(filename)) {
+        return false;
+    }
+
+    m_options = options;
+    m_options.bufferCount = std::max(m_options.bufferCount, 1);
+
+    // Group index entries to frames per stream type. Channels of a frame are recorded one after another.
+    const auto& index = m_recording.getIndex();
+    for (size_t i = 0; i < index.size(); i++) {
+        const auto& entry = index[i];
+        if (entry.channelIndex < 0 || entry.channelIndex > 1) {
+            LOG_WARNING("Ignoring recorded frame with invalid channel: %lld", entry.channelIndex);
+            continue;
+        }
+
+        auto it = std::find_if(m_streams.begin(), m_streams.end(), [&](const auto& stream) { return stream->config.streamType == entry.streamType; });
+        if (it == m_streams.end()) {
+            auto stream = std::make_unique<Stream>();
+            stream->config.streamId = static_cast<varjo_StreamId>(m_streams.size());
+            stream->config.streamType = entry.streamType;
+            stream->config.bufferType = varjo_BufferType_CPU;
+            stream->config.format = varjo_TextureFormat_INVALID;
+            stream->config.streamTransform = {{1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0}};
+            m_streams.push_back(std::move(stream));
+            it = m_streams.end() - 1;
+        }
+
+        Stream& stream = **it;
+        if (stream.frames.empty() || stream.frames.back().frameNumber != entry.frameNumber || stream.frames.back().entries[entry.channelIndex] >= 0) {
+            FrameGroup group;
+            group.frameNumber = entry.frameNumber;
+            group.timestamp = entry.timestamp;
+            stream.frames.push_back(group);
+        }
+        stream.frames.back().entries[entry.channelIndex] = static_cast<int64_t>(i);
+
+        // Buffer layout from first frame with data
+        const auto& bufferMetadata = m_recording.getFrame(i)->metadata->bufferMetadata;
+        if (entry.payloadSize > 0 && stream.config.format == varjo_TextureFormat_INVALID) {
+            stream.config.format = bufferMetadata.format;
+            stream.config.width = bufferMetadata.width;
+            stream.config.height = bufferMetadata.height;
+            stream.config.rowStride = bufferMetadata.rowStride;
+        }
+        if (entry.payloadSize > 0) {
+            stream.config.channelFlags |= c_channelFlags[entry.channelIndex];
+        }
+    }
+
+    m_startTimestamp = index.empty() ? 0 : index.front().timestamp;
+    for (auto& stream : m_streams) {
+        // Frame rate from average frame interval
+        const auto& frames = stream->frames;
+        m_startTimestamp = std::min(m_startTimestamp, frames.front().timestamp);
+        if (frames.size() > 1 && frames.back().timestamp > frames.front().timestamp) {
+            const double interval = static_cast<double>(frames.back().timestamp - frames.front().timestamp) / (frames.size() - 1);
+            stream->config.frameRate = static_cast<int32_t>(std::lround(1e9 / interval));
+        }
+
+        for (auto& buffers : stream->buffers) {
+            buffers.resize(static_cast<size_t>(m_options.bufferCount));
+        }
+
+        LOG_INFO("Replay stream: id=%lld, type=%lld, format=%lld, channels=%lld, fps=%d, w=%d, h=%d, frames=%zu", stream->config.streamId,
+            stream->config.streamType, stream->config.format, stream->config.channelFlags, stream->config.frameRate, stream->config.width,
+            stream->config.height, frames.size());
+    }
+
+    return true;
+}
+
+bool ReplayDataStream::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::all_of(m_streams.begin(), m_streams.end(), [](const auto& stream) { return !stream->running || stream->finished; });
+}
+
+void ReplayDataStream::waitUntilFinished() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() {
+        return std::all_of(m_streams.begin(), m_streams.end(), [](const auto& stream) { return !stream->running || stream->finished; });
+    });
+}
+
+ReplayDataStream::Stats ReplayDataStream::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+int32_t ReplayDataStream::getDataStreamConfigCount() const { return static_cast<int32_t>(m_streams.size()); }
+
+void ReplayDataStream::getDataStreamConfigs(varjo_StreamConfig* configs, int32_t maxSize) const
+{
+    const size_t count = std::min(m_streams.size(), static_cast<size_t>(std::max(maxSize, 0)));
+    for (size_t i = 0; i < count; i++) {
+        configs[i] = m_streams[i]->config;
+    }
+}
+
+void ReplayDataStream::startDataStream(varjo_StreamId id, varjo_ChannelFlag channels, varjo_FrameListener* callback, void* userData)
+{
+    Stream* stream = findStream(id);
+    if (!stream || !callback) {
+        LOG_ERROR("Replay: Invalid stream start: id=%lld", id);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (stream->running) {
+        LOG_ERROR("Replay: Stream already running: id=%lld", id);
+        return;
+    }
+
+    // Replay timeline starts with the first stream
+    if (!m_started) {
+        m_startTime = std::chrono::steady_clock::now();
+        m_started = true;
+    }
+
+    freeBuffers(*stream);
+    stream->channels = channels & stream->config.channelFlags;
+    stream->callback = callback;
+    stream->userData = userData;
+    stream->running = true;
+    stream->finished = false;
+    stream->thread = std::thread(&ReplayDataStream::streamMain, this, std::ref(*stream));
+}
+
+void ReplayDataStream::stopDataStream(varjo_StreamId id)
+{
+    Stream* stream = findStream(id);
+    if (!stream) {
+        LOG_ERROR("Replay: Invalid stream stop: id=%lld", id);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stream->running = false;
+
+        // Overwrite copied buffers before waiting for the stream thread, so that data read by a frame listener
+        // that is still running or by anyone keeping buffer pointers after stopping shows up as corrupted
+        if (m_options.copyBuffers) {
+            for (auto& buffers : stream->buffers) {
+                for (auto& buffer : buffers) {
+                    std::fill(buffer.data.begin(), buffer.data.end(), c_freedBufferValue);
+                }
+            }
+        }
+    }
+    m_condition.notify_all();
+
+    if (stream->thread.joinable()) {
+        stream->thread.join();
+    }
+
+    // Buffers are freed when the stream stops, like in the runtime
+    std::lock_guard<std::mutex> lock(m_mutex);
+    freeBuffers(*stream);
+}
+
+varjo_CameraIntrinsics ReplayDataStream::getCameraIntrinsics(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Buffer* buffer = findFrameBuffer(id, frameNumber, index);
+    return buffer ? m_recording.getFrame(static_cast<size_t>(buffer->entry))->metadata->intrinsics : varjo_CameraIntrinsics{};
+}
+
+varjo_Matrix ReplayDataStream::getCameraExtrinsics(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Buffer* buffer = findFrameBuffer(id, frameNumber, index);
+    return buffer ? m_recording.getFrame(static_cast<size_t>(buffer->entry))->metadata->extrinsics : varjo_Matrix{};
+}
+
+varjo_BufferId ReplayDataStream::getBufferId(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Buffer* buffer = findFrameBuffer(id, frameNumber, index);
+    if (!buffer || m_recording.getIndex()[static_cast<size_t>(buffer->entry)].payloadSize == 0) {
+        return varjo_InvalidId;
+    }
+
+    const auto& buffers = m_streams[static_cast<size_t>(id)]->buffers[static_cast<size_t>(index)];
+    return makeBufferId(id, index, static_cast<size_t>(buffer - buffers.data()));
+}
+
+void ReplayDataStream::lockDataStreamBuffer(varjo_BufferId id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Buffer* buffer = findBuffer(id);
+    if (!buffer) {
+        LOG_ERROR("Replay: Invalid buffer lock: id=%lld", id);
+        m_stats.invalidBufferIds++;
+        return;
+    }
+    buffer->locked = true;
+}
+
+void ReplayDataStream::unlockDataStreamBuffer(varjo_BufferId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Buffer* buffer = findBuffer(id);
+        if (!buffer) {
+            LOG_ERROR("Replay: Invalid buffer unlock: id=%lld", id);
+            m_stats.invalidBufferIds++;
+            return;
+        }
+        buffer->locked = false;
+    }
+
+    // Stream threads replaying as fast as possible wait for free buffers
+    m_condition.notify_all();
+}
+
+varjo_BufferMetadata ReplayDataStream::getBufferMetadata(varjo_BufferId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Buffer* buffer = findBuffer(id);
+    return buffer ? m_recording.getFrame(static_cast<size_t>(buffer->entry))->metadata->bufferMetadata : varjo_BufferMetadata{};
+}
+
+void* ReplayDataStream::getBufferCPUData(varjo_BufferId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Buffer* buffer = findBuffer(id);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    // Recording is mapped read only, the runtime API just does not express it
+    return m_options.copyBuffers ? buffer->data.data() : const_cast<uint8_t*>(m_recording.getFrame(static_cast<size_t>(buffer->entry))->data);
+}
+
+varjo_Nanoseconds ReplayDataStream::getCurrentTime() const
+{
+    // Replaying as fast as possible has no wall clock relation, time advances with delivered frames
+    if (m_options.speed <= 0.0) {
+        return m_latestTimestamp;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_started) {
+        return m_startTimestamp;
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_startTime).count();
+    return m_startTimestamp + static_cast<varjo_Nanoseconds>(elapsed * m_options.speed);
+}
+
+void ReplayDataStream::streamMain(Stream& stream)
+{
+    const auto& frames = stream.frames;
+    const bool realTime = m_options.speed > 0.0;
+
+    // Looped frames continue frame numbers and timestamps after the last frame
+    const int64_t frameSpan = frames.back().frameNumber - frames.front().frameNumber + 1;
+    const varjo_Nanoseconds frameInterval =
+        frames.size() > 1 ? (frames.back().timestamp - frames.front().timestamp) / static_cast<varjo_Nanoseconds>(frames.size() - 1) : 0;
+    const varjo_Nanoseconds timeSpan = frames.back().timestamp - frames.front().timestamp + frameInterval;
+
+    // A stream started late in real time replay begins from the current frame, like a live stream
+    size_t pos = 0;
+    if (realTime) {
+        const varjo_Nanoseconds now = getCurrentTime();
+        while (pos < frames.size() && frames[pos].timestamp < now) {
+            pos++;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.skippedFrames += pos;
+    }
+
+    int64_t loopCount = 0;
+    while (true) {
+        if (pos == frames.size()) {
+            if (!m_options.loop) {
+                break;
+            }
+            pos = 0;
+            loopCount++;
+        }
+
+        const FrameGroup& group = frames[pos++];
+        const int64_t frameNumber = group.frameNumber + loopCount * frameSpan;
+        const varjo_Nanoseconds timestamp = group.timestamp + loopCount * timeSpan;
+
+        if (realTime && !waitUntil(stream, toWallTime(timestamp))) {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!stream.running) {
+                return;
+            }
+
+            // Runtime drops frames when the application keeps all buffers locked. Replaying as fast as possible
+            // waits for the application to unlock a buffer instead, so that no frames are lost.
+            if (!realTime) {
+                m_condition.wait(lock, [&]() { return !stream.running || assignBuffers(stream, group, frameNumber); });
+                if (!stream.running) {
+                    return;
+                }
+            } else if (!assignBuffers(stream, group, frameNumber)) {
+                m_stats.droppedFrames++;
+                continue;
+            }
+        }
+
+        // Recorded frame with stream specific values replaced
+        const int64_t entry = group.entries[0] >= 0 ? group.entries[0] : group.entries[1];
+        varjo_StreamFrame frame = m_recording.getFrame(static_cast<size_t>(entry))->metadata->streamFrame;
+        frame.id = stream.config.streamId;
+        frame.frameNumber = frameNumber;
+        frame.channels &= stream.channels;
+        setFrameTimestamp(frame, timestamp);
+
+        varjo_Nanoseconds latest = m_latestTimestamp;
+        while (latest < timestamp && !m_latestTimestamp.compare_exchange_weak(latest, timestamp)) {
+        }
+
+        stream.callback(&frame, getSession(), stream.userData);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.deliveredFrames++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stream.finished = true;
+    }
+    m_condition.notify_all();
+}
+
+bool ReplayDataStream::assignBuffers(Stream& stream, const FrameGroup& group, int64_t frameNumber)
+{
+    // Find free buffers for all recorded channels first, so frames are either delivered whole or dropped
+    std::array<Buffer*, 2> assigned{};
+    for (size_t ch = 0; ch < 2; ch++) {
+        if (group.entries[ch] < 0) {
+            continue;
+        }
+
+        auto& buffers = stream.buffers[ch];
+        for (size_t i = 0; i < buffers.size() && !assigned[ch]; i++) {
+            const size_t bufferIndex = (stream.nextBuffer[ch] + i) % buffers.size();
+            if (!buffers[bufferIndex].locked) {
+                assigned[ch] = &buffers[bufferIndex];
+                stream.nextBuffer[ch] = (bufferIndex + 1) % buffers.size();
+            }
+        }
+        if (!assigned[ch]) {
+            return false;
+        }
+    }
+
+    for (size_t ch = 0; ch < 2; ch++) {
+        if (assigned[ch]) {
+            assigned[ch]->frameNumber = frameNumber;
+            assigned[ch]->entry = group.entries[ch];
+            if (m_options.copyBuffers) {
+                const auto frame = m_recording.getFrame(static_cast<size_t>(group.entries[ch]));
+                assigned[ch]->data.assign(frame->data, frame->data + frame->size);
+            }
+        }
+    }
+    return true;
+}
+
+void ReplayDataStream::freeBuffers(Stream& stream)
+{
+    // Copied data storage is kept, so that pointers to freed buffers stay readable
+    for (auto& buffers : stream.buffers) {
+        for (auto& buffer : buffers) {
+            buffer.frameNumber = -1;
+            buffer.entry = -1;
+            buffer.locked = false;
+        }
+    }
+}
+
+ReplayDataStream::Stream* ReplayDataStream::findStream(varjo_StreamId id) const
+{
+    return (id >= 0 && static_cast<size_t>(id) < m_streams.size()) ? m_streams[static_cast<size_t>(id)].get() : nullptr;
+}
+
+ReplayDataStream::Buffer* ReplayDataStream::findBuffer(varjo_BufferId id) const
+{
+    if (id < 0) {
+        return nullptr;
+    }
+
+    Stream* stream = findStream((id >> c_bufferIndexBits) / 2);
+    const size_t channelIndex = static_cast<size_t>((id >> c_bufferIndexBits) % 2);
+    const size_t bufferIndex = static_cast<size_t>(id & ((int64_t(1) << c_bufferIndexBits) - 1));
+    if (!stream || bufferIndex >= stream->buffers[channelIndex].size()) {
+        return nullptr;
+    }
+
+    Buffer& buffer = stream->buffers[channelIndex][bufferIndex];
+    return buffer.entry >= 0 ? &buffer : nullptr;
+}
+
+const ReplayDataStream::Buffer* ReplayDataStream::findFrameBuffer(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const
+{
+    const Stream* stream = findStream(id);
+    if (!stream || index < 0 || index > 1) {
+        return nullptr;
+    }
+
+    const auto& buffers = stream->buffers[static_cast<size_t>(index)];
+    const auto it = std::find_if(buffers.begin(), buffers.end(), [frameNumber](const Buffer& buffer) { return buffer.frameNumber == frameNumber; });
+    return it != buffers.end() ? &*it : nullptr;
+}
+
+bool ReplayDataStream::waitUntil(const Stream& stream, std::chrono::steady_clock::time_point time)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_until(lock, time, [&stream]() { return !stream.running; });
+    return stream.running;
+}
+
+std::chrono::steady_clock::time_point ReplayDataStream::toWallTime(varjo_Nanoseconds timestamp) const
+{
+    const double offset = static_cast<double>(timestamp - m_startTimestamp) / m_options.speed;
+    return m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::nano>(offset));
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,174 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Varjo_types_datastream.h>
+
+#include "FrameRecording.hpp"
+
+namespace VarjoExamples
+{
+//! Replays a frame recording through the Varjo data stream API.
+//!
+//! Each recorded stream type is exposed as a stream config, and started streams deliver their
+//! recorded frames from a stream specific thread through the same frame listener contract as
+//! the runtime. Buffers are served directly from the mapped recording, and each stream channel
+//! has a fixed pool of buffers like the runtime. Frames are delivered in real time or at a multiple
+//! of real time, dropping a frame if all buffers of a channel are still locked by the application,
+//! or as fast as the application consumes them, waiting for a buffer to be unlocked instead. In timed
+//! replay, the timeline starts with the first started stream, and streams started later begin from
+//! the current frame.
+//!
+//! ReplayDataStreamApi.cpp implements the Varjo_datastream.h functions on top of this class, so
+//! data stream consumers can be run without a headset by linking it instead of VarjoLib (build
+//! with VARJORUNTIME_STATIC) and passing getSession() as the Varjo session. DataStreamReplay does
+//! this for DataStreamer, enable it with CMake option EXAMPLES_REPLAY_DATASTREAM.
+class ReplayDataStream
+{
+public:
+    //! Default number of buffers per stream channel
+    static constexpr int32_t c_defaultBufferCount = 4;
+
+    //! Replay options
+    struct Options {
+        double speed{1.0};                          //!< Replay speed relative to recording, zero or less replays as fast as possible
+        bool loop{false};                           //!< Restart streams from the beginning when the recording ends
+        int32_t bufferCount{c_defaultBufferCount};  //!< Number of buffers per stream channel
+        bool copyBuffers{false};                    //!< Serve buffers from replay owned copies, overwritten when the stream stops
+    };
+
+    //! Replay statistics
+    struct Stats {
+        uint64_t deliveredFrames{0};   //!< Number of frames passed to frame listeners
+        uint64_t droppedFrames{0};     //!< Number of frames dropped due to all buffers being locked
+        uint64_t skippedFrames{0};     //!< Number of frames skipped because stream was started after them
+        uint64_t invalidBufferIds{0};  //!< Number of buffer lock and unlock calls with IDs of freed buffers
+    };
+
+    //! Construct replay
+    ReplayDataStream();
+
+    //! Destruct replay. Stops running streams.
+    ~ReplayDataStream();
+
+    // Disable copy, move and assign
+    ReplayDataStream(const ReplayDataStream& other) = delete;
+    ReplayDataStream(const ReplayDataStream&& other) = delete;
+    ReplayDataStream& operator=(const ReplayDataStream& other) = delete;
+    ReplayDataStream& operator=(const ReplayDataStream&& other) = delete;
+
+    //! Open recording for replay in real time. Returns false if the recording could not be opened.
+    bool open(const std::string& filename);
+
+    //! Open recording for replay with given options. Returns false if the recording could not be opened.
+    bool open(const std::string& filename, const Options& options);
+
+    //! Returns session handle to use with data stream API functions
+    varjo_Session* getSession() { return reinterpret_cast<varjo_Session*>(this); }
+
+    //! Returns replay owning given session handle
+    static ReplayDataStream* fromSession(varjo_Session* session) { return reinterpret_cast<ReplayDataStream*>(session); }
+
+    //! Returns true if all started streams have delivered all their frames
+    bool isFinished() const;
+
+    //! Block until all started streams have delivered all their frames. Never returns when looping.
+    void waitUntilFinished() const;
+
+    //! Returns replay statistics
+    Stats getStats() const;
+
+    // Data stream API, see Varjo_datastream.h
+
+    int32_t getDataStreamConfigCount() const;
+    void getDataStreamConfigs(varjo_StreamConfig* configs, int32_t maxSize) const;
+    void startDataStream(varjo_StreamId id, varjo_ChannelFlag channels, varjo_FrameListener* callback, void* userData);
+    void stopDataStream(varjo_StreamId id);
+    varjo_CameraIntrinsics getCameraIntrinsics(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const;
+    varjo_Matrix getCameraExtrinsics(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const;
+    varjo_BufferId getBufferId(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const;
+    void lockDataStreamBuffer(varjo_BufferId id);
+    void unlockDataStreamBuffer(varjo_BufferId id);
+    varjo_BufferMetadata getBufferMetadata(varjo_BufferId id) const;
+    void* getBufferCPUData(varjo_BufferId id) const;
+
+    //! Returns current time on the recording timeline
+    varjo_Nanoseconds getCurrentTime() const;
+
+private:
+    //! Recorded frame of a stream, holding index entries of its channels
+    struct FrameGroup {
+        int64_t frameNumber{0};                  //!< Recorded frame number
+        varjo_Nanoseconds timestamp{0};          //!< Recorded frame timestamp
+        std::array<int64_t, 2> entries{-1, -1};  //!< Index entry per channel, -1 if not recorded
+    };
+
+    //! Stream channel buffer, references a frame in the mapped recording
+    struct Buffer {
+        int64_t frameNumber{-1};    //!< Delivered frame number, -1 if not in use
+        int64_t entry{-1};          //!< Index entry of buffer data
+        bool locked{false};         //!< Locked by application
+        std::vector<uint8_t> data;  //!< Copy of frame data if copying buffers, kept when the buffer is freed
+    };
+
+    //! Replayed stream
+    struct Stream {
+        varjo_StreamConfig config{};                         //!< Stream config
+        std::vector<FrameGroup> frames;                      //!< Recorded frames in order
+        std::array<std::vector<Buffer>, 2> buffers;          //!< Buffer pool per channel
+        std::array<size_t, 2> nextBuffer{0, 0};              //!< Next buffer to use per channel
+        varjo_ChannelFlag channels{varjo_ChannelFlag_None};  //!< Started channels
+        varjo_FrameListener* callback{nullptr};              //!< Frame listener
+        void* userData{nullptr};                             //!< Frame listener user data
+        std::thread thread;                                  //!< Stream thread
+        bool running{false};                                 //!< Stream started
+        bool finished{false};                                //!< All frames delivered
+    };
+
+    //! Stream thread main loop
+    void streamMain(Stream& stream);
+
+    //! Assign buffers for given frame. Returns false if a buffer is not available. Mutex must be held.
+    bool assignBuffers(Stream& stream, const FrameGroup& group, int64_t frameNumber);
+
+    //! Free buffers of given stream. Mutex must be held.
+    void freeBuffers(Stream& stream);
+
+    //! Find stream by ID, null if not found
+    Stream* findStream(varjo_StreamId id) const;
+
+    //! Find buffer by ID. Mutex must be held.
+    Buffer* findBuffer(varjo_BufferId id) const;
+
+    //! Find delivered buffer of given frame. Mutex must be held.
+    const Buffer* findFrameBuffer(varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index) const;
+
+    //! Wait until given replay time or stop. Returns false if the stream was stopped.
+    bool waitUntil(const Stream& stream, std::chrono::steady_clock::time_point time);
+
+    //! Convert recording timestamp to wall clock time
+    std::chrono::steady_clock::time_point toWallTime(varjo_Nanoseconds timestamp) const;
+
+    FrameRecording m_recording;                           //!< Mapped recording
+    Options m_options{};                                  //!< Replay options
+    std::vector<std::unique_ptr<Stream>> m_streams;       //!< Streams, indexed by stream ID
+    varjo_Nanoseconds m_startTimestamp{0};                //!< First timestamp in recording
+    std::chrono::steady_clock::time_point m_startTime;    //!< Wall clock time of first timestamp
+    bool m_started{false};                                //!< Replay timeline started
+    std::atomic<varjo_Nanoseconds> m_latestTimestamp{0};  //!< Latest delivered timestamp
+    mutable std::mutex m_mutex;                           //!< Mutex for streams, buffers and stats
+    mutable std::condition_variable m_condition;          //!< Signaled when streams stop or finish, or buffers are unlocked
+    Stats m_stats{};                                      //!< Replay statistics
+};
+
+}  // namespace VarjoExamples
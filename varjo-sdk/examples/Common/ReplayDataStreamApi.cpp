@@ -0,0 +1,78 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+// Data stream API implemented on top of ReplayDataStream.
+//
+// Link this instead of VarjoLib to run data stream consumers against a recording, and build with
+// VARJORUNTIME_STATIC so that API declarations do not expect DLL imports. Besides the data stream
+// functions, only the error and time queries used by the data stream examples are provided.
+// Sessions passed to these functions must come from ReplayDataStream::getSession().
+
+#include <Varjo.h>
+#include <Varjo_datastream.h>
+
+#include "ReplayDataStream.hpp"
+
+using VarjoExamples::ReplayDataStream;
+
+extern "C" {
+
+int32_t varjo_GetDataStreamConfigCount(struct varjo_Session* session)
+{
+    return ReplayDataStream::fromSession(session)->getDataStreamConfigCount();
+}
+
+void varjo_GetDataStreamConfigs(struct varjo_Session* session, struct varjo_StreamConfig* configs, int32_t maxSize)
+{
+    ReplayDataStream::fromSession(session)->getDataStreamConfigs(configs, maxSize);
+}
+
+void varjo_StartDataStream(struct varjo_Session* session, varjo_StreamId id, varjo_ChannelFlag channels, varjo_FrameListener* callback, void* userData)
+{
+    ReplayDataStream::fromSession(session)->startDataStream(id, channels, callback, userData);
+}
+
+void varjo_StopDataStream(struct varjo_Session* session, varjo_StreamId id) { ReplayDataStream::fromSession(session)->stopDataStream(id); }
+
+struct varjo_CameraIntrinsics varjo_GetCameraIntrinsics(struct varjo_Session* session, varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index)
+{
+    return ReplayDataStream::fromSession(session)->getCameraIntrinsics(id, frameNumber, index);
+}
+
+struct varjo_Matrix varjo_GetCameraExtrinsics(struct varjo_Session* session, varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index)
+{
+    return ReplayDataStream::fromSession(session)->getCameraExtrinsics(id, frameNumber, index);
+}
+
+varjo_BufferId varjo_GetBufferId(struct varjo_Session* session, varjo_StreamId id, int64_t frameNumber, varjo_ChannelIndex index)
+{
+    return ReplayDataStream::fromSession(session)->getBufferId(id, frameNumber, index);
+}
+
+void varjo_LockDataStreamBuffer(struct varjo_Session* session, varjo_BufferId id) { ReplayDataStream::fromSession(session)->lockDataStreamBuffer(id); }
+
+void varjo_UnlockDataStreamBuffer(struct varjo_Session* session, varjo_BufferId id) { ReplayDataStream::fromSession(session)->unlockDataStreamBuffer(id); }
+
+struct varjo_BufferMetadata varjo_GetBufferMetadata(struct varjo_Session* session, varjo_BufferId id)
+{
+    return ReplayDataStream::fromSession(session)->getBufferMetadata(id);
+}
+
+struct varjo_Texture varjo_GetBufferGPUData(struct varjo_Session* /*session*/, varjo_BufferId /*id*/)
+{
+    // Recordings only hold CPU buffers
+    return varjo_Texture{};
+}
+
+void* varjo_GetBufferCPUData(struct varjo_Session* session, varjo_BufferId id) { return ReplayDataStream::fromSession(session)->getBufferCPUData(id); }
+
+varjo_Nanoseconds varjo_GetCurrentTime(struct varjo_Session* session) { return ReplayDataStream::fromSession(session)->getCurrentTime(); }
+
+varjo_Error varjo_GetError(struct varjo_Session* /*session*/)
+{
+    // Replay reports invalid calls to log instead
+    return varjo_NoError;
+}
+
+const char* varjo_GetErrorDesc(varjo_Error /*error*/) { return "No error"; }
+
+}  // extern "C"
@@ -0,0 +1,316 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include "SnapshotWriter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+#include "Globals.hpp"
+#include "DataStreamer.hpp"
+#include "PngEncoder.hpp"
+
+namespace VarjoExamples
+{
+namespace
+{
+// Bitmap file headers, laid out as in the file format
+#pragma pack(push, 1)
+struct BmpFileHeader {
+    uint16_t type;
+    uint32_t size;
+    uint16_t reserved1;
+    uint16_t reserved2;
+    uint32_t offBits;
+};
+
+struct BmpInfoHeader {
+    uint32_t size;
+    int32_t width;
+    int32_t height;
+    uint16_t planes;
+    uint16_t bitCount;
+    uint32_t compression;
+    uint32_t sizeImage;
+    int32_t xPelsPerMeter;
+    int32_t yPelsPerMeter;
+    uint32_t clrUsed;
+    uint32_t clrImportant;
+};
+#pragma pack(pop)
+
+void writeBMP(const std::string& filename, int32_t width, int32_t height, int32_t components, const uint8_t* data, size_t rowStride)
+{
+    assert(components == 1 || components == 4);
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    if (!outFile.good()) {
+        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
+        return;
+    }
+
+    // Single channel images use a grayscale palette. Bitmap rows are padded to 4 bytes.
+    const uint32_t paletteSize = components == 1 ? 256 * 4 : 0;
+    const uint32_t bmpRowSize = (components * width + 3) & ~3;
+    const uint32_t imageDataSize = bmpRowSize * height;
+
+    // Write BMP headers
+    BmpFileHeader bmFileHdr{};
+    bmFileHdr.type = 0x4d42;  // "BM"
+    bmFileHdr.size = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) + paletteSize + imageDataSize;
+    bmFileHdr.offBits = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader) + paletteSize;
+    outFile.write(reinterpret_cast<const char*>(&bmFileHdr), sizeof(bmFileHdr));
+    if (!outFile.good()) {
+        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
+        return;
+    }
+
+    // Write bitmap header for RGB or grayscale data
+    BmpInfoHeader bmInfoHdr{};
+    bmInfoHdr.size = sizeof(bmInfoHdr);
+    bmInfoHdr.width = width;
+    bmInfoHdr.height = -height;  // Negative height to avoid flipping image vertically
+    bmInfoHdr.planes = 1;
+    bmInfoHdr.bitCount = static_cast<uint16_t>(components * 8);
+    bmInfoHdr.compression = 0;  // Uncompressed RGB
+    bmInfoHdr.sizeImage = 0;
+    bmInfoHdr.xPelsPerMeter = bmInfoHdr.yPelsPerMeter = 2835;
+    bmInfoHdr.clrImportant = bmInfoHdr.clrUsed = 0;
+    outFile.write(reinterpret_cast<const char*>(&bmInfoHdr), sizeof(bmInfoHdr));
+    if (!outFile.good()) {
+        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
+        return;
+    }
+
+    if (components == 1) {
+        // Grayscale palette entries in BGRX order
+        std::vector<uint8_t> palette(paletteSize, 0);
+        for (size_t i = 0; i < 256; ++i) {
+            palette[i * 4 + 0] = palette[i * 4 + 1] = palette[i * 4 + 2] = static_cast<uint8_t>(i);
+        }
+        outFile.write(reinterpret_cast<const char*>(palette.data()), paletteSize);
+    }
+
+    // Write data row by row
+    std::vector<uint8_t> row(bmpRowSize, 0);
+    for (int32_t y = 0; y < height; ++y) {
+        const uint8_t* src = data + y * rowStride;
+        if (components == 1) {
+            std::memcpy(row.data(), src, width);
+        } else {
+            uint8_t* dst = row.data();
+            for (int32_t x = 0; x < width; ++x) {
+                // Swap RGBA to BGRA used in bitmaps
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+                dst[3] = src[3];
+                dst += 4;
+                src += 4;
+            }
+        }
+
+        outFile.write(reinterpret_cast<const char*>(row.data()), row.size());
+        if (!outFile.good()) {
+            LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
+            return;
+        }
+    }
+
+    outFile.close();
+    LOG_INFO("File saved succesfully: %s", filename.c_str());
+}
+
+void writePNG(const std::string& filename, int32_t width, int32_t height, int32_t components, const uint8_t* data, size_t rowStride,
+    WorkerPool& encoderPool)
+{
+    std::vector<uint8_t> encoded;
+    if (!PngEncoder::encode(data, width, height, components, rowStride, encoded, &encoderPool)) {
+        LOG_ERROR("Encoding PNG image failed: %s", filename.c_str());
+        return;
+    }
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    if (!outFile.good()) {
+        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
+        return;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing to PNG file failed: %s", filename.c_str());
+        return;
+    }
+
+    outFile.close();
+    LOG_INFO("File saved succesfully: %s", filename.c_str());
+}
+
+// Save varjo buffer data as image file. Format is selected by filename extension.
+void saveImage(const std::string& filename, const varjo_BufferMetadata& buffer, const void* bufferData, WorkerPool& encoderPool)
+{
+    LOG_DEBUG("Saving buffer to file: %s", filename.c_str());
+
+    // Y8 buffers are written as single channel images, other formats are converted to RGBA
+    const uint8_t* image = static_cast<const uint8_t*>(bufferData);
+    int32_t components = 1;
+    size_t rowStride = buffer.rowStride;
+    std::vector<uint8_t> output;
+    if (buffer.format != varjo_TextureFormat_Y8_UNORM) {
+        components = 4;
+        rowStride = static_cast<size_t>(buffer.width) * components;
+        output.resize(rowStride * buffer.height);
+        if (!DataStreamer::convertToR8G8B8A(buffer, bufferData, output.data())) {
+            return;
+        }
+        image = output.data();
+    }
+
+    switch (SnapshotWriter::getImageFormat(filename)) {
+        case SnapshotWriter::ImageFormat::BMP: writeBMP(filename, buffer.width, buffer.height, components, image, rowStride); break;
+        case SnapshotWriter::ImageFormat::PNG: writePNG(filename, buffer.width, buffer.height, components, image, rowStride, encoderPool); break;
+    }
+}
+
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(size_t threadCount, size_t queueCapacity, size_t encoderThreadCount)
+    : m_queueCapacity(queueCapacity)
+    , m_encoderPool(encoderThreadCount)
+{
+    threadCount = std::max<size_t>(threadCount, 1);
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&SnapshotWriter::writerMain, this);
+    }
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    // Write what has been queued, then stop writer threads
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_queueCondition.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+bool SnapshotWriter::write(Request request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.size() >= m_queueCapacity) {
+            m_stats.dropped++;
+            LOG_WARNING("Snapshot queue full, dropping snapshot: %s", request.filename.c_str());
+            return false;
+        }
+
+        m_queue.emplace_back(std::move(request));
+        m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_queue.size());
+    }
+    m_queueCondition.notify_one();
+    return true;
+}
+
+void SnapshotWriter::writeAll(std::vector<Request> requests)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& request : requests) {
+            m_queue.emplace_back(std::move(request));
+        }
+        m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_queue.size());
+    }
+    m_queueCondition.notify_all();
+}
+
+void SnapshotWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this]() { return m_queue.empty() && m_activeWrites == 0; });
+}
+
+SnapshotWriter::ImageFormat SnapshotWriter::getImageFormat(const std::string& filename)
+{
+    const auto dot = filename.find_last_of('.');
+    std::string extension = dot != std::string::npos ? filename.substr(dot + 1) : std::string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return extension == "png" ? ImageFormat::PNG : ImageFormat::BMP;
+}
+
+const char* SnapshotWriter::getFileExtension(ImageFormat format)
+{
+    switch (format) {
+        case ImageFormat::BMP: return ".bmp";
+        case ImageFormat::PNG: return ".png";
+    }
+    return "";
+}
+
+SnapshotWriter::Stats SnapshotWriter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.queueDepth = m_queue.size();
+    return stats;
+}
+
+std::shared_ptr<const uint8_t> SnapshotWriter::copyBuffer(const void* data, size_t byteSize)
+{
+    auto copy = std::make_shared<std::vector<uint8_t>>(byteSize);
+    std::memcpy(copy->data(), data, byteSize);
+    return std::shared_ptr<const uint8_t>(copy, copy->data());
+}
+
+void SnapshotWriter::writerMain()
+{
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueCondition.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+
+            request = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_activeWrites++;
+        }
+
+        // Convert and write without holding the lock
+        if (request.data) {
+            saveImage(request.filename, request.bufferMetadata, request.data.get(), m_encoderPool);
+        }
+
+        // Release buffer before reporting idle, so that flush() guarantees no buffer is referenced anymore
+        const bool written = request.data != nullptr;
+        request = {};
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeWrites--;
+            if (written) {
+                m_stats.written++;
+            }
+            if (m_queue.empty() && m_activeWrites == 0) {
+                m_idleCondition.notify_all();
+            }
+        }
+    }
+}
+
+}  // namespace VarjoExamples
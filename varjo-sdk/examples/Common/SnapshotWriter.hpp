@@ -0,0 +1,105 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Varjo_types_datastream.h>
+
+#include "WorkerPool.hpp"
+
+namespace VarjoExamples
+{
+//! Background writer for data stream snapshots.
+//!
+//! Converting a buffer to RGBA and writing it to disk takes far longer than a stream frame
+//! interval, so stream callbacks only queue the buffer and writer threads do the rest. The
+//! queue is bounded: when it is full, new snapshots are dropped instead of blocking the caller.
+//! Images are written as BMP or PNG depending on the filename extension. Y8 buffers are written
+//! as single channel images, PNG images are encoded in parallel row bands.
+class SnapshotWriter
+{
+public:
+    //! Snapshot image file format
+    enum class ImageFormat {
+        BMP = 0,  //!< Uncompressed bitmap
+        PNG,      //!< Losslessly compressed PNG, see PngEncoder
+    };
+
+    //! Snapshot write request
+    struct Request {
+        std::string filename;                   //!< Output filename
+        varjo_BufferMetadata bufferMetadata{};  //!< Buffer metadata
+        std::shared_ptr<const uint8_t> data;    //!< Buffer data, e.g. a copy or a buffer lease. Kept alive until written.
+    };
+
+    //! Writer statistics
+    struct Stats {
+        size_t queueDepth{0};     //!< Number of requests waiting to be written
+        size_t maxQueueDepth{0};  //!< Highest queue depth seen
+        uint64_t written{0};      //!< Number of snapshots written
+        uint64_t dropped{0};      //!< Number of snapshots dropped due to full queue
+    };
+
+    //! Default maximum number of queued snapshots
+    static constexpr size_t c_defaultQueueCapacity = 8;
+
+    //! Construct writer with given number of writer threads, queue capacity and PNG encoder threads
+    explicit SnapshotWriter(
+        size_t threadCount = 1, size_t queueCapacity = c_defaultQueueCapacity, size_t encoderThreadCount = WorkerPool::getDefaultThreadCount());
+
+    //! Destruct writer. Writes all queued snapshots before returning.
+    ~SnapshotWriter();
+
+    // Disable copy, move and assign
+    SnapshotWriter(const SnapshotWriter& other) = delete;
+    SnapshotWriter(const SnapshotWriter&& other) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter& other) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&& other) = delete;
+
+    //! Queue snapshot for writing. Returns false and counts a drop if the queue is full.
+    bool write(Request request);
+
+    //! Queue multiple snapshots at once, e.g. a finished burst capture. Their memory is already
+    //! allocated, so these are not limited by queue capacity.
+    void writeAll(std::vector<Request> requests);
+
+    //! Block until all queued snapshots have been written
+    void flush();
+
+    //! Returns writer statistics
+    Stats getStats() const;
+
+    //! Returns image format for given filename. Filenames without .png extension are written as BMP.
+    static ImageFormat getImageFormat(const std::string& filename);
+
+    //! Returns filename extension for given image format, including the dot
+    static const char* getFileExtension(ImageFormat format);
+
+    //! Copy buffer data to memory owned by the returned pointer
+    static std::shared_ptr<const uint8_t> copyBuffer(const void* data, size_t byteSize);
+
+private:
+    //! Writer thread main loop
+    void writerMain();
+
+    const size_t m_queueCapacity;              //!< Maximum number of queued single snapshots
+    WorkerPool m_encoderPool;                  //!< Worker pool for encoding PNG row bands
+    std::vector<std::thread> m_threads;        //!< Writer threads
+    mutable std::mutex m_mutex;                //!< Mutex for queue and stats
+    std::condition_variable m_queueCondition;  //!< Signaled when requests are queued or writer stopped
+    std::condition_variable m_idleCondition;   //!< Signaled when queue becomes empty and writers idle
+    std::deque<Request> m_queue;               //!< Queued requests
+    size_t m_activeWrites{0};                  //!< Number of requests being written
+    Stats m_stats{};                           //!< Writer statistics
+    bool m_stop{false};                        //!< Stop flag for writer threads
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,124 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace VarjoExamples
+{
+//! Capacity template argument of queues sized at construction
+constexpr size_t c_dynamicCapacity = 0;
+
+//! Bounded wait-free single producer, single consumer queue.
+//!
+//! Exactly one thread may push and exactly one (other) thread may pop at a time. Items are
+//! stored in a fixed ring, so push and pop never allocate or block. The ring size is either
+//! given as template argument, or at construction when it is c_dynamicCapacity.
+template <typename T, size_t Capacity = c_dynamicCapacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+    //! Construct queue with capacity given as template argument
+    SpscQueue()
+        : m_mask(Capacity - 1)
+    {
+        static_assert(Capacity != c_dynamicCapacity, "Capacity must be given to constructor.");
+    }
+
+    //! Construct queue with given capacity, rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : m_items(roundUpCapacity(capacity))
+        , m_mask(roundUpCapacity(capacity) - 1)
+    {
+        static_assert(Capacity == c_dynamicCapacity, "Capacity is given as template argument.");
+    }
+
+    // Disable copy, move and assign
+    SpscQueue(const SpscQueue& other) = delete;
+    SpscQueue(const SpscQueue&& other) = delete;
+    SpscQueue& operator=(const SpscQueue& other) = delete;
+    SpscQueue& operator=(const SpscQueue&& other) = delete;
+
+    //! Push item to the queue. Returns false if the queue is full. Producer thread only.
+    bool push(const T& item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Pop item from the queue. Returns false if the queue is empty. Consumer thread only.
+    bool pop(T& item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Returns item at given position from the front of the queue, or null if the queue has fewer items.
+    //! The item can be modified in place and stays valid until it is popped. Consumer thread only.
+    T* peek(size_t index = 0)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_tail.load(std::memory_order_acquire) - head <= index) {
+            return nullptr;
+        }
+
+        return &m_items[(head + index) & m_mask];
+    }
+
+    //! Remove item from the front of the queue without reading it. Returns false if the queue is empty.
+    //! The item stays in its slot until overwritten, so it can keep its storage for reuse. Consumer thread only.
+    bool discard()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Returns approximate number of items in the queue
+    size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+    //! Returns queue capacity
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    //! Round capacity up to a power of two, at least one
+    static size_t roundUpCapacity(size_t capacity)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    using Items = std::conditional_t<Capacity == c_dynamicCapacity, std::vector<T>, std::array<T, Capacity>>;
+
+    Items m_items{};                            //!< Item ring
+    const size_t m_mask;                        //!< Capacity minus one, for wrapping indices
+    alignas(64) std::atomic<size_t> m_head{0};  //!< Index of next item to pop, written by consumer
+    alignas(64) std::atomic<size_t> m_tail{0};  //!< Index of next item to push, written by producer
+};
+
+}  // namespace VarjoExamples
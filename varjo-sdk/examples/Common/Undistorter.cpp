@@ -79,7 +79,9 @@ Undistorter::Undistorter(const glm::ivec2& inputSize, const glm::ivec2& outputSi
     }
 }
 
-glm::ivec2 Undistorter::getSampleCoord(int x, int y) const
+glm::ivec2 Undistorter::getSampleCoord(int x, int y) const { return getSampleCoordSubpixel(x, y); }
+
+glm::vec2 Undistorter::getSampleCoordSubpixel(int x, int y) const
 {
     // Camera and view coordinate systems have opposite YZ direction.
     const glm::mat3x3 flipYZ = glm::diagonal3x3(glm::vec3{1.0, -1.0, -1.0});
@@ -92,4 +94,44 @@ glm::ivec2 Undistorter::getSampleCoord(int x, int y) const
     return sampleCoord * glm::vec2(m_inputSize);
 }
 
+std::vector<uint32_t> Undistorter::buildRemapTable() const
+{
+    std::vector<uint32_t> table(static_cast<size_t>(m_outputSize.x) * m_outputSize.y);
+
+    size_t i = 0;
+    for (int y = 0; y < m_outputSize.y; ++y) {
+        for (int x = 0; x < m_outputSize.x; ++x) {
+            const glm::ivec2 sampleCoord = getSampleCoord(x, y);
+            const bool valid = sampleCoord.x >= 0 && sampleCoord.x < m_inputSize.x && sampleCoord.y >= 0 && sampleCoord.y < m_inputSize.y;
+            table[i++] = valid ? packSample(sampleCoord.x, sampleCoord.y) : c_invalidSample;
+        }
+    }
+
+    return table;
+}
+
+std::vector<Undistorter::FixedPointSample> Undistorter::buildFixedPointRemapTable() const
+{
+    constexpr float c_fixedPointScale = 65536.0f;
+
+    std::vector<FixedPointSample> table(static_cast<size_t>(m_outputSize.x) * m_outputSize.y);
+    const glm::vec2 maxPos = glm::vec2(m_inputSize - 1);
+
+    size_t i = 0;
+    for (int y = 0; y < m_outputSize.y; ++y) {
+        for (int x = 0; x < m_outputSize.x; ++x) {
+            const glm::vec2 sampleCoord = getSampleCoordSubpixel(x, y);
+            if (sampleCoord.x >= 0.0f && sampleCoord.x < m_inputSize.x && sampleCoord.y >= 0.0f && sampleCoord.y < m_inputSize.y) {
+                // Position relative to pixel centers, clamped so that the first bilinear tap is always inside the buffer
+                const glm::vec2 pos = glm::clamp(sampleCoord - 0.5f, glm::vec2(0.0f), maxPos);
+                table[i++] = {static_cast<int32_t>(pos.x * c_fixedPointScale + 0.5f), static_cast<int32_t>(pos.y * c_fixedPointScale + 0.5f)};
+            } else {
+                table[i++] = {c_invalidFixedPointSample, c_invalidFixedPointSample};
+            }
+        }
+    }
+
+    return table;
+}
+
 }  // namespace VarjoExamples
@@ -1,8 +1,11 @@
 // Copyright 2022 Varjo Technologies Oy. All rights reserved.
 
+#pragma once
+
 #include "Globals.hpp"
 
 #include <optional>
+#include <vector>
 
 namespace VarjoExamples
 {
@@ -20,6 +23,33 @@ public:
     //! Get undistorted sample coordinate into distorted source buffer, that should be used for a screen space pixel x,y.
     glm::ivec2 getSampleCoord(int x, int y) const;
 
+    //! Get undistorted sample coordinate with subpixel precision. Integer part is the pixel index, fraction the position inside the pixel.
+    glm::vec2 getSampleCoordSubpixel(int x, int y) const;
+
+    //! Marker for remap table samples that fall outside the input buffer
+    static constexpr uint32_t c_invalidSample = 0xffffffff;
+
+    //! Pack integer sample coordinate to remap table entry: x in low 16 bits, y in high 16 bits.
+    static constexpr uint32_t packSample(int x, int y) { return static_cast<uint32_t>(x) | (static_cast<uint32_t>(y) << 16); }
+
+    //! Build remap table of packed sample coordinates for every output pixel in row order.
+    //! Samples outside the input buffer are set to c_invalidSample.
+    std::vector<uint32_t> buildRemapTable() const;
+
+    //! Fixed point remap table entry for bilinear sampling. Coordinates are 16.16 fixed point positions
+    //! relative to input pixel centers, clamped to the buffer edges.
+    struct FixedPointSample {
+        int32_t x;  //!< X position in 16.16 fixed point
+        int32_t y;  //!< Y position in 16.16 fixed point
+    };
+
+    //! Marker for fixed point remap table samples that fall outside the input buffer
+    static constexpr int32_t c_invalidFixedPointSample = INT32_MIN;
+
+    //! Build fixed point remap table for every output pixel in row order.
+    //! Samples outside the input buffer have x set to c_invalidFixedPointSample.
+    std::vector<FixedPointSample> buildFixedPointRemapTable() const;
+
 private:
     glm::ivec2 m_inputSize;               //!< Input buffer dimenions
     glm::ivec2 m_outputSize;              //!< Output buffer dimenions
@@ -0,0 +1,97 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "WorkerPool.hpp"
+
+namespace VarjoExamples
+{
+WorkerPool::WorkerPool(size_t threadCount)
+{
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&WorkerPool::workerMain, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+size_t WorkerPool::getDefaultThreadCount()
+{
+    const size_t hwThreads = std::thread::hardware_concurrency();
+    return hwThreads > 1 ? hwThreads - 1 : 0;
+}
+
+void WorkerPool::parallelFor(size_t taskCount, const std::function<void(size_t)>& task)
+{
+    // Run small jobs directly to avoid waking up the workers
+    if (m_threads.empty() || taskCount <= 1) {
+        for (size_t i = 0; i < taskCount; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(m_jobMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_activeWorkers = m_threads.size();
+        m_generation++;
+    }
+    m_wakeCondition.notify_all();
+
+    // Calling thread participates in the job
+    runTasks();
+
+    // Wait for all workers, so that none of them can still be inside the job when the next one starts
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return m_activeWorkers == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::workerMain()
+{
+    uint64_t generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_activeWorkers == 0) {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::runTasks()
+{
+    for (size_t i = m_nextTask++; i < m_taskCount; i = m_nextTask++) {
+        (*m_task)(i);
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,65 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VarjoExamples
+{
+//! Pool of worker threads for running data parallel jobs.
+//!
+//! Jobs are split into a number of tasks that are picked by the workers and the calling
+//! thread one at a time, so tasks of uneven cost are balanced automatically.
+class WorkerPool
+{
+public:
+    //! Construct pool with given number of worker threads in addition to the calling thread.
+    //! Zero threads runs all tasks on the calling thread.
+    explicit WorkerPool(size_t threadCount);
+
+    //! Destruct pool. Stops and joins worker threads.
+    ~WorkerPool();
+
+    // Disable copy, move and assign
+    WorkerPool(const WorkerPool& other) = delete;
+    WorkerPool(const WorkerPool&& other) = delete;
+    WorkerPool& operator=(const WorkerPool& other) = delete;
+    WorkerPool& operator=(const WorkerPool&& other) = delete;
+
+    //! Returns default worker thread count for this machine, leaving one core for the calling thread
+    static size_t getDefaultThreadCount();
+
+    //! Returns number of worker threads
+    size_t getThreadCount() const { return m_threads.size(); }
+
+    //! Run task for every index in [0, taskCount) across the workers and the calling thread.
+    //! Blocks until all tasks have finished. Concurrent calls are serialized.
+    void parallelFor(size_t taskCount, const std::function<void(size_t)>& task);
+
+private:
+    //! Worker thread main loop
+    void workerMain();
+
+    //! Run tasks of the current job until none are left
+    void runTasks();
+
+    std::vector<std::thread> m_threads;                  //!< Worker threads
+    std::mutex m_jobMutex;                               //!< Mutex for serializing jobs
+    std::mutex m_mutex;                                  //!< Mutex for job state
+    std::condition_variable m_wakeCondition;             //!< Signaled when a job is started or pool stopped
+    std::condition_variable m_doneCondition;             //!< Signaled when all workers have finished a job
+    const std::function<void(size_t)>* m_task{nullptr};  //!< Task of the current job
+    size_t m_taskCount{0};                               //!< Number of tasks in the current job
+    std::atomic<size_t> m_nextTask{0};                   //!< Index of the next task to run
+    size_t m_activeWorkers{0};                           //!< Number of workers still running the current job
+    uint64_t m_generation{0};                            //!< Job counter for waking up workers
+    bool m_stop{false};                                  //!< Stop flag for worker threads
+};
+
+}  // namespace VarjoExamples
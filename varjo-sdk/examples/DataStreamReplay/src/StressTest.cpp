@@ -0,0 +1,357 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "StressTest.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Globals.hpp"
+#include "DataStreamer.hpp"
+#include "FrameRecording.hpp"
+#include "ReplayDataStream.hpp"
+
+using namespace VarjoExamples;
+
+namespace
+{
+// Generated stream
+struct StressStream {
+    varjo_StreamType type;        // Stream type
+    varjo_TextureFormat format;   // Buffer format
+    varjo_ChannelFlag channels;   // Recorded channels
+    int32_t width;                // Buffer width
+    int32_t height;               // Buffer height
+    int32_t rowStride;            // Buffer row stride in bytes
+    uint32_t byteSize;            // Buffer size in bytes
+    int64_t frameCount;           // Number of recorded frames
+    varjo_Nanoseconds frameTime;  // Recorded frame interval
+};
+
+// Generated streams. Small buffers keep the frame rate and the amount of contention high.
+const StressStream c_streams[] = {
+    {varjo_StreamType_DistortedColor, varjo_TextureFormat_NV12, varjo_ChannelFlag_First | varjo_ChannelFlag_Second, 64, 48, 64, 64 * 48 * 3 / 2, 90,
+        11111111},
+    {varjo_StreamType_EyeCamera, varjo_TextureFormat_Y8_UNORM, varjo_ChannelFlag_First | varjo_ChannelFlag_Second, 80, 60, 80, 80 * 60, 200, 5000000},
+    {varjo_StreamType_EnvironmentCubemap, varjo_TextureFormat_RGBA16_FLOAT, varjo_ChannelFlag_First, 16, 16 * 6, 16 * 8, 16 * 8 * 16 * 6, 30, 33333333},
+};
+constexpr size_t c_streamCount = std::size(c_streams);
+
+// Replay buffers per stream channel. More than leases can hold, so that retained leases never stall the replay.
+constexpr int32_t c_bufferCount = 8;
+
+// Buffer leases retained by the consumer per stream
+constexpr size_t c_retainedLeases = 2;
+
+// Number of corrupted frames logged in detail
+constexpr uint64_t c_maxLoggedErrors = 10;
+
+// Main loop iteration interval
+constexpr std::chrono::milliseconds c_iterationInterval{1};
+
+// Generated buffer value of a stream channel frame. Differs between frames, so reused buffers are detected too.
+uint8_t getPatternValue(size_t streamIndex, varjo_ChannelIndex channelIndex, int64_t frameNumber, size_t offset)
+{
+    return static_cast<uint8_t>(streamIndex * 67 + channelIndex * 131 + frameNumber * 7 + offset);
+}
+
+// Returns index of stream with given type, or stream count if not found
+size_t findStreamIndex(varjo_StreamType streamType)
+{
+    size_t index = 0;
+    while (index < c_streamCount && c_streams[index].type != streamType) {
+        index++;
+    }
+    return index;
+}
+
+// Write recording of all generated streams. Returns false on failure.
+bool writeRecording(const std::string& filename)
+{
+    FrameRecorder recorder;
+    if (!recorder.open(filename)) {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    for (size_t streamIndex = 0; streamIndex < c_streamCount; streamIndex++) {
+        const StressStream& stream = c_streams[streamIndex];
+        buffer.resize(stream.byteSize);
+
+        for (int64_t frameNumber = 0; frameNumber < stream.frameCount; frameNumber++) {
+            DataStreamer::Frame::Metadata metadata;
+            metadata.streamFrame.type = stream.type;
+            metadata.streamFrame.id = static_cast<varjo_StreamId>(streamIndex);
+            metadata.streamFrame.frameNumber = frameNumber;
+            metadata.streamFrame.channels = stream.channels;
+            metadata.streamFrame.dataFlags = varjo_DataFlag_Buffer;
+            metadata.timestamp = 1000000000LL + frameNumber * stream.frameTime;
+            metadata.bufferMetadata.type = varjo_BufferType_CPU;
+            metadata.bufferMetadata.format = stream.format;
+            metadata.bufferMetadata.width = stream.width;
+            metadata.bufferMetadata.height = stream.height;
+            metadata.bufferMetadata.rowStride = stream.rowStride;
+            metadata.bufferMetadata.byteSize = stream.byteSize;
+
+            // Channels of a frame are recorded one after another
+            for (varjo_ChannelIndex channelIndex : {varjo_ChannelIndex_Left, varjo_ChannelIndex_Right}) {
+                if (!(stream.channels & (1ull << channelIndex))) {
+                    continue;
+                }
+                metadata.channelIndex = channelIndex;
+                for (size_t i = 0; i < buffer.size(); i++) {
+                    buffer[i] = getPatternValue(streamIndex, channelIndex, frameNumber, i);
+                }
+                if (!recorder.record(metadata, buffer.data(), buffer.size())) {
+                    return false;
+                }
+            }
+        }
+    }
+    return recorder.close();
+}
+
+// Consumer state of a generated stream
+struct StreamState {
+    std::atomic_bool stopped{true};                // Set by main thread after the stream has been stopped
+    std::array<std::atomic_bool, 2> delivering{};  // Set while a frame of the channel is in the frame callback
+    std::array<int64_t, 2> lastFrameNumber{};      // Last delivered frame number of the channel, used while delivering
+    std::mutex mutex;                              // Mutex for retained leases
+    bool retainLeases{false};                      // Frame callback retains leases while set
+    std::vector<DataStreamer::Frame> retained;     // Leased frames retained by the consumer
+};
+
+// Consumer counters, updated from frame callbacks and main thread
+struct Counters {
+    std::atomic<uint64_t> frames{0};            // Number of frames passed to frame callback
+    std::atomic<uint64_t> leasedFrames{0};      // Number of frames holding a buffer lease
+    std::atomic<uint64_t> retainedFrames{0};    // Number of leased frames retained by the consumer
+    std::atomic<uint64_t> corruptFrames{0};     // Number of frames not matching the generated data
+    std::atomic<uint64_t> lateFrames{0};        // Number of frames passed for a stopped stream
+    std::atomic<uint64_t> overlappedFrames{0};  // Number of frames delivered while the same channel was being delivered
+    std::atomic<uint64_t> reorderedFrames{0};   // Number of frames delivered after a later frame of the same channel
+};
+
+// Check frame data against the generated data. Logs the first errors.
+bool checkFrame(const DataStreamer::Frame& frame, Counters& counters, const char* context)
+{
+    const auto& metadata = frame.metadata;
+    const size_t streamIndex = findStreamIndex(metadata.streamFrame.type);
+    bool valid = streamIndex < c_streamCount && metadata.bufferMetadata.byteSize == c_streams[streamIndex].byteSize && frame.getData() != nullptr;
+
+    size_t offset = 0;
+    if (valid) {
+        const uint8_t* data = frame.getData();
+        const int64_t frameNumber = metadata.streamFrame.frameNumber % c_streams[streamIndex].frameCount;
+        while (offset < metadata.bufferMetadata.byteSize && data[offset] == getPatternValue(streamIndex, metadata.channelIndex, frameNumber, offset)) {
+            offset++;
+        }
+        valid = offset == metadata.bufferMetadata.byteSize;
+    }
+
+    if (!valid && counters.corruptFrames++ < c_maxLoggedErrors) {
+        LOG_ERROR("Corrupted %s frame: type=%lld, channel=%lld, frame=%lld, bytes=%u, leased=%d, offset=%zu", context, metadata.streamFrame.type,
+            metadata.channelIndex, metadata.streamFrame.frameNumber, metadata.bufferMetadata.byteSize, frame.lease ? 1 : 0, offset);
+    }
+    return valid;
+}
+
+// Check and release leases retained for given stream
+void releaseRetained(StreamState& state, Counters& counters)
+{
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (const auto& frame : state.retained) {
+        checkFrame(frame, counters, "retained");
+    }
+    state.retained.clear();
+}
+
+}  // namespace
+
+bool runDataStreamerStressTest(double duration)
+{
+    // Snapshots are written to working directory, keep them in a directory of their own
+    const auto workingDir = std::filesystem::current_path();
+    const auto testDir = std::filesystem::temp_directory_path() / "DataStreamReplayStress";
+    std::error_code error;
+    std::filesystem::remove_all(testDir, error);
+    if (!std::filesystem::create_directories(testDir, error)) {
+        LOG_ERROR("Creating stress test directory failed: %s", testDir.string().c_str());
+        return false;
+    }
+    std::filesystem::current_path(testDir);
+
+    bool passed = false;
+    {
+        const std::string recordingFile = (testDir / "stress.rec").string();
+        ReplayDataStream::Options replayOptions;
+        replayOptions.speed = 0.0;
+        replayOptions.loop = true;
+        replayOptions.bufferCount = c_bufferCount;
+        replayOptions.copyBuffers = true;
+
+        ReplayDataStream replay;
+        if (!writeRecording(recordingFile) || !replay.open(recordingFile, replayOptions)) {
+            LOG_ERROR("Creating stress test recording failed: %s", recordingFile.c_str());
+            std::filesystem::current_path(workingDir);
+            return false;
+        }
+
+        std::array<StreamState, c_streamCount> states;
+        Counters counters;
+        DataStreamer streamer(replay.getSession(), [&](const DataStreamer::Frame& frame) {
+            counters.frames++;
+            const size_t streamIndex = findStreamIndex(frame.metadata.streamFrame.type);
+            if (streamIndex < c_streamCount && states[streamIndex].stopped && counters.lateFrames++ < c_maxLoggedErrors) {
+                LOG_ERROR("Frame callback for stopped stream: type=%lld, frame=%lld", frame.metadata.streamFrame.type, frame.metadata.streamFrame.frameNumber);
+            }
+            if (!checkFrame(frame, counters, "callback")) {
+                return;
+            }
+
+            // Frames of a channel must be delivered one at a time and in order, also while delivery modes change
+            auto& state = states[streamIndex];
+            const auto channelIndex = static_cast<size_t>(frame.metadata.channelIndex);
+            const int64_t frameNumber = frame.metadata.streamFrame.frameNumber;
+            if (state.delivering[channelIndex].exchange(true)) {
+                if (counters.overlappedFrames++ < c_maxLoggedErrors) {
+                    LOG_ERROR("Overlapping frame callbacks: type=%lld, channel=%zu, frame=%lld", frame.metadata.streamFrame.type, channelIndex, frameNumber);
+                }
+            } else {
+                if (frameNumber <= state.lastFrameNumber[channelIndex] && counters.reorderedFrames++ < c_maxLoggedErrors) {
+                    LOG_ERROR("Frame delivered out of order: type=%lld, channel=%zu, frame=%lld, previous=%lld", frame.metadata.streamFrame.type, channelIndex,
+                        frameNumber, state.lastFrameNumber[channelIndex]);
+                }
+                state.lastFrameNumber[channelIndex] = frameNumber;
+                state.delivering[channelIndex] = false;
+            }
+            if (!frame.lease) {
+                return;
+            }
+
+            counters.leasedFrames++;
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.retainLeases && state.retained.size() < c_retainedLeases) {
+                state.retained.push_back(frame);
+                counters.retainedFrames++;
+            }
+        });
+
+        const auto startStream = [&](size_t streamIndex) {
+            const StressStream& stream = c_streams[streamIndex];
+            states[streamIndex].lastFrameNumber = {-1, -1};
+            states[streamIndex].stopped = false;
+            {
+                std::lock_guard<std::mutex> lock(states[streamIndex].mutex);
+                states[streamIndex].retainLeases = true;
+            }
+            streamer.startDataStream(stream.type, stream.format, stream.channels);
+        };
+
+        // Leases must be released before stopping the stream, see DataStreamer::setBufferLeasingEnabled()
+        const auto stopStream = [&](size_t streamIndex) {
+            const StressStream& stream = c_streams[streamIndex];
+            {
+                std::lock_guard<std::mutex> lock(states[streamIndex].mutex);
+                states[streamIndex].retainLeases = false;
+            }
+            releaseRetained(states[streamIndex], counters);
+            streamer.stopDataStream(stream.type, stream.format);
+            states[streamIndex].stopped = true;
+        };
+
+        const uint32_t seed = std::random_device()();
+        LOG_INFO("Running DataStreamer stress test: duration=%.1f s, seed=%u", duration, seed);
+        std::mt19937 random(seed);
+        const auto chance = [&random](uint32_t oneIn) { return random() % oneIn == 0; };
+
+        for (size_t i = 0; i < c_streamCount; i++) {
+            startStream(i);
+        }
+
+        uint64_t restarts = 0;
+        uint64_t modeChanges = 0;
+        const auto startTime = std::chrono::steady_clock::now();
+        auto statusTime = startTime;
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() < duration) {
+            const size_t streamIndex = random() % c_streamCount;
+            const StressStream& stream = c_streams[streamIndex];
+
+            // Restart streams while their callbacks are running
+            if (chance(10)) {
+                if (streamer.isStreaming(stream.type, stream.format)) {
+                    stopStream(streamIndex);
+                } else {
+                    startStream(streamIndex);
+                }
+                restarts++;
+            }
+
+            // Change handling modes under running streams. Parallel channel handling applies to streams started later.
+            if (chance(200)) {
+                streamer.setBufferLeasingEnabled(!streamer.isBufferLeasingEnabled());
+                modeChanges++;
+            }
+            if (chance(200)) {
+                streamer.setParallelChannelHandlingEnabled(!streamer.isParallelChannelHandlingEnabled());
+                modeChanges++;
+            }
+            if (chance(200)) {
+                streamer.setDelayedBufferHandlingEnabled(!streamer.isDelayedBufferHandlingEnabled());
+                modeChanges++;
+            }
+
+            if (chance(50) && streamer.isStreaming(stream.type, stream.format)) {
+                streamer.requestSnapshot(stream.type, stream.format);
+            }
+            if (chance(10)) {
+                releaseRetained(states[streamIndex], counters);
+            }
+
+            // Handles remaining delayed buffers also after delayed handling was disabled
+            streamer.handleDelayedBuffers();
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - statusTime >= std::chrono::seconds(1)) {
+                LOG_INFO("%s", streamer.getStatusLine().c_str());
+                statusTime = now;
+            }
+            streamer.getLatencyStats();
+
+            std::this_thread::sleep_for(c_iterationInterval);
+        }
+
+        for (size_t i = 0; i < c_streamCount; i++) {
+            if (streamer.isStreaming(c_streams[i].type, c_streams[i].format)) {
+                stopStream(i);
+            }
+        }
+        streamer.handleDelayedBuffers(true);
+
+        const auto replayStats = replay.getStats();
+        LOG_INFO("Stress test done: frames=%llu, leased=%llu, retained=%llu, restarts=%llu, mode changes=%llu",
+            static_cast<unsigned long long>(counters.frames.load()), static_cast<unsigned long long>(counters.leasedFrames.load()),
+            static_cast<unsigned long long>(counters.retainedFrames.load()), static_cast<unsigned long long>(restarts),
+            static_cast<unsigned long long>(modeChanges));
+        LOG_INFO("Violations: corrupted frames=%llu, frames for stopped streams=%llu, overlapping callbacks=%llu, reordered frames=%llu, "
+                 "freed buffer lock or unlock=%llu",
+            static_cast<unsigned long long>(counters.corruptFrames.load()), static_cast<unsigned long long>(counters.lateFrames.load()),
+            static_cast<unsigned long long>(counters.overlappedFrames.load()), static_cast<unsigned long long>(counters.reorderedFrames.load()),
+            static_cast<unsigned long long>(replayStats.invalidBufferIds));
+
+        passed = counters.frames > 0 && counters.corruptFrames == 0 && counters.lateFrames == 0 && counters.overlappedFrames == 0 &&
+                 counters.reorderedFrames == 0 && replayStats.invalidBufferIds == 0;
+    }
+
+    std::filesystem::current_path(workingDir);
+    std::filesystem::remove_all(testDir, error);
+
+    LOG_INFO("DataStreamer stress test %s", passed ? "passed" : "FAILED");
+    return passed;
+}
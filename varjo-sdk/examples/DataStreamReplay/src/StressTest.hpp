@@ -0,0 +1,11 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+//! Run DataStreamer stress test for given number of seconds. Generates a recording with color, eye camera and cubemap
+//! streams and replays it as fast as possible from copied buffers, which are overwritten when their stream stops.
+//! Meanwhile the main thread keeps restarting streams, toggling buffer leasing, parallel channel and delayed buffer
+//! handling, requesting snapshots and holding on to buffer leases. Every frame passed to the frame callback is checked
+//! against the generated data. Does not need a headset or Varjo runtime. Returns false if a frame was corrupted, a
+//! frame callback arrived for a stopped stream or a freed buffer was locked or unlocked.
+bool runDataStreamerStressTest(double duration);
@@ -0,0 +1,222 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+/* Data Stream Replay
+ *
+ * - Replays a data stream recording through DataStreamer, the same data stream consumer the examples use
+ * - Does not need a headset or Varjo runtime: ReplayDataStreamApi.cpp is linked instead of VarjoLib
+ * - Reports received frames and latency per stream channel, and can record the replayed frames again
+ * - Stress test mode restarts streams and switches DataStreamer modes under a generated recording
+ * - Built only when CMake option EXAMPLES_REPLAY_DATASTREAM is enabled
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Globals.hpp"
+#include "DataStreamer.hpp"
+#include "FrameRecording.hpp"
+#include "ReplayDataStream.hpp"
+#include "StressTest.hpp"
+
+using namespace VarjoExamples;
+
+namespace
+{
+// Interval for logging DataStreamer status line
+constexpr std::chrono::seconds c_statusInterval{1};
+
+// Replay driver options
+struct Options {
+    std::string recording;             // Recording to replay
+    ReplayDataStream::Options replay;  // Replay options
+    double duration{0.0};              // Maximum replay duration in seconds, zero for no limit
+    bool bufferLeasing{false};         // Use zero-copy buffer leasing in DataStreamer
+    bool parallelChannels{false};      // Handle stream channels on worker threads
+    bool delayedBuffers{false};        // Handle buffers on main thread
+    std::string recordFile;            // Record replayed frames to given file
+    std::string latencyLogFile;        // Write latency statistics to given file
+};
+
+// Frames received by the frame callback for a stream channel
+struct ChannelCount {
+    uint64_t frames{0};  // Number of frames
+    uint64_t bytes{0};   // Number of buffer bytes
+};
+
+// Replay recording and return process exit code
+int runReplay(const Options& options)
+{
+    ReplayDataStream replay;
+    if (!replay.open(options.recording, options.replay)) {
+        LOG_ERROR("Opening recording failed: %s", options.recording.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Count frames per stream type and channel. Called from stream threads and channel workers.
+    std::mutex countMutex;
+    std::map<std::pair<varjo_StreamType, varjo_ChannelIndex>, ChannelCount> counts;
+    DataStreamer streamer(replay.getSession(), [&](const DataStreamer::Frame& frame) {
+        std::lock_guard<std::mutex> countLock(countMutex);
+        auto& count = counts[{frame.metadata.streamFrame.type, frame.metadata.channelIndex}];
+        count.frames++;
+        count.bytes += frame.metadata.bufferMetadata.byteSize;
+    });
+    streamer.setBufferLeasingEnabled(options.bufferLeasing);
+    streamer.setParallelChannelHandlingEnabled(options.parallelChannels);
+    streamer.setDelayedBufferHandlingEnabled(options.delayedBuffers);
+    if (!options.latencyLogFile.empty() && !streamer.setLatencyLogFile(options.latencyLogFile)) {
+        LOG_ERROR("Opening latency log failed: %s", options.latencyLogFile.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::shared_ptr<FrameRecorder> recorder;
+    if (!options.recordFile.empty()) {
+        recorder = std::make_shared<FrameRecorder>();
+        if (!recorder->open(options.recordFile)) {
+            LOG_ERROR("Opening recording for writing failed: %s", options.recordFile.c_str());
+            return EXIT_FAILURE;
+        }
+        streamer.setRecorder(recorder);
+    }
+
+    // Start all recorded streams with all recorded channels
+    std::vector<varjo_StreamConfig> configs(varjo_GetDataStreamConfigCount(replay.getSession()));
+    varjo_GetDataStreamConfigs(replay.getSession(), configs.data(), static_cast<int32_t>(configs.size()));
+    streamer.printStreamConfigs();
+    for (const auto& config : configs) {
+        streamer.startDataStream(config.streamType, config.format, config.channelFlags);
+    }
+
+    // Run until the replay has delivered all frames or the duration is up
+    const auto startTime = std::chrono::steady_clock::now();
+    auto statusTime = startTime;
+    while (!replay.isFinished()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (options.duration > 0.0 && std::chrono::duration<double>(now - startTime).count() >= options.duration) {
+            break;
+        }
+        if (now - statusTime >= c_statusInterval) {
+            LOG_INFO("%s", streamer.getStatusLine().c_str());
+            statusTime = now;
+        }
+
+        if (options.delayedBuffers) {
+            streamer.handleDelayedBuffers();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (options.delayedBuffers) {
+        streamer.handleDelayedBuffers();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Latency statistics are only available for running streams
+    const auto latencyStats = streamer.getLatencyStats();
+    for (const auto& config : configs) {
+        streamer.stopDataStream(config.streamType, config.format);
+    }
+    streamer.setRecorder(nullptr);
+
+    bool recordingFailed = false;
+    if (recorder) {
+        recordingFailed = !recorder->close();
+        const auto recorderStats = recorder->getStats();
+        LOG_INFO("Recorded %llu frames to %s, dropped %llu", static_cast<unsigned long long>(recorderStats.recordedFrames), options.recordFile.c_str(),
+            static_cast<unsigned long long>(recorderStats.droppedFrames));
+    }
+
+    const auto replayStats = replay.getStats();
+    LOG_INFO("Replayed for %.2f s: delivered=%llu, dropped=%llu, skipped=%llu", elapsed, static_cast<unsigned long long>(replayStats.deliveredFrames),
+        static_cast<unsigned long long>(replayStats.droppedFrames), static_cast<unsigned long long>(replayStats.skippedFrames));
+
+    LOG_INFO("%-8s %-8s %12s %12s", "Type", "Channel", "Frames", "MB");
+    uint64_t totalFrames = 0;
+    for (const auto& [key, count] : counts) {
+        LOG_INFO("%-8lld %-8lld %12llu %12.1f", key.first, key.second, static_cast<unsigned long long>(count.frames), count.bytes / (1024.0 * 1024.0));
+        totalFrames += count.frames;
+    }
+
+    LOG_INFO("Latency in microseconds (p50 / p99 / max):");
+    for (const auto& stats : latencyStats) {
+        LOG_INFO("  type=%lld, channel=%lld, frames=%llu: exposure to callback %.1f / %.1f / %.1f, callback to delivery %.1f / %.1f / %.1f",
+            stats.streamType, stats.channelIndex, static_cast<unsigned long long>(stats.frameCount), stats.exposureToCallback.p50 * 1e-3,
+            stats.exposureToCallback.p99 * 1e-3, stats.exposureToCallback.max * 1e-3, stats.callbackToDelivery.p50 * 1e-3,
+            stats.callbackToDelivery.p99 * 1e-3, stats.callbackToDelivery.max * 1e-3);
+    }
+
+    if (totalFrames == 0) {
+        LOG_ERROR("No frames were replayed.");
+        return EXIT_FAILURE;
+    }
+    return recordingFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace
+
+// Application entry point
+int main(int argc, char** argv)
+{
+    cxxopts::Options cmdOptions("DataStreamReplay", "Varjo data stream replay\nReplays a data stream recording through DataStreamer without Varjo system.");
+    cmdOptions.add_options()  //
+        ("recording", "Data stream recording to replay, e.g. recorded with EyeCameraStreamExample --record.",
+            cxxopts::value<std::string>()->default_value(""))  //
+        ("speed", "Replay speed relative to recording. Zero replays as fast as frames are consumed.",
+            cxxopts::value<double>()->default_value("1.0"))  //
+        ("loop", "Restart streams from the beginning when the recording ends.",
+            cxxopts::value<bool>()->default_value("false"))  //
+        ("duration", "Stop replay after given number of seconds. Zero replays until the recording ends.",
+            cxxopts::value<double>()->default_value("0"))  //
+        ("buffers", "Number of buffers per stream channel.",
+            cxxopts::value<int32_t>()->default_value(std::to_string(ReplayDataStream::c_defaultBufferCount)))  //
+        ("leasing", "Pass leased buffers to the frame callback instead of copies.",
+            cxxopts::value<bool>()->default_value("false"))  //
+        ("parallel-channels", "Handle stream channels on channel worker threads.",
+            cxxopts::value<bool>()->default_value("false"))  //
+        ("delayed", "Handle buffers on main thread instead of stream callbacks.",
+            cxxopts::value<bool>()->default_value("false"))  //
+        ("record", "Record replayed frames to given file.",
+            cxxopts::value<std::string>()->default_value(""))  //
+        ("latency-log", "Write latency statistics to given file once per second.",
+            cxxopts::value<std::string>()->default_value(""))  //
+        ("stress", "Run DataStreamer stress test for given number of seconds instead of replaying a recording.",
+            cxxopts::value<double>()->default_value("0"))  //
+        ("help", "Display help info");
+    cmdOptions.parse_positional({"recording"});
+
+    Options options;
+    try {
+        auto arguments = cmdOptions.parse(argc, argv);
+        const double stressDuration = arguments["stress"].as<double>();
+        if (stressDuration > 0.0 && !arguments.count("help")) {
+            return runDataStreamerStressTest(stressDuration) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (arguments.count("help") || arguments["recording"].as<std::string>().empty()) {
+            std::cout << cmdOptions.help();
+            return arguments.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        options.recording = arguments["recording"].as<std::string>();
+        options.replay.speed = arguments["speed"].as<double>();
+        options.replay.loop = arguments["loop"].as<bool>();
+        options.replay.bufferCount = arguments["buffers"].as<int32_t>();
+        options.duration = arguments["duration"].as<double>();
+        options.bufferLeasing = arguments["leasing"].as<bool>();
+        options.parallelChannels = arguments["parallel-channels"].as<bool>();
+        options.delayedBuffers = arguments["delayed"].as<bool>();
+        options.recordFile = arguments["record"].as<std::string>();
+        options.latencyLogFile = arguments["latency-log"].as<std::string>();
+    } catch (const std::exception& e) {
+        std::cerr << e.what();
+        return EXIT_FAILURE;
+    }
+
+    return runReplay(options);
+}
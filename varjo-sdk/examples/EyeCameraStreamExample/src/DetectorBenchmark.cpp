@@ -0,0 +1,114 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "DetectorBenchmark.hpp"
+
+#include <FrameBus.hpp>
+#include <FrameRecording.hpp>
+#include <Globals.hpp>
+
+namespace
+{
+// Returns detector options for frames transformed with given options
+PupilDetector::Options getDetectorOptions(const IApplication::Options& options)
+{
+    PupilDetector::Options detectorOptions;
+    detectorOptions.inputDownsample = options.detectTransform.downsample;
+    return detectorOptions;
+}
+
+}  // namespace
+
+DetectorBenchmark::DetectorBenchmark(const Options& options)
+    : m_options(options)
+    , m_detectors{PupilDetector(getDetectorOptions(options)), PupilDetector(getDetectorOptions(options))}
+{
+}
+
+void DetectorBenchmark::run()
+{
+    VarjoExamples::FrameRecording recording;
+    if (!recording.open(m_options.benchmarkRecording)) {
+        // Recording logs the reason
+        return;
+    }
+
+    // Collect Y8 eye camera frames of selected channels
+    std::vector<VarjoExamples::FrameRecording::FrameView> frames;
+    for (size_t i = 0; i < recording.getFrameCount(); ++i) {
+        const auto& entry = recording.getIndex()[i];
+        if (entry.streamType != varjo_StreamType_EyeCamera || !hasChannel(static_cast<size_t>(entry.channelIndex))) {
+            continue;
+        }
+
+        const auto optFrame = recording.getFrame(i);
+        if (optFrame && optFrame->data && optFrame->metadata->bufferMetadata.format == varjo_TextureFormat_Y8_UNORM) {
+            frames.push_back(*optFrame);
+        }
+    }
+
+    if (frames.empty()) {
+        LOG_ERROR("No eye camera frames in recording: %s", m_options.benchmarkRecording.c_str());
+        return;
+    }
+
+    // Apply the ingest transform the stream would apply before detection. Transformed frames replace
+    // the mapped frames, so that detection is timed on the same input as when streaming.
+    std::vector<VarjoExamples::DataStreamer::Frame> transformedFrames;
+    if (m_options.detectTransform.hasImageTransform()) {
+        transformedFrames.resize(frames.size());
+        const auto transformStartTime = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.size(); ++i) {
+            // Lease does not own the mapped data, recording outlives the frames
+            VarjoExamples::DataStreamer::Frame frame;
+            frame.metadata = *frames[i].metadata;
+            frame.lease = std::shared_ptr<const uint8_t>(std::shared_ptr<const uint8_t>(), frames[i].data);
+            if (!VarjoExamples::FrameBus::transformFrame(frame, m_options.detectTransform, transformedFrames[i])) {
+                LOG_ERROR("Transforming eye camera frame failed: %d x %d", frame.metadata.bufferMetadata.width, frame.metadata.bufferMetadata.height);
+                return;
+            }
+            frames[i] = {&transformedFrames[i].metadata, transformedFrames[i].data.data(), transformedFrames[i].data.size()};
+        }
+        const auto transformElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - transformStartTime).count();
+        const auto& buffer = transformedFrames.front().metadata.bufferMetadata;
+        LOG_INFO("Transformed %zu frames to %d x %d in %.3f s", frames.size(), buffer.width, buffer.height, transformElapsed);
+    }
+
+    // Allocate detector scratch memory and read mapped frame data before timing anything
+    volatile uint8_t pageData = 0;
+    for (const auto& frame : frames) {
+        const auto& buffer = frame.metadata->bufferMetadata;
+        m_detectors[static_cast<size_t>(frame.metadata->channelIndex)].reserve(buffer.width, buffer.height);
+        for (size_t offset = 0; offset < frame.size; offset += 4096) {
+            pageData = frame.data[offset];
+        }
+    }
+    static_cast<void>(pageData);
+
+    LOG_INFO("Benchmarking pupil and glint detection over %zu eye camera frames, %d passes", frames.size(), m_options.benchmarkPasses);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    size_t detectedFrames = 0;
+    for (int32_t pass = 0; pass < m_options.benchmarkPasses && !m_terminated; ++pass) {
+        for (const auto& frame : frames) {
+            const auto& metadata = *frame.metadata;
+            const auto& buffer = metadata.bufferMetadata;
+            const auto channelIndex = static_cast<size_t>(metadata.channelIndex);
+            const auto& eyeCameraMetadata = metadata.streamFrame.metadata.eyeCamera;
+            const auto glintMask = (channelIndex == 0) ? eyeCameraMetadata.glintMaskLeft : eyeCameraMetadata.glintMaskRight;
+            m_detectors[channelIndex].detect(frame.data, buffer.width, buffer.height, static_cast<size_t>(buffer.rowStride), glintMask);
+            detectedFrames++;
+        }
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    LOG_INFO("Processed %zu frames in %.3f s, %.0f frames/s", detectedFrames, elapsed, (elapsed > 0.0) ? detectedFrames / elapsed : 0.0);
+    for (size_t channelIndex = 0; channelIndex < m_detectors.size(); ++channelIndex) {
+        if (hasChannel(channelIndex)) {
+            LOG_INFO("%s eye: %s", (channelIndex == 0) ? "Left" : "Right", m_detectors[channelIndex].getStatusLine().c_str());
+        }
+    }
+}
+
+void DetectorBenchmark::terminate() { m_terminated = true; }
+
+bool DetectorBenchmark::hasChannel(size_t channelIndex) const { return (m_options.channels & (1ull << channelIndex)) != 0; }
@@ -0,0 +1,27 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "IApplication.hpp"
+#include "PupilDetector.hpp"
+
+// Application that runs pupil and glint detection over eye camera
+// frames of a data stream recording and reports per frame latencies.
+class DetectorBenchmark : public IApplication
+{
+public:
+    explicit DetectorBenchmark(const Options& options);
+
+    void run() override;
+    void terminate() override;
+
+private:
+    bool hasChannel(size_t channelIndex) const;
+
+    const Options m_options;
+    std::atomic_bool m_terminated{false};
+    std::array<PupilDetector, 2> m_detectors;
+};
@@ -3,12 +3,19 @@
 #include "EyeCameraStream.hpp"
 
 #include <functional>
+#include <utility>
 
-EyeCameraStream::EyeCameraStream(const std::shared_ptr<Session>& session, varjo_ChannelFlag channels)
+EyeCameraStream::EyeCameraStream(const std::shared_ptr<Session>& session, varjo_ChannelFlag channels, bool queueFrames)
     : m_session(session)
     , m_channels(channels)
+    , m_queueFrames(queueFrames)
     , m_dataStreamer(*m_session, std::bind(&EyeCameraStream::onFrameReceived, this, std::placeholders::_1))
 {
+    // Queued frames are copied and transformed frame bus payloads are produced from the runtime buffer in the frame
+    // callback, so there is no need for DataStreamer to copy the full frame first. Untransformed frame bus subscribers
+    // share the lease until they release the frame, so those queueing more frames than there are leases per stream
+    // need to set FrameBus::SubscriberOptions::copyLeasedFrames.
+    m_dataStreamer.setBufferLeasingEnabled(true);
 }
 
 std::optional<varjo_StreamConfig> EyeCameraStream::getConfig() const { return m_dataStreamer.getConfig(varjo_StreamType_EyeCamera); }
@@ -19,36 +26,58 @@ void EyeCameraStream::stopStream() { m_dataStreamer.stopDataStream(varjo_StreamT
 
 bool EyeCameraStream::getNextFrame(Frame& frame, varjo_ChannelIndex channelIndex)
 {
+    // Query time before locking, stream callback may be waiting for the lock
+    const auto now = varjo_GetCurrentTime(*m_session);
+
     std::lock_guard<std::mutex> lock(m_frameMutex);
     auto& frameQueue = m_frames[static_cast<size_t>(channelIndex)];
 
-    discardOldFrames(frameQueue);
-    if (frameQueue.empty()) {
+    discardOldFrames(frameQueue, now);
+    if (frameQueue.size == 0) {
         return false;
     }
 
-    // Pop first frame from queue
-    frame = frameQueue.front();
-    frameQueue.erase(frameQueue.begin());
+    // Pop first frame from queue. Swapping hands the buffer of the given frame to the queue for reuse.
+    std::swap(frame, frameQueue.at(0));
+    frameQueue.popFront();
     return true;
 }
 
 bool EyeCameraStream::getLatestFrame(Frame& frame, varjo_ChannelIndex channelIndex, bool keepLatest)
 {
+    const auto now = varjo_GetCurrentTime(*m_session);
+
     std::lock_guard<std::mutex> lock(m_frameMutex);
     auto& frameQueue = m_frames[static_cast<size_t>(channelIndex)];
 
-    discardOldFrames(frameQueue);
-    if (frameQueue.empty()) {
+    // Queue is in timestamp order, so if the latest frame is too old, all of them are
+    if ((frameQueue.size == 0) || (now - frameQueue.at(frameQueue.size - 1).metadata.timestamp > c_maximumCameraFrameAge)) {
+        while (frameQueue.size > 0) {
+            frameQueue.popFront();
+        }
         return false;
     }
 
-    // Return latest frame from the queue and discard others
-    frame = frameQueue.back();
+    // Discard all but the latest frame
+    while (frameQueue.size > 1) {
+        frameQueue.popFront();
+    }
+
+    // Return latest frame from the queue
+    auto& latest = frameQueue.at(0);
     if (keepLatest) {
-        frameQueue.erase(frameQueue.begin(), frameQueue.end() - 1);
+        // Latest frame is typically polled many times, only copy it when it has changed
+        const bool changed = (frame.metadata.streamFrame.frameNumber != latest.metadata.streamFrame.frameNumber) ||
+                             (frame.metadata.timestamp != latest.metadata.timestamp) || (frame.metadata.channelIndex != latest.metadata.channelIndex);
+        if (changed) {
+            // Copy assignment reuses the buffer of the given frame when it is large enough
+            frame.metadata = latest.metadata;
+            frame.data = latest.data;
+            frame.lease = latest.lease;
+        }
     } else {
-        frameQueue.clear();
+        std::swap(frame, latest);
+        frameQueue.popFront();
     }
 
     return true;
@@ -56,28 +85,57 @@ bool EyeCameraStream::getLatestFrame(Frame& frame, varjo_ChannelIndex channelInd
 
 void EyeCameraStream::onFrameReceived(const Frame& frame)
 {
+    // Subscribers with an ingest transform read the leased runtime buffer directly
+    m_frameBus.publish(frame);
+
+    if (!m_queueFrames) {
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(m_frameMutex);
     auto& frameQueue = m_frames[static_cast<size_t>(frame.metadata.channelIndex)];
 
-    // Discard old frames so that queue won't grow too big if application is not polling frames
-    discardOldFrames(frameQueue);
-    frameQueue.emplace_back(frame);
+    // Discard old frames so that queue won't grow too big if application is not polling frames.
+    // Frame timestamps use the same clock as varjo_GetCurrentTime(), so the new frame is a good enough reference.
+    discardOldFrames(frameQueue, frame.metadata.timestamp);
+    if (frameQueue.size == c_frameQueueCapacity) {
+        frameQueue.popFront();
+    }
+
+    // Copy frame to next free slot, reusing its buffer. Queued frames must not keep runtime buffers locked.
+    auto& slot = frameQueue.at(frameQueue.size);
+    const uint8_t* data = frame.getData();
+    const size_t size = frame.lease ? static_cast<size_t>(frame.metadata.bufferMetadata.byteSize) : frame.data.size();
+    slot.metadata = frame.metadata;
+    slot.data.assign(data, data + size);
+    slot.lease.reset();
+    ++frameQueue.size;
 }
 
-void EyeCameraStream::discardOldFrames(std::vector<Frame>& queue) const
+void EyeCameraStream::discardOldFrames(FrameQueue& queue, varjo_Nanoseconds now)
 {
-    const auto now = varjo_GetCurrentTime(*m_session);
-
-    auto it = queue.begin();
-    while (it != queue.end()) {
-        if (now - it->metadata.timestamp <= c_maximumCameraFrameAge) {
-            break;
-        }
-
-        ++it;
+    while ((queue.size > 0) && (now - queue.at(0).metadata.timestamp > c_maximumCameraFrameAge)) {
+        queue.popFront();
     }
+}
 
-    queue.erase(queue.begin(), it);
+void EyeCameraStream::FrameQueue::popFront()
+{
+    slots[head].lease.reset();
+    head = (head + 1) % c_frameQueueCapacity;
+    --size;
 }
 
 void EyeCameraStream::requestSnapshot() { m_dataStreamer.requestSnapshot(varjo_StreamType_EyeCamera, varjo_TextureFormat_Y8_UNORM); }
+
+void EyeCameraStream::requestBurstCapture(int32_t frameCount)
+{
+    m_dataStreamer.requestBurstCapture(varjo_StreamType_EyeCamera, varjo_TextureFormat_Y8_UNORM, frameCount);
+}
+
+void EyeCameraStream::setRecorder(std::shared_ptr<VarjoExamples::FrameRecorder> recorder) { m_dataStreamer.setRecorder(std::move(recorder)); }
+
+std::shared_ptr<VarjoExamples::FrameBus::Subscription> EyeCameraStream::subscribe(const VarjoExamples::FrameBus::SubscriberOptions& options)
+{
+    return m_frameBus.subscribe(options);
+}
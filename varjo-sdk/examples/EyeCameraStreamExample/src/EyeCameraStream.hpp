@@ -3,16 +3,23 @@
 #pragma once
 
 #include <DataStreamer.hpp>
+#include <FrameBus.hpp>
 
 #include "Session.hpp"
 
 //! Helper class for accessing Varjo eye tracking camera stream
+//!
+//! Runtime buffers are leased instead of copied by DataStreamer. Frames are copied once from the
+//! runtime buffer to the frame queue, unless it is disabled, and published to subscribers, which
+//! can crop, downsample or decimate frames with an ingest transform straight from the runtime buffer.
 class EyeCameraStream
 {
 public:
     using Frame = VarjoExamples::DataStreamer::Frame;
 
-    EyeCameraStream(const std::shared_ptr<Session>& session, varjo_ChannelFlag channels);
+    //! Construct stream for given channels. If queueFrames is false, frames are only passed to subscribers
+    //! and getNextFrame() and getLatestFrame() return no frames.
+    EyeCameraStream(const std::shared_ptr<Session>& session, varjo_ChannelFlag channels, bool queueFrames = true);
 
     //! Gets eye camera stream configuration.
     //! Returns std::nullopt if there was an error.
@@ -25,26 +32,58 @@ public:
     void stopStream();
 
     //! Get next eye camera frame from the queue
+    //! The frame is moved out of the queue, and the buffer previously held by the given frame
+    //! is recycled for later frames. Frame is not modified if the queue is empty.
     bool getNextFrame(Frame& frame, varjo_ChannelIndex channelIndex);
 
     //! Get latest eye camera frame from the queue and discard all other frames
     //! If keepLatest is false, also the latest frame is discarded and will not
     //! be returned in subsequent calls to to getLatestFrame() or getNextFrame().
+    //! If keepLatest is true, the latest frame is copied, otherwise it is moved like in getNextFrame().
     bool getLatestFrame(Frame& frame, varjo_ChannelIndex channelIndex, bool keepLatest);
 
     //! Requests making snapshot for next frame
     void requestSnapshot();
 
+    //! Requests capturing given number of consecutive frames to files
+    void requestBurstCapture(int32_t frameCount);
+
+    //! Set recorder for received frames, or null to stop recording
+    void setRecorder(std::shared_ptr<VarjoExamples::FrameRecorder> recorder);
+
+    //! Subscribe to eye camera frames, e.g. with an ingest transform. Subscription receives frames published after this call.
+    std::shared_ptr<VarjoExamples::FrameBus::Subscription> subscribe(const VarjoExamples::FrameBus::SubscriberOptions& options);
+
 private:
+    static constexpr varjo_Nanoseconds c_maximumCameraFrameAge = 250000000;  // 250ms
+    static constexpr size_t c_frameQueueCapacity = 64;                       // 250ms at 200Hz with some headroom
+
+    //! Fixed capacity frame queue of a single channel. Frame slots are preallocated and keep their
+    //! buffers when frames are removed, so received frames reuse the storage of earlier frames.
+    struct FrameQueue {
+        std::array<Frame, c_frameQueueCapacity> slots;  //!< Frame slots
+        size_t head{0};                                 //!< Slot of oldest frame
+        size_t size{0};                                 //!< Number of queued frames
+
+        //! Returns queued frame, index 0 being the oldest
+        Frame& at(size_t index) { return slots[(head + index) % c_frameQueueCapacity]; }
+
+        //! Remove oldest frame. Slot keeps its buffer for reuse.
+        void popFront();
+    };
+
     void onFrameReceived(const Frame& frame);
-    void discardOldFrames(std::vector<Frame>& queue) const;
 
-    static constexpr varjo_Nanoseconds c_maximumCameraFrameAge = 250000000;  // 250ms
+    //! Discard frames that are older than the maximum age relative to given time.
+    //! Frames are queued in timestamp order, so this only inspects the oldest frames.
+    static void discardOldFrames(FrameQueue& queue, varjo_Nanoseconds now);
 
     const std::shared_ptr<Session> m_session;
     const varjo_ChannelFlag m_channels;
+    const bool m_queueFrames;
+    VarjoExamples::FrameBus m_frameBus;  //!< Subscribers of received frames, destroyed after the data streamer
     VarjoExamples::DataStreamer m_dataStreamer;
 
-    mutable std::mutex m_frameMutex;             //!< Mutex for locking frame data
-    std::array<std::vector<Frame>, 2> m_frames;  //!< Received frames
+    mutable std::mutex m_frameMutex;     //!< Mutex for locking frame data
+    std::array<FrameQueue, 2> m_frames;  //!< Received frames
 };
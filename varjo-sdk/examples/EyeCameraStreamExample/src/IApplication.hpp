@@ -2,13 +2,22 @@
 
 #pragma once
 
+#include <string>
+
 #include <Varjo_types_datastream.h>
 
+#include <FrameBus.hpp>
+
 class IApplication
 {
 public:
     struct Options {
-        varjo_ChannelFlag channels;
+        varjo_ChannelFlag channels;                                  //!< Channels to stream
+        bool detectPupils{false};                                    //!< Run pupil and glint detection on streamed frames
+        VarjoExamples::FrameBus::IngestTransform detectTransform{};  //!< Crop and downsample of frames for detection
+        std::string recordingFile;                                   //!< Record streamed frames to this file if set
+        std::string benchmarkRecording;                              //!< Eye camera recording for detector benchmark
+        int32_t benchmarkPasses{1};                                  //!< Number of passes over the benchmark recording
     };
 
     virtual ~IApplication() = default;
@@ -0,0 +1,435 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "PupilDetector.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdio>
+
+#include <ColorConversion.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace VarjoExamples;
+
+namespace
+{
+// Downsample factor of the image used for adaptive pupil threshold, relative to camera resolution
+constexpr int32_t c_coarseFactor = 4;
+
+// Run capacity relative to frame pixel count. Frames with more runs are noise, not eyes.
+constexpr int32_t c_pixelsPerRun = 8;
+
+constexpr double c_pi = 3.14159265358979323846;
+
+// Returns index of lowest set bit of a non-zero value
+int getLowestBit(uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long bit = 0;
+    _BitScanForward(&bit, value);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+// Returns sum of squares of integers [0, n]
+inline int64_t sumOfSquares(int64_t n) { return n * (n + 1) * (2 * n + 1) / 6; }
+
+}  // namespace
+
+PupilDetector::PupilDetector()
+    : PupilDetector(Options{})
+{
+}
+
+PupilDetector::PupilDetector(const Options& options)
+    : m_options(options)
+    , m_limits(getLimits(options))
+{
+}
+
+PupilDetector::Limits PupilDetector::getLimits(const Options& options)
+{
+    // Frames downsampled at ingest need less downsampling for the threshold, none if already at the coarse size
+    const int32_t downsample = std::max(options.inputDownsample, 1);
+    const int32_t areaScale = downsample * downsample;
+
+    Limits limits;
+    limits.coarseFactor = std::max(c_coarseFactor / downsample, 1);
+    limits.minPupilArea = std::max(options.minPupilArea / areaScale, 1);
+    limits.maxPupilArea = std::max(options.maxPupilArea / areaScale, 1);
+    limits.maxPupilRunGap = options.maxPupilRunGap / downsample;
+    limits.minGlintArea = std::max(options.minGlintArea / areaScale, 1);
+    limits.maxGlintArea = std::max(options.maxGlintArea / areaScale, 1);
+    return limits;
+}
+
+void PupilDetector::reserve(int32_t width, int32_t height)
+{
+    if (width <= m_capacityWidth && height <= m_capacityHeight) {
+        return;
+    }
+
+    m_capacityWidth = std::max(width, m_capacityWidth);
+    m_capacityHeight = std::max(height, m_capacityHeight);
+
+    const size_t rowWords = (static_cast<size_t>(m_capacityWidth) + 31) / 32;
+    m_mask.resize(rowWords * m_capacityHeight);
+    if (m_limits.coarseFactor > 1) {
+        m_coarse.resize(static_cast<size_t>(m_capacityWidth / m_limits.coarseFactor) * (m_capacityHeight / m_limits.coarseFactor));
+    }
+
+    // Every run can start a new label, so labels need the same capacity
+    const size_t runCapacity = std::max<size_t>(static_cast<size_t>(m_capacityWidth) * m_capacityHeight / c_pixelsPerRun, m_capacityHeight);
+    m_runs.resize(runCapacity);
+    m_parents.resize(runCapacity);
+    m_blobs.resize(runCapacity);
+}
+
+const PupilDetector::Result& PupilDetector::detect(const uint8_t* data, int32_t width, int32_t height, size_t rowStride, uint32_t glintMask)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    reserve(width, height);
+
+    m_result = Result{};
+    m_result.enabledGlints = std::min(std::bitset<32>(glintMask).count(), c_maxGlints);
+    m_result.pupilThreshold = (m_options.pupilThreshold > 0) ? m_options.pupilThreshold : computePupilThreshold(data, width, height, rowStride);
+
+    if (labelBlobs(data, rowStride, 0, 0, width, height, static_cast<uint8_t>(m_result.pupilThreshold), false, m_limits.maxPupilRunGap)) {
+        findPupil(width, height);
+    } else {
+        m_result.overflow = true;
+    }
+
+    // Glints are only searched around the pupil, and only if glint LEDs are on
+    if (m_result.pupilFound && m_result.enabledGlints > 0) {
+        const auto& pupil = m_result.pupil;
+        const float radius = pupil.semiMajor * m_options.glintSearchRadius;
+        const int32_t x0 = std::clamp(static_cast<int32_t>(pupil.centerX - radius), 0, width);
+        const int32_t y0 = std::clamp(static_cast<int32_t>(pupil.centerY - radius), 0, height);
+        const int32_t x1 = std::clamp(static_cast<int32_t>(std::ceil(pupil.centerX + radius)), x0, width);
+        const int32_t y1 = std::clamp(static_cast<int32_t>(std::ceil(pupil.centerY + radius)), y0, height);
+
+        const auto glintThreshold = static_cast<uint8_t>(std::clamp(m_options.glintThreshold, 0, 255));
+        if (labelBlobs(data, rowStride, x0, y0, x1 - x0, y1 - y0, glintThreshold, true, 0)) {
+            findGlints();
+        } else {
+            m_result.overflow = true;
+        }
+    }
+
+    m_result.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Update statistics
+    m_frames++;
+    m_pupilFrames += m_result.pupilFound ? 1 : 0;
+    m_glints += m_result.glintCount;
+    m_overflowFrames += m_result.overflow ? 1 : 0;
+    m_overBudgetFrames += (m_result.duration > std::chrono::nanoseconds(m_options.frameBudget).count()) ? 1 : 0;
+    m_latency.record(m_result.duration);
+
+    return m_result;
+}
+
+PupilDetector::Stats PupilDetector::getStats() const
+{
+    Stats stats;
+    stats.frames = m_frames;
+    stats.pupilFrames = m_pupilFrames;
+    stats.glints = m_glints;
+    stats.overflowFrames = m_overflowFrames;
+    stats.overBudgetFrames = m_overBudgetFrames;
+    stats.latency = m_latency.getSnapshot().getSummary();
+    return stats;
+}
+
+std::string PupilDetector::getStatusLine() const
+{
+    const auto stats = getStats();
+    if (stats.frames == 0) {
+        return "No frames.";
+    }
+
+    const double frames = static_cast<double>(stats.frames);
+    char line[256];
+    snprintf(line, sizeof(line), "%llu frames, pupil %.1f%%, %.2f glints/frame, latency p50 %.1f us p99 %.1f us max %.1f us, %llu over %lld us budget",
+        static_cast<unsigned long long>(stats.frames), 100.0 * stats.pupilFrames / frames, stats.glints / frames, stats.latency.p50 / 1000.0,
+        stats.latency.p99 / 1000.0, stats.latency.max / 1000.0, static_cast<unsigned long long>(stats.overBudgetFrames),
+        static_cast<long long>(m_options.frameBudget.count()));
+    return line;
+}
+
+int32_t PupilDetector::computePupilThreshold(const uint8_t* data, int32_t width, int32_t height, size_t rowStride)
+{
+    // Box filtering removes sensor noise, so the percentile is not dominated by single dark pixels.
+    // Frames downsampled enough at ingest are used as they are.
+    const int32_t coarseWidth = width / m_limits.coarseFactor;
+    const int32_t coarseHeight = height / m_limits.coarseFactor;
+    const uint8_t* coarse = data;
+    size_t coarseStride = rowStride;
+    if (m_limits.coarseFactor > 1) {
+        ColorConversion::downsampleY8(data, rowStride, coarseWidth, coarseHeight, m_limits.coarseFactor, m_coarse.data(), coarseWidth);
+        coarse = m_coarse.data();
+        coarseStride = coarseWidth;
+    }
+
+    std::array<uint32_t, 256> histogram{};
+    for (int32_t y = 0; y < coarseHeight; y++) {
+        const uint8_t* row = coarse + coarseStride * y;
+        for (int32_t x = 0; x < coarseWidth; x++) {
+            histogram[row[x]]++;
+        }
+    }
+    const size_t pixelCount = static_cast<size_t>(coarseWidth) * coarseHeight;
+
+    const auto target = std::max<size_t>(static_cast<size_t>(pixelCount * m_options.pupilDarkPercentile / 100.0f), 1);
+    size_t count = 0;
+    int32_t value = 0;
+    for (; value < 255; value++) {
+        count += histogram[value];
+        if (count >= target) {
+            break;
+        }
+    }
+
+    return std::clamp(value + m_options.pupilThresholdOffset, 1, 255);
+}
+
+bool PupilDetector::labelBlobs(
+    const uint8_t* data, size_t rowStride, int32_t x, int32_t y, int32_t width, int32_t height, uint8_t threshold, bool bright, int32_t maxRunGap)
+{
+    m_runCount = 0;
+    m_labelCount = 0;
+    if (width <= 0 || height <= 0) {
+        return true;
+    }
+
+    const size_t rowWords = (static_cast<size_t>(width) + 31) / 32;
+    const auto mode = bright ? ColorConversion::ThresholdMode::Above : ColorConversion::ThresholdMode::Below;
+    ColorConversion::thresholdY8(data + rowStride * y + x, rowStride, width, height, threshold, mode, m_mask.data(), rowWords);
+
+    size_t prevBegin = 0;
+    size_t prevEnd = 0;
+    for (int32_t row = 0; row < height; row++) {
+        const uint32_t* mask = m_mask.data() + rowWords * row;
+        const size_t rowBegin = m_runCount;
+
+        // Find runs of set bits. Only words with bits set or a run in progress need any work.
+        int32_t runStart = -1;
+        for (size_t word = 0; word <= rowWords; word++) {
+            // Virtual word after the row ends a run reaching the last pixel
+            const uint32_t bits = (word < rowWords) ? mask[word] : 0;
+            const int32_t base = static_cast<int32_t>(word) * 32;
+            int32_t bit = 0;
+            while (bit < 32) {
+                const uint32_t remaining = (runStart < 0 ? bits : ~bits) & (~0u << bit);
+                if (remaining == 0) {
+                    break;
+                }
+                bit = getLowestBit(remaining);
+
+                if (runStart < 0) {
+                    runStart = base + bit;
+                } else {
+                    const int32_t runEnd = std::min(base + bit, width);
+                    if (m_runCount > rowBegin && (x + runStart) - m_runs[m_runCount - 1].x1 <= maxRunGap) {
+                        // Join to previous run over a small gap
+                        m_runs[m_runCount - 1].x1 = x + runEnd;
+                    } else {
+                        if (m_runCount == m_runs.size()) {
+                            return false;
+                        }
+                        m_runs[m_runCount++] = {x + runStart, x + runEnd, y + row, -1};
+                    }
+                    runStart = -1;
+                }
+            }
+        }
+
+        labelRow(rowBegin, m_runCount, prevBegin, prevEnd);
+        prevBegin = rowBegin;
+        prevEnd = m_runCount;
+    }
+
+    mergeBlobs();
+    return true;
+}
+
+void PupilDetector::labelRow(size_t rowBegin, size_t rowEnd, size_t prevBegin, size_t prevEnd)
+{
+    size_t prev = prevBegin;
+    for (size_t i = rowBegin; i < rowEnd; i++) {
+        Run& run = m_runs[i];
+
+        // Skip previous row runs left of this one. They are left of the following runs too.
+        while (prev < prevEnd && m_runs[prev].x1 < run.x0) {
+            prev++;
+        }
+
+        // Join labels of all 8-connected runs on the previous row. Union keeps the smaller label as root,
+        // so parents always have smaller labels than their children.
+        for (size_t j = prev; j < prevEnd && m_runs[j].x0 <= run.x1; j++) {
+            const int32_t root = findRoot(m_runs[j].label);
+            if (run.label < 0) {
+                run.label = root;
+                continue;
+            }
+
+            const int32_t ownRoot = findRoot(run.label);
+            if (root < ownRoot) {
+                m_parents[ownRoot] = root;
+            } else if (ownRoot < root) {
+                m_parents[root] = ownRoot;
+            }
+        }
+
+        if (run.label < 0) {
+            run.label = m_labelCount++;
+            m_parents[run.label] = run.label;
+            m_blobs[run.label] = {0, 0, 0, 0, 0, 0, run.x0, run.y, run.x1 - 1, run.y};
+        }
+
+        // Accumulate run moments to its label. Labels are added to their roots when labeling is done.
+        const int64_t n = run.x1 - run.x0;
+        const int64_t sumX = (static_cast<int64_t>(run.x0) + run.x1 - 1) * n / 2;
+        auto& blob = m_blobs[run.label];
+        blob.area += n;
+        blob.sumX += sumX;
+        blob.sumY += n * run.y;
+        blob.sumXX += sumOfSquares(run.x1 - 1) - sumOfSquares(run.x0 - 1);
+        blob.sumYY += n * run.y * run.y;
+        blob.sumXY += sumX * run.y;
+        blob.minX = std::min(blob.minX, run.x0);
+        blob.maxX = std::max(blob.maxX, run.x1 - 1);
+        blob.maxY = std::max(blob.maxY, run.y);
+    }
+}
+
+int32_t PupilDetector::findRoot(int32_t label)
+{
+    int32_t root = label;
+    while (m_parents[root] != root) {
+        root = m_parents[root];
+    }
+
+    // Compress path
+    while (m_parents[label] != root) {
+        const int32_t parent = m_parents[label];
+        m_parents[label] = root;
+        label = parent;
+    }
+    return root;
+}
+
+void PupilDetector::mergeBlobs()
+{
+    // Parents have smaller labels, so going backwards moves all moments to roots
+    for (int32_t label = m_labelCount - 1; label > 0; label--) {
+        const int32_t parent = m_parents[label];
+        if (parent == label) {
+            continue;
+        }
+
+        const auto& blob = m_blobs[label];
+        auto& target = m_blobs[parent];
+        target.area += blob.area;
+        target.sumX += blob.sumX;
+        target.sumY += blob.sumY;
+        target.sumXX += blob.sumXX;
+        target.sumYY += blob.sumYY;
+        target.sumXY += blob.sumXY;
+        target.minX = std::min(target.minX, blob.minX);
+        target.minY = std::min(target.minY, blob.minY);
+        target.maxX = std::max(target.maxX, blob.maxX);
+        target.maxY = std::max(target.maxY, blob.maxY);
+    }
+}
+
+void PupilDetector::findPupil(int32_t width, int32_t height)
+{
+    const Blob* best = nullptr;
+    Ellipse bestEllipse{};
+    for (int32_t label = 0; label < m_labelCount; label++) {
+        const auto& blob = m_blobs[label];
+        if (m_parents[label] != label || blob.area < m_limits.minPupilArea || blob.area > m_limits.maxPupilArea) {
+            continue;
+        }
+
+        // Dark image corners and eyelashes reach the frame edges
+        if (blob.minX == 0 || blob.minY == 0 || blob.maxX == width - 1 || blob.maxY == height - 1) {
+            continue;
+        }
+
+        if (best && blob.area <= best->area) {
+            continue;
+        }
+
+        // Fit ellipse with the same second moments. Variance along an axis of a filled ellipse is a quarter of
+        // the squared semi-axis.
+        const double area = static_cast<double>(blob.area);
+        const double meanX = blob.sumX / area;
+        const double meanY = blob.sumY / area;
+        const double varX = blob.sumXX / area - meanX * meanX;
+        const double varY = blob.sumYY / area - meanY * meanY;
+        const double covXY = blob.sumXY / area - meanX * meanY;
+        const double halfSum = 0.5 * (varX + varY);
+        const double spread = std::sqrt(0.25 * (varX - varY) * (varX - varY) + covXY * covXY);
+        const double semiMajor = 2.0 * std::sqrt(std::max(halfSum + spread, 0.0));
+        const double semiMinor = 2.0 * std::sqrt(std::max(halfSum - spread, 0.0));
+        if (semiMajor <= 0.0 || semiMinor < semiMajor * m_options.minPupilAspect || area < c_pi * semiMajor * semiMinor * m_options.minPupilFill) {
+            continue;
+        }
+
+        best = &blob;
+        bestEllipse.centerX = static_cast<float>(meanX + 0.5);
+        bestEllipse.centerY = static_cast<float>(meanY + 0.5);
+        bestEllipse.semiMajor = static_cast<float>(semiMajor);
+        bestEllipse.semiMinor = static_cast<float>(semiMinor);
+        bestEllipse.angle = static_cast<float>(0.5 * std::atan2(2.0 * covXY, varX - varY));
+    }
+
+    if (best) {
+        m_result.pupilFound = true;
+        m_result.pupil = bestEllipse;
+        m_result.pupilArea = static_cast<int32_t>(best->area);
+    }
+}
+
+void PupilDetector::findGlints()
+{
+    // Keep the glints nearest to the pupil center, as many as there are LEDs enabled. Glints are few,
+    // so insertion into the sorted result array is fast enough.
+    std::array<float, c_maxGlints> distances{};
+    auto& glints = m_result.glints;
+    size_t& count = m_result.glintCount;
+    const auto& pupil = m_result.pupil;
+
+    for (int32_t label = 0; label < m_labelCount; label++) {
+        const auto& blob = m_blobs[label];
+        if (m_parents[label] != label || blob.area < m_limits.minGlintArea || blob.area > m_limits.maxGlintArea) {
+            continue;
+        }
+
+        const float area = static_cast<float>(blob.area);
+        const Glint glint{blob.sumX / area + 0.5f, blob.sumY / area + 0.5f, static_cast<int32_t>(blob.area)};
+        const float distance = std::hypot(glint.x - pupil.centerX, glint.y - pupil.centerY);
+        if (count == m_result.enabledGlints && distance >= distances[count - 1]) {
+            continue;
+        }
+
+        size_t index = std::min(count, m_result.enabledGlints - 1);
+        for (; index > 0 && distances[index - 1] > distance; index--) {
+            glints[index] = glints[index - 1];
+            distances[index] = distances[index - 1];
+        }
+        glints[index] = glint;
+        distances[index] = distance;
+        count = std::min(count + 1, m_result.enabledGlints);
+    }
+}
@@ -0,0 +1,195 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <LatencyHistogram.hpp>
+
+//! CPU pupil and glint detector for a single eye camera.
+//!
+//! Pupil is found as the largest dark blob of elliptical shape, and glints as small bright blobs
+//! around it. Frames are thresholded to bit masks with vectorized kernels, and blobs are labeled
+//! from the runs of set mask bits, so only the few pixels passing the threshold are visited after
+//! thresholding. Pupil ellipse and glint centers are computed from blob moments accumulated per run.
+//!
+//! Frames can be cropped or downsampled before detection, e.g. by a frame bus ingest transform.
+//! Pixel sizes in options are given at camera resolution and scaled by the input downsample factor,
+//! and results are in input image coordinates.
+//!
+//! Scratch memory is allocated by reserve() for the largest frame size, so detection does not
+//! allocate. Detector is not thread safe, use one detector per eye.
+class PupilDetector
+{
+public:
+    //! Maximum number of glints per eye. Varjo devices have up to 12 glint LEDs per eye.
+    static constexpr size_t c_maxGlints = 12;
+
+    //! Detector options
+    struct Options {
+        int32_t pupilThreshold{0};                    //!< Pupil intensity threshold, zero for adaptive threshold
+        float pupilDarkPercentile{0.1f};              //!< Adaptive threshold: percentile of image intensities inside the pupil
+        int32_t pupilThresholdOffset{20};             //!< Adaptive threshold: intensity added to the percentile value
+        int32_t minPupilArea{200};                    //!< Smallest pupil area in pixels
+        int32_t maxPupilArea{40000};                  //!< Largest pupil area in pixels
+        float minPupilAspect{0.4f};                   //!< Smallest ratio of pupil minor and major axes
+        float minPupilFill{0.75f};                    //!< Smallest ratio of pupil blob area to fitted ellipse area
+        int32_t maxPupilRunGap{6};                    //!< Dark runs at most this far apart are joined, fills glints in the pupil
+        int32_t glintThreshold{220};                  //!< Glint intensity threshold
+        int32_t minGlintArea{2};                      //!< Smallest glint area in pixels
+        int32_t maxGlintArea{200};                    //!< Largest glint area in pixels
+        float glintSearchRadius{3.0f};                //!< Glint search area half size relative to pupil semi-major axis
+        std::chrono::microseconds frameBudget{1000};  //!< Time budget per frame, slower detections are counted
+        int32_t inputDownsample{1};                   //!< Downsample factor of input frames relative to camera resolution
+    };
+
+    //! Ellipse in image pixel coordinates
+    struct Ellipse {
+        float centerX{0.0f};    //!< Center x coordinate
+        float centerY{0.0f};    //!< Center y coordinate
+        float semiMajor{0.0f};  //!< Semi-major axis length
+        float semiMinor{0.0f};  //!< Semi-minor axis length
+        float angle{0.0f};      //!< Major axis angle from x axis in radians
+    };
+
+    //! Glint in image pixel coordinates
+    struct Glint {
+        float x{0.0f};    //!< Center x coordinate
+        float y{0.0f};    //!< Center y coordinate
+        int32_t area{0};  //!< Area in pixels
+    };
+
+    //! Detection result of a frame
+    struct Result {
+        bool pupilFound{false};                   //!< Flag indicating whether pupil was found
+        Ellipse pupil{};                          //!< Pupil ellipse
+        int32_t pupilArea{0};                     //!< Pupil blob area in pixels
+        int32_t pupilThreshold{0};                //!< Pupil threshold used for the frame
+        std::array<Glint, c_maxGlints> glints{};  //!< Glints ordered by distance from pupil center
+        size_t glintCount{0};                     //!< Number of detected glints
+        size_t enabledGlints{0};                  //!< Number of enabled glint LEDs, limits detected glints
+        bool overflow{false};                     //!< Too many blobs in frame, some were not analyzed
+        int64_t duration{0};                      //!< Detection time in nanoseconds
+    };
+
+    //! Detector statistics
+    struct Stats {
+        uint64_t frames{0};                                //!< Number of processed frames
+        uint64_t pupilFrames{0};                           //!< Number of frames with pupil found
+        uint64_t glints{0};                                //!< Total number of detected glints
+        uint64_t overflowFrames{0};                        //!< Number of frames with too many blobs
+        uint64_t overBudgetFrames{0};                      //!< Number of frames exceeding the time budget
+        VarjoExamples::LatencyHistogram::Summary latency;  //!< Detection time per frame in nanoseconds
+    };
+
+    //! Construct detector with default options
+    PupilDetector();
+
+    //! Construct detector with given options
+    explicit PupilDetector(const Options& options);
+
+    // Disable copy, move and assign
+    PupilDetector(const PupilDetector& other) = delete;
+    PupilDetector(const PupilDetector&& other) = delete;
+    PupilDetector& operator=(const PupilDetector& other) = delete;
+    PupilDetector& operator=(const PupilDetector&& other) = delete;
+
+    //! Allocate scratch memory for frames up to given size. Called by detect() for larger frames.
+    void reserve(int32_t width, int32_t height);
+
+    //! Detect pupil and glints from Y8 eye camera image. Glint mask of the eye tells which glint LEDs are enabled.
+    const Result& detect(const uint8_t* data, int32_t width, int32_t height, size_t rowStride, uint32_t glintMask);
+
+    //! Returns result of the latest frame
+    const Result& getResult() const { return m_result; }
+
+    //! Returns detector statistics
+    Stats getStats() const;
+
+    //! Returns detection rates and latency percentiles as a single line of text
+    std::string getStatusLine() const;
+
+    //! Returns detector options
+    const Options& getOptions() const { return m_options; }
+
+private:
+    //! Run of set mask bits in a row, end exclusive
+    struct Run {
+        int32_t x0;     //!< First pixel
+        int32_t x1;     //!< Pixel after the last one
+        int32_t y;      //!< Row
+        int32_t label;  //!< Blob label
+    };
+
+    //! Pixel limits of options at input resolution
+    struct Limits {
+        int32_t coarseFactor;    //!< Downsample factor of the image for adaptive threshold
+        int32_t minPupilArea;    //!< Smallest pupil area
+        int32_t maxPupilArea;    //!< Largest pupil area
+        int32_t maxPupilRunGap;  //!< Largest joined gap between dark runs
+        int32_t minGlintArea;    //!< Smallest glint area
+        int32_t maxGlintArea;    //!< Largest glint area
+    };
+
+    //! Returns option pixel limits scaled by input downsample factor
+    static Limits getLimits(const Options& options);
+
+    //! Blob moments and bounds, accumulated from runs
+    struct Blob {
+        int64_t area;   //!< Number of pixels
+        int64_t sumX;   //!< Sum of x coordinates
+        int64_t sumY;   //!< Sum of y coordinates
+        int64_t sumXX;  //!< Sum of squared x coordinates
+        int64_t sumYY;  //!< Sum of squared y coordinates
+        int64_t sumXY;  //!< Sum of x and y coordinate products
+        int32_t minX;   //!< Left edge
+        int32_t minY;   //!< Top edge
+        int32_t maxX;   //!< Right edge, inclusive
+        int32_t maxY;   //!< Bottom edge, inclusive
+    };
+
+    //! Returns adaptive pupil threshold computed from downsampled image histogram
+    int32_t computePupilThreshold(const uint8_t* data, int32_t width, int32_t height, size_t rowStride);
+
+    //! Threshold given image region and label its blobs. Returns false if blob capacity was exceeded.
+    bool labelBlobs(const uint8_t* data, size_t rowStride, int32_t x, int32_t y, int32_t width, int32_t height, uint8_t threshold, bool bright,
+        int32_t maxRunGap);
+
+    //! Label runs of a row against overlapping runs of the previous row and accumulate their moments
+    void labelRow(size_t rowBegin, size_t rowEnd, size_t prevBegin, size_t prevEnd);
+
+    //! Returns root label of given label
+    int32_t findRoot(int32_t label);
+
+    //! Add moments of labels to their roots
+    void mergeBlobs();
+
+    //! Find pupil from labeled dark blobs. Blobs touching the frame edges are ignored.
+    void findPupil(int32_t width, int32_t height);
+
+    //! Find glints nearest to the pupil from labeled bright blobs
+    void findGlints();
+
+    const Options m_options;                    //!< Detector options
+    const Limits m_limits;                      //!< Pixel limits at input resolution
+    int32_t m_capacityWidth{0};                 //!< Largest supported frame width
+    int32_t m_capacityHeight{0};                //!< Largest supported frame height
+    std::vector<uint32_t> m_mask;               //!< Threshold bit mask
+    std::vector<uint8_t> m_coarse;              //!< Downsampled image for adaptive threshold
+    std::vector<Run> m_runs;                    //!< Runs of the labeled region
+    size_t m_runCount{0};                       //!< Number of used runs
+    std::vector<int32_t> m_parents;             //!< Union-find parent of each label
+    std::vector<Blob> m_blobs;                  //!< Blob of each label
+    int32_t m_labelCount{0};                    //!< Number of used labels
+    Result m_result;                            //!< Latest result
+    uint64_t m_frames{0};                       //!< Number of processed frames
+    uint64_t m_pupilFrames{0};                  //!< Number of frames with pupil
+    uint64_t m_glints{0};                       //!< Number of detected glints
+    uint64_t m_overflowFrames{0};               //!< Number of frames with too many blobs
+    uint64_t m_overBudgetFrames{0};             //!< Number of frames over time budget
+    VarjoExamples::LatencyHistogram m_latency;  //!< Detection time histogram
+};
@@ -2,11 +2,49 @@
 
 #include "StreamingApplication.hpp"
 
+#include <FrameRecording.hpp>
+
+namespace
+{
+// Detection frames queued per channel. Frames are handled every 20ms, which is 4 frames at 200Hz.
+constexpr size_t c_detectQueueDepth = 16;
+
+// Returns detector options for frames transformed with given options
+PupilDetector::Options getDetectorOptions(const IApplication::Options& options)
+{
+    PupilDetector::Options detectorOptions;
+    detectorOptions.inputDownsample = options.detectTransform.downsample;
+    return detectorOptions;
+}
+
+}  // namespace
+
 StreamingApplication::StreamingApplication(const std::shared_ptr<Session>& session, const Options& options)
     : m_channels(options.channels)
-    , m_stream(session, options.channels)
+    , m_stream(session, options.channels, !options.detectPupils)
     , m_fpsCalculator(std::chrono::seconds(10))  // Print FPS every 10s
+    , m_detectPupils(options.detectPupils)
+    , m_recordingFile(options.recordingFile)
+    , m_detectors{PupilDetector(getDetectorOptions(options)), PupilDetector(getDetectorOptions(options))}
 {
+    // Detection gets frames from the stream cropped and downsampled at ingest, so full frames are not queued at all
+    if (m_detectPupils) {
+        for (size_t channelIndex = 0; channelIndex < m_detectSubscriptions.size(); ++channelIndex) {
+            if (!hasChannel(channelIndex)) {
+                continue;
+            }
+
+            VarjoExamples::FrameBus::SubscriberOptions subscriberOptions;
+            subscriberOptions.name = (channelIndex == 0) ? "leftDetector" : "rightDetector";
+            subscriberOptions.streamType = varjo_StreamType_EyeCamera;
+            subscriberOptions.channels = static_cast<varjo_ChannelFlag>(1ull << channelIndex);
+            subscriberOptions.queueDepth = c_detectQueueDepth;
+            subscriberOptions.transform = options.detectTransform;
+            // Queue is deeper than the stream lease limit, so untransformed frames must not keep runtime buffers locked
+            subscriberOptions.copyLeasedFrames = true;
+            m_detectSubscriptions[channelIndex] = m_stream.subscribe(subscriberOptions);
+        }
+    }
 }
 
 void StreamingApplication::run()
@@ -18,6 +56,25 @@ void StreamingApplication::run()
         return;
     }
 
+    // Allocate detector memory up front, so that detection does not allocate while streaming. Transformed frames
+    // are never larger than the stream frames.
+    if (m_detectPupils) {
+        for (auto& detector : m_detectors) {
+            detector.reserve(optStreamConfig->width, optStreamConfig->height);
+        }
+    }
+
+    // Record frames from the start of the stream
+    std::shared_ptr<VarjoExamples::FrameRecorder> recorder;
+    if (!m_recordingFile.empty()) {
+        recorder = std::make_shared<VarjoExamples::FrameRecorder>();
+        if (recorder->open(m_recordingFile)) {
+            m_stream.setRecorder(recorder);
+        } else {
+            recorder.reset();
+        }
+    }
+
     // Start streaming
     m_stream.startStream();
 
@@ -35,12 +92,33 @@ void StreamingApplication::run()
         handleNewFrames();
         std::this_thread::sleep_for(std::chrono::milliseconds(20));
     }
+
+    // Stop feeding frames before closing, closing writes the frames still buffered
+    if (recorder) {
+        m_stream.setRecorder(nullptr);
+        recorder->close();
+    }
 }
 
 void StreamingApplication::terminate() { m_terminated = true; }
 
 bool StreamingApplication::hasChannel(size_t channelIndex) const { return (m_channels & (1ull << channelIndex)) != 0; }
 
+bool StreamingApplication::fetchFrame(size_t channelIndex)
+{
+    const auto& subscription = m_detectSubscriptions[channelIndex];
+    if (!subscription) {
+        return m_stream.getNextFrame(m_frame[channelIndex], static_cast<varjo_ChannelIndex>(channelIndex));
+    }
+
+    // Transformed frame is kept for detection, frame matching only needs its metadata
+    if (!subscription->tryPop(m_detectFrames[channelIndex])) {
+        return false;
+    }
+    m_frame[channelIndex].metadata = m_detectFrames[channelIndex]->metadata;
+    return true;
+}
+
 std::optional<int64_t> StreamingApplication::getCommonFrameNumber() const
 {
     std::optional<int64_t> frameNumber;
@@ -74,7 +152,7 @@ void StreamingApplication::handleNewFrames()
         const auto channelIndex = nextChannelIsLeft ? 0 : 1;
 
         // Fetch the frame
-        const bool success = m_stream.getNextFrame(m_frame[channelIndex], channelIndex);
+        const bool success = fetchFrame(channelIndex);
 
         // Update frame and queue status
         m_validFrame[channelIndex] = m_validFrame[channelIndex] || success;
@@ -91,9 +169,13 @@ void StreamingApplication::handleNewFrames()
 
 void StreamingApplication::update()
 {
-    // m_frame array contains eye camera data. This example doesn't use that data,
-    // but is only updating frame statistics. See UIApplication for more information
-    // on how to use the streamed data.
+    // m_frame array contains eye camera data. Unless pupil detection is enabled, this example
+    // doesn't use that data, but is only updating frame statistics. With pupil detection, m_frame
+    // only holds frame metadata and detection uses the transformed frames of the detection
+    // subscriptions. See UIApplication for more information on how to use the streamed data.
+    if (m_detectPupils) {
+        detectPupils();
+    }
 
     // Update FPS calculator
     m_fpsCalculator.frameReceived(m_frameNumber);
@@ -102,5 +184,34 @@ void StreamingApplication::update()
     const auto optStatsUpdate = m_fpsCalculator.getStatsUpdate();
     if (optStatsUpdate.has_value()) {
         LOG_INFO("Frame %lli FPS %.1f Dropped %zu frames", optStatsUpdate->frameNumber, optStatsUpdate->fps, optStatsUpdate->droppedFrames);
+
+        if (m_detectPupils) {
+            for (size_t channelIndex = 0; channelIndex < m_detectors.size(); ++channelIndex) {
+                if (hasChannel(channelIndex)) {
+                    LOG_INFO("%s eye: %s", (channelIndex == 0) ? "Left" : "Right", m_detectors[channelIndex].getStatusLine().c_str());
+                }
+            }
+        }
+    }
+}
+
+void StreamingApplication::detectPupils()
+{
+    for (size_t channelIndex = 0; channelIndex < m_frame.size(); ++channelIndex) {
+        if (!hasChannel(channelIndex) || !m_detectFrames[channelIndex]) {
+            continue;
+        }
+
+        const auto& frame = *m_detectFrames[channelIndex];
+        const auto& buffer = frame.metadata.bufferMetadata;
+        const uint8_t* data = frame.getData();
+        if (buffer.format != varjo_TextureFormat_Y8_UNORM || data == nullptr) {
+            continue;
+        }
+
+        // Glint LEDs of both eyes are reported in the metadata of each frame
+        const auto& eyeCameraMetadata = frame.metadata.streamFrame.metadata.eyeCamera;
+        const auto glintMask = (channelIndex == 0) ? eyeCameraMetadata.glintMaskLeft : eyeCameraMetadata.glintMaskRight;
+        m_detectors[channelIndex].detect(data, buffer.width, buffer.height, static_cast<size_t>(buffer.rowStride), glintMask);
     }
 }
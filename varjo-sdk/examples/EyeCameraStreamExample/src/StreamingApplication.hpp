@@ -5,6 +5,7 @@
 #include "EyeCameraStream.hpp"
 #include "FPSCalculator.hpp"
 #include "IApplication.hpp"
+#include "PupilDetector.hpp"
 #include "Session.hpp"
 
 // Application that streams all possible frames
@@ -24,6 +25,9 @@ private:
     //! This is used to avoid partial left/right channel updates to output.
     std::optional<int64_t> getCommonFrameNumber() const;
 
+    //! Fetch next frame of given channel to m_frame. Returns false if there are no queued frames.
+    bool fetchFrame(size_t channelIndex);
+
     //! Handles all queued frames from the stream
     void handleNewFrames();
 
@@ -31,6 +35,9 @@ private:
     //! frame numbers for selected channels
     void update();
 
+    //! Run pupil and glint detection for frames of selected channels
+    void detectPupils();
+
     const varjo_ChannelFlag m_channels{};
     EyeCameraStream m_stream;
     std::atomic_bool m_terminated{false};
@@ -38,4 +45,9 @@ private:
     std::array<bool, 2> m_validFrame{};
     int64_t m_frameNumber = 0;
     FPSCalculator m_fpsCalculator;
+    const bool m_detectPupils{false};
+    const std::string m_recordingFile;
+    std::array<PupilDetector, 2> m_detectors;
+    std::array<std::shared_ptr<VarjoExamples::FrameBus::Subscription>, 2> m_detectSubscriptions;  //!< Transformed frames for detection
+    std::array<VarjoExamples::FrameBus::FramePtr, 2> m_detectFrames;                             //!< Latest transformed frames
 };
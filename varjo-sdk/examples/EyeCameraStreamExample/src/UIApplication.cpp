@@ -127,9 +127,12 @@ bool UIApplication::onFrameCallback()
 
 void UIApplication::onKeyCallback(unsigned int key)
 {
+    constexpr int32_t c_burstFrameCount = 30;  // Number of consecutive frames in a burst capture
+
     switch (key) {
         case VK_ESCAPE: terminate(); break;
         case VK_SPACE: m_stream.requestSnapshot(); break;
+        case 'B': m_stream.requestBurstCapture(c_burstFrameCount); break;
     }
 }
 
@@ -230,7 +233,7 @@ void UIApplication::drawFrames(uint8_t* output, size_t outputRowStride)
     for (size_t i = 0; i < m_frame.size(); ++i) {
         if (hasChannel(i)) {
             // Convert frame to R8G8B8A8
-            VarjoExamples::DataStreamer::convertToR8G8B8A(m_frame[i].metadata.bufferMetadata, m_frame[i].data.data(), output, outputRowStride);
+            VarjoExamples::DataStreamer::convertToR8G8B8A(m_frame[i].metadata.bufferMetadata, m_frame[i].getData(), output, outputRowStride);
 
             // Get glint mask
             const auto& eyeCameraMetadata = m_frame[i].metadata.streamFrame.metadata.eyeCamera;
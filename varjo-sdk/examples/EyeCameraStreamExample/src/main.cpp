@@ -3,10 +3,12 @@
 /* Eye Tracking Camera Stream Example application
  *
  * - Showcases how eye tracking camera stream can be retrieved using Varjo data stream API
+ * - Detects pupils and glints from the stream on CPU, and benchmarks detection over recorded streams
  */
 
 #include <cxxopts.hpp>
 
+#include "DetectorBenchmark.hpp"
 #include "Session.hpp"
 #include "StreamingApplication.hpp"
 #include "UIApplication.hpp"
@@ -25,6 +27,7 @@ BOOL WINAPI CtrlHandler(DWORD dwCtrlType)
 
 // Command line parsing helpers
 varjo_ChannelFlag parseChannels(const std::string& str);
+int32_t parseDownsample(int32_t factor);
 
 std::string getAppNameAndVersionText() { return std::string("Varjo Eye Tracking Camera Example ") + varjo_GetVersionString(); }
 
@@ -39,6 +42,20 @@ int main(int argc, char** argv)
             cxxopts::value<std::string>()->default_value("both"))  //
         ("streaming", "Run streaming FPS test instead default UI application.",
             cxxopts::value<bool>()->default_value("false"))  //
+        ("detect", "Detect pupils and glints in streaming FPS test.",
+            cxxopts::value<bool>()->default_value("false"))  //
+        ("detect-downsample", "Downsample eye camera frames by 1, 2 or 4 at stream ingest for detection.",
+            cxxopts::value<int32_t>()->default_value("1"))  //
+        ("detect-roi-width", "Crop eye camera frames to given centered width at stream ingest for detection. Zero keeps full width.",
+            cxxopts::value<int32_t>()->default_value("0"))  //
+        ("detect-roi-height", "Crop eye camera frames to given centered height at stream ingest for detection. Zero keeps full height.",
+            cxxopts::value<int32_t>()->default_value("0"))  //
+        ("record", "Record eye camera stream to given file in streaming FPS test. Recordings can be used for detection benchmark.",
+            cxxopts::value<std::string>()->default_value(""))  //
+        ("benchmark", "Benchmark pupil and glint detection over given data stream recording. Does not need Varjo system.",
+            cxxopts::value<std::string>()->default_value(""))  //
+        ("benchmark-passes", "Number of passes over the recording in detection benchmark.",
+            cxxopts::value<int32_t>()->default_value("1"))  //
         ("help", "Display help info");
 
     IApplication::Options appOptions;
@@ -53,6 +70,14 @@ int main(int argc, char** argv)
 
         useStreamingApp = arguments["streaming"].as<bool>();
         appOptions.channels = parseChannels(arguments["channels"].as<std::string>());
+        appOptions.detectPupils = arguments["detect"].as<bool>();
+        appOptions.detectTransform.downsample = parseDownsample(arguments["detect-downsample"].as<int32_t>());
+        appOptions.detectTransform.roiWidth = std::max(arguments["detect-roi-width"].as<int32_t>(), 0);
+        appOptions.detectTransform.roiHeight = std::max(arguments["detect-roi-height"].as<int32_t>(), 0);
+        appOptions.detectTransform.centerRoi = true;
+        appOptions.recordingFile = arguments["record"].as<std::string>();
+        appOptions.benchmarkRecording = arguments["benchmark"].as<std::string>();
+        appOptions.benchmarkPasses = std::max(arguments["benchmark-passes"].as<int32_t>(), 1);
     } catch (const std::exception& e) {
         std::cerr << e.what();
         return EXIT_FAILURE;
@@ -62,6 +87,13 @@ int main(int argc, char** argv)
     SetConsoleCtrlHandler(CtrlHandler, TRUE);
 
     try {
+        // Benchmark runs over a recording, without a session
+        if (!appOptions.benchmarkRecording.empty()) {
+            g_application = std::make_unique<DetectorBenchmark>(appOptions);
+            g_application->run();
+            return EXIT_SUCCESS;
+        }
+
         // Initialize session
         auto session = std::make_shared<Session>();
         if (!session->isValid()) {
@@ -111,3 +143,12 @@ varjo_ChannelFlag parseChannels(const std::string& str)
 
     throw std::runtime_error("Unsupported command line option --channels=" + str);
 }
+
+int32_t parseDownsample(int32_t factor)
+{
+    if (factor == 1 || factor == 2 || factor == 4) {
+        return factor;
+    }
+
+    throw std::runtime_error("Unsupported command line option --detect-downsample=" + std::to_string(factor));
+}
@@ -23,10 +23,21 @@ Application::Application(const std::shared_ptr<Session>& session, const Options&
     , m_session(session)
     , m_gazeTracking(session)
 {
-    // Initialize CSV writer
-    if (!options.csvOutputFile.empty()) {
-        m_csvWriter = std::make_unique<CsvWriter>(options.csvOutputFile);
-        m_state.recordingCsv = true;
+    // Initialize gaze log writer. CSV output is converted from the log on exit, so that
+    // formatting text doesn't slow down gaze polling.
+    if (!options.outputFile.empty()) {
+        m_gazeLogFile = options.outputFile;
+        if (m_gazeLogFile.extension() == ".csv") {
+            m_csvOutputFile = m_gazeLogFile;
+            m_gazeLogFile.replace_extension(".vgl");
+        }
+
+        // Map Varjo time to Unix time once, the log stores raw Varjo timestamps
+        GazeLogClock clock;
+        clock.varjoTime = m_session->getCurrentTime();
+        clock.unixTime = varjo_ConvertToUnixTime(*m_session, clock.varjoTime);
+        m_gazeLog = std::make_unique<GazeLogWriter>(m_gazeLogFile, clock);
+        m_state.recordingGazeLog = true;
     }
 
     // Request calibration if requested from command line
@@ -37,16 +48,6 @@ Application::Application(const std::shared_ptr<Session>& session, const Options&
 
 void Application::run()
 {
-    // Write header for output CSV
-    if (m_csvWriter) {
-        m_csvWriter->outputLine("Current timestamp", "Current time", "Frame number", "Capture raw timestamp", "Capture Unix timestamp", "Status",
-            "Gaze Forward X", "Gaze Forward Y", "Gaze Forward Z", "Gaze Origin X", "Gaze Origin Y", "Gaze Origin Z", "Left Status", "Left Forward X",
-            "Left Forward Y", "Left Forward Z", "Left Origin X", "Left Origin Y", "Left Origin Z", "Right Status", "Right Forward X", "Right Forward Y",
-            "Right Forward Z", "Right Origin X", "Right Origin Y", "Right Origin Z", "Focus distance", "Stability", "Left Pupil-Iris Diameter Ratio",
-            "Right Pupil-Iris Diameter Ratio", "Left Pupil Diameter (mm)", "Right Pupil Diameter (mm)", "Left Iris Diameter (mm)", "Right Iris Diameter (mm)",
-            "Left eye openess ratio", "Right eye openness ratio");
-    }
-
     while (m_running) {
         m_ui.update();
         handleInput();
@@ -58,10 +59,18 @@ void Application::run()
         // gaze samples per iteration when using 200Hz output sampling frequency.
         //
         // Note: This value can be increased to lower CPU usage, but time between
-        // GazeTracking.getGazeData() (varjo_GetGazeArray) calls should not exceed
+        // GazeTracking.pollGazeData() (varjo_GetGazeDataArray) calls should not exceed
         // 500ms or samples might be lost.
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
+
+    // Write remaining samples and convert log to CSV, if requested
+    if (m_gazeLog) {
+        m_gazeLog.reset();
+        if (!m_csvOutputFile.empty()) {
+            convertGazeLogToCsv(m_gazeLogFile, m_csvOutputFile);
+        }
+    }
 }
 
 void Application::terminate() { m_running = false; }
@@ -109,35 +118,36 @@ void Application::update()
         m_initialized = true;
     }
 
-    // Fetch gaze data
-    const auto gazeDataWithEyeMeasurements = m_gazeTracking.getGazeDataWithEyeMeasurements();
-    if (gazeDataWithEyeMeasurements.empty()) {
+    // Fetch gaze data into sample buffer
+    if (m_gazeTracking.pollGazeData() == 0) {
         if (!checkError("Failed to read gaze data")) {
             return;
         }
     }
+    m_state.gazeSampleOverflows = m_gazeTracking.getOverflowCount();
 
     // Update state with latest gaze
-    if (!gazeDataWithEyeMeasurements.empty()) {
-        m_state.gaze = gazeDataWithEyeMeasurements.back().first;
-        m_state.eyeMeasurements = gazeDataWithEyeMeasurements.back().second;
+    const auto samples = m_gazeTracking.getSamples();
+    if (!samples.empty()) {
+        m_state.gaze = samples.getGaze(samples.size() - 1);
+        m_state.eyeMeasurements = samples.getEyeMeasurements(samples.size() - 1);
     }
 
-    // Write CSV
-    if (m_csvWriter) {
-        using namespace std::chrono;
-        const auto currentTimestamp = m_session->getCurrentTime();
-        const auto currentSystemTime = system_clock::now();
-
-        for (const auto& [gaze, eyeMeasurements] : gazeDataWithEyeMeasurements) {
-            m_csvWriter->outputLine(currentTimestamp, currentSystemTime, gaze.frameNumber, gaze.captureTime,
-                varjo_ConvertToUnixTime(*m_session, gaze.captureTime), gaze.status, gaze.gaze.forward, gaze.gaze.origin, gaze.leftStatus, gaze.leftEye.forward,
-                gaze.leftEye.origin, gaze.rightStatus, gaze.rightEye.forward, gaze.rightEye.origin, gaze.focusDistance, gaze.stability,
-                eyeMeasurements.leftPupilIrisDiameterRatio, eyeMeasurements.rightPupilIrisDiameterRatio, eyeMeasurements.leftPupilDiameterInMM,
-                eyeMeasurements.rightPupilDiameterInMM, eyeMeasurements.leftIrisDiameterInMM, eyeMeasurements.rightIrisDiameterInMM,
-                eyeMeasurements.leftEyeOpenness, eyeMeasurements.rightEyeOpenness);
-        }
+    // Queue samples to gaze log writer thread
+    if (m_gazeLog) {
+        GazeLogSample logSample;
+        logSample.pollTime = m_session->getCurrentTime();
+        samples.forEach([&](const varjo_Gaze& gaze, const varjo_EyeMeasurements& eyeMeasurements) {
+            logSample.gaze = gaze;
+            logSample.eyeMeasurements = eyeMeasurements;
+            m_gazeLog->write(logSample);
+        });
+        m_state.gazeLogSamples = m_gazeLog->getWrittenCount();
+        m_state.gazeLogDrops = m_gazeLog->getDroppedCount();
     }
+
+    // All buffered samples have been handled
+    m_gazeTracking.consumeSamples(samples.size());
 }
 
 void Application::handleInput()
@@ -8,8 +8,8 @@
 
 #include <Session.hpp>
 
+#include "GazeLog.hpp"
 #include "GazeTracking.hpp"
-#include "CsvWriter.hpp"
 #include "UI.hpp"
 
 // Application logic
@@ -21,7 +21,7 @@ public:
         GazeTracking::OutputFrequency outputFrequency;
         std::optional<GazeTracking::CalibrationType> calibrationType;
         std::optional<GazeTracking::HeadsetAlignmentGuidanceMode> headsetAlignmentGuidanceMode;
-        std::filesystem::path csvOutputFile;
+        std::filesystem::path outputFile;
     };
 
     Application(const std::shared_ptr<Session>& session, const Options& options);
@@ -54,7 +54,9 @@ private:
     UI m_ui;
     std::shared_ptr<Session> m_session;
     GazeTracking m_gazeTracking;
-    std::unique_ptr<CsvWriter> m_csvWriter;
+    std::unique_ptr<GazeLogWriter> m_gazeLog;
+    std::filesystem::path m_gazeLogFile;
+    std::filesystem::path m_csvOutputFile;
     std::atomic_bool m_running = true;
     bool m_initialized = false;
 };
@@ -0,0 +1,584 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "GazeLog.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "CsvWriter.hpp"
+
+namespace
+{
+// File identification and format version
+constexpr char c_fileMagic[8] = {'V', 'A', 'R', 'J', 'O', 'G', 'Z', 'L'};
+constexpr uint32_t c_formatVersion = 1;
+
+// Block identification, "GBLK"
+constexpr uint32_t c_blockMagic = 0x4B4C4247;
+
+// Largest block size accepted by the reader
+constexpr uint32_t c_maxBlockRows = 65536;
+
+// Idle time of the writer thread when the queue is empty
+constexpr std::chrono::milliseconds c_writerIdleTime{10};
+
+// Column value type
+enum class ColumnType : uint8_t {
+    INT64,
+    FLOAT64,
+    FLOAT32,
+};
+
+// Column chunk encoding
+enum class ColumnCodec : uint8_t {
+    // Little endian values as is
+    RAW,
+
+    // Values predicted from previous row, residual bytes shuffled and zero runs encoded
+    SHUFFLE_RLE,
+};
+
+// File header, followed by column headers
+struct FileHeader {
+    char magic[8];           // File identification
+    uint32_t version;        // Format version
+    uint32_t columnCount;    // Number of column headers
+    uint32_t blockRows;      // Maximum number of rows per block
+    uint32_t reserved;       // Reserved, zero
+    int64_t clockVarjoTime;  // Varjo time of the clock mapping
+    int64_t clockUnixTime;   // Unix time of the clock mapping
+};
+static_assert(sizeof(FileHeader) == 40, "Unexpected gaze log header size");
+
+// Column header
+struct ColumnHeader {
+    char name[56];        // Column name, null terminated
+    uint8_t type;         // Value type
+    uint8_t width;        // Value width in bytes
+    uint8_t reserved[6];  // Reserved, zero
+};
+static_assert(sizeof(ColumnHeader) == 64, "Unexpected gaze log column header size");
+
+// Block header, followed by a chunk of each column in header order
+struct BlockHeader {
+    uint32_t magic;     // Block identification
+    uint32_t rowCount;  // Number of rows
+    uint32_t size;      // Size of column chunks in bytes
+    uint32_t reserved;  // Reserved, zero
+};
+static_assert(sizeof(BlockHeader) == 16, "Unexpected gaze log block header size");
+
+// Column chunk header, followed by encoded column data
+struct ChunkHeader {
+    uint8_t codec;        // Column encoding
+    uint8_t reserved[3];  // Reserved, zero
+    uint32_t size;        // Size of encoded data in bytes
+};
+static_assert(sizeof(ChunkHeader) == 8, "Unexpected gaze log chunk header size");
+
+// Logged sample field
+struct Column {
+    const char* name;                                   // Column name
+    ColumnType type;                                    // Value type
+    uint64_t (*get)(const GazeLogSample& sample);       // Returns value bits of the field
+    void (*set)(GazeLogSample& sample, uint64_t bits);  // Sets field from value bits
+};
+
+template <typename T>
+constexpr ColumnType getColumnType()
+{
+    static_assert(std::is_same_v<T, int64_t> || std::is_same_v<T, double> || std::is_same_v<T, float>, "Unsupported gaze log column type");
+    return std::is_same_v<T, int64_t> ? ColumnType::INT64 : (std::is_same_v<T, double> ? ColumnType::FLOAT64 : ColumnType::FLOAT32);
+}
+
+size_t getColumnWidth(ColumnType type) { return (type == ColumnType::FLOAT32) ? 4 : 8; }
+
+template <typename T>
+uint64_t toBits(T value)
+{
+    if constexpr (sizeof(T) == sizeof(uint64_t)) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    } else {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+template <typename T>
+void fromBits(uint64_t bits, T& value)
+{
+    if constexpr (sizeof(T) == sizeof(uint64_t)) {
+        std::memcpy(&value, &bits, sizeof(value));
+    } else {
+        const auto lowBits = static_cast<uint32_t>(bits);
+        std::memcpy(&value, &lowBits, sizeof(value));
+    }
+}
+
+// Column of given sample field, value type is deduced from the field
+#define GAZE_LOG_COLUMN(name, field)                                                         \
+    {                                                                                        \
+        name, getColumnType<std::decay_t<decltype(std::declval<GazeLogSample&>().field)>>(), \
+            [](const GazeLogSample& sample) { return toBits(sample.field); },                \
+            [](GazeLogSample& sample, uint64_t bits) { fromBits(bits, sample.field); }       \
+    }
+
+// Logged columns. Names match the CSV output. New columns can be added to the end,
+// as the reader skips columns it doesn't know.
+const Column c_columns[] = {
+    GAZE_LOG_COLUMN("Current timestamp", pollTime),
+    GAZE_LOG_COLUMN("Frame number", gaze.frameNumber),
+    GAZE_LOG_COLUMN("Capture raw timestamp", gaze.captureTime),
+    GAZE_LOG_COLUMN("Status", gaze.status),
+    GAZE_LOG_COLUMN("Gaze Forward X", gaze.gaze.forward[0]),
+    GAZE_LOG_COLUMN("Gaze Forward Y", gaze.gaze.forward[1]),
+    GAZE_LOG_COLUMN("Gaze Forward Z", gaze.gaze.forward[2]),
+    GAZE_LOG_COLUMN("Gaze Origin X", gaze.gaze.origin[0]),
+    GAZE_LOG_COLUMN("Gaze Origin Y", gaze.gaze.origin[1]),
+    GAZE_LOG_COLUMN("Gaze Origin Z", gaze.gaze.origin[2]),
+    GAZE_LOG_COLUMN("Left Status", gaze.leftStatus),
+    GAZE_LOG_COLUMN("Left Forward X", gaze.leftEye.forward[0]),
+    GAZE_LOG_COLUMN("Left Forward Y", gaze.leftEye.forward[1]),
+    GAZE_LOG_COLUMN("Left Forward Z", gaze.leftEye.forward[2]),
+    GAZE_LOG_COLUMN("Left Origin X", gaze.leftEye.origin[0]),
+    GAZE_LOG_COLUMN("Left Origin Y", gaze.leftEye.origin[1]),
+    GAZE_LOG_COLUMN("Left Origin Z", gaze.leftEye.origin[2]),
+    GAZE_LOG_COLUMN("Right Status", gaze.rightStatus),
+    GAZE_LOG_COLUMN("Right Forward X", gaze.rightEye.forward[0]),
+    GAZE_LOG_COLUMN("Right Forward Y", gaze.rightEye.forward[1]),
+    GAZE_LOG_COLUMN("Right Forward Z", gaze.rightEye.forward[2]),
+    GAZE_LOG_COLUMN("Right Origin X", gaze.rightEye.origin[0]),
+    GAZE_LOG_COLUMN("Right Origin Y", gaze.rightEye.origin[1]),
+    GAZE_LOG_COLUMN("Right Origin Z", gaze.rightEye.origin[2]),
+    GAZE_LOG_COLUMN("Focus distance", gaze.focusDistance),
+    GAZE_LOG_COLUMN("Stability", gaze.stability),
+    GAZE_LOG_COLUMN("Left Pupil-Iris Diameter Ratio", eyeMeasurements.leftPupilIrisDiameterRatio),
+    GAZE_LOG_COLUMN("Right Pupil-Iris Diameter Ratio", eyeMeasurements.rightPupilIrisDiameterRatio),
+    GAZE_LOG_COLUMN("Left Pupil Diameter (mm)", eyeMeasurements.leftPupilDiameterInMM),
+    GAZE_LOG_COLUMN("Right Pupil Diameter (mm)", eyeMeasurements.rightPupilDiameterInMM),
+    GAZE_LOG_COLUMN("Left Iris Diameter (mm)", eyeMeasurements.leftIrisDiameterInMM),
+    GAZE_LOG_COLUMN("Right Iris Diameter (mm)", eyeMeasurements.rightIrisDiameterInMM),
+    GAZE_LOG_COLUMN("Left eye openess ratio", eyeMeasurements.leftEyeOpenness),
+    GAZE_LOG_COLUMN("Right eye openness ratio", eyeMeasurements.rightEyeOpenness),
+};
+
+#undef GAZE_LOG_COLUMN
+
+constexpr size_t c_columnCount = std::size(c_columns);
+
+// Zero run-length encoding. Control byte below 128 is followed by (control + 1) literal bytes,
+// control byte from 128 up stands for (control - 128 + 2) zero bytes.
+constexpr size_t c_maxLiteralRun = 128;
+constexpr size_t c_minZeroRun = 2;
+constexpr size_t c_maxZeroRun = 129;
+
+// Returns worst case size of zero run encoded data
+size_t getMaxEncodedSize(size_t size) { return size + (size + c_maxLiteralRun - 1) / c_maxLiteralRun; }
+
+size_t encodeZeroRuns(const uint8_t* src, size_t size, uint8_t* dst)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        size_t zeros = 0;
+        while ((in + zeros < size) && (src[in + zeros] == 0) && (zeros < c_maxZeroRun)) {
+            zeros++;
+        }
+        if (zeros >= c_minZeroRun) {
+            dst[out++] = static_cast<uint8_t>(128 + zeros - c_minZeroRun);
+            in += zeros;
+            continue;
+        }
+
+        // Literal run ends where the next zero run starts
+        size_t end = in;
+        while ((end < size) && (end - in < c_maxLiteralRun) && !((src[end] == 0) && (end + 1 < size) && (src[end + 1] == 0))) {
+            end++;
+        }
+        dst[out++] = static_cast<uint8_t>(end - in - 1);
+        std::memcpy(dst + out, src + in, end - in);
+        out += end - in;
+        in = end;
+    }
+    return out;
+}
+
+bool decodeZeroRuns(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        const uint8_t control = src[in++];
+        if (control >= 128) {
+            const size_t zeros = control - 128 + c_minZeroRun;
+            if (out + zeros > dstSize) {
+                return false;
+            }
+            std::memset(dst + out, 0, zeros);
+            out += zeros;
+        } else {
+            const size_t literals = control + 1;
+            if ((in + literals > size) || (out + literals > dstSize)) {
+                return false;
+            }
+            std::memcpy(dst + out, src + in, literals);
+            in += literals;
+            out += literals;
+        }
+    }
+    return out == dstSize;
+}
+
+// Predict values from the previous row and shuffle bytes of the residuals into planes of equal significance.
+// Timestamps and counters advance steadily and float fields change slowly, so most high bytes become zero.
+void predictAndShuffle(const uint64_t* values, size_t count, ColumnType type, size_t width, uint8_t* dst)
+{
+    uint64_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t residual;
+        if (type == ColumnType::INT64) {
+            // Zigzag encode delta, so that small negative deltas have zero high bytes too
+            const auto delta = static_cast<int64_t>(values[i] - previous);
+            residual = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+        } else {
+            residual = values[i] ^ previous;
+        }
+        previous = values[i];
+
+        for (size_t b = 0; b < width; b++) {
+            dst[b * count + i] = static_cast<uint8_t>(residual >> (8 * b));
+        }
+    }
+}
+
+void unshuffleAndPredict(const uint8_t* src, size_t count, ColumnType type, size_t width, uint64_t* values)
+{
+    uint64_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t residual = 0;
+        for (size_t b = 0; b < width; b++) {
+            residual |= static_cast<uint64_t>(src[b * count + i]) << (8 * b);
+        }
+
+        if (type == ColumnType::INT64) {
+            previous += (residual >> 1) ^ (0 - (residual & 1));
+        } else {
+            previous ^= residual;
+        }
+        values[i] = previous;
+    }
+}
+
+// Returns known column index of given column name and type, or -1 if not found
+int32_t findColumn(const char* name, ColumnType type)
+{
+    for (size_t i = 0; i < c_columnCount; i++) {
+        if ((c_columns[i].type == type) && (std::strcmp(c_columns[i].name, name) == 0)) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+GazeLogWriter::GazeLogWriter(const std::filesystem::path& filename, const GazeLogClock& clock)
+    : m_stream(filename, std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    if (!m_stream) {
+        throw std::runtime_error("Failed to open gaze log file: " + filename.string());
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, c_fileMagic, sizeof(header.magic));
+    header.version = c_formatVersion;
+    header.columnCount = static_cast<uint32_t>(c_columnCount);
+    header.blockRows = static_cast<uint32_t>(c_blockRows);
+    header.clockVarjoTime = clock.varjoTime;
+    header.clockUnixTime = clock.unixTime;
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& column : c_columns) {
+        ColumnHeader columnHeader{};
+        std::strncpy(columnHeader.name, column.name, sizeof(columnHeader.name) - 1);
+        columnHeader.type = static_cast<uint8_t>(column.type);
+        columnHeader.width = static_cast<uint8_t>(getColumnWidth(column.type));
+        m_stream.write(reinterpret_cast<const char*>(&columnHeader), sizeof(columnHeader));
+    }
+
+    if (!m_stream) {
+        throw std::runtime_error("Failed to write gaze log file: " + filename.string());
+    }
+
+    // Allocate block buffers for worst case encoding up front
+    m_values.resize(c_columnCount * c_blockRows);
+    m_shuffled.resize(sizeof(uint64_t) * c_blockRows);
+    m_block.resize(sizeof(BlockHeader) + c_columnCount * (sizeof(ChunkHeader) + getMaxEncodedSize(sizeof(uint64_t) * c_blockRows)));
+
+    m_thread = std::thread(&GazeLogWriter::run, this);
+}
+
+GazeLogWriter::~GazeLogWriter()
+{
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool GazeLogWriter::write(const GazeLogSample& sample)
+{
+    if (!m_queue.push(sample)) {
+        m_droppedCount++;
+        return false;
+    }
+    return true;
+}
+
+void GazeLogWriter::run()
+{
+    while (true) {
+        // Check running flag before draining, so that samples queued before stopping get written
+        const bool running = m_running;
+
+        size_t count = 0;
+        while (const auto* sample = m_queue.peek()) {
+            addRow(*sample);
+            m_queue.discard();
+            count++;
+        }
+
+        if (!running) {
+            break;
+        }
+        if (count == 0) {
+            std::this_thread::sleep_for(c_writerIdleTime);
+        }
+    }
+
+    if (m_rowCount > 0) {
+        writeBlock();
+    }
+    m_stream.flush();
+}
+
+void GazeLogWriter::addRow(const GazeLogSample& sample)
+{
+    for (size_t c = 0; c < c_columnCount; c++) {
+        m_values[c * c_blockRows + m_rowCount] = c_columns[c].get(sample);
+    }
+
+    if (++m_rowCount == c_blockRows) {
+        writeBlock();
+    }
+}
+
+void GazeLogWriter::writeBlock()
+{
+    size_t offset = sizeof(BlockHeader);
+    for (size_t c = 0; c < c_columnCount; c++) {
+        const auto type = c_columns[c].type;
+        const size_t width = getColumnWidth(type);
+        const size_t rawSize = width * m_rowCount;
+        const uint64_t* values = &m_values[c * c_blockRows];
+        uint8_t* data = m_block.data() + offset + sizeof(ChunkHeader);
+
+        ChunkHeader chunk{};
+        chunk.codec = static_cast<uint8_t>(ColumnCodec::SHUFFLE_RLE);
+        predictAndShuffle(values, m_rowCount, type, width, m_shuffled.data());
+        size_t size = encodeZeroRuns(m_shuffled.data(), rawSize, data);
+
+        // Store noisy columns as is
+        if (size >= rawSize) {
+            chunk.codec = static_cast<uint8_t>(ColumnCodec::RAW);
+            for (size_t i = 0; i < m_rowCount; i++) {
+                for (size_t b = 0; b < width; b++) {
+                    data[i * width + b] = static_cast<uint8_t>(values[i] >> (8 * b));
+                }
+            }
+            size = rawSize;
+        }
+
+        chunk.size = static_cast<uint32_t>(size);
+        std::memcpy(m_block.data() + offset, &chunk, sizeof(chunk));
+        offset += sizeof(chunk) + size;
+    }
+
+    BlockHeader header{};
+    header.magic = c_blockMagic;
+    header.rowCount = static_cast<uint32_t>(m_rowCount);
+    header.size = static_cast<uint32_t>(offset - sizeof(BlockHeader));
+    std::memcpy(m_block.data(), &header, sizeof(header));
+
+    // Samples of a failed write are not counted as written
+    if (m_stream.write(reinterpret_cast<const char*>(m_block.data()), offset)) {
+        m_writtenCount += m_rowCount;
+    }
+    m_rowCount = 0;
+}
+
+GazeLogReader::GazeLogReader(const std::filesystem::path& filename)
+    : m_stream(filename, std::ios::in | std::ios::binary)
+{
+    if (!m_stream) {
+        throw std::runtime_error("Failed to open gaze log file: " + filename.string());
+    }
+
+    FileHeader header{};
+    if (!m_stream.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, c_fileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a gaze log file: " + filename.string());
+    }
+    if (header.version != c_formatVersion) {
+        throw std::runtime_error("Unsupported gaze log version: " + std::to_string(header.version));
+    }
+    if (header.blockRows == 0 || header.blockRows > c_maxBlockRows) {
+        throw std::runtime_error("Invalid gaze log block size: " + std::to_string(header.blockRows));
+    }
+
+    m_clock.varjoTime = header.clockVarjoTime;
+    m_clock.unixTime = header.clockUnixTime;
+    m_blockRows = header.blockRows;
+
+    for (uint32_t i = 0; i < header.columnCount; i++) {
+        ColumnHeader columnHeader{};
+        if (!m_stream.read(reinterpret_cast<char*>(&columnHeader), sizeof(columnHeader))) {
+            throw std::runtime_error("Truncated gaze log header: " + filename.string());
+        }
+        columnHeader.name[sizeof(columnHeader.name) - 1] = '\0';
+
+        const auto type = static_cast<ColumnType>(columnHeader.type);
+        if (columnHeader.type > static_cast<uint8_t>(ColumnType::FLOAT32) || columnHeader.width != getColumnWidth(type)) {
+            throw std::runtime_error("Invalid gaze log column: " + std::string(columnHeader.name));
+        }
+
+        m_columns.push_back(findColumn(columnHeader.name, type));
+        m_widths.push_back(columnHeader.width);
+        m_types.push_back(columnHeader.type);
+    }
+
+    m_values.resize(m_columns.size() * m_blockRows);
+    m_shuffled.resize(sizeof(uint64_t) * m_blockRows);
+}
+
+bool GazeLogReader::read(GazeLogSample& sample)
+{
+    if (m_row == m_rowCount && !readBlock()) {
+        return false;
+    }
+
+    sample = {};
+    for (size_t c = 0; c < m_columns.size(); c++) {
+        if (m_columns[c] >= 0) {
+            c_columns[m_columns[c]].set(sample, m_values[c * m_blockRows + m_row]);
+        }
+    }
+    m_row++;
+    return true;
+}
+
+bool GazeLogReader::readBlock()
+{
+    BlockHeader header{};
+    if (!m_stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        if (m_stream.gcount() == 0) {
+            return false;
+        }
+        throw std::runtime_error("Truncated gaze log block");
+    }
+    if (header.magic != c_blockMagic || header.rowCount == 0 || header.rowCount > m_blockRows) {
+        throw std::runtime_error("Corrupted gaze log block");
+    }
+
+    m_block.resize(header.size);
+    if (!m_stream.read(reinterpret_cast<char*>(m_block.data()), header.size)) {
+        throw std::runtime_error("Truncated gaze log block");
+    }
+
+    size_t offset = 0;
+    for (size_t c = 0; c < m_columns.size(); c++) {
+        ChunkHeader chunk{};
+        if (offset + sizeof(chunk) > m_block.size()) {
+            throw std::runtime_error("Corrupted gaze log block");
+        }
+        std::memcpy(&chunk, m_block.data() + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+        if (chunk.size > m_block.size() - offset) {
+            throw std::runtime_error("Corrupted gaze log block");
+        }
+
+        const auto type = static_cast<ColumnType>(m_types[c]);
+        const size_t width = m_widths[c];
+        const size_t rawSize = width * header.rowCount;
+        const uint8_t* data = m_block.data() + offset;
+        uint64_t* values = &m_values[c * m_blockRows];
+
+        switch (static_cast<ColumnCodec>(chunk.codec)) {
+            case ColumnCodec::RAW: {
+                if (chunk.size != rawSize) {
+                    throw std::runtime_error("Corrupted gaze log block");
+                }
+                for (size_t i = 0; i < header.rowCount; i++) {
+                    uint64_t value = 0;
+                    for (size_t b = 0; b < width; b++) {
+                        value |= static_cast<uint64_t>(data[i * width + b]) << (8 * b);
+                    }
+                    values[i] = value;
+                }
+                break;
+            }
+            case ColumnCodec::SHUFFLE_RLE: {
+                if (!decodeZeroRuns(data, chunk.size, m_shuffled.data(), rawSize)) {
+                    throw std::runtime_error("Corrupted gaze log block");
+                }
+                unshuffleAndPredict(m_shuffled.data(), header.rowCount, type, width, values);
+                break;
+            }
+            default: throw std::runtime_error("Unsupported gaze log column encoding: " + std::to_string(chunk.codec));
+        }
+        offset += chunk.size;
+    }
+
+    m_rowCount = header.rowCount;
+    m_row = 0;
+    return true;
+}
+
+size_t convertGazeLogToCsv(const std::filesystem::path& logFile, const std::filesystem::path& csvFile)
+{
+    using namespace std::chrono;
+
+    GazeLogReader reader(logFile);
+    const auto& clock = reader.getClock();
+
+    CsvWriter csvWriter(csvFile);
+    csvWriter.outputLine("Current timestamp", "Current time", "Frame number", "Capture raw timestamp", "Capture Unix timestamp", "Status", "Gaze Forward X",
+        "Gaze Forward Y", "Gaze Forward Z", "Gaze Origin X", "Gaze Origin Y", "Gaze Origin Z", "Left Status", "Left Forward X", "Left Forward Y",
+        "Left Forward Z", "Left Origin X", "Left Origin Y", "Left Origin Z", "Right Status", "Right Forward X", "Right Forward Y", "Right Forward Z",
+        "Right Origin X", "Right Origin Y", "Right Origin Z", "Focus distance", "Stability", "Left Pupil-Iris Diameter Ratio",
+        "Right Pupil-Iris Diameter Ratio", "Left Pupil Diameter (mm)", "Right Pupil Diameter (mm)", "Left Iris Diameter (mm)", "Right Iris Diameter (mm)",
+        "Left eye openess ratio", "Right eye openness ratio");
+
+    size_t count = 0;
+    GazeLogSample sample;
+    while (reader.read(sample)) {
+        const auto& gaze = sample.gaze;
+        const auto& eyeMeasurements = sample.eyeMeasurements;
+        const auto currentTime = system_clock::time_point(duration_cast<system_clock::duration>(nanoseconds(clock.toUnixTime(sample.pollTime))));
+
+        csvWriter.outputLine(sample.pollTime, currentTime, gaze.frameNumber, gaze.captureTime, clock.toUnixTime(gaze.captureTime), gaze.status,
+            gaze.gaze.forward, gaze.gaze.origin, gaze.leftStatus, gaze.leftEye.forward, gaze.leftEye.origin, gaze.rightStatus, gaze.rightEye.forward,
+            gaze.rightEye.origin, gaze.focusDistance, gaze.stability, eyeMeasurements.leftPupilIrisDiameterRatio, eyeMeasurements.rightPupilIrisDiameterRatio,
+            eyeMeasurements.leftPupilDiameterInMM, eyeMeasurements.rightPupilDiameterInMM, eyeMeasurements.leftIrisDiameterInMM,
+            eyeMeasurements.rightIrisDiameterInMM, eyeMeasurements.leftEyeOpenness, eyeMeasurements.rightEyeOpenness);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,141 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <Varjo_types.h>
+#include <SpscQueue.hpp>
+
+// Binary gaze log
+//
+// Gaze samples are stored in blocks of rows. Within a block, each column is stored separately with
+// fixed-width values of its own type, so that similar values end up next to each other. Each column is
+// compressed with a predictor (integer delta or float XOR against the previous row), byte shuffle,
+// which groups bytes of equal significance together, and zero run-length encoding. Columns that don't
+// compress are stored raw.
+//
+// Timestamps are stored as raw Varjo nanoseconds. File header stores a single mapping between Varjo
+// and Unix time captured when the log was opened, which is used to derive wall clock times on conversion.
+
+// Gaze sample stored to gaze log
+struct GazeLogSample {
+    varjo_Nanoseconds pollTime{0};            // Varjo time when the sample was polled from runtime
+    varjo_Gaze gaze{};                        // Gaze data
+    varjo_EyeMeasurements eyeMeasurements{};  // Eye measurements
+};
+
+// Mapping from Varjo time to Unix time
+struct GazeLogClock {
+    varjo_Nanoseconds varjoTime{0};  // Varjo time
+    varjo_Nanoseconds unixTime{0};   // Unix time at the same instant
+
+    // Returns Unix time of given Varjo time
+    varjo_Nanoseconds toUnixTime(varjo_Nanoseconds time) const { return time - varjoTime + unixTime; }
+};
+
+// Writes gaze log on a background thread
+//
+// Samples are passed to the writer thread through a wait-free queue, so writing never blocks the
+// calling thread on file I/O or compression. If the writer thread falls behind and the queue fills up,
+// samples are dropped and counted.
+class GazeLogWriter final
+{
+public:
+    // Capacity of the sample queue. Writer thread drains the queue every few milliseconds,
+    // so this covers several seconds of gaze data at maximum output frequency.
+    static constexpr size_t c_queueCapacity = 1024;
+
+    // Number of rows per compressed block
+    static constexpr size_t c_blockRows = 1024;
+
+    // Opens log file for writing and starts writer thread. Throws on failure.
+    //
+    // @param filename Log file name
+    // @param clock Mapping from Varjo time to Unix time stored in file header
+    GazeLogWriter(const std::filesystem::path& filename, const GazeLogClock& clock);
+
+    // Writes remaining samples and closes the file
+    ~GazeLogWriter();
+
+    // Disable copy, move and assign
+    GazeLogWriter(const GazeLogWriter& other) = delete;
+    GazeLogWriter(const GazeLogWriter&& other) = delete;
+    GazeLogWriter& operator=(const GazeLogWriter& other) = delete;
+    GazeLogWriter& operator=(const GazeLogWriter&& other) = delete;
+
+    // Queues sample for writing. Returns false if the queue is full and the sample was dropped.
+    // Must always be called from the same thread.
+    bool write(const GazeLogSample& sample);
+
+    // Returns number of samples written to file
+    uint64_t getWrittenCount() const { return m_writtenCount; }
+
+    // Returns number of samples dropped due to full queue
+    uint64_t getDroppedCount() const { return m_droppedCount; }
+
+private:
+    // Writer thread main loop
+    void run();
+
+    // Adds sample to current block, writing the block when it is full
+    void addRow(const GazeLogSample& sample);
+
+    // Compresses and writes current block
+    void writeBlock();
+
+    std::ofstream m_stream;                                            // Output file stream
+    VarjoExamples::SpscQueue<GazeLogSample, c_queueCapacity> m_queue;  // Samples from application thread
+    std::vector<uint64_t> m_values;                                    // Column-major values of current block
+    std::vector<uint8_t> m_shuffled;                                   // Predicted and shuffled column bytes
+    std::vector<uint8_t> m_block;                                      // Encoded block
+    size_t m_rowCount{0};                                              // Number of rows in current block
+    std::atomic_bool m_running{true};                                  // Writer thread keeps running while set
+    std::atomic<uint64_t> m_writtenCount{0};                           // Number of samples written
+    uint64_t m_droppedCount{0};                                        // Number of dropped samples
+    std::thread m_thread;                                              // Writer thread
+};
+
+// Reads gaze log written by GazeLogWriter
+class GazeLogReader final
+{
+public:
+    // Opens log file for reading. Throws if the file can't be opened or isn't a gaze log.
+    //
+    // @param filename Log file name
+    explicit GazeLogReader(const std::filesystem::path& filename);
+
+    // Returns mapping from Varjo time to Unix time of the log
+    const GazeLogClock& getClock() const { return m_clock; }
+
+    // Reads next sample. Returns false at the end of the log. Throws if the log is corrupted.
+    bool read(GazeLogSample& sample);
+
+private:
+    // Reads and decompresses next block. Returns false at the end of the log.
+    bool readBlock();
+
+    std::ifstream m_stream;           // Input file stream
+    GazeLogClock m_clock;             // Clock mapping from file header
+    std::vector<int32_t> m_columns;   // Known column index of each file column, -1 for unknown columns
+    std::vector<uint8_t> m_widths;    // Value width in bytes of each file column
+    std::vector<uint8_t> m_types;     // Value type of each file column
+    std::vector<uint64_t> m_values;   // Column-major values of current block
+    std::vector<uint8_t> m_shuffled;  // Decoded column bytes
+    std::vector<uint8_t> m_block;     // Encoded block
+    size_t m_blockRows{0};            // Maximum number of rows per block
+    size_t m_rowCount{0};             // Number of rows in current block
+    size_t m_row{0};                  // Next row to read from current block
+};
+
+// Converts gaze log to CSV file. Throws on failure.
+//
+// @param logFile Gaze log file name
+// @param csvFile Output CSV file name
+// @return Number of converted samples
+size_t convertGazeLogToCsv(const std::filesystem::path& logFile, const std::filesystem::path& csvFile);
@@ -2,11 +2,13 @@
 
 #include "GazeTracking.hpp"
 
-#include <array>
+#include <algorithm>
 #include <charconv>
 
 GazeTracking::GazeTracking(const std::shared_ptr<Session>& session)
     : m_session(session)
+    , m_gaze(c_sampleCapacity)
+    , m_eyeMeasurements(c_sampleCapacity)
 {
 }
 
@@ -88,51 +90,51 @@ GazeTracking::Status GazeTracking::getStatus() const
     return Status::NOT_CALIBRATED;
 }
 
-std::vector<varjo_Gaze> GazeTracking::getGazeData() const
+size_t GazeTracking::pollGazeData()
 {
-    // Number of items to grow the output buffer in each iteration
-    constexpr size_t c_growStep = 16;
+    // Number of oldest samples discarded at once when the buffer is full
+    constexpr size_t c_discardStep = c_sampleCapacity / 4;
 
-    std::vector<varjo_Gaze> output;
+    size_t newSamples = 0;
     while (true) {
-        // Grow output buffer
-        const auto currentItems = output.size();
-        output.resize(currentItems + c_growStep);
-
-        // Get more items from Varjo
-        const auto newItems = varjo_GetGazeArray(*m_session, output.data() + currentItems, c_growStep);
-        if (newItems == c_growStep) {
-            // There might be more items. Do another loop.
-            continue;
+        // Make room, if application has not consumed buffered samples
+        if (m_sampleCount == c_sampleCapacity) {
+            m_sampleHead = (m_sampleHead + c_discardStep) % c_sampleCapacity;
+            m_sampleCount -= c_discardStep;
+            m_overflowCount += c_discardStep;
         }
 
-        // Remove extra items from the output buffer and return
-        output.resize(currentItems + newItems);
-        return output;
+        // Get as many items from Varjo as fit in the contiguous free space after the newest sample
+        const size_t tail = (m_sampleHead + m_sampleCount) % c_sampleCapacity;
+        const size_t space = std::min(c_sampleCapacity - m_sampleCount, c_sampleCapacity - tail);
+        const int32_t newItems = varjo_GetGazeDataArray(*m_session, &m_gaze[tail], &m_eyeMeasurements[tail], static_cast<int32_t>(space));
+        if (newItems <= 0) {
+            return newSamples;
+        }
+
+        m_sampleCount += newItems;
+        newSamples += newItems;
+        if (static_cast<size_t>(newItems) < space) {
+            // All pending items were read
+            return newSamples;
+        }
     }
 }
 
-std::vector<std::pair<varjo_Gaze, varjo_EyeMeasurements>> GazeTracking::getGazeDataWithEyeMeasurements() const
+GazeTracking::SampleView GazeTracking::getSamples() const
 {
-    // Number of items to grow the output buffer in each iteration
-    constexpr size_t c_growStep = 16;
-    std::array<varjo_Gaze, c_growStep> gazeArray;
-    std::array<varjo_EyeMeasurements, c_growStep> eyeMeasurementsArray;
-
-    std::vector<std::pair<varjo_Gaze, varjo_EyeMeasurements>> output;
-    int32_t newItems = 0;
-    do {
-        // Get more items from Varjo
-        newItems = varjo_GetGazeDataArray(*m_session, gazeArray.data(), eyeMeasurementsArray.data(), c_growStep);
-
-        // Copy new items to output
-        output.reserve(output.size() + newItems);
-        for (int32_t i = 0; i < newItems; ++i) {
-            output.push_back({gazeArray[i], eyeMeasurementsArray[i]});
-        }
-    } while (newItems == c_growStep);
+    SampleView view;
+    const size_t firstCount = std::min(m_sampleCount, c_sampleCapacity - m_sampleHead);
+    view.spans[0] = {&m_gaze[m_sampleHead], &m_eyeMeasurements[m_sampleHead], firstCount};
+    view.spans[1] = {m_gaze.data(), m_eyeMeasurements.data(), m_sampleCount - firstCount};
+    return view;
+}
 
-    return output;
+void GazeTracking::consumeSamples(size_t count)
+{
+    count = std::min(count, m_sampleCount);
+    m_sampleHead = (m_sampleHead + count) % c_sampleCapacity;
+    m_sampleCount -= count;
 }
 
 std::optional<double> GazeTracking::getUserIPD() const
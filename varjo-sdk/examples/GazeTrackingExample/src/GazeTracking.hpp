@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <string>
@@ -15,6 +16,10 @@ class GazeTracking final
 public:
     GazeTracking(const std::shared_ptr<Session>& session);
 
+    // Capacity of the gaze sample buffer. Runtime keeps samples for 500ms, which is 100 samples at 200Hz,
+    // so the buffer holds everything from a late poll plus earlier samples the application hasn't consumed.
+    static constexpr size_t c_sampleCapacity = 256;
+
     // Gaze output filter type
     enum class OutputFilterType {
         // Output filter is disabled
@@ -91,11 +96,61 @@ public:
     // Gets the status of gaze tracking
     Status getStatus() const;
 
-    // Gets all pending gaze samples
-    std::vector<varjo_Gaze> getGazeData() const;
+    // Contiguous range of buffered gaze samples. Both arrays have count items.
+    struct SampleSpan {
+        const varjo_Gaze* gaze = nullptr;
+        const varjo_EyeMeasurements* eyeMeasurements = nullptr;
+        size_t count = 0;
+    };
+
+    // View of buffered gaze samples, oldest first. Buffer storage wraps around, so samples are split in at most
+    // two spans. View is valid until the next call to pollGazeData() or consumeSamples().
+    struct SampleView {
+        std::array<SampleSpan, 2> spans{};
+
+        // Gets number of samples in view
+        size_t size() const { return spans[0].count + spans[1].count; }
+
+        // Returns true if view has no samples
+        bool empty() const { return size() == 0; }
+
+        // Gets gaze of sample at given index, 0 being the oldest
+        const varjo_Gaze& getGaze(size_t index) const
+        {
+            return (index < spans[0].count) ? spans[0].gaze[index] : spans[1].gaze[index - spans[0].count];
+        }
+
+        // Gets eye measurements of sample at given index, 0 being the oldest
+        const varjo_EyeMeasurements& getEyeMeasurements(size_t index) const
+        {
+            return (index < spans[0].count) ? spans[0].eyeMeasurements[index] : spans[1].eyeMeasurements[index - spans[0].count];
+        }
+
+        // Calls given function with gaze and eye measurements of each sample, oldest first
+        template <typename Func>
+        void forEach(Func&& func) const
+        {
+            for (const auto& span : spans) {
+                for (size_t i = 0; i < span.count; ++i) {
+                    func(span.gaze[i], span.eyeMeasurements[i]);
+                }
+            }
+        }
+    };
+
+    // Reads all pending gaze samples with eye measurements from runtime directly into the sample buffer.
+    // Does not allocate. If the buffer is full, oldest samples are discarded and counted as overflow.
+    // Returns number of new samples.
+    size_t pollGazeData();
+
+    // Gets view of buffered samples that have not been consumed
+    SampleView getSamples() const;
 
-    // Gets all pending gaze samples with eye measurements
-    std::vector<std::pair<varjo_Gaze, varjo_EyeMeasurements>> getGazeDataWithEyeMeasurements() const;
+    // Removes given number of oldest samples from the buffer
+    void consumeSamples(size_t count);
+
+    // Gets number of samples discarded because the buffer was full
+    uint64_t getOverflowCount() const { return m_overflowCount; }
 
     // Gets estimate of user's interpupillary distance
     std::optional<double> getUserIPD() const;
@@ -114,4 +169,11 @@ public:
 
 private:
     const std::shared_ptr<Session> m_session;
+
+    // Gaze sample ring buffer. Gaze and eye measurements of a sample have the same index.
+    std::vector<varjo_Gaze> m_gaze;
+    std::vector<varjo_EyeMeasurements> m_eyeMeasurements;
+    size_t m_sampleHead = 0;
+    size_t m_sampleCount = 0;
+    uint64_t m_overflowCount = 0;
 };
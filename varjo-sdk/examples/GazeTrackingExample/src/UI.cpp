@@ -213,14 +213,27 @@ void UI::update()
         Console::writeLine(14, "Headset alignment guidance mode (for next request): " + toString(m_applicationState.headsetAlignmentGuidanceMode));
     }
 
-    if (!m_previousState.has_value() || (m_previousState->recordingCsv != m_applicationState.recordingCsv)) {
-        Console::writeLine(15, m_applicationState.recordingCsv ? "RECORDING CSV" : "");
+    if (!m_previousState.has_value() || (m_previousState->recordingGazeLog != m_applicationState.recordingGazeLog) ||
+        (m_previousState->gazeLogSamples != m_applicationState.gazeLogSamples) || (m_previousState->gazeLogDrops != m_applicationState.gazeLogDrops)) {
+        std::string text;
+        if (m_applicationState.recordingGazeLog) {
+            text = "RECORDING GAZE LOG: " + std::to_string(m_applicationState.gazeLogSamples) + " samples written";
+            if (m_applicationState.gazeLogDrops) {
+                text += ", " + std::to_string(m_applicationState.gazeLogDrops) + " dropped (writer queue full)";
+            }
+        }
+        Console::writeLine(15, text);
     }
 
     if (!m_previousState.has_value() || (m_previousState->status != m_applicationState.status)) {
         Console::writeLine(16, "Status: " + toString(m_applicationState.status));
     }
 
+    if (!m_previousState.has_value() || (m_previousState->gazeSampleOverflows != m_applicationState.gazeSampleOverflows)) {
+        const auto overflows = m_applicationState.gazeSampleOverflows;
+        Console::writeLine(17, overflows ? "Gaze samples dropped (buffer full): " + std::to_string(overflows) : "");
+    }
+
     if (!m_previousState.has_value() || (m_previousState->gaze.frameNumber != m_applicationState.gaze.frameNumber)) {
         const auto& gaze = m_applicationState.gaze;
         Console::writeLines(18,  //
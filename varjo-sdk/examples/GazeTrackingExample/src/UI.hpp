@@ -17,11 +17,14 @@ struct ApplicationState {
     GazeTracking::OutputFrequency outputFrequency{};
     GazeTracking::CalibrationType calibrationType{};
     GazeTracking::HeadsetAlignmentGuidanceMode headsetAlignmentGuidanceMode{};
-    bool recordingCsv = false;
+    bool recordingGazeLog = false;
+    uint64_t gazeLogSamples = 0;
+    uint64_t gazeLogDrops = 0;
     GazeTracking::Status status{};
     std::string lastError;
     varjo_Gaze gaze{};
     varjo_EyeMeasurements eyeMeasurements{};
+    uint64_t gazeSampleOverflows = 0;
 
     bool hasError() const { return !lastError.empty(); }
 };
@@ -4,7 +4,7 @@
  *
  * - Showcases Varjo Gaze API features
  * - Just run the example and it prints out usage instructions
- * - For CSV data export option, see command line help
+ * - For gaze data export options, see command line help
  *
  * - If you are interested how to visualize user's gaze, you might want to
  *   take look at Benchmark application instead.
@@ -18,6 +18,7 @@
 #include <Windows.h>
 
 #include "Application.hpp"
+#include "GazeLog.hpp"
 #include "Session.hpp"
 
 // Application instance
@@ -44,6 +45,7 @@ int main(int argc, char** argv)
     // Use UTF-8
     SetConsoleOutputCP(CP_UTF8);
     Application::Options appOptions;
+    std::filesystem::path convertFile;
 
     try {
         cxxopts::Options options("GazeTrackingExample", UI::getAppNameAndVersionText() + "\n" + UI::getCopyrightText());
@@ -58,8 +60,12 @@ int main(int argc, char** argv)
                 "Mode of operation for headset alignment guidance. Defaults to wait for user input before proceeding to calibration. Allowed options are "
                 "'WaitForUserInputToContinue', 'AutoContinueOnAcceptableHeadsetPosition'.",
                 cxxopts::value<std::string>()->implicit_value("WaitInput"))  //
-            ("output", "Specifies name of the file where CSV formatted gaze data should be saved.",
+            ("output",
+                "Specifies name of the file where gaze data should be saved. Data is recorded to a binary gaze log. If the file has .csv "
+                "extension, the log is written next to it with .vgl extension and converted to CSV on exit.",
                 cxxopts::value<std::string>()->default_value(""))  //
+            ("convert", "Converts given binary gaze log to CSV and exits. CSV file name is given with --output, or derived from the log file name.",
+                cxxopts::value<std::string>())  //
             ("help", "Display help info");
 
         // Parse command line arguments
@@ -77,12 +83,32 @@ int main(int argc, char** argv)
         if (arguments.count("headset-alignment-guidance-mode")) {
             appOptions.headsetAlignmentGuidanceMode = parseHeadsetAlignmentGuidanceMode(arguments["headset-alignment-guidance-mode"].as<std::string>());
         }
-        appOptions.csvOutputFile = arguments["output"].as<std::string>();
+        appOptions.outputFile = arguments["output"].as<std::string>();
+        if (arguments.count("convert")) {
+            convertFile = arguments["convert"].as<std::string>();
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what();
         return EXIT_FAILURE;
     }
 
+    // Convert gaze log without starting a session
+    if (!convertFile.empty()) {
+        try {
+            auto csvFile = appOptions.outputFile;
+            if (csvFile.empty()) {
+                csvFile = convertFile;
+                csvFile.replace_extension(".csv");
+            }
+            const size_t count = convertGazeLogToCsv(convertFile, csvFile);
+            std::cout << "Converted " << count << " gaze samples to " << csvFile.string() << std::endl;
+            return EXIT_SUCCESS;
+        } catch (const std::exception& e) {
+            std::cerr << "Conversion failed: " << e.what();
+            return EXIT_FAILURE;
+        }
+    }
+
     // Setup Ctrl+C handler to exit application cleanly
     SetConsoleCtrlHandler(CtrlHandler, TRUE);
 
@@ -16,12 +16,20 @@
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include "D3D11MultiLayerView.hpp"
+#include "FrameRecording.hpp"
 
 // VarjoExamples namespace contains simple example wrappers for using Varjo API features.
 // These are only meant to be used in SDK example applications. In your own application,
 // use your own production quality integration layer.
 using namespace VarjoExamples;
 
+namespace
+{
+// Color frames buffered per channel for stereo matching
+constexpr size_t c_colorSyncQueueCapacity = 4;
+
+}  // namespace
+
 //---------------------------------------------------------------------------
 
 AppLogic::~AppLogic()
@@ -77,6 +85,23 @@ bool AppLogic::init(GfxContext& context)
     // Create scene instance
     m_scene = std::make_unique<MRScene>(*m_renderer);
 
+    // Create stereo color frame synchronizer. Must exist before data streamer delivers frames. Only the latest set
+    // is used every frame, so a few queued frames per channel are enough and bound the copies of full color frames.
+    const std::vector<FrameSynchronizer::Input> colorInputs{
+        {varjo_StreamType_DistortedColor, varjo_ChannelIndex_Left},
+        {varjo_StreamType_DistortedColor, varjo_ChannelIndex_Right},
+    };
+    m_colorSync = std::make_unique<FrameSynchronizer>(colorInputs, FrameSynchronizer::MatchMode::FrameNumber, 0, c_colorSyncQueueCapacity);
+
+    // Create frame bus for data stream consumers. Only the latest cubemap frame is of interest.
+    m_frameBus = std::make_unique<FrameBus>();
+    FrameBus::SubscriberOptions cubemapOptions;
+    cubemapOptions.name = "cubemap";
+    cubemapOptions.streamType = varjo_StreamType_EnvironmentCubemap;
+    cubemapOptions.channels = varjo_ChannelFlag_First;
+    cubemapOptions.policy = FrameBus::Policy::KeepLatest;
+    m_cubemapSubscription = m_frameBus->subscribe(cubemapOptions);
+
     // Create data streamer instance
     m_streamer = std::make_unique<DataStreamer>(m_session, std::bind(&AppLogic::onFrameReceived, this, std::placeholders::_1));
 
@@ -267,8 +292,58 @@ void AppLogic::setState(const AppState& appState, bool force)
         LOG_INFO("Buffer handling: %s", appState.options.delayedBufferHandlingEnabled ? "DELAYED" : "IMMEDIATE");
     }
 
+    if (force || appState.options.bufferLeasingEnabled != prevState.options.bufferLeasingEnabled) {
+        m_streamer->setBufferLeasingEnabled(appState.options.bufferLeasingEnabled);
+        LOG_INFO("Buffer leasing: %s", appState.options.bufferLeasingEnabled ? "ZERO-COPY" : "COPY");
+    }
+
+    if (force || appState.options.parallelChannelHandlingEnabled != prevState.options.parallelChannelHandlingEnabled) {
+        m_streamer->setParallelChannelHandlingEnabled(appState.options.parallelChannelHandlingEnabled);
+        LOG_INFO("Channel handling: %s (for streams started next)", appState.options.parallelChannelHandlingEnabled ? "PARALLEL" : "SERIAL");
+    }
+
+    // Data stream recording
+    if (force || appState.options.dataStreamRecordingEnabled != prevState.options.dataStreamRecordingEnabled) {
+        if (appState.options.dataStreamRecordingEnabled) {
+            if (!m_streamer->getRecorder()) {
+                const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                auto recorder = std::make_shared<FrameRecorder>();
+                if (recorder->open("datastream_" + std::to_string(seconds) + ".vrec")) {
+                    m_streamer->setRecorder(recorder);
+                }
+            }
+        } else if (const auto recorder = m_streamer->getRecorder()) {
+            // Stop feeding frames before closing, closing writes the frames still buffered
+            m_streamer->setRecorder(nullptr);
+            recorder->close();
+        }
+
+        // Write recording status back to state
+        m_appState.options.dataStreamRecordingEnabled = (m_streamer->getRecorder() != nullptr);
+    }
+
+    // Data stream latency log
+    if (force || appState.options.dataStreamLatencyLogEnabled != prevState.options.dataStreamLatencyLogEnabled) {
+        if (appState.options.dataStreamLatencyLogEnabled) {
+            if (!m_streamer->isLatencyLogEnabled()) {
+                const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                m_streamer->setLatencyLogFile("datastream_latency_" + std::to_string(seconds) + ".jsonl");
+            }
+        } else {
+            m_streamer->setLatencyLogFile("");
+        }
+
+        // Write log status back to state
+        m_appState.options.dataStreamLatencyLogEnabled = m_streamer->isLatencyLogEnabled();
+    }
+
     if (force || appState.options.undistortEnabled != prevState.options.undistortEnabled) {
         LOG_INFO("Color stream undistortion: %s", appState.options.undistortEnabled ? "ENABLED" : "DISABLED");
+
+        // Release remap tables when not undistorting
+        if (!appState.options.undistortEnabled) {
+            m_remapCache.clear();
+        }
     }
 
     // Data stream: YUV
@@ -325,12 +400,15 @@ void AppLogic::setState(const AppState& appState, bool force)
             // Reset textures if disabled
             {
                 std::lock_guard<std::mutex> streamLock(m_frameDataMutex);
-                m_frameData.colorFrames = {};
                 m_scene->updateColorFrame(0, {0, 0}, 0, 0, nullptr);
                 m_scene->updateColorFrame(1, {0, 0}, 0, 0, nullptr);
             }
         }
 
+        // Drop pending frames, leased buffers of a stopped stream are no longer valid
+        m_colorSync->clear();
+        m_colorFrames = {};
+
         // Write stream status back to state
         m_appState.options.dataStreamColorEnabled = m_streamer->isStreaming(streamType, streamFormat);
     }
@@ -353,7 +431,7 @@ void AppLogic::setState(const AppState& appState, bool force)
             // Reset textures if disabled
             {
                 std::lock_guard<std::mutex> streamLock(m_frameDataMutex);
-                m_frameData.cubemapFrame = {};
+                m_cubemapSubscription->clear();
                 m_scene->updateHdrCubemap(0, 0, 0, nullptr);
             }
         }
@@ -372,6 +450,14 @@ void AppLogic::onFrameReceived(const DataStreamer::Frame& frame)
 {
     const auto& streamFrame = frame.metadata.streamFrame;
 
+    // Queue color frames for stereo matching without locking. Metadata only streams have no frames to match.
+    if ((streamFrame.type == varjo_StreamType_DistortedColor) && (frame.metadata.bufferMetadata.byteSize > 0)) {
+        m_colorSync->push(frame);
+    }
+
+    // Publish frame to bus subscribers. Frame data is shared by all of them.
+    m_frameBus->publish(frame);
+
     std::lock_guard<std::mutex> streamLock(m_frameDataMutex);
     switch (streamFrame.type) {
         case varjo_StreamType_DistortedColor: {
@@ -379,12 +465,10 @@ void AppLogic::onFrameReceived(const DataStreamer::Frame& frame)
             if (frame.metadata.channelIndex == varjo_ChannelIndex_First) {
                 m_frameData.metadata = streamFrame.metadata.distortedColor;
             }
-            m_frameData.colorFrames[static_cast<size_t>(frame.metadata.channelIndex)] = frame;
         } break;
         case varjo_StreamType_EnvironmentCubemap: {
-            // We update cube frame only from first channel only (actually there is no second)
+            // We update cube metadata only from first channel only (actually there is no second). Frame is received from bus.
             if (frame.metadata.channelIndex == varjo_ChannelIndex_First) {
-                m_frameData.cubemapFrame = frame;
                 m_frameData.cubemapMetadata = streamFrame.metadata.environmentCubemap;
             }
         } break;
@@ -416,16 +500,6 @@ void AppLogic::update()
         std::lock_guard<std::mutex> streamLock(m_frameDataMutex);
 
         frameData.metadata = m_frameData.metadata;
-
-        // Move frame datas
-        for (size_t ch = 0; ch < m_frameData.colorFrames.size(); ch++) {
-            frameData.colorFrames[ch] = std::move(m_frameData.colorFrames[ch]);
-            m_frameData.colorFrames[ch] = std::nullopt;
-        }
-
-        frameData.cubemapFrame = std::move(m_frameData.cubemapFrame);
-        m_frameData.cubemapFrame = std::nullopt;
-
         frameData.cubemapMetadata = m_frameData.cubemapMetadata;
     }
 
@@ -458,21 +532,16 @@ void AppLogic::update()
     m_scene->update(m_varjoView->getFrameTime(), m_varjoView->getDeltaTime(), m_varjoView->getFrameNumber(), updateParams);
 
     // Get latest cubemap frame.
-    if (frameData.cubemapFrame.has_value()) {
-        const auto& cubemapFrame = frameData.cubemapFrame.value();
-        m_scene->updateHdrCubemap(cubemapFrame.metadata.bufferMetadata.width, cubemapFrame.metadata.bufferMetadata.format,
-            cubemapFrame.metadata.bufferMetadata.rowStride, cubemapFrame.data.data());
+    FrameBus::FramePtr cubemapFrame;
+    if (m_cubemapSubscription->tryPop(cubemapFrame)) {
+        m_scene->updateHdrCubemap(cubemapFrame->metadata.bufferMetadata.width, cubemapFrame->metadata.bufferMetadata.format,
+            cubemapFrame->metadata.bufferMetadata.rowStride, cubemapFrame->getData());
     }
 
-    // Get latest color frame
-    for (size_t ch = 0; ch < frameData.colorFrames.size(); ch++) {
-        if (frameData.colorFrames[ch].has_value()) {
-            const auto& colorFrame = frameData.colorFrames[ch].value();
-
-            // Skip conversions if the stream has only metadata.
-            if (colorFrame.metadata.bufferMetadata.byteSize == 0) {
-                continue;
-            }
+    // Get latest color frames. Left and right frames are matched by frame number.
+    if (m_colorSync->getLatestSet(m_colorFrames)) {
+        for (size_t ch = 0; ch < m_colorFrames.frames.size(); ch++) {
+            const auto& colorFrame = m_colorFrames.frames[ch];
 
             // NOTICE! This code is only to demonstrate how color camera frames can be accessed,
             // converted to RGB colorspace, and rectified and projected for e.g. computer vision purposes.
@@ -493,8 +562,8 @@ void AppLogic::update()
 
                 // Convert to rectified RGBA in lower resolution
                 std::vector<uint8_t> bufferRGBA(rowStride * h);
-                DataStreamer::convertDistortedYUVToRectifiedRGBA(colorFrame.metadata.bufferMetadata, colorFrame.data.data(), glm::ivec2(w, h),
-                    bufferRGBA.data(), colorFrame.metadata.extrinsics, colorFrame.metadata.intrinsics, projection);
+                DataStreamer::convertDistortedYUVToRectifiedRGBA(colorFrame.metadata.bufferMetadata, colorFrame.getData(), glm::ivec2(w, h),
+                    bufferRGBA.data(), colorFrame.metadata.extrinsics, colorFrame.metadata.intrinsics, projection, m_remapCache);
 
                 // Update frame data
                 m_scene->updateColorFrame(static_cast<int>(ch), glm::ivec2(w, h), varjo_TextureFormat_R8G8B8A8_UNORM, rowStride, bufferRGBA.data());
@@ -505,12 +574,17 @@ void AppLogic::update()
 
                 // Convert to RGBA in full res (this conversion is pixel to pixel, no scaling allowed)
                 std::vector<uint8_t> bufferRGBA(rowStride * h);
-                DataStreamer::convertToR8G8B8A(colorFrame.metadata.bufferMetadata, colorFrame.data.data(), bufferRGBA.data());
+                DataStreamer::convertToR8G8B8A(colorFrame.metadata.bufferMetadata, colorFrame.getData(), bufferRGBA.data());
 
                 // Update frame data
                 m_scene->updateColorFrame(static_cast<int>(ch), glm::ivec2(w, h), varjo_TextureFormat_R8G8B8A8_UNORM, rowStride, bufferRGBA.data());
             }
         }
+
+        // Release leased runtime buffers right away, copied buffers are kept for reuse
+        for (auto& colorFrame : m_colorFrames.frames) {
+            colorFrame.lease.reset();
+        }
     }
 
     // Early exit if no frame submit
@@ -13,6 +13,9 @@
 #include "MarkerTracker.hpp"
 #include "CameraManager.hpp"
 #include "DataStreamer.hpp"
+#include "FrameBus.hpp"
+#include "FrameSynchronizer.hpp"
+#include "RemapCache.hpp"
 
 #include "AppState.hpp"
 #include "GfxContext.hpp"
@@ -80,13 +83,18 @@ private:
     std::unique_ptr<VarjoExamples::CameraManager> m_camera;   //!< Camera manager instance
 
     struct FrameData {
-        std::optional<varjo_DistortedColorFrameMetadata> metadata;                     //!< Color stream metadata
-        std::array<std::optional<VarjoExamples::DataStreamer::Frame>, 2> colorFrames;  //!< Color stream stereo frames
-        std::optional<VarjoExamples::DataStreamer::Frame> cubemapFrame;                //!< HDR cubemap frame
-        std::optional<varjo_EnvironmentCubemapFrameMetadata> cubemapMetadata;          //!< HDR cubemap metadata
+        std::optional<varjo_DistortedColorFrameMetadata> metadata;             //!< Color stream metadata
+        std::optional<varjo_EnvironmentCubemapFrameMetadata> cubemapMetadata;  //!< HDR cubemap metadata
     };
     FrameData m_frameData;        //!< Latest frame data
     std::mutex m_frameDataMutex;  //!< Mutex for locking frame data
 
+    std::unique_ptr<VarjoExamples::FrameBus> m_frameBus;                           //!< Fans out data stream frames to subscribers
+    std::shared_ptr<VarjoExamples::FrameBus::Subscription> m_cubemapSubscription;  //!< Latest HDR cubemap frame
+    std::unique_ptr<VarjoExamples::FrameSynchronizer> m_colorSync;                 //!< Matches left and right color stream frames
+    VarjoExamples::FrameSynchronizer::FrameSet m_colorFrames;                      //!< Latest matched color frames, buffers reused between frames
+
+    VarjoExamples::RemapCache m_remapCache;  //!< Cached undistortion remap tables for color stream rectification
+
     varjo_TextureFormat m_colorStreamFormat{varjo_TextureFormat_INVALID};  //!< Texture format for color stream
 };
@@ -30,6 +30,10 @@ struct AppState {
         bool dataStreamColorEnabled{false};               //!< Color data stream enabled flag
         bool dataStreamCubemapEnabled{false};             //!< Cubemap data stream enabled flag
         bool delayedBufferHandlingEnabled{false};         //!< Delayed data stream buffer handling
+        bool bufferLeasingEnabled{false};                 //!< Zero-copy data stream buffer leasing
+        bool parallelChannelHandlingEnabled{false};       //!< Data stream channels handled in parallel
+        bool dataStreamRecordingEnabled{false};           //!< Data stream recording enabled flag
+        bool dataStreamLatencyLogEnabled{false};          //!< Data stream latency log enabled flag
         bool undistortEnabled{false};                     //!< Undistort color datastream when saving to file
         float vrViewOffset{1.0};                          //!< VR view offset value
         bool vrDepthTestRangeEnabled{false};              //!< VR depth test range enabled flag
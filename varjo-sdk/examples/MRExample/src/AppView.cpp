@@ -52,6 +52,8 @@ static const std::unordered_map<AppView::Action, ActionInfo> c_actions = {
     {AppView::Action::ToggleChromaKeying,            {"ToggleChromaKeying",              VK_F7,      "F7    Toggle chroma keying"}},
     {AppView::Action::ToggleVRViewOffset,            {"ToggleVRViewOffset",              VK_F8,      "F8    Toggle VR view offset: 0%, 50%, 100%"}},
     {AppView::Action::ToggleBufferHandlingMode,      {"ToggleBufferHandlingMode",        VK_F9,      "F9    Toggle buffer handling mode"}},
+    {AppView::Action::ToggleStreamRecording,         {"ToggleStreamRecording",           VK_F10,     "F10   Toggle data stream recording"}},
+    {AppView::Action::ToggleStreamLatencyLog,        {"ToggleStreamLatencyLog",          VK_F11,     "F11   Toggle data stream latency log"}},
     {AppView::Action::ToggleRenderVideoOn,           {"ToggleRenderVideoOn",             VK_LEFT,    "LEFT  Toggle video rendering ON"}},
     {AppView::Action::ToggleRenderVideoOff,          {"ToggleRenderVideoOff",            VK_RIGHT,   "RIGHT Toggle video rendering OFF"}},
     {AppView::Action::ToggleStreamColorYUV,          {"ToggleStreamColorYUV",            VK_DOWN,    "DOWN  Toggle stream COLOR: YUV"}},
@@ -405,6 +407,16 @@ bool AppView::onAction(Action actionType, AppState& appState)
             stateDirty = true;
         } break;
 
+        case Action::ToggleStreamRecording: {
+            appState.options.dataStreamRecordingEnabled = !appState.options.dataStreamRecordingEnabled;
+            stateDirty = true;
+        } break;
+
+        case Action::ToggleStreamLatencyLog: {
+            appState.options.dataStreamLatencyLogEnabled = !appState.options.dataStreamLatencyLogEnabled;
+            stateDirty = true;
+        } break;
+
         case Action::ToggleUndistortMode: {
             appState.options.undistortEnabled = !appState.options.undistortEnabled;
             stateDirty = true;
@@ -792,7 +804,15 @@ void AppView::updateUI()
         UIHelpers::HSpace();
         ImGui::Checkbox("Delayed handling" _TAG, &appState.options.delayedBufferHandlingEnabled);
         ImGui::SameLine();
+        ImGui::Checkbox("Zero-copy" _TAG, &appState.options.bufferLeasingEnabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Parallel channels" _TAG, &appState.options.parallelChannelHandlingEnabled);
+        ImGui::SameLine();
         ImGui::Checkbox("Undistort color stream" _TAG, &appState.options.undistortEnabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Record" _TAG, &appState.options.dataStreamRecordingEnabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Latency log" _TAG, &appState.options.dataStreamLatencyLogEnabled);
 
         UIHelpers::VSpace();
         ImGui::Text("Status: %s", m_logic.getStreamer().getStatusLine().c_str());
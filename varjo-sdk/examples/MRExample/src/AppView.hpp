@@ -46,6 +46,8 @@ public:
         NextFocusDistance,
         ToggleBufferHandlingMode,
         ToggleUndistortMode,
+        ToggleStreamRecording,
+        ToggleStreamLatencyLog,
         ToggleRenderingVR,
         ToggleSubmittingVRDepth,
         ToggleDepthTestRange,
@@ -0,0 +1,318 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "ColorConversionBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Globals.hpp"
+#include "ColorConversion.hpp"
+
+using namespace VarjoExamples;
+
+namespace
+{
+// Synthetic cubemap buffer size, six faces stacked vertically
+constexpr int32_t c_faceSize = 1024;
+constexpr int32_t c_width = c_faceSize;
+constexpr int32_t c_height = c_faceSize * 6;
+
+// Minimum measurement duration per case
+constexpr double c_minDuration = 0.5;
+
+// Background color used by DataStreamer
+constexpr float c_background[3] = {0.25f, 0.45f, 0.40f};
+
+// NV12 check image widths. Covers widths below, at and past the SSE4.1 and AVX2 block sizes, odd and even.
+constexpr int32_t c_nv12CheckWidths[] = {1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 97, 1023};
+
+// Extra bytes added to NV12 check source and destination row strides
+constexpr size_t c_nv12CheckPaddings[] = {0, 1, 13, 64};
+
+// NV12 check image height. Odd, so the last luma row has a chroma row of its own.
+constexpr int32_t c_nv12CheckHeight = 5;
+
+// NV12 throughput benchmark image size, same as the color camera stream
+constexpr int32_t c_nv12Width = 2048;
+constexpr int32_t c_nv12Height = 1536;
+
+// Value written to destination row padding before conversion. Kernels must leave it untouched.
+constexpr uint8_t c_guardValue = 0xcd;
+
+// Convert float to half, round to nearest. Only used for generating test data, so inputs are in normal half range.
+uint16_t convertFloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    if (exponent <= 0) {
+        return static_cast<uint16_t>(sign);
+    }
+    const uint32_t rounded = (static_cast<uint32_t>(exponent) << 10 | ((bits >> 13) & 0x3ff)) + ((bits >> 12) & 1);
+    return static_cast<uint16_t>(sign | std::min<uint32_t>(rounded, 0x7bff));
+}
+
+// Create RGBA16F buffer with HDR colors. Most texels are opaque, some are partially transparent.
+std::vector<uint16_t> createInput()
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> color(0.0f, 4.0f);
+    std::uniform_real_distribution<float> alpha(0.0f, 1.0f);
+
+    std::vector<uint16_t> data(static_cast<size_t>(c_width) * c_height * 4);
+    for (size_t i = 0; i < data.size(); i += 4) {
+        data[i + 0] = convertFloatToHalf(color(rng));
+        data[i + 1] = convertFloatToHalf(color(rng));
+        data[i + 2] = convertFloatToHalf(color(rng));
+        data[i + 3] = convertFloatToHalf((i / 4) % 8 == 0 ? alpha(rng) : 1.0f);
+    }
+    return data;
+}
+
+// Returns maximum absolute difference of color channels
+int32_t getMaxError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+    int32_t maxError = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        maxError = std::max(maxError, std::abs(static_cast<int32_t>(a[i]) - static_cast<int32_t>(b[i])));
+    }
+    return maxError;
+}
+
+// Convert every non-negative finite half value with given alpha and return maximum error against reference
+int32_t getExhaustiveMaxError(ColorConversion::SimdLevel level, float alpha)
+{
+    // One pixel per half value, all channels get the same value
+    const int32_t valueCount = 0x7c00;
+    std::vector<uint16_t> input(static_cast<size_t>(valueCount) * 4);
+    for (int32_t i = 0; i < valueCount; i++) {
+        const uint16_t value = static_cast<uint16_t>(i);
+        input[i * 4 + 0] = input[i * 4 + 1] = input[i * 4 + 2] = value;
+        input[i * 4 + 3] = convertFloatToHalf(alpha);
+    }
+
+    const size_t rowStride = static_cast<size_t>(valueCount) * 4;
+    std::vector<uint8_t> reference(rowStride);
+    std::vector<uint8_t> output(rowStride);
+    ColorConversion::convertRGBA16FToRGBAReference(input.data(), rowStride * sizeof(uint16_t), valueCount, 1, reference.data(), rowStride, c_background);
+    ColorConversion::convertRGBA16FToRGBA(input.data(), rowStride * sizeof(uint16_t), valueCount, 1, output.data(), rowStride, c_background, level);
+    return getMaxError(reference, output);
+}
+
+// Reference NV12 conversion, converts each pixel separately with ColorConversion::convertYUVtoRGB
+void convertNV12Reference(
+    const uint8_t* srcY, const uint8_t* srcUV, size_t srcRowStride, int32_t width, int32_t height, uint8_t* dst, size_t dstRowStride)
+{
+    for (int32_t y = 0; y < height; y++) {
+        const uint8_t* rowY = srcY + srcRowStride * y;
+        const uint8_t* rowUV = srcUV + srcRowStride * (y / 2);
+        uint8_t* rowDst = dst + dstRowStride * y;
+        for (int32_t x = 0; x < width; x++) {
+            const uint8_t* uv = rowUV + (x & ~1);
+            uint8_t* pixel = rowDst + static_cast<size_t>(x) * 4;
+            ColorConversion::convertYUVtoRGB(rowY[x], uv[0], uv[1], pixel[0], pixel[1], pixel[2]);
+            pixel[3] = 255;
+        }
+    }
+}
+
+// Returns number of bytes that differ
+size_t countMismatches(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+    size_t mismatches = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        mismatches += (a[i] != b[i]) ? 1 : 0;
+    }
+    return mismatches;
+}
+
+// Convert random NV12 images with all check widths and row paddings and return number of output bytes that differ
+// from the reference. Destination padding is included, so writes past the end of a row are counted too.
+size_t getNV12StrideMismatches(ColorConversion::SimdLevel level)
+{
+    std::mt19937 rng(5678);
+    std::uniform_int_distribution<int32_t> byte(0, 255);
+
+    size_t mismatches = 0;
+    for (const int32_t width : c_nv12CheckWidths) {
+        for (const size_t padding : c_nv12CheckPaddings) {
+            // Chroma rows of odd width images hold one more byte than there are pixels
+            const size_t srcRowStride = static_cast<size_t>(width + (width & 1)) + padding;
+            const size_t dstRowStride = static_cast<size_t>(width) * 4 + padding;
+            const int32_t chromaRows = (c_nv12CheckHeight + 1) / 2;
+
+            std::vector<uint8_t> srcY(srcRowStride * c_nv12CheckHeight);
+            std::vector<uint8_t> srcUV(srcRowStride * chromaRows);
+            std::generate(srcY.begin(), srcY.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+            std::generate(srcUV.begin(), srcUV.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+
+            std::vector<uint8_t> reference(dstRowStride * c_nv12CheckHeight, c_guardValue);
+            std::vector<uint8_t> output(dstRowStride * c_nv12CheckHeight, c_guardValue);
+            convertNV12Reference(srcY.data(), srcUV.data(), srcRowStride, width, c_nv12CheckHeight, reference.data(), dstRowStride);
+            ColorConversion::convertNV12ToRGBA(srcY.data(), srcUV.data(), srcRowStride, width, c_nv12CheckHeight, output.data(), dstRowStride, level);
+            mismatches += countMismatches(reference, output);
+        }
+    }
+    return mismatches;
+}
+
+// Convert every Y, U and V combination and return number of output bytes that differ from the reference. Chroma
+// sample in row U and column V of the image holds that U and V, and the four luma pixels sharing it hold consecutive
+// Y values, so 64 passes with a different Y base cover all combinations.
+size_t getNV12ExhaustiveMismatches(ColorConversion::SimdLevel level)
+{
+    constexpr int32_t width = 512;
+    constexpr int32_t height = 512;
+    constexpr size_t srcRowStride = width;
+    constexpr size_t dstRowStride = width * 4;
+
+    std::vector<uint8_t> srcY(srcRowStride * height);
+    std::vector<uint8_t> srcUV(srcRowStride * height / 2);
+    for (int32_t u = 0; u < height / 2; u++) {
+        for (int32_t v = 0; v < width / 2; v++) {
+            srcUV[srcRowStride * u + v * 2 + 0] = static_cast<uint8_t>(u);
+            srcUV[srcRowStride * u + v * 2 + 1] = static_cast<uint8_t>(v);
+        }
+    }
+
+    std::vector<uint8_t> reference(dstRowStride * height);
+    std::vector<uint8_t> output(dstRowStride * height);
+    size_t mismatches = 0;
+    for (int32_t base = 0; base < 256; base += 4) {
+        for (int32_t y = 0; y < height; y++) {
+            for (int32_t x = 0; x < width; x++) {
+                srcY[srcRowStride * y + x] = static_cast<uint8_t>(base + (y & 1) * 2 + (x & 1));
+            }
+        }
+        convertNV12Reference(srcY.data(), srcUV.data(), srcRowStride, width, height, reference.data(), dstRowStride);
+        ColorConversion::convertNV12ToRGBA(srcY.data(), srcUV.data(), srcRowStride, width, height, output.data(), dstRowStride, level);
+        mismatches += countMismatches(reference, output);
+    }
+    return mismatches;
+}
+
+// Run given function repeatedly and return throughput in megapixels per second
+template <typename Func>
+double measure(size_t pixelCount, Func&& func)
+{
+    // Warm up, this also builds the gamma table
+    func();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    int iterations = 0;
+    double elapsed = 0.0;
+    do {
+        func();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    } while (elapsed < c_minDuration);
+
+    return static_cast<double>(pixelCount) * iterations / elapsed / 1e6;
+}
+
+// Check NV12 kernels against the reference and measure their throughput. Returns false if any kernel differs.
+bool runNV12Benchmark()
+{
+    using ColorConversion::SimdLevel;
+
+    std::mt19937 rng(4321);
+    std::uniform_int_distribution<int32_t> byte(0, 255);
+    const size_t pixelCount = static_cast<size_t>(c_nv12Width) * c_nv12Height;
+    const size_t srcRowStride = c_nv12Width;
+    const size_t dstRowStride = static_cast<size_t>(c_nv12Width) * 4;
+    std::vector<uint8_t> srcY(pixelCount);
+    std::vector<uint8_t> srcUV(pixelCount / 2);
+    std::generate(srcY.begin(), srcY.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+    std::generate(srcUV.begin(), srcUV.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+    std::vector<uint8_t> reference(pixelCount * 4);
+    std::vector<uint8_t> output(pixelCount * 4);
+
+    LOG_INFO("NV12 conversion benchmark: input=%dx%d, supported=%s", c_nv12Width, c_nv12Height,
+        ColorConversion::getSimdLevelName(ColorConversion::getSupportedSimdLevel()));
+
+    const double referenceThroughput = measure(pixelCount, [&]() {
+        convertNV12Reference(srcY.data(), srcUV.data(), srcRowStride, c_nv12Width, c_nv12Height, reference.data(), dstRowStride);
+    });
+    LOG_INFO("%-10s %12s %12s %12s %12s %12s", "Kernel", "MPix/s", "Speedup", "Mismatches", "Strides", "All YUV");
+    LOG_INFO("%-10s %12.1f %12.1f %12d %12d %12d", "Reference", referenceThroughput, 1.0, 0, 0, 0);
+
+    bool passed = true;
+    for (const SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2}) {
+        if (level > ColorConversion::getSupportedSimdLevel()) {
+            continue;
+        }
+
+        const double throughput = measure(pixelCount, [&]() {
+            ColorConversion::convertNV12ToRGBA(srcY.data(), srcUV.data(), srcRowStride, c_nv12Width, c_nv12Height, output.data(), dstRowStride, level);
+        });
+        const size_t mismatches = countMismatches(reference, output);
+        const size_t strideMismatches = getNV12StrideMismatches(level);
+        const size_t exhaustiveMismatches = getNV12ExhaustiveMismatches(level);
+
+        LOG_INFO("%-10s %12.1f %12.1f %12zu %12zu %12zu", ColorConversion::getSimdLevelName(level), throughput, throughput / referenceThroughput,
+            mismatches, strideMismatches, exhaustiveMismatches);
+        passed = passed && mismatches == 0 && strideMismatches == 0 && exhaustiveMismatches == 0;
+    }
+
+    LOG_INFO("Mismatches count output bytes that differ from the per pixel convertYUVtoRGB reference. Strides converts");
+    LOG_INFO("widths 1 to 1023 with padded rows, All YUV converts every Y, U and V combination.");
+    if (!passed) {
+        LOG_ERROR("NV12 conversion kernels are not bit exact with the reference.");
+    }
+    return passed;
+}
+
+}  // namespace
+
+bool runColorConversionBenchmark()
+{
+    using ColorConversion::SimdLevel;
+
+    const bool nv12Passed = runNV12Benchmark();
+
+    const std::vector<uint16_t> input = createInput();
+    const size_t pixelCount = static_cast<size_t>(c_width) * c_height;
+    const size_t srcRowStride = static_cast<size_t>(c_width) * 4 * sizeof(uint16_t);
+    const size_t dstRowStride = static_cast<size_t>(c_width) * 4;
+    std::vector<uint8_t> reference(pixelCount * 4);
+    std::vector<uint8_t> output(pixelCount * 4);
+
+    LOG_INFO("RGBA16F conversion benchmark: input=%dx%d, supported=%s", c_width, c_height,
+        ColorConversion::getSimdLevelName(ColorConversion::getSupportedSimdLevel()));
+
+    const double referenceThroughput = measure(pixelCount, [&]() {
+        ColorConversion::convertRGBA16FToRGBAReference(input.data(), srcRowStride, c_width, c_height, reference.data(), dstRowStride, c_background);
+    });
+    LOG_INFO("%-10s %12s %12s %12s %12s", "Kernel", "MPix/s", "Speedup", "Max error", "All halves");
+    LOG_INFO("%-10s %12.1f %12.1f %12d %12d", "Reference", referenceThroughput, 1.0, 0, 0);
+
+    bool rgba16fPassed = true;
+    for (const SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2}) {
+        if (level > ColorConversion::getSupportedSimdLevel()) {
+            continue;
+        }
+
+        const double throughput = measure(pixelCount, [&]() {
+            ColorConversion::convertRGBA16FToRGBA(input.data(), srcRowStride, c_width, c_height, output.data(), dstRowStride, c_background, level);
+        });
+        const int32_t maxError = getMaxError(reference, output);
+        const int32_t exhaustiveMaxError = std::max(getExhaustiveMaxError(level, 1.0f), getExhaustiveMaxError(level, 0.5f));
+
+        LOG_INFO("%-10s %12.1f %12.1f %12d %12d", ColorConversion::getSimdLevelName(level), throughput, throughput / referenceThroughput, maxError,
+            exhaustiveMaxError);
+        rgba16fPassed = rgba16fPassed && maxError == 0 && exhaustiveMaxError == 0;
+    }
+
+    LOG_INFO("Max error is the largest 8-bit channel difference to the powf reference. All halves converts every");
+    LOG_INFO("non-negative finite half value with alpha 1.0 and 0.5. AVX2 kernel requires F16C, otherwise it falls back to scalar.");
+    if (!rgba16fPassed) {
+        LOG_ERROR("RGBA16F conversion kernels don't match the reference.");
+    }
+
+    return nv12Passed && rgba16fPassed;
+}
@@ -0,0 +1,10 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+//! Run NV12 and RGBA16F to RGBA8 conversion benchmarks on synthetic data and log results. NV12 kernels are checked
+//! bit exact against the per pixel reference for odd and even widths with padded row strides and for every Y, U and
+//! V combination. RGBA16F kernels are checked against the per channel powf reference, both for all half float inputs
+//! and for a synthetic cubemap. Also reports throughput in MPix/s for each kernel. Does not need a headset or Varjo
+//! runtime. Returns false if any kernel output differs from its reference.
+bool runColorConversionBenchmark();
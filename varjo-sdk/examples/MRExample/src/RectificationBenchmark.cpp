@@ -0,0 +1,140 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#include "RectificationBenchmark.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include "Globals.hpp"
+#include "DataStreamer.hpp"
+#include "Rectifier.hpp"
+#include "RemapCache.hpp"
+
+using namespace VarjoExamples;
+
+namespace
+{
+// Synthetic distorted input buffer size
+constexpr int c_inputWidth = 2880;
+constexpr int c_inputHeight = 2720;
+
+// Minimum measurement duration per case
+constexpr double c_minDuration = 0.5;
+
+// Output downscale factors to benchmark
+constexpr int c_downScaleFactors[] = {1, 2, 4};
+
+// Create omnidir intrinsics with typical wide angle distortion
+varjo_CameraIntrinsics createIntrinsics()
+{
+    varjo_CameraIntrinsics intrinsics{};
+    intrinsics.model = varjo_IntrinsicsModel_Omnidir;
+    intrinsics.principalPointX = 0.5;
+    intrinsics.principalPointY = 0.5;
+    intrinsics.focalLengthX = 0.6;
+    intrinsics.focalLengthY = 0.6;
+    intrinsics.distortionCoefficients[0] = -0.1;   // K1
+    intrinsics.distortionCoefficients[1] = 0.02;   // K2
+    intrinsics.distortionCoefficients[2] = 0.0;    // Skew
+    intrinsics.distortionCoefficients[3] = 1.0;    // Xi
+    intrinsics.distortionCoefficients[4] = 0.001;  // P1
+    intrinsics.distortionCoefficients[5] = 0.001;  // P2
+    return intrinsics;
+}
+
+// Create NV12 buffer with gradient pattern
+std::vector<uint8_t> createInput(const varjo_BufferMetadata& buffer)
+{
+    std::vector<uint8_t> data(static_cast<size_t>(buffer.rowStride) * buffer.height * 3 / 2);
+    uint8_t* yPlane = data.data();
+    uint8_t* uvPlane = data.data() + static_cast<size_t>(buffer.rowStride) * buffer.height;
+
+    for (int32_t y = 0; y < buffer.height; y++) {
+        for (int32_t x = 0; x < buffer.width; x++) {
+            yPlane[y * buffer.rowStride + x] = static_cast<uint8_t>(16 + (x + y) % 220);
+        }
+    }
+    for (int32_t y = 0; y < buffer.height / 2; y++) {
+        for (int32_t x = 0; x < buffer.width / 2; x++) {
+            uvPlane[y * buffer.rowStride + x * 2 + 0] = static_cast<uint8_t>(x % 256);
+            uvPlane[y * buffer.rowStride + x * 2 + 1] = static_cast<uint8_t>(y % 256);
+        }
+    }
+    return data;
+}
+
+// Run given function repeatedly and return throughput in megapixels per second
+template <typename Func>
+double measure(size_t pixelCount, Func&& func)
+{
+    // Warm up, this also builds cached remap tables
+    func();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    int iterations = 0;
+    double elapsed = 0.0;
+    do {
+        func();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    } while (elapsed < c_minDuration);
+
+    return static_cast<double>(pixelCount) * iterations / elapsed / 1e6;
+}
+
+}  // namespace
+
+void runRectificationBenchmark()
+{
+    varjo_BufferMetadata buffer{};
+    buffer.format = varjo_TextureFormat_NV12;
+    buffer.type = varjo_BufferType_CPU;
+    buffer.width = c_inputWidth;
+    buffer.height = c_inputHeight;
+    buffer.rowStride = c_inputWidth;
+    buffer.byteSize = buffer.rowStride * buffer.height * 3 / 2;
+
+    const std::vector<uint8_t> input = createInput(buffer);
+    const varjo_CameraIntrinsics intrinsics = createIntrinsics();
+    const varjo_Matrix extrinsics = toVarjoMatrix(glm::mat4x4(1.0f));
+    const std::optional<const varjo_Matrix> projection;
+
+    RemapCache remapCache;
+    Rectifier rectifier;
+    Rectifier rectifierSingleThread(0);
+
+    LOG_INFO("Rectification benchmark: input=%dx%d NV12, threads=%zu", c_inputWidth, c_inputHeight, rectifier.getThreadCount() + 1);
+    LOG_INFO("%-8s %-10s %12s %12s %12s %12s %12s %12s", "Scale", "Output", "Original", "Cached", "Bilin 1T", "Bilin RGBA", "Bilin RGB", "Bilin Y8");
+
+    for (const int downScaleFactor : c_downScaleFactors) {
+        const glm::ivec2 outputSize(c_inputWidth / downScaleFactor, c_inputHeight / downScaleFactor);
+        const size_t pixelCount = static_cast<size_t>(outputSize.x) * outputSize.y;
+        std::vector<uint8_t> output(pixelCount * 4);
+
+        // Original implementation evaluates the camera model for every pixel on every call
+        const double original = measure(pixelCount, [&]() {
+            DataStreamer::convertDistortedYUVToRectifiedRGBA(buffer, input.data(), outputSize, output.data(), extrinsics, intrinsics, projection);
+        });
+
+        const double cached = measure(pixelCount, [&]() {
+            DataStreamer::convertDistortedYUVToRectifiedRGBA(
+                buffer, input.data(), outputSize, output.data(), extrinsics, intrinsics, projection, remapCache);
+        });
+
+        const auto measureRectifier = [&](Rectifier& r, Rectifier::OutputFormat format) {
+            return measure(pixelCount, [&]() { r.rectify(buffer, input.data(), outputSize, output.data(), 0, format, extrinsics, intrinsics, projection); });
+        };
+
+        const double bilinearSingle = measureRectifier(rectifierSingleThread, Rectifier::OutputFormat::RGBA8);
+        const double bilinearRGBA = measureRectifier(rectifier, Rectifier::OutputFormat::RGBA8);
+        const double bilinearRGB = measureRectifier(rectifier, Rectifier::OutputFormat::RGB8);
+        const double bilinearY = measureRectifier(rectifier, Rectifier::OutputFormat::Y8);
+
+        const std::string scale = std::to_string(downScaleFactor) + "x";
+        const std::string size = std::to_string(outputSize.x) + "x" + std::to_string(outputSize.y);
+        LOG_INFO("%-8s %-10s %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f", scale.c_str(), size.c_str(), original, cached, bilinearSingle, bilinearRGBA,
+            bilinearRGB, bilinearY);
+    }
+
+    LOG_INFO("Throughput in output MPix/s. Bilin 1T is bilinear RGBA on a single thread.");
+}
@@ -0,0 +1,8 @@
+// Copyright 2024 Varjo Technologies Oy. All rights reserved.
+
+#pragma once
+
+//! Run color stream rectification throughput benchmark on synthetic NV12 data and log results in MPix/s.
+//! Compares the original per call undistortion, cached nearest neighbor remapping and the tiled bilinear
+//! rectifier at 1x, 2x and 4x downscale. Does not need a headset or Varjo runtime.
+void runRectificationBenchmark();
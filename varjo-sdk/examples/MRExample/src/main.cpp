@@ -4,16 +4,33 @@
  *
  * - Showcases Varjo MR API features: Camera, data streams, rendering, and more!
  * - Run example and press F1 for help
+ * - Run with --benchmark-rectification (and --console) to benchmark CPU color stream rectification
+ * - Run with --benchmark-color-conversion (and --console) to check and benchmark NV12 and RGBA16F conversion kernels.
+ *   Exits with failure if the kernels are not bit exact with their references.
  */
 
 // Internal includes
 #include "Globals.hpp"
 #include "AppLogic.hpp"
 #include "AppView.hpp"
+#include "ColorConversionBenchmark.hpp"
+#include "RectificationBenchmark.hpp"
 
-// Common main function called from the entry point
-void commonMain()
+// Common main function called from the entry point. Returns false if a benchmark check failed.
+bool commonMain(bool rectificationBenchmark, bool colorConversionBenchmark)
 {
+    // Run benchmarks instead of the application if requested
+    if (rectificationBenchmark || colorConversionBenchmark) {
+        bool passed = true;
+        if (rectificationBenchmark) {
+            runRectificationBenchmark();
+        }
+        if (colorConversionBenchmark) {
+            passed = runColorConversionBenchmark() && passed;
+        }
+        return passed;
+    }
+
     // Instantiate application logic and view
     auto appLogic = std::make_unique<AppLogic>();
     auto appView = std::make_unique<AppView>(*appLogic);
@@ -39,16 +56,27 @@ void commonMain()
 
     // Exit successfully
     LOG_INFO("Done!");
+    return true;
 }
 
 // Console application entry point
 int main(int argc, char** argv)
 {
+    bool rectificationBenchmark = false;
+    bool colorConversionBenchmark = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--benchmark-rectification") {
+            rectificationBenchmark = true;
+        } else if (std::string(argv[i]) == "--benchmark-color-conversion") {
+            colorConversionBenchmark = true;
+        }
+    }
+
     // Call common main function
-    commonMain();
+    const bool passed = commonMain(rectificationBenchmark, colorConversionBenchmark);
 
     // Application finished
-    return EXIT_SUCCESS;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 // Windows application entry point
@@ -58,9 +86,15 @@ int __stdcall wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdL
     LPWSTR* args = CommandLineToArgvW(pCmdLine, &argc);
 
     bool console = false;
+    bool rectificationBenchmark = false;
+    bool colorConversionBenchmark = false;
     for (int i = 0; i < argc; i++) {
         if (std::wstring(args[i]) == (L"--console")) {
             console = true;
+        } else if (std::wstring(args[i]) == (L"--benchmark-rectification")) {
+            rectificationBenchmark = true;
+        } else if (std::wstring(args[i]) == (L"--benchmark-color-conversion")) {
+            colorConversionBenchmark = true;
         }
     }
 
@@ -74,8 +108,8 @@ int __stdcall wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdL
     }
 
     // Call common main function
-    commonMain();
+    const bool passed = commonMain(rectificationBenchmark, colorConversionBenchmark);
 
     // Application finished
-    return EXIT_SUCCESS;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
 }